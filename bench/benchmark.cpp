@@ -0,0 +1,221 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+
+#include <simulated_process.hpp>
+
+#include "hook_program.hpp"
+#include "measure.hpp"
+#include "synthetic_module.hpp"
+#ifdef _WIN32
+#include "module.hpp"
+#endif
+
+using namespace Injector;
+
+static constexpr const char* BenchmarkFileName = "syringe.bench.tsv";
+
+/*!
+* @brief Startup scaling benchmark: synthetic hook DLL of each size (see SyntheticModule) goes through the same steps as injection,
+* @brief against SimulatedProcess with code of synthetic host & target module. Median time of repeats is reported per step.
+* @brief Results are appended to TSV file (one row per size & run, unix time in first column), so runs can be trended.
+* @brief Module::parse needs Windows (LoadLibrary & file mapping), elsewhere hooks are taken from the generator and parse time is nan.
+*/
+struct Options
+{
+    vector<size_t> Sizes      { 100, 1000, 10000, 100000 };
+    size_t         Repeat     = 3;
+    uint32_t       Seed       = 1;
+    string         OutputFile = BenchmarkFileName;
+    // where synthetic DLLs are written for Module::parse
+    string         Directory  = ".";
+};
+
+struct Result
+{
+    size_t Hooks        = 0;
+    size_t Pockets      = 0;
+    size_t Facades      = 0;
+    size_t Conflicts    = 0;
+    size_t ImageBytes   = 0;
+    size_t ProgramBytes = 0;
+    size_t Allocations  = 0;
+
+    vector<double> Generate, Parse, Plan, Assemble, Write, ConflictDetection;
+};
+
+static constexpr const char* ResultColumns =
+    "time\tplatform\thooks\tpockets\tfacades\tconflicts\timage_bytes\tprogram_bytes\tallocations\trepeat\t"
+    "generate_ms\tparse_ms\tplan_ms\tassemble_ms\twrite_ms\tconflicts_ms\n";
+
+Result run(size_t size, Options const& options)
+{
+    Result result;
+    result.Hooks = size;
+
+    for (size_t repeat = 0; repeat < options.Repeat; repeat++)
+    {
+        SyntheticModuleSpec spec = SyntheticModuleSpec::Scaled(size, options.Seed);
+        spec.Name = fmt::format("synthetic{0}", size);
+
+        unique_ptr<SyntheticModule> synthetic;
+        result.Generate.push_back(measure([&] { synthetic = make_unique<SyntheticModule>(spec); }));
+
+        vector<BYTE> const image = synthetic->Image();
+        result.ImageBytes = image.size();
+
+        list<Hook> hooks;
+#ifdef _WIN32
+        auto const fileName = (std::filesystem::path(options.Directory) / synthetic->FileName()).string();
+        if (repeat == 0)
+        {
+            std::ofstream file(fileName, std::ios::binary | std::ios::trunc);
+            file.write(reinterpret_cast<const char*>(image.data()), image.size());
+        }
+
+        list<Module> modules;
+        Module& mdl = modules.emplace_back();
+        result.Parse.push_back(measure([&] { mdl.parse(fileName); }));
+        // functions are resolved as if DLL is loaded at its preferred base
+        mdl.set_handle(reinterpret_cast<HMODULE>(spec.ImageBase));
+        mdl.resolve_exported_functions(modules);
+        hooks.splice(hooks.end(), mdl.Hooks);
+#else
+        hooks = synthetic->MakeHooks();
+#endif
+
+        SimulatedProcess process;
+        process.Map(reinterpret_cast<Address>(spec.HostBase + SyntheticModule::CodeRva), synthetic->HostCode.data(), synthetic->HostCode.size());
+        process.Map(reinterpret_cast<Address>(spec.TargetBase + SyntheticModule::CodeRva), synthetic->TargetCode.data(), synthetic->TargetCode.size());
+        ProcessMemory memory(process);
+        {
+            HookProgram program(memory);
+            result.Plan.push_back(measure([&]
+            {
+                for (auto& hook : hooks)
+                {
+                    Address const placement = synthetic->PlacementOf(hook);
+                    if (!placement)
+                        continue;
+                    // redefine by name is resolved before conflicts are checked, as ParseModules does (RVA in target module)
+                    if (hook.Type == HookType::FacadeByName)
+                        hook.Placement = hook.ModuleName.size() ? placement - spec.TargetBase : placement;
+                    if (hook.ModuleName.size())
+                        hook.ModuleBase = reinterpret_cast<Address>(spec.TargetBase);
+                    program.Add(hook, placement);
+                }
+                program.Plan();
+            }));
+            result.Assemble.push_back(measure([&]
+            {
+                program.Allocate();
+                program.Assemble();
+            }));
+            result.Write.push_back(measure([&] { program.Write(); }));
+
+            result.Pockets      = program.Pockets.size();
+            result.Facades      = program.Facades.size();
+            result.ProgramBytes = program.Size();
+        }
+        result.Allocations = process.Stats.Allocations;
+
+        result.ConflictDetection.push_back(measure([&]
+        {
+            vector<Hook*> pointers;
+            for (auto& hook : hooks)
+                pointers.push_back(&hook);
+            result.Conflicts = find_hook_conflicts(pointers).size();
+        }));
+    }
+    return result;
+}
+
+bool parse_arguments(int argc, char** argv, Options& options)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        string const arg   = argv[i];
+        auto const   value = [&arg](const char* prefix, string& out)
+        {
+            if (arg.rfind(prefix, 0) != 0)
+                return false;
+            out = arg.substr(strlen(prefix));
+            return true;
+        };
+
+        string text;
+        if (value("-sizes=", text))
+        {
+            options.Sizes.clear();
+            for (auto const& size : Utilities::string_split(text, ","))
+                options.Sizes.push_back(std::stoul(size));
+        }
+        else if (value("-repeat=", text))
+            options.Repeat = (std::max)(std::stoul(text), 1ul);
+        else if (value("-seed=", text))
+            options.Seed = std::stoul(text);
+        else if (value("-out=", text))
+            options.OutputFile = text;
+        else if (value("-dir=", text))
+            options.Directory = text;
+        else
+            return false;
+    }
+    return !options.Sizes.empty();
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    try
+    {
+        if (!parse_arguments(argc, argv, options))
+        {
+            std::cerr << "Usage: syringe_bench [-sizes=100,1000,10000,100000] [-repeat=3] [-seed=1] [-out=" << BenchmarkFileName << "] [-dir=.]\n";
+            return EXIT_FAILURE;
+        }
+    }
+    catch (const std::exception&)
+    {
+        std::cerr << "Invalid number in arguments.\n";
+        return EXIT_FAILURE;
+    }
+
+    // injector steps log every hook
+    spdlog::set_level(spdlog::level::warn);
+
+#ifdef _WIN32
+    const char* const platform = "win32";
+#else
+    const char* const platform = "simulated";
+#endif
+
+    bool const   header = !std::filesystem::exists(options.OutputFile) || std::filesystem::file_size(options.OutputFile) == 0;
+    std::ofstream file(options.OutputFile, std::ios::app);
+    if (!file)
+    {
+        std::cerr << "Unable to write benchmark results \"" << options.OutputFile << "\".\n";
+        return EXIT_FAILURE;
+    }
+    if (header)
+        file << ResultColumns;
+
+    std::cout << fmt::format("{0:>8} {1:>8} {2:>10} {3:>10} {4:>10} {5:>10} {6:>10} {7:>10}\n",
+        "hooks", "pockets", "generate", "parse", "plan", "assemble", "write", "conflicts");
+    auto const now = static_cast<long long>(std::time(nullptr));
+    for (size_t size : options.Sizes)
+    {
+        Result const r = run(size, options);
+        std::cout << fmt::format("{0:>8} {1:>8} {2:>10.3f} {3:>10.3f} {4:>10.3f} {5:>10.3f} {6:>10.3f} {7:>10.3f}\n",
+            r.Hooks, r.Pockets, median(r.Generate), median(r.Parse), median(r.Plan), median(r.Assemble), median(r.Write), median(r.ConflictDetection));
+        file << fmt::format("{0}\t{1}\t{2}\t{3}\t{4}\t{5}\t{6}\t{7}\t{8}\t{9}\t{10:.3f}\t{11:.3f}\t{12:.3f}\t{13:.3f}\t{14:.3f}\t{15:.3f}\n",
+            now, platform, r.Hooks, r.Pockets, r.Facades, r.Conflicts, r.ImageBytes, r.ProgramBytes, r.Allocations, options.Repeat,
+            median(r.Generate), median(r.Parse), median(r.Plan), median(r.Assemble), median(r.Write), median(r.ConflictDetection));
+        file.flush();
+    }
+    std::cout << "Results appended to \"" << options.OutputFile << "\" (milliseconds, median of " << options.Repeat << " runs).\n";
+    return EXIT_SUCCESS;
+}
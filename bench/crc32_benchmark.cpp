@@ -0,0 +1,184 @@
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <random>
+
+#include <fmt/format.h>
+
+#include <crc32.hpp>
+#include <checksum.hpp>
+#include <string.hpp>
+
+#include "measure.hpp"
+
+using std::string;
+using std::vector;
+
+static constexpr const char* BenchmarkFileName = "syringe.crc32.tsv";
+
+/*!
+* @brief Throughput of CRC32 engine (Crc32, see debugger/checksum.hpp) against Utilities::CRC32::compute_stream it replaced.
+* @brief Random data of each size is hashed from memory (single & parallel) and from file written next to benchmark,
+* @brief file is hashed by both engine (mapping) and baseline (stream), values are checked to match.
+* @brief Median of repeats is reported in MiB/s and appended to TSV file (one row per size & run) like syringe_bench does.
+*/
+struct Options
+{
+    // KiB
+    vector<size_t> Sizes      { 4, 64, 1024, 16 * 1024, 128 * 1024 };
+    size_t         Repeat     = 5;
+    string         OutputFile = BenchmarkFileName;
+    string         DataFile   = "syringe.crc32.bin";
+};
+
+struct Result
+{
+    size_t Bytes    = 0;
+    bool   Matching = true;
+
+    vector<double> Memory, Parallel, File, Baseline;
+};
+
+static constexpr const char* ResultColumns =
+    "time\taccelerated\tbytes\trepeat\tmemory_mibs\tparallel_mibs\tfile_mibs\tbaseline_mibs\tspeedup\n";
+
+Result run(size_t size, Options const& options)
+{
+    Result result;
+    result.Bytes = size * 1024;
+
+    vector<unsigned char> data(result.Bytes);
+    std::mt19937 random(static_cast<uint32_t>(size));
+    for (auto& byte : data)
+        byte = static_cast<unsigned char>(random());
+    {
+        std::ofstream file(options.DataFile, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(data.data()), data.size());
+        if (!file)
+            throw std::runtime_error("Unable to write \"" + options.DataFile + "\"");
+    }
+
+    unsigned int expected = 0;
+    for (size_t repeat = 0; repeat < options.Repeat; repeat++)
+    {
+        unsigned int memory = 0, parallel = 0, file = 0, baseline = 0;
+        result.Memory.push_back(measure([&] { memory = Crc32::compute(data.data(), data.size()); }));
+        result.Parallel.push_back(measure([&] { parallel = Crc32::compute_parallel(data.data(), data.size()); }));
+        result.File.push_back(measure([&] { file = Crc32::compute_file(options.DataFile); }));
+        result.Baseline.push_back(measure([&]
+        {
+            std::ifstream stream(options.DataFile, std::ios::binary);
+            baseline = Utilities::CRC32::compute_stream(stream);
+        }));
+
+        if (repeat == 0)
+            expected = baseline;
+        result.Matching &= memory == expected && parallel == expected && file == expected && baseline == expected;
+    }
+    return result;
+}
+
+bool parse_arguments(int argc, char** argv, Options& options)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        string const arg   = argv[i];
+        auto const   value = [&arg](const char* prefix, string& out)
+        {
+            if (arg.rfind(prefix, 0) != 0)
+                return false;
+            out = arg.substr(strlen(prefix));
+            return true;
+        };
+
+        string text;
+        if (value("-sizes=", text))
+        {
+            options.Sizes.clear();
+            for (auto const& size : Utilities::string_split(text, ","))
+                options.Sizes.push_back(std::stoul(size));
+        }
+        else if (value("-repeat=", text))
+            options.Repeat = (std::max)(std::stoul(text), 1ul);
+        else if (value("-out=", text))
+            options.OutputFile = text;
+        else if (value("-data=", text))
+            options.DataFile = text;
+        else
+            return false;
+    }
+    return !options.Sizes.empty();
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    try
+    {
+        if (!parse_arguments(argc, argv, options))
+        {
+            std::cerr << "Usage: crc32_bench [-sizes=4,64,1024,16384,131072] (KiB) [-repeat=5] [-out=" << BenchmarkFileName
+                << "] [-data=syringe.crc32.bin]\n";
+            return EXIT_FAILURE;
+        }
+    }
+    catch (const std::exception&)
+    {
+        std::cerr << "Invalid number in arguments.\n";
+        return EXIT_FAILURE;
+    }
+
+    bool const   header = !std::filesystem::exists(options.OutputFile) || std::filesystem::file_size(options.OutputFile) == 0;
+    std::ofstream file(options.OutputFile, std::ios::app);
+    if (!file)
+    {
+        std::cerr << "Unable to write benchmark results \"" << options.OutputFile << "\".\n";
+        return EXIT_FAILURE;
+    }
+    if (header)
+        file << ResultColumns;
+
+    bool const accelerated = Crc32::hardware_accelerated();
+    std::cout << "Engine: " << (accelerated ? "PCLMULQDQ folding" : "slice-by-16 tables") << ".\n";
+    std::cout << fmt::format("{0:>12} {1:>10} {2:>10} {3:>10} {4:>10} {5:>8}\n",
+        "bytes", "memory", "parallel", "file", "baseline", "speedup");
+
+    auto const now = static_cast<long long>(std::time(nullptr));
+    auto const throughput = [](size_t bytes, double ms) { return bytes / (1024.0 * 1024.0) / (ms / 1000.0); };
+    bool matching = true;
+    for (size_t size : options.Sizes)
+    {
+        Result r;
+        try
+        {
+            r = run(size, options);
+        }
+        catch (const std::exception& ex)
+        {
+            std::cerr << ex.what() << ".\n";
+            return EXIT_FAILURE;
+        }
+        matching &= r.Matching;
+
+        double const memory   = throughput(r.Bytes, median(r.Memory));
+        double const parallel = throughput(r.Bytes, median(r.Parallel));
+        double const fileMibs = throughput(r.Bytes, median(r.File));
+        double const baseline = throughput(r.Bytes, median(r.Baseline));
+        std::cout << fmt::format("{0:>12} {1:>10.1f} {2:>10.1f} {3:>10.1f} {4:>10.1f} {5:>7.1f}x{6}\n",
+            r.Bytes, memory, parallel, fileMibs, baseline, fileMibs / baseline, r.Matching ? "" : " MISMATCH");
+        file << fmt::format("{0}\t{1}\t{2}\t{3}\t{4:.1f}\t{5:.1f}\t{6:.1f}\t{7:.1f}\t{8:.2f}\n",
+            now, accelerated ? 1 : 0, r.Bytes, options.Repeat, memory, parallel, fileMibs, baseline, fileMibs / baseline);
+        file.flush();
+    }
+    std::error_code error;
+    std::filesystem::remove(options.DataFile, error);
+
+    std::cout << "Results appended to \"" << options.OutputFile << "\" (MiB/s, median of " << options.Repeat << " runs, speedup of file engine over baseline).\n";
+    if (!matching)
+    {
+        std::cerr << "Checksums of engine differ from Utilities::CRC32.\n";
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,280 @@
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+#include "measure.hpp"
+#include "synthetic_module.hpp"
+#include "x86_decoder.hpp"
+
+using namespace Injector;
+
+static constexpr const char* BenchmarkFileName = "syringe.decoder.tsv";
+
+/*!
+* @brief Throughput of x86 length decoder and of relocation of overridden instructions (RelocatedCode) over a corpus of code:
+* @brief executable sections of real PE file (-file) or code of synthetic host & target module (see SyntheticModule).
+* @brief Corpus is decoded linearly (unknown byte is skipped), then each instruction boundary (up to -sites) is taken as hook site:
+* @brief bytes are read as HookProgram reads them, overridden instructions are planned for jump and relocated to another address.
+* @brief Median of repeats is printed and appended to TSV file like syringe_bench does.
+*/
+struct Options
+{
+    string   File;
+    size_t   Hooks      = 100000;
+    size_t   Sites      = 100000;
+    size_t   Repeat     = 5;
+    uint32_t Seed       = 1;
+    string   OutputFile = BenchmarkFileName;
+};
+
+struct Corpus
+{
+    string Name;
+    // code & address it's placed at in process
+    vector<std::pair<vector<BYTE>, DWORD>> Blocks;
+
+    size_t bytes() const
+    {
+        size_t result = 0;
+        for (auto const& block : Blocks)
+            result += block.first.size();
+        return result;
+    }
+};
+
+struct Result
+{
+    size_t Instructions = 0;
+    size_t Unknown      = 0;
+    size_t Sites        = 0;
+    size_t Relocatable  = 0;
+    size_t Branches     = 0;
+
+    vector<double> Decode, Plan, Relocate;
+};
+
+template<typename T>
+static bool read_at(vector<BYTE> const& data, size_t offset, T& value)
+{
+    if (offset + sizeof(T) > data.size())
+        return false;
+    memcpy(&value, data.data() + offset, sizeof(T));
+    return true;
+}
+
+// Executable sections of PE32 file by their preferred address, whole file at 0 if it isn't PE
+Corpus load_file(string const& fileName)
+{
+    std::ifstream file(fileName, std::ios::binary);
+    if (!file)
+        throw std::runtime_error("Unable to read \"" + fileName + "\"");
+    vector<BYTE> const data { std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>() };
+
+    Corpus corpus;
+    corpus.Name = std::filesystem::path(fileName).filename().string();
+
+    // IMAGE_DOS_HEADER::e_lfanew, IMAGE_NT_HEADERS32 & IMAGE_SECTION_HEADER fields by offset, so it's read on any platform
+    static constexpr DWORD PESignature = 0x00004550, ExecutableSection = 0x20000000;
+    DWORD newHeader = 0, signature = 0, imageBase = 0;
+    WORD  sections = 0, optionalSize = 0;
+    if (read_at(data, 0x3C, newHeader) && read_at(data, newHeader, signature) && signature == PESignature
+        && read_at(data, newHeader + 6, sections) && read_at(data, newHeader + 20, optionalSize)
+        && read_at(data, newHeader + 24 + 28, imageBase))
+    {
+        size_t const table = newHeader + 24 + optionalSize;
+        for (WORD i = 0; i < sections; i++)
+        {
+            size_t const header = table + i * 40;
+            DWORD virtualAddress = 0, rawSize = 0, rawPointer = 0, characteristics = 0;
+            if (!read_at(data, header + 12, virtualAddress) || !read_at(data, header + 16, rawSize)
+                || !read_at(data, header + 20, rawPointer) || !read_at(data, header + 36, characteristics))
+                break;
+            if (!(characteristics & ExecutableSection) || rawPointer >= data.size())
+                continue;
+            rawSize = (std::min)(rawSize, static_cast<DWORD>(data.size() - rawPointer));
+            corpus.Blocks.emplace_back(vector<BYTE>(data.cbegin() + rawPointer, data.cbegin() + rawPointer + rawSize), imageBase + virtualAddress);
+        }
+    }
+    if (corpus.Blocks.empty())
+        corpus.Blocks.emplace_back(data, 0);
+    return corpus;
+}
+
+Corpus generate(Options const& options)
+{
+    SyntheticModuleSpec const spec = SyntheticModuleSpec::Scaled(options.Hooks, options.Seed);
+    SyntheticModule const synthetic(spec);
+
+    Corpus corpus;
+    corpus.Name = fmt::format("synthetic{0}", options.Hooks);
+    corpus.Blocks.emplace_back(synthetic.HostCode, spec.HostBase + SyntheticModule::CodeRva);
+    corpus.Blocks.emplace_back(synthetic.TargetCode, spec.TargetBase + SyntheticModule::CodeRva);
+    return corpus;
+}
+
+Result run(Corpus const& corpus, Options const& options)
+{
+    // bytes are read at site as HookProgram reads them: enough for the longest instruction behind the jump
+    static constexpr size_t SiteBytes = JumpR32lInstructionLength - 1 + MaxInstructionLength;
+    static constexpr DWORD  Target    = 0x10000000;
+
+    Result result;
+    vector<std::pair<vector<BYTE>, DWORD>> sites;
+    for (size_t repeat = 0; repeat < options.Repeat; repeat++)
+    {
+        size_t instructions = 0, unknown = 0;
+        vector<std::pair<size_t, size_t>> boundaries;
+        result.Decode.push_back(measure([&]
+        {
+            for (size_t index = 0; index < corpus.Blocks.size(); index++)
+            {
+                vector<BYTE> const& code = corpus.Blocks[index].first;
+                for (size_t offset = 0; offset < code.size(); )
+                {
+                    X86Instruction instruction;
+                    if (!decode_instruction(code.data() + offset, code.size() - offset, instruction))
+                    {
+                        unknown++;
+                        offset++;
+                        continue;
+                    }
+                    instructions++;
+                    if (repeat == 0 && boundaries.size() < options.Sites)
+                        boundaries.emplace_back(index, offset);
+                    offset += instruction.Length;
+                }
+            }
+        }));
+        result.Instructions = instructions;
+        result.Unknown      = unknown;
+
+        if (repeat == 0)
+            for (auto const& [index, offset] : boundaries)
+            {
+                auto const& [code, address] = corpus.Blocks[index];
+                size_t const size = (std::min)(SiteBytes, code.size() - offset);
+                sites.emplace_back(vector<BYTE>(code.cbegin() + offset, code.cbegin() + offset + size), address + static_cast<DWORD>(offset));
+            }
+
+        vector<RelocatedCode> planned(sites.size());
+        vector<bool>          decoded(sites.size());
+        result.Plan.push_back(measure([&]
+        {
+            for (size_t i = 0; i < sites.size(); i++)
+                decoded[i] = planned[i].plan(sites[i].first, JumpR32lInstructionLength);
+        }));
+
+        size_t relocatable = 0, branches = 0;
+        result.Relocate.push_back(measure([&]
+        {
+            for (size_t i = 0; i < sites.size(); i++)
+            {
+                if (!decoded[i])
+                    continue;
+                try
+                {
+                    auto const bytes = planned[i].relocate(sites[i].first, reinterpret_cast<Address>(sites[i].second), reinterpret_cast<Address>(Target));
+                    relocatable += bytes.size() == planned[i].Size;
+                    branches    += planned[i].Branches;
+                }
+                catch (invalid_jump_offset_error const&)
+                {
+                }
+            }
+        }));
+        result.Sites       = sites.size();
+        result.Relocatable = relocatable;
+        result.Branches    = branches;
+    }
+    return result;
+}
+
+bool parse_arguments(int argc, char** argv, Options& options)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        string const arg   = argv[i];
+        auto const   value = [&arg](const char* prefix, string& out)
+        {
+            if (arg.rfind(prefix, 0) != 0)
+                return false;
+            out = arg.substr(strlen(prefix));
+            return true;
+        };
+
+        string text;
+        if (value("-file=", text))
+            options.File = text;
+        else if (value("-hooks=", text))
+            options.Hooks = (std::max)(std::stoul(text), 1ul);
+        else if (value("-sites=", text))
+            options.Sites = std::stoul(text);
+        else if (value("-repeat=", text))
+            options.Repeat = (std::max)(std::stoul(text), 1ul);
+        else if (value("-seed=", text))
+            options.Seed = std::stoul(text);
+        else if (value("-out=", text))
+            options.OutputFile = text;
+        else
+            return false;
+    }
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    try
+    {
+        if (!parse_arguments(argc, argv, options))
+        {
+            std::cerr << "Usage: decoder_bench [-file=gamemd.exe | -hooks=100000] [-sites=100000] [-repeat=5] [-seed=1] [-out=" << BenchmarkFileName << "]\n";
+            return EXIT_FAILURE;
+        }
+    }
+    catch (const std::exception&)
+    {
+        std::cerr << "Invalid number in arguments.\n";
+        return EXIT_FAILURE;
+    }
+
+    Corpus corpus;
+    Result r;
+    try
+    {
+        corpus = options.File.empty() ? generate(options) : load_file(options.File);
+        r = run(corpus, options);
+    }
+    catch (const std::exception& ex)
+    {
+        std::cerr << ex.what() << ".\n";
+        return EXIT_FAILURE;
+    }
+
+    bool const   header = !std::filesystem::exists(options.OutputFile) || std::filesystem::file_size(options.OutputFile) == 0;
+    std::ofstream file(options.OutputFile, std::ios::app);
+    if (!file)
+    {
+        std::cerr << "Unable to write benchmark results \"" << options.OutputFile << "\".\n";
+        return EXIT_FAILURE;
+    }
+    if (header)
+        file << "time\tcorpus\tbytes\tinstructions\tunknown_bytes\tsites\trelocatable\tbranches\trepeat\tdecode_ms\tdecode_mibs\tplan_ms\trelocate_ms\n";
+
+    size_t const bytes    = corpus.bytes();
+    double const decode   = median(r.Decode);
+    double const plan     = median(r.Plan);
+    double const relocate = median(r.Relocate);
+    double const mibs     = bytes / (1024.0 * 1024.0) / (decode / 1000.0);
+    std::cout << fmt::format("Corpus \"{0}\": {1} bytes, {2} instructions, {3} unknown bytes.\n", corpus.Name, bytes, r.Instructions, r.Unknown);
+    std::cout << fmt::format("Decode: {0:.3f} ms ({1:.1f} MiB/s, {2:.1f} ns per instruction).\n", decode, mibs, decode * 1000000.0 / (std::max)(r.Instructions, size_t(1)));
+    std::cout << fmt::format("Sites: {0}, relocatable {1}, relative operands {2}; plan {3:.3f} ms, relocate {4:.3f} ms ({5:.1f} ns per site).\n",
+        r.Sites, r.Relocatable, r.Branches, plan, relocate, (plan + relocate) * 1000000.0 / (std::max)(r.Sites, size_t(1)));
+    file << fmt::format("{0}\t{1}\t{2}\t{3}\t{4}\t{5}\t{6}\t{7}\t{8}\t{9:.3f}\t{10:.1f}\t{11:.3f}\t{12:.3f}\n",
+        static_cast<long long>(std::time(nullptr)), corpus.Name, bytes, r.Instructions, r.Unknown, r.Sites, r.Relocatable, r.Branches,
+        options.Repeat, decode, mibs, plan, relocate);
+    std::cout << "Results appended to \"" << options.OutputFile << "\" (median of " << options.Repeat << " runs).\n";
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,104 @@
+#include <fstream>
+#include <iostream>
+
+#include "synthetic_module.hpp"
+
+using namespace Injector;
+
+/*!
+* @brief Writes synthetic hook DLL (see SyntheticModule) with its host executable & target module into directory.
+* @brief Same arguments & seed give the same files.
+*/
+static const char* const Usage =
+    "Usage: hookgen <directory> [-hooks=N] [-generic=N] [-extended=N] [-lean=N] [-facadesByName=N] [-facadesAtAddress=N]\n"
+    "               [-hosts=N] [-exports=N] [-names=prefixed|random] [-nameLength=MIN:MAX] [-shared=SHARE] [-sharedFunctions=SHARE]\n"
+    "               [-overlaps=SHARE] [-conflicts=SHARE] [-pocketRedefines=SHARE] [-seed=N] [-name=synthetic] [-host=gamemd] [-target=target]\n"
+    "  -hooks spreads N hooks over kinds like real builds, counts of kinds override it.\n";
+
+bool write_file(std::filesystem::path const& fileName, vector<BYTE> const& data)
+{
+    std::ofstream file(fileName, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char*>(data.data()), data.size());
+    if (!file)
+    {
+        std::cerr << "Unable to write \"" << fileName.string() << "\".\n";
+        return false;
+    }
+    std::cout << fileName.string() << " (" << data.size() << " bytes)\n";
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        std::cerr << Usage;
+        return EXIT_FAILURE;
+    }
+
+    std::filesystem::path const directory = argv[1];
+    SyntheticModuleSpec spec = SyntheticModuleSpec::Scaled(1000);
+    try
+    {
+        // -hooks goes first, explicit counts of kinds are applied over it
+        for (int i = 2; i < argc; i++)
+            if (string(argv[i]).rfind("-hooks=", 0) == 0)
+                spec = SyntheticModuleSpec::Scaled(std::stoul(argv[i] + strlen("-hooks=")));
+
+        for (int i = 2; i < argc; i++)
+        {
+            string const arg   = argv[i];
+            auto const   eq    = arg.find('=');
+            string const key   = arg.substr(0, eq);
+            string const value = eq == string::npos ? "" : arg.substr(eq + 1);
+
+            if (key == "-hooks")                 continue;
+            else if (key == "-generic")          spec.GenericHooks      = std::stoul(value);
+            else if (key == "-extended")         spec.ExtendedHooks     = std::stoul(value);
+            else if (key == "-lean")             spec.LeanHooks         = std::stoul(value);
+            else if (key == "-facadesByName")    spec.FacadesByName     = std::stoul(value);
+            else if (key == "-facadesAtAddress") spec.FacadesAtAddress  = std::stoul(value);
+            else if (key == "-hosts")            spec.Hosts             = std::stoul(value);
+            else if (key == "-exports")          spec.ExtraExports      = std::stoul(value);
+            else if (key == "-shared")           spec.SharedPlacements  = std::stod(value);
+            else if (key == "-sharedFunctions")  spec.SharedFunctions   = std::stod(value);
+            else if (key == "-overlaps")         spec.PartialOverlaps   = std::stod(value);
+            else if (key == "-conflicts")        spec.RedefineConflicts = std::stod(value);
+            else if (key == "-pocketRedefines")  spec.PocketRedefines   = std::stod(value);
+            else if (key == "-seed")             spec.Seed              = std::stoul(value);
+            else if (key == "-name")             spec.Name              = value;
+            else if (key == "-host")             spec.HostName          = value;
+            else if (key == "-target")           spec.TargetName        = value;
+            else if (key == "-names" && (value == "prefixed" || value == "random"))
+                spec.Names = value == "prefixed" ? SyntheticNames::Prefixed : SyntheticNames::Random;
+            else if (key == "-nameLength" && value.find(':') != string::npos)
+            {
+                spec.MinNameLength = std::stoul(value.substr(0, value.find(':')));
+                spec.MaxNameLength = std::stoul(value.substr(value.find(':') + 1));
+            }
+            else
+            {
+                std::cerr << "Unknown argument \"" << arg << "\".\n" << Usage;
+                return EXIT_FAILURE;
+            }
+        }
+    }
+    catch (const std::exception&)
+    {
+        std::cerr << "Invalid number in arguments.\n" << Usage;
+        return EXIT_FAILURE;
+    }
+
+    SyntheticModule const synthetic(spec);
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+    if (!write_file(directory / synthetic.FileName(), synthetic.Image()) ||
+        !write_file(directory / synthetic.HostFileName(), synthetic.HostImage()) ||
+        !write_file(directory / synthetic.TargetFileName(), synthetic.TargetImage()))
+        return EXIT_FAILURE;
+
+    std::cout << spec.Hooks() << " hooks (" << spec.GenericHooks << " generic, " << spec.ExtendedHooks << " extended, "
+        << spec.LeanHooks << " lean, " << spec.FacadesByName << " facades by name, " << spec.FacadesAtAddress << " facades at address), "
+        << synthetic.Exports.size() << " exports, seed " << spec.Seed << ".\n";
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,27 @@
+#ifndef BENCH_MEASURE_HPP
+#define BENCH_MEASURE_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <vector>
+
+// Milliseconds taken by action
+template<typename TAction>
+double measure(TAction&& action)
+{
+    auto const start = std::chrono::steady_clock::now();
+    action();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Median of repeats, nan if there are none
+inline double median(std::vector<double> values)
+{
+    if (values.empty())
+        return std::nan("");
+    std::sort(values.begin(), values.end());
+    size_t const middle = values.size() / 2;
+    return values.size() % 2 ? values[middle] : (values[middle - 1] + values[middle]) / 2;
+}
+#endif //BENCH_MEASURE_HPP
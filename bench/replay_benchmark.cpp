@@ -0,0 +1,131 @@
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+#include <event_recorder.hpp>
+#include <event_replay.hpp>
+
+#include "framework.hpp"
+#include "measure.hpp"
+
+using namespace Injector;
+
+static constexpr const char* BenchmarkFileName = "syringe.replay.tsv";
+
+/*!
+* @brief Replays event log of session recorded by `syringe -record` (see EventReplay) against SimulatedProcess, on any platform.
+* @brief Debug events are raised to counting handlers, memory operations go through ProcessMemory, reads are checked against
+* @brief replayed memory. Median time of repeats is reported with counts of replay, appended to TSV file like syringe_bench does.
+*/
+struct Options
+{
+    string Log        = EventLogFileName;
+    size_t Repeat     = 5;
+    string OutputFile = BenchmarkFileName;
+};
+
+bool parse_arguments(int argc, char** argv, Options& options)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        string const arg   = argv[i];
+        auto const   value = [&arg](const char* prefix, string& out)
+        {
+            if (arg.rfind(prefix, 0) != 0)
+                return false;
+            out = arg.substr(strlen(prefix));
+            return true;
+        };
+
+        string text;
+        if (value("-log=", text))
+            options.Log = text;
+        else if (value("-repeat=", text))
+            options.Repeat = (std::max)(std::stoul(text), 1ul);
+        else if (value("-out=", text))
+            options.OutputFile = text;
+        else
+            return false;
+    }
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    try
+    {
+        if (!parse_arguments(argc, argv, options))
+        {
+            std::cerr << "Usage: replay_bench [-log=" << EventLogFileName << "] [-repeat=5] [-out=" << BenchmarkFileName << "]\n";
+            return EXIT_FAILURE;
+        }
+    }
+    catch (const std::exception&)
+    {
+        std::cerr << "Invalid number in arguments.\n";
+        return EXIT_FAILURE;
+    }
+
+    EventLogReader log;
+    if (!log.Open(options.Log))
+    {
+        std::cerr << "Unable to read event log \"" << options.Log << "\" (record it by syringe -record).\n";
+        return EXIT_FAILURE;
+    }
+
+    vector<double>               times;
+    EventReplay::Statistics      stats;
+    SimulatedProcess::Statistics process;
+    size_t                       handled = 0;
+    for (size_t repeat = 0; repeat < options.Repeat; repeat++)
+    {
+        log.Rewind();
+        EventReplay replay;
+        handled = 0;
+        auto const count = [&handled](DebugEventRecord const&) { handled++; };
+        auto const named = [&handled](DebugEventRecord const&, std::string_view const&) { handled++; };
+        replay.OnProcessCreated  = count;
+        replay.OnThreadAdded     = count;
+        replay.OnThreadRemoved   = count;
+        replay.OnBreakpoint      = count;
+        replay.OnSingleStep      = count;
+        replay.OnAccessViolation = count;
+        replay.OnDllLoaded       = named;
+        replay.OnDllUnloaded     = count;
+        replay.OnDebugString     = named;
+        replay.OnProcessExited   = count;
+
+        times.push_back(measure([&] { replay.Run(log); }));
+        stats   = replay.Stats;
+        process = replay.Process.Stats;
+    }
+
+    size_t events = 0;
+    for (size_t count : stats.Events)
+        events += count;
+    double const ms = median(times);
+    std::cout << fmt::format("Event log \"{0}\": {1} bytes, {2} records, {3} debug events ({4} raised to handlers).\n",
+        options.Log, log.Size(), stats.Records, events, handled);
+    std::cout << fmt::format("Reads {0} ({1} bytes, {2} answered by replayed memory), writes {3} ({4} bytes, {5} into unmapped memory), "
+        "allocations {6} ({7} failed, peak {8} bytes), contexts {9}.\n",
+        stats.Reads, stats.ReadBytes, stats.MatchingReads, stats.Writes, stats.WrittenBytes, stats.UnmappedWrites,
+        stats.Allocations, stats.FailedAllocations, process.PeakBytes, stats.Contexts);
+    std::cout << fmt::format("Replay: {0:.3f} ms ({1:.0f} records/s), median of {2} runs.\n", ms, stats.Records / (ms / 1000.0), options.Repeat);
+
+    bool const   header = !std::filesystem::exists(options.OutputFile) || std::filesystem::file_size(options.OutputFile) == 0;
+    std::ofstream file(options.OutputFile, std::ios::app);
+    if (!file)
+    {
+        std::cerr << "Unable to write benchmark results \"" << options.OutputFile << "\".\n";
+        return EXIT_FAILURE;
+    }
+    if (header)
+        file << "time\tlog\tbytes\trecords\tevents\treads\tmatching_reads\twrites\tallocations\tpeak_bytes\trepeat\treplay_ms\n";
+    file << fmt::format("{0}\t{1}\t{2}\t{3}\t{4}\t{5}\t{6}\t{7}\t{8}\t{9}\t{10}\t{11:.3f}\n",
+        static_cast<long long>(std::time(nullptr)), options.Log, log.Size(), stats.Records, events, stats.Reads, stats.MatchingReads,
+        stats.Writes, stats.Allocations, process.PeakBytes, options.Repeat, ms);
+    std::cout << "Results appended to \"" << options.OutputFile << "\".\n";
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,680 @@
+#include <algorithm>
+#include <iterator>
+#include <random>
+
+#include "synthetic_module.hpp"
+#include "x86_decoder.hpp"
+
+namespace Injector
+{
+    namespace
+    {
+        static constexpr DWORD SectionAlignment = 0x1000;
+        static constexpr DWORD FileAlignment    = 0x200;
+        static constexpr DWORD HeadersSize      = 0x400;
+
+        static constexpr DWORD CodeSection      = 0x60000020; // code, execute, read
+        static constexpr DWORD ReadOnlySection  = 0x40000040; // initialized data, read
+        static constexpr DWORD DataSection      = 0xC0000040; // initialized data, read, write
+        static constexpr DWORD RelocSection     = 0x42000040; // initialized data, discardable, read
+
+        static constexpr size_t ExportDirectory     = 0;
+        static constexpr size_t RelocationDirectory = 5;
+
+        // export ordinals are WORD
+        static constexpr size_t MaxExports = 0xFFFF;
+
+        // xor eax, eax; ret - hook returns 0, overridden instructions are executed
+        BYTE const FunctionStubData[] = { 0x33, 0xC0, 0xC3 };
+        static constexpr DWORD FunctionStubSize = 0x10;
+
+        static constexpr DWORD align_up(DWORD value, DWORD alignment) { return (value + alignment - 1) & ~(alignment - 1); }
+
+        template<typename T>
+        void put(vector<BYTE>& bytes, size_t offset, T const& value)
+        {
+            memcpy(bytes.data() + offset, &value, sizeof(T));
+        }
+        template<typename T>
+        void append(vector<BYTE>& bytes, T const& value)
+        {
+            bytes.resize(bytes.size() + sizeof(T));
+            put(bytes, bytes.size() - sizeof(T), value);
+        }
+        size_t append(vector<BYTE>& bytes, string const& str)
+        {
+            size_t const offset = bytes.size();
+            bytes.insert(bytes.end(), str.cbegin(), str.cend());
+            bytes.push_back(0);
+            return offset;
+        }
+        // Declaration with zero padding, as compiler emits it into section
+        template<typename TDecl>
+        TDecl zeroed()
+        {
+            TDecl decl;
+            memset(&decl, 0, sizeof(decl));
+            return decl;
+        }
+
+        /*!
+        * @brief PE32 image of sections laid out in order of adding, RVA of section is known as soon as it's added
+        * @brief (code & data which point into image are made section by section).
+        */
+        class ImageBuilder
+        {
+            struct Section
+            {
+                string       Name;
+                vector<BYTE> Data;
+                DWORD        Rva;
+                DWORD        Characteristics;
+            };
+
+            DWORD           _imageBase;
+            bool            _dll;
+            vector<Section> _sections;
+            DWORD           _entryPoint = 0;
+            DWORD           _directories[16][2] {};
+        public:
+            ImageBuilder(DWORD imageBase, bool dll) : _imageBase(imageBase), _dll(dll) { }
+
+            DWORD NextRva() const
+            {
+                if (_sections.empty())
+                    return SectionAlignment;
+                auto const& last = _sections.back();
+                return align_up(last.Rva + (std::max)(static_cast<DWORD>(last.Data.size()), DWORD(1)), SectionAlignment);
+            }
+            DWORD Add(string const& name, vector<BYTE> data, DWORD characteristics)
+            {
+                DWORD const rva = NextRva();
+                _sections.push_back({ name, std::move(data), rva, characteristics });
+                return rva;
+            }
+            void SetEntryPoint(DWORD rva) { _entryPoint = rva; }
+            void SetDirectory(size_t index, DWORD rva, DWORD size)
+            {
+                _directories[index][0] = rva;
+                _directories[index][1] = size;
+            }
+
+            vector<BYTE> Build() const
+            {
+                size_t fileSize = HeadersSize;
+                for (auto const& section : _sections)
+                    fileSize += align_up(static_cast<DWORD>(section.Data.size()), FileAlignment);
+                vector<BYTE> image(fileSize);
+
+                size_t const pe = 0x40;
+                put<WORD>(image, 0x00, 0x5A4D);                       // "MZ"
+                put<DWORD>(image, 0x3C, static_cast<DWORD>(pe));      // e_lfanew
+                put<DWORD>(image, pe, 0x00004550);                    // "PE\0\0"
+
+                size_t const file = pe + 4;
+                put<WORD>(image, file + 0,  0x014C);                  // i386
+                put<WORD>(image, file + 2,  static_cast<WORD>(_sections.size()));
+                put<WORD>(image, file + 16, 0x00E0);                  // size of optional header
+                // executable image of 32 bit machine: DLL or executable without relocations
+                put<WORD>(image, file + 18, static_cast<WORD>(_dll ? 0x2102 : 0x0103));
+
+                DWORD codeSize = 0, dataSize = 0, baseOfCode = 0, baseOfData = 0;
+                for (auto const& section : _sections)
+                {
+                    DWORD const size = align_up(static_cast<DWORD>(section.Data.size()), FileAlignment);
+                    bool  const code = section.Characteristics & 0x20;
+                    (code ? codeSize : dataSize) += size;
+                    DWORD& base = code ? baseOfCode : baseOfData;
+                    if (!base)
+                        base = section.Rva;
+                }
+
+                size_t const optional = file + 20;
+                put<WORD>(image,  optional + 0,  0x010B);             // PE32
+                put<BYTE>(image,  optional + 2,  14);                 // linker version
+                put<DWORD>(image, optional + 4,  codeSize);
+                put<DWORD>(image, optional + 8,  dataSize);
+                put<DWORD>(image, optional + 16, _entryPoint);
+                put<DWORD>(image, optional + 20, baseOfCode);
+                put<DWORD>(image, optional + 24, baseOfData);
+                put<DWORD>(image, optional + 28, _imageBase);
+                put<DWORD>(image, optional + 32, SectionAlignment);
+                put<DWORD>(image, optional + 36, FileAlignment);
+                put<WORD>(image,  optional + 40, 6);                  // operating system version
+                put<WORD>(image,  optional + 48, 6);                  // subsystem version
+                put<DWORD>(image, optional + 56, NextRva());          // size of image
+                put<DWORD>(image, optional + 60, HeadersSize);
+                put<WORD>(image,  optional + 68, 2);                  // windows GUI
+                put<WORD>(image,  optional + 70, static_cast<WORD>(_dll ? 0x0140 : 0x0100)); // NX compatible, DLL is relocatable
+                put<DWORD>(image, optional + 72, 0x100000);           // stack reserve & commit
+                put<DWORD>(image, optional + 76, 0x1000);
+                put<DWORD>(image, optional + 80, 0x100000);           // heap reserve & commit
+                put<DWORD>(image, optional + 84, 0x1000);
+                put<DWORD>(image, optional + 92, 16);                 // data directories
+                for (size_t i = 0; i < 16; i++)
+                {
+                    put<DWORD>(image, optional + 96 + i * 8,     _directories[i][0]);
+                    put<DWORD>(image, optional + 96 + i * 8 + 4, _directories[i][1]);
+                }
+
+                size_t header = optional + 0xE0;
+                size_t raw    = HeadersSize;
+                for (auto const& section : _sections)
+                {
+                    DWORD const rawSize = align_up(static_cast<DWORD>(section.Data.size()), FileAlignment);
+                    memcpy(image.data() + header, section.Name.data(), (std::min)(section.Name.size(), size_t(8)));
+                    put<DWORD>(image, header + 8,  static_cast<DWORD>(section.Data.size()));
+                    put<DWORD>(image, header + 12, section.Rva);
+                    put<DWORD>(image, header + 16, rawSize);
+                    put<DWORD>(image, header + 20, static_cast<DWORD>(raw));
+                    put<DWORD>(image, header + 36, section.Characteristics);
+                    if (!section.Data.empty())
+                        memcpy(image.data() + raw, section.Data.data(), section.Data.size());
+
+                    header += 40;
+                    raw    += rawSize;
+                }
+                return image;
+            }
+        };
+
+        // Appends export directory, tables & names to section at rva. Returns RVA & size of the directory.
+        std::pair<DWORD, DWORD> append_exports(vector<BYTE>& section, DWORD sectionRva, string const& moduleName, map<string, DWORD> const& exports)
+        {
+            // names are sorted as loader looks them up by binary search, ordinal of function is its index
+            DWORD  const count     = static_cast<DWORD>(exports.size());
+            size_t const directory = align_up(static_cast<DWORD>(section.size()), 4);
+            size_t const functions = directory + 40;
+            size_t const names     = functions + sizeof(DWORD) * count;
+            size_t const ordinals  = names + sizeof(DWORD) * count;
+            section.resize(ordinals + sizeof(WORD) * count);
+
+            auto const rva = [sectionRva](size_t offset) { return static_cast<DWORD>(sectionRva + offset); };
+            put<DWORD>(section, directory + 12, rva(append(section, moduleName)));
+            put<DWORD>(section, directory + 16, 1);               // ordinal base
+            put<DWORD>(section, directory + 20, count);
+            put<DWORD>(section, directory + 24, count);
+            put<DWORD>(section, directory + 28, rva(functions));
+            put<DWORD>(section, directory + 32, rva(names));
+            put<DWORD>(section, directory + 36, rva(ordinals));
+
+            DWORD index = 0;
+            for (auto const& [name, function] : exports)
+            {
+                put<DWORD>(section, functions + sizeof(DWORD) * index, function);
+                put<DWORD>(section, names + sizeof(DWORD) * index, rva(append(section, name)));
+                put<WORD>(section, ordinals + sizeof(WORD) * index, static_cast<WORD>(index));
+                index++;
+            }
+            return { rva(directory), static_cast<DWORD>(section.size() - directory) };
+        }
+
+        // Instruction of synthetic code, relative operand (if any) is randomized
+        struct CodeTemplate
+        {
+            vector<BYTE> Bytes;
+            size_t       RelativeOffset;
+            size_t       RelativeSize;
+        };
+        // typical instructions of game code, all of them are known to x86 decoder
+        static CodeTemplate const CodeTemplates[] =
+        {
+            { { 0x55 },                                                       0, 0 }, // push ebp
+            { { 0x8B, 0xEC },                                                 0, 0 }, // mov ebp, esp
+            { { 0x83, 0xEC, 0x10 },                                           0, 0 }, // sub esp, 10h
+            { { 0x8B, 0x4C, 0x24, 0x04 },                                     0, 0 }, // mov ecx, [esp+4]
+            { { 0x0F, 0xB6, 0x44, 0x24, 0x08 },                               0, 0 }, // movzx eax, byte ptr [esp+8]
+            { { 0xA1, 0x00, 0x10, 0x80, 0x00 },                               0, 0 }, // mov eax, [00801000h]
+            { { 0x81, 0xEC, 0x00, 0x01, 0x00, 0x00 },                         0, 0 }, // sub esp, 100h
+            { { 0x8B, 0x04, 0x85, 0x00, 0x10, 0x80, 0x00 },                   0, 0 }, // mov eax, [eax*4+00801000h]
+            { { 0xC7, 0x05, 0x00, 0x10, 0x80, 0x00, 0x01, 0x00, 0x00, 0x00 }, 0, 0 }, // mov dword ptr [00801000h], 1
+            { { 0xE8, 0x00, 0x00, 0x00, 0x00 },                               1, 4 }, // call rel32
+            { { 0x0F, 0x84, 0x00, 0x00, 0x00, 0x00 },                         2, 4 }, // jz rel32
+            { { 0x74, 0x00 },                                                 1, 1 }, // jz rel8
+        };
+
+        struct CodeSite
+        {
+            DWORD  Offset      = 0;
+            size_t Size        = 0;
+            size_t FirstLength = 0;
+        };
+
+        class CodeWriter
+        {
+            std::mt19937& _random;
+        public:
+            vector<BYTE> Code;
+
+            explicit CodeWriter(std::mt19937& random) : _random(random) { }
+
+            size_t Instruction()
+            {
+                auto const& instruction = CodeTemplates[std::uniform_int_distribution<size_t>(0, std::size(CodeTemplates) - 1)(_random)];
+                size_t const offset = Code.size();
+                Code.insert(Code.end(), instruction.Bytes.cbegin(), instruction.Bytes.cend());
+                if (instruction.RelativeSize == sizeof(int32_t))
+                {
+                    int32_t const relative = std::uniform_int_distribution<int32_t>(-0x8000, 0x8000)(_random);
+                    memcpy(Code.data() + offset + instruction.RelativeOffset, &relative, sizeof(relative));
+                }
+                else if (instruction.RelativeSize == sizeof(int8_t))
+                    Code[offset + instruction.RelativeOffset] = static_cast<BYTE>(std::uniform_int_distribution<int>(-0x40, 0x40)(_random));
+                return instruction.Bytes.size();
+            }
+            // Few instructions of filler, then whole instructions which cover the jump
+            CodeSite Site()
+            {
+                for (int filler = std::uniform_int_distribution<int>(0, 3)(_random); filler > 0; filler--)
+                    Instruction();
+
+                CodeSite site;
+                site.Offset      = static_cast<DWORD>(Code.size());
+                site.FirstLength = Instruction();
+                site.Size        = site.FirstLength;
+                while (site.Size < JumpR32lInstructionLength)
+                    site.Size += Instruction();
+                return site;
+            }
+            // Original bytes of the last site are read with the longest instruction behind them
+            vector<BYTE> Finish()
+            {
+                Code.insert(Code.end(), MaxInstructionLength + 1, NOP);
+                return std::move(Code);
+            }
+        };
+
+        static const char* const ClassNames[] =
+        {
+            "TechnoClass", "BuildingClass", "UnitClass", "InfantryClass", "AircraftClass", "HouseClass", "BulletClass",
+            "WeaponTypeClass", "WarheadTypeClass", "SuperClass", "MapClass", "TacticalClass", "ScenarioClass", "RulesClass",
+        };
+        static const char* const MethodNames[] =
+        {
+            "AI", "Update", "Draw", "Fire", "ReceiveDamage", "Init", "Load", "Save", "Select", "CanEnterCell",
+            "GetFireError", "Limbo", "Unlimbo", "Mission_Attack", "Mission_Move", "DrawExtras", "GetActionOnObject",
+        };
+
+        class NameMaker
+        {
+            SyntheticModuleSpec const& _spec;
+            std::mt19937&              _random;
+            size_t                     _count = 0;
+
+            char character(bool first)
+            {
+                static constexpr char Characters[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz_0123456789";
+                // identifier doesn't start with digit
+                return Characters[std::uniform_int_distribution<size_t>(0, first ? 52 : sizeof(Characters) - 2)(_random)];
+            }
+        public:
+            NameMaker(SyntheticModuleSpec const& spec, std::mt19937& random) : _spec(spec), _random(random) { }
+
+            string Next()
+            {
+                string const suffix = fmt::format("_{0:X}", _count++);
+                size_t const length = std::uniform_int_distribution<size_t>(_spec.MinNameLength, (std::max)(_spec.MinNameLength, _spec.MaxNameLength))(_random);
+
+                string name;
+                if (_spec.Names == SyntheticNames::Prefixed)
+                {
+                    name  = ClassNames[std::uniform_int_distribution<size_t>(0, std::size(ClassNames) - 1)(_random)];
+                    name += "_";
+                    name += MethodNames[std::uniform_int_distribution<size_t>(0, std::size(MethodNames) - 1)(_random)];
+                }
+                while (name.size() + suffix.size() < length)
+                    name += character(name.empty());
+                return (name.empty() ? string(1, character(true)) : name) + suffix;
+            }
+        };
+    }
+
+    SyntheticModuleSpec SyntheticModuleSpec::Scaled(size_t hooks, uint32_t seed)
+    {
+        SyntheticModuleSpec spec;
+        spec.Seed             = seed;
+        spec.ExtendedHooks    = hooks * 5 / 100;
+        spec.LeanHooks        = hooks * 5 / 100;
+        spec.FacadesByName    = hooks / 100;
+        spec.FacadesAtAddress = hooks / 100;
+        spec.GenericHooks     = hooks - spec.ExtendedHooks - spec.LeanHooks - spec.FacadesByName - spec.FacadesAtAddress;
+        spec.ExtraExports     = hooks / 20;
+        spec.PocketRedefines  = 0.05;
+        return spec;
+    }
+
+    SyntheticModule::SyntheticModule(SyntheticModuleSpec const& spec) : Spec(spec)
+    {
+        std::mt19937 random(spec.Seed);
+        auto const chance = [&random](double share) { return share > 0.0 && std::uniform_real_distribution<double>(0.0, 1.0)(random) < share; };
+
+        NameMaker  names(spec, random);
+        CodeWriter host(random);
+        CodeWriter target(random);
+
+        // stubs of exported functions are laid out in .text by order of creation
+        DWORD nextFunction = CodeRva;
+        auto const exportFunction = [this, &nextFunction](string const& name)
+        {
+            Exports[name] = nextFunction;
+            nextFunction += FunctionStubSize;
+        };
+        size_t const functionLimit = MaxExports - (std::min)(spec.ExtraExports, MaxExports - 1);
+
+        vector<string> regularFunctions;
+        vector<string> leanFunctions;
+        auto const setFunction = [&](SyntheticHook& hook, bool lean)
+        {
+            auto& functions = lean ? leanFunctions : regularFunctions;
+            if (!functions.empty() && (Exports.size() >= functionLimit || chance(spec.SharedFunctions)))
+                hook.DeclaredName = functions[std::uniform_int_distribution<size_t>(0, functions.size() - 1)(random)];
+            else
+            {
+                hook.DeclaredName = names.Next();
+                functions.push_back(hook.DeclaredName);
+                // __fastcall function with two DWORD arguments is exported with decorated name
+                exportFunction(lean ? "@" + hook.DeclaredName + "@8" : hook.DeclaredName);
+            }
+            hook.FunctionName = lean ? "@" + hook.DeclaredName + "@8" : hook.DeclaredName;
+            hook.FunctionRva  = Exports[hook.FunctionName];
+        };
+
+        struct LastSite
+        {
+            bool     Valid = false;
+            DWORD    Address = 0;
+            CodeSite Site;
+        };
+        auto const place = [&](SyntheticHook& hook, CodeWriter& code, DWORD base, LastSite& last)
+        {
+            if (last.Valid && chance(spec.SharedPlacements))
+            {
+                hook.Address = last.Address;
+                hook.Size    = last.Site.Size;
+                return;
+            }
+            if (last.Valid && last.Site.FirstLength < last.Site.Size && chance(spec.PartialOverlaps))
+            {
+                hook.Address = last.Address + static_cast<DWORD>(last.Site.FirstLength);
+                hook.Size    = (std::max)(JumpR32lInstructionLength, last.Site.Size - last.Site.FirstLength);
+                return;
+            }
+            last.Site    = code.Site();
+            last.Address = base + CodeRva + last.Site.Offset;
+            last.Valid   = true;
+            hook.Address = last.Address;
+            hook.Size    = last.Site.Size;
+        };
+
+        // generic & lean hooks share pockets of host
+        Hooks.reserve(spec.Hooks());
+        LastSite lastHost;
+        for (size_t i = 0; i < spec.GenericHooks + spec.LeanHooks; i++)
+        {
+            bool const lean = i >= spec.GenericHooks;
+            SyntheticHook& hook = Hooks.emplace_back();
+            hook.Type = lean ? HookType::Lean : HookType::Generic;
+            setFunction(hook, lean);
+            place(hook, host, spec.HostBase, lastHost);
+            if (lean)
+            {
+                auto const reg = [&random](bool result)
+                {
+                    // result is never written into ESP
+                    static constexpr LeanHookRegister Registers[] = { LHR_None, LHR_EAX, LHR_ECX, LHR_EDX, LHR_EBX, LHR_EBP, LHR_ESI, LHR_EDI, LHR_ESP };
+                    return Registers[std::uniform_int_distribution<size_t>(0, std::size(Registers) - (result ? 2 : 1))(random)];
+                };
+                hook.Registers = LEAN_REGISTERS(reg(false), reg(false), reg(true), chance(0.5));
+            }
+        }
+
+        // extended hooks & facades are placed into target module by RVA
+        LastSite lastTarget;
+        for (size_t i = 0; i < spec.ExtendedHooks; i++)
+        {
+            SyntheticHook& hook = Hooks.emplace_back();
+            hook.Type = HookType::Extended;
+            setFunction(hook, false);
+            place(hook, target, 0, lastTarget);
+        }
+
+        DWORD lastFacade = 0;
+        for (size_t i = 0; i < spec.FacadesAtAddress; i++)
+        {
+            SyntheticHook& hook = Hooks.emplace_back();
+            hook.Type = HookType::FacadeAtAddress;
+            setFunction(hook, false);
+            if (lastTarget.Valid && chance(spec.PocketRedefines))
+                hook.Address = lastTarget.Address;
+            else
+                hook.Address = lastFacade && chance(spec.RedefineConflicts) ? lastFacade : CodeRva + target.Site().Offset;
+            lastFacade   = hook.Address;
+        }
+
+        string lastTargetFunction;
+        for (size_t i = 0; i < spec.FacadesByName; i++)
+        {
+            SyntheticHook& hook = Hooks.emplace_back();
+            hook.Type = HookType::FacadeByName;
+            setFunction(hook, false);
+            if (lastTargetFunction.empty() || !chance(spec.RedefineConflicts))
+            {
+                lastTargetFunction = names.Next();
+                TargetExports[lastTargetFunction] = lastTarget.Valid && chance(spec.PocketRedefines)
+                    ? lastTarget.Address
+                    : CodeRva + target.Site().Offset;
+            }
+            hook.PlacementFunction = lastTargetFunction;
+        }
+
+        for (size_t i = 0; i < spec.ExtraExports && Exports.size() < MaxExports; i++)
+            exportFunction(names.Next());
+
+        for (size_t i = 0; i < spec.Hosts; i++)
+            Hosts.push_back(i ? fmt::format("{0}_{1}", spec.HostName, i) : spec.HostName);
+
+        HostCode   = host.Finish();
+        TargetCode = target.Finish();
+    }
+
+    vector<BYTE> SyntheticModule::Image() const
+    {
+        ImageBuilder image(Spec.ImageBase, true);
+
+        vector<BYTE> text(Exports.size() * FunctionStubSize, 0xCC);
+        for (auto const& [name, rva] : Exports)
+            memcpy(text.data() + rva - CodeRva, FunctionStubData, sizeof(FunctionStubData));
+        image.Add(".text", std::move(text), CodeSection);
+
+        // names of declarations are pointers (VA at preferred base) into .rdata, equal names are merged
+        DWORD const  rdataRva = image.NextRva();
+        vector<BYTE> rdata;
+        map<string, DWORD> strings;
+        auto const va = [this, rdataRva, &rdata, &strings](string const& str) -> DWORD
+        {
+            auto it = strings.find(str);
+            if (it == strings.end())
+                it = strings.emplace(str, Spec.ImageBase + rdataRva + static_cast<DWORD>(append(rdata, str))).first;
+            return it->second;
+        };
+
+        vector<BYTE> generic, extended, lean, facadesByName, facadesAtAddress, hosts;
+        for (auto const& hook : Hooks)
+        {
+            switch (hook.Type)
+            {
+                case HookType::Generic:
+                {
+                    auto decl = zeroed<HookDecl>();
+                    decl.Address         = hook.Address;
+                    decl.Size            = hook.Size;
+                    decl.FunctionNamePtr = va(hook.DeclaredName);
+                    append(generic, decl);
+                } break;
+                case HookType::Extended:
+                {
+                    auto decl = zeroed<ExtendedHookDecl>();
+                    decl.Address         = hook.Address;
+                    decl.Size            = hook.Size;
+                    decl.FunctionNamePtr = va(hook.DeclaredName);
+                    decl.ModuleNamePtr   = va(TargetFileName());
+                    append(extended, decl);
+                } break;
+                case HookType::Lean:
+                {
+                    auto decl = zeroed<LeanHookDecl>();
+                    decl.Address         = hook.Address;
+                    decl.Size            = hook.Size;
+                    decl.FunctionNamePtr = va(hook.DeclaredName);
+                    decl.Registers       = hook.Registers;
+                    append(lean, decl);
+                } break;
+                case HookType::FacadeByName:
+                {
+                    auto decl = zeroed<FunctionReplacement0Decl>();
+                    decl.OriginalFunctionNamePtr = va(hook.PlacementFunction);
+                    decl.FunctionNamePtr         = va(hook.DeclaredName);
+                    decl.ModuleNamePtr           = va(TargetFileName());
+                    append(facadesByName, decl);
+                } break;
+                case HookType::FacadeAtAddress:
+                {
+                    auto decl = zeroed<FunctionReplacement1Decl>();
+                    decl.Address         = hook.Address;
+                    decl.FunctionNamePtr = va(hook.DeclaredName);
+                    decl.ModuleNamePtr   = va(TargetFileName());
+                    append(facadesAtAddress, decl);
+                } break;
+                default:
+                    break;
+            }
+        }
+        for (auto const& name : Hosts)
+        {
+            auto decl = zeroed<HostDecl>();
+            decl.NamePtr = va(name);
+            append(hosts, decl);
+        }
+
+        auto const [exportRva, exportSize] = append_exports(rdata, rdataRva, FileName(), Exports);
+        image.Add(".rdata", std::move(rdata), ReadOnlySection);
+        image.SetDirectory(ExportDirectory, exportRva, exportSize);
+
+        // sections are named & read as Module::parse does
+        std::pair<const char*, vector<BYTE>*> const sections[] =
+        {
+            { GenericHooksPESectionName,                  &generic },
+            { ExtendedHooksPESectionName,                 &extended },
+            { LeanHooksPESectionName,                     &lean },
+            { FunctionReplacementsByAddressPESectionName, &facadesByName },
+            { FunctionReplacementsByNamePESectionName,    &facadesAtAddress },
+            { HostsPESectionName,                         &hosts },
+        };
+        for (auto const& [name, data] : sections)
+            if (!data->empty())
+                image.Add(name, std::move(*data), DataSection);
+
+        // empty relocation block: DLL can be loaded at any base, nothing points into it at run time
+        vector<BYTE> relocations;
+        append<DWORD>(relocations, CodeRva);
+        append<DWORD>(relocations, 8);
+        DWORD const relocationsRva = image.Add(".reloc", std::move(relocations), RelocSection);
+        image.SetDirectory(RelocationDirectory, relocationsRva, 8);
+
+        return image.Build();
+    }
+
+    vector<BYTE> SyntheticModule::HostImage() const
+    {
+        ImageBuilder image(Spec.HostBase, false);
+        image.Add(".text", HostCode, CodeSection);
+        image.SetEntryPoint(CodeRva);
+        return image.Build();
+    }
+
+    vector<BYTE> SyntheticModule::TargetImage() const
+    {
+        ImageBuilder image(Spec.TargetBase, true);
+        image.Add(".text", TargetCode, CodeSection);
+
+        DWORD const  rdataRva = image.NextRva();
+        vector<BYTE> rdata;
+        auto const [exportRva, exportSize] = append_exports(rdata, rdataRva, TargetFileName(), TargetExports);
+        image.Add(".rdata", std::move(rdata), ReadOnlySection);
+        image.SetDirectory(ExportDirectory, exportRva, exportSize);
+
+        vector<BYTE> relocations;
+        append<DWORD>(relocations, CodeRva);
+        append<DWORD>(relocations, 8);
+        DWORD const relocationsRva = image.Add(".reloc", std::move(relocations), RelocSection);
+        image.SetDirectory(RelocationDirectory, relocationsRva, 8);
+
+        return image.Build();
+    }
+
+    list<Hook> SyntheticModule::MakeHooks() const
+    {
+        list<Hook> hooks;
+        for (auto const& synthetic : Hooks)
+        {
+            Hook::Variant decl;
+            switch (synthetic.Type)
+            {
+                case HookType::Generic:
+                {
+                    auto d = zeroed<HookDecl>();
+                    d.Address = synthetic.Address;
+                    d.Size    = synthetic.Size;
+                    decl = d;
+                } break;
+                case HookType::Extended:
+                {
+                    auto d = zeroed<ExtendedHookDecl>();
+                    d.Address = synthetic.Address;
+                    d.Size    = synthetic.Size;
+                    decl = d;
+                } break;
+                case HookType::Lean:
+                {
+                    auto d = zeroed<LeanHookDecl>();
+                    d.Address   = synthetic.Address;
+                    d.Size      = synthetic.Size;
+                    d.Registers = synthetic.Registers;
+                    decl = d;
+                } break;
+                case HookType::FacadeByName:
+                    decl = zeroed<FunctionReplacement0Decl>();
+                    break;
+                case HookType::FacadeAtAddress:
+                {
+                    auto d = zeroed<FunctionReplacement1Decl>();
+                    d.Address = synthetic.Address;
+                    decl = d;
+                } break;
+                default:
+                    continue;
+            }
+
+            Hook& hook       = hooks.emplace_back(synthetic.FunctionName, decl);
+            hook.Placement   = reinterpret_cast<Address>(synthetic.Address);
+            hook.Size        = synthetic.Type == HookType::FacadeByName || synthetic.Type == HookType::FacadeAtAddress ? 0 : synthetic.Size;
+            hook.Function    = reinterpret_cast<HookFunction>(Spec.ImageBase + synthetic.FunctionRva);
+            hook.FunctionRva = synthetic.FunctionRva;
+            if (synthetic.Type != HookType::Generic && synthetic.Type != HookType::Lean)
+                hook.ModuleName = TargetFileName();
+            hook.PlacementFunction = synthetic.PlacementFunction;
+        }
+        return hooks;
+    }
+
+    Address SyntheticModule::PlacementOf(Hook const& hook) const
+    {
+        if (hook.Type == HookType::FacadeByName)
+        {
+            auto const it = TargetExports.find(hook.PlacementFunction);
+            return it == TargetExports.cend() ? nullptr : reinterpret_cast<Address>(Spec.TargetBase + it->second);
+        }
+        DWORD const placement = reinterpret_cast<DWORD>(hook.Placement);
+        return reinterpret_cast<Address>(hook.ModuleName.empty() ? placement : Spec.TargetBase + placement);
+    }
+}
@@ -0,0 +1,120 @@
+#ifndef INJECTOR_SYNTHETIC_MODULE_HPP
+#define INJECTOR_SYNTHETIC_MODULE_HPP
+
+#include "framework.hpp"
+#include "hook.hpp"
+
+namespace Injector
+{
+    // How names of hook functions are made, each name ends with unique hex suffix
+    enum class SyntheticNames
+    {
+        // random identifiers, length is uniform in [MinNameLength, MaxNameLength]
+        Random,
+        // "TechnoClass_AI_1F" like in Ares & Phobos: few class & method names, so names share long prefixes
+        Prefixed,
+    };
+
+    /*!
+    * @brief Contents of synthetic hook DLL: count of declarations of each kind, exports, names and how hooks share placements.
+    * @brief Hooks are placed into code of synthetic host executable & target module (see SyntheticModule).
+    */
+    struct SyntheticModuleSpec
+    {
+        string         Name              = "synthetic";
+        string         HostName          = "gamemd";
+        string         TargetName        = "target";
+
+        size_t         GenericHooks      = 0;
+        size_t         ExtendedHooks     = 0;
+        size_t         LeanHooks         = 0;
+        size_t         FacadesByName     = 0;
+        size_t         FacadesAtAddress  = 0;
+        size_t         Hosts             = 1;
+        // exported functions which are not hooks
+        size_t         ExtraExports      = 0;
+
+        // share of hooks placed at address of previous hook (pocket of several functions)
+        double         SharedPlacements  = 0.1;
+        // share of hooks which call function of previous hook (one function hooked at several addresses)
+        double         SharedFunctions   = 0.05;
+        // share of hooks placed inside of instructions overridden by previous hook
+        double         PartialOverlaps   = 0.0;
+        // share of facades which redefine placement of previous facade
+        double         RedefineConflicts = 0.01;
+        // share of facades which redefine placement of previous extended hook (facade inside of pocket in target module)
+        double         PocketRedefines   = 0.0;
+
+        SyntheticNames Names             = SyntheticNames::Prefixed;
+        size_t         MinNameLength     = 8;
+        size_t         MaxNameLength     = 48;
+        uint32_t       Seed              = 1;
+
+        DWORD          ImageBase         = 0x10000000;
+        DWORD          HostBase          = 0x00400000;
+        DWORD          TargetBase        = 0x20000000;
+
+        size_t Hooks() const noexcept { return GenericHooks + ExtendedHooks + LeanHooks + FacadesByName + FacadesAtAddress; }
+
+        // Spreads count of hooks over kinds like real builds do: mostly generic hooks, few percents of the others
+        static SyntheticModuleSpec Scaled(size_t hooks, uint32_t seed = 1);
+    };
+
+    // Declaration of synthetic DLL, placement is known without the host
+    struct SyntheticHook
+    {
+        HookType Type = HookType::Unknown;
+        // name in declaration
+        string   DeclaredName;
+        // name of exported function (lean hook - decorated)
+        string   FunctionName;
+        DWORD    FunctionRva = 0;
+        // address in host executable or RVA in target module, 0 - facade by name
+        DWORD    Address = 0;
+        size_t   Size = 0;
+        DWORD    Registers = 0;
+        // facade by name - function exported by target module
+        string   PlacementFunction;
+    };
+
+    /*!
+    * @brief Synthetic hook DLL built by SyntheticModuleSpec, deterministic for the same spec & seed.
+    * @brief Images are PE32 files: hook DLL (declaration sections, names & exported hook functions), host executable
+    * @brief and target module (code the hooks are placed into, exports of facades by name). Code is made of instructions
+    * @brief which x86 decoder knows, every placement is at instruction boundary and its declared size covers whole instructions.
+    * @brief Hooks can be taken without the images (MakeHooks), so everything but Module::parse works without Windows.
+    */
+    class SyntheticModule final
+    {
+    public:
+        // .text of each image
+        static constexpr DWORD CodeRva = 0x1000;
+
+        SyntheticModuleSpec const Spec;
+        vector<SyntheticHook>     Hooks;
+        vector<string>            Hosts;
+        // exported functions of hook DLL (hook functions & extra exports) by name
+        map<string, DWORD>        Exports;
+        // exported functions of target module by name
+        map<string, DWORD>        TargetExports;
+        vector<BYTE>              HostCode;
+        vector<BYTE>              TargetCode;
+
+        explicit SyntheticModule(SyntheticModuleSpec const& spec);
+
+        vector<BYTE> Image() const;
+        vector<BYTE> HostImage() const;
+        vector<BYTE> TargetImage() const;
+
+        string FileName()       const { return Spec.Name + ".dll"; }
+        string HostFileName()   const { return Spec.HostName + ".exe"; }
+        string TargetFileName() const { return Spec.TargetName + ".dll"; }
+
+        // Hooks as Module::parse reads them from Image, with functions resolved at ImageBase. Name pointers of declarations are not set.
+        list<Hook> MakeHooks() const;
+        // Absolute placement of hook of this module (facade by name is resolved by target exports), nullptr if it can't be placed
+        Address PlacementOf(Hook const& hook) const;
+    };
+}
+
+#endif //INJECTOR_SYNTHETIC_MODULE_HPP
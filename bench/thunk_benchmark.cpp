@@ -0,0 +1,274 @@
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#ifndef _WIN32
+#include <sys/mman.h>
+#endif
+
+#include <process_backend.hpp>
+#include <process_memory.hpp>
+
+#include "hook_program.hpp"
+#include "measure.hpp"
+
+using namespace Injector;
+
+static constexpr const char* BenchmarkFileName = "syringe.thunks.tsv";
+
+/*!
+* @brief Cycles per call of hooked site for each way hook function is called: site without hook, lean hooks (see LeanHookCallCode)
+* @brief and regular hook through REGISTERS frame (RegistersBuildCode, HookCallCode, RegistersCleanupCode).
+* @brief HookProgram is planned, assembled & written into this process (LocalProcess), then sites are called directly,
+* @brief so measured code is the one written into game. Needs x86 (32 bit build, as injector core).
+*/
+struct Options
+{
+    size_t Calls      = 1000000;
+    size_t Repeat     = 7;
+    string OutputFile = BenchmarkFileName;
+};
+
+/*!
+* @brief ProcessBackend over memory of this process: allocations are executable, so assembled program can be run in place.
+*/
+class LocalProcess final : public ProcessBackend
+{
+    std::map<Address, size_t> _allocations;
+public:
+    ~LocalProcess() override
+    {
+        while (!_allocations.empty())
+            Free(_allocations.begin()->first);
+    }
+
+    bool Read(void const* address, void* buffer, size_t size, size_t* transferred = nullptr) override
+    {
+        memcpy(buffer, address, size);
+        if (transferred)
+            *transferred = size;
+        return true;
+    }
+    bool Write(void* address, void const* buffer, size_t size, size_t* transferred = nullptr) override
+    {
+        memcpy(address, buffer, size);
+        if (transferred)
+            *transferred = size;
+        return true;
+    }
+    // protection is ignored, memory is always executable & writable
+    Address Allocate(Address address, size_t size, DWORD protection) override
+    {
+#ifdef _WIN32
+        Address const result = VirtualAlloc(address, size, MEM_RESERVE | MEM_COMMIT, PAGE_EXECUTE_READWRITE);
+#else
+        Address result = mmap(address, size, PROT_READ | PROT_WRITE | PROT_EXEC, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (result == MAP_FAILED)
+            result = nullptr;
+        else if (address && result != address)
+        {
+            munmap(result, size);
+            result = nullptr;
+        }
+#endif
+        if (result)
+            _allocations.emplace(result, size);
+        return result;
+    }
+    bool Free(Address address) override
+    {
+        auto const it = _allocations.find(address);
+        if (it == _allocations.end())
+            return false;
+#ifdef _WIN32
+        VirtualFree(address, 0, MEM_RELEASE);
+#else
+        munmap(address, it->second);
+#endif
+        _allocations.erase(it);
+        return true;
+    }
+    bool Protect(Address address, size_t size, DWORD protection, DWORD* previous = nullptr) override
+    {
+        if (previous)
+            *previous = PAGE_EXECUTE_READWRITE;
+        return true;
+    }
+    DWORD LastError() const override { return 0; }
+};
+
+static volatile DWORD HookCalls = 0;
+
+static DWORD __cdecl RegistersHook(RegistersPtr)
+{
+    HookCalls = HookCalls + 1;
+    return 0;
+}
+static DWORD __fastcall LeanHook(DWORD a1, DWORD)
+{
+    HookCalls = HookCalls + 1;
+    return a1;
+}
+
+// MOV EAX, imm32 (overridden by hook); RET
+static constexpr BYTE SiteCode[] = { 0xB8, 0x78, 0x56, 0x34, 0x12, 0xC3 };
+static constexpr size_t SiteStride = 16;
+
+struct Variant
+{
+    const char* Name;
+    HookType    Type;
+    DWORD       Registers;
+};
+static constexpr Variant Variants[] =
+{
+    { "site",              HookType::Unknown, 0 },
+    { "lean",              HookType::Lean,    LEAN_REGISTERS(LHR_ECX, LHR_None, LHR_None, false) },
+    { "lean_flags_result", HookType::Lean,    LEAN_REGISTERS(LHR_ECX, LHR_EDX, LHR_EAX, true) },
+    { "registers",         HookType::Generic, 0 },
+};
+
+bool parse_arguments(int argc, char** argv, Options& options)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        string const arg   = argv[i];
+        auto const   value = [&arg](const char* prefix, string& out)
+        {
+            if (arg.rfind(prefix, 0) != 0)
+                return false;
+            out = arg.substr(strlen(prefix));
+            return true;
+        };
+
+        string text;
+        if (value("-calls=", text))
+            options.Calls = (std::max)(std::stoul(text), 1ul);
+        else if (value("-repeat=", text))
+            options.Repeat = (std::max)(std::stoul(text), 1ul);
+        else if (value("-out=", text))
+            options.OutputFile = text;
+        else
+            return false;
+    }
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    try
+    {
+        if (!parse_arguments(argc, argv, options))
+        {
+            std::cerr << "Usage: thunk_bench [-calls=1000000] [-repeat=7] [-out=" << BenchmarkFileName << "]\n";
+            return EXIT_FAILURE;
+        }
+    }
+    catch (const std::exception&)
+    {
+        std::cerr << "Invalid number in arguments.\n";
+        return EXIT_FAILURE;
+    }
+
+    // injector steps log every hook
+    spdlog::set_level(spdlog::level::warn);
+
+    LocalProcess  process;
+    ProcessMemory memory(process);
+    BYTE* const   sites = static_cast<BYTE*>(process.Allocate(nullptr, SiteStride * std::size(Variants), PAGE_EXECUTE_READWRITE));
+    if (!sites)
+    {
+        std::cerr << "Unable to allocate executable memory.\n";
+        return EXIT_FAILURE;
+    }
+    for (size_t i = 0; i < std::size(Variants); i++)
+        memcpy(sites + i * SiteStride, SiteCode, sizeof(SiteCode));
+
+    list<Hook> hooks;
+    HookProgram program(memory);
+    for (size_t i = 0; i < std::size(Variants); i++)
+    {
+        Variant const& variant = Variants[i];
+        BYTE* const    site    = sites + i * SiteStride;
+        Hook::Variant decl;
+        if (variant.Type == HookType::Lean)
+            decl = LeanHookDecl { reinterpret_cast<DWORD>(site), 5, 0, variant.Registers };
+        else if (variant.Type == HookType::Generic)
+            decl = HookDecl { reinterpret_cast<DWORD>(site), 5, 0 };
+        else
+            continue;
+
+        Hook& hook     = hooks.emplace_back(variant.Name, decl);
+        hook.Placement = site;
+        hook.Size      = 5;
+        hook.Function  = variant.Type == HookType::Lean ? reinterpret_cast<HookFunction>(&LeanHook) : &RegistersHook;
+        program.Add(hook, site);
+    }
+    program.Plan();
+    program.Allocate();
+    program.Assemble();
+    if (!program.Write())
+    {
+        std::cerr << "Unable to write hook sites.\n";
+        return EXIT_FAILURE;
+    }
+
+    bool const   header = !std::filesystem::exists(options.OutputFile) || std::filesystem::file_size(options.OutputFile) == 0;
+    std::ofstream file(options.OutputFile, std::ios::app);
+    if (!file)
+    {
+        std::cerr << "Unable to write benchmark results \"" << options.OutputFile << "\".\n";
+        return EXIT_FAILURE;
+    }
+    if (header)
+        file << "time\tvariant\tcalls\trepeat\tcycles\toverhead_cycles\tns\n";
+
+    std::cout << fmt::format("{0:>18} {1:>10} {2:>10} {3:>10}\n", "variant", "cycles", "overhead", "ns");
+    auto const now = static_cast<long long>(std::time(nullptr));
+    double     siteCycles = 0;
+    for (size_t i = 0; i < std::size(Variants); i++)
+    {
+        using Site = DWORD(__cdecl*)();
+        Site const site = reinterpret_cast<Site>(sites + i * SiteStride);
+
+        vector<double> cycles, ms;
+        for (size_t repeat = 0; repeat < options.Repeat; repeat++)
+        {
+            size_t wrong = 0;
+            HookCalls = 0;
+            unsigned long long const start = __rdtsc();
+            ms.push_back(measure([&]
+            {
+                // overridden instruction must still set result of site
+                for (size_t call = 0; call < options.Calls; call++)
+                    wrong += site() != 0x12345678;
+            }));
+            cycles.push_back(static_cast<double>(__rdtsc() - start) / options.Calls);
+
+            if (wrong || (Variants[i].Type != HookType::Unknown && HookCalls != options.Calls))
+            {
+                std::cerr << "Site " << Variants[i].Name << ": hook was called " << HookCalls << " times of " << options.Calls
+                    << ", " << wrong << " wrong results.\n";
+                return EXIT_FAILURE;
+            }
+        }
+
+        double const perCall = median(cycles);
+        double const ns      = median(ms) * 1000000.0 / options.Calls;
+        if (Variants[i].Type == HookType::Unknown)
+            siteCycles = perCall;
+        std::cout << fmt::format("{0:>18} {1:>10.1f} {2:>10.1f} {3:>10.2f}\n", Variants[i].Name, perCall, perCall - siteCycles, ns);
+        file << fmt::format("{0}\t{1}\t{2}\t{3}\t{4:.1f}\t{5:.1f}\t{6:.2f}\n",
+            now, Variants[i].Name, options.Calls, options.Repeat, perCall, perCall - siteCycles, ns);
+    }
+    std::cout << "Results appended to \"" << options.OutputFile << "\" (TSC cycles & ns per call, median of " << options.Repeat << " runs).\n";
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,357 @@
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <future>
+#include <thread>
+#include <vector>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define CRC32_TARGET_CLMUL
+#else
+#include <cpuid.h>
+#include <wmmintrin.h>
+#define CRC32_TARGET_CLMUL __attribute__((target("pclmul,sse2")))
+#endif
+
+#include "checksum.hpp"
+#include "mapped_file.hpp"
+
+namespace
+{
+    constexpr uint32_t Polynomial = 0xEDB88320u;
+
+    using SliceTable = std::array<std::array<uint32_t, 256>, 16>;
+
+    SliceTable make_slice_table()
+    {
+        SliceTable t {};
+        for (uint32_t i = 0; i < 256; i++)
+        {
+            uint32_t crc = i;
+            for (int bit = 0; bit < 8; bit++)
+                crc = (crc >> 1) ^ (Polynomial & (0u - (crc & 1u)));
+            t[0][i] = crc;
+        }
+        for (uint32_t i = 0; i < 256; i++)
+            for (size_t k = 1; k < t.size(); k++)
+                t[k][i] = (t[k - 1][i] >> 8) ^ t[0][t[k - 1][i] & 0xFF];
+        return t;
+    }
+    SliceTable const& slice_table()
+    {
+        static SliceTable const table = make_slice_table();
+        return table;
+    }
+
+    inline uint32_t load32(const uint8_t* p)
+    {
+        uint32_t value;
+        memcpy(&value, p, sizeof(value));
+        return value;
+    }
+
+    // state is inverted crc (as in the middle of computation)
+    uint32_t crc32_slice16(const uint8_t* p, size_t size, uint32_t state)
+    {
+        auto const& t = slice_table();
+
+        for (; size >= 16; p += 16, size -= 16)
+        {
+            uint32_t const a = load32(p) ^ state;
+            uint32_t const b = load32(p + 4);
+            uint32_t const c = load32(p + 8);
+            uint32_t const d = load32(p + 12);
+
+            state = t[15][a & 0xFF] ^ t[14][(a >> 8) & 0xFF] ^ t[13][(a >> 16) & 0xFF] ^ t[12][a >> 24]
+                  ^ t[11][b & 0xFF] ^ t[10][(b >> 8) & 0xFF] ^ t[ 9][(b >> 16) & 0xFF] ^ t[ 8][b >> 24]
+                  ^ t[ 7][c & 0xFF] ^ t[ 6][(c >> 8) & 0xFF] ^ t[ 5][(c >> 16) & 0xFF] ^ t[ 4][c >> 24]
+                  ^ t[ 3][d & 0xFF] ^ t[ 2][(d >> 8) & 0xFF] ^ t[ 1][(d >> 16) & 0xFF] ^ t[ 0][d >> 24];
+        }
+        for (; size; p++, size--)
+            state = (state >> 8) ^ t[0][(state ^ *p) & 0xFF];
+
+        return state;
+    }
+
+    // Folding by carry-less multiplication, see Intel "Fast CRC Computation for Generic Polynomials Using PCLMULQDQ Instruction".
+    // Constants are for bit-reflected domain. Requires size >= 64 and size % 16 == 0, state is inverted crc.
+    CRC32_TARGET_CLMUL uint32_t crc32_clmul(const uint8_t* p, size_t size, uint32_t state)
+    {
+        alignas(16) static const uint64_t k1k2[] = { 0x0154442bd4, 0x01c6e41596 };
+        alignas(16) static const uint64_t k3k4[] = { 0x01751997d0, 0x00ccaa009e };
+        alignas(16) static const uint64_t k5k0[] = { 0x0163cd6124, 0x0000000000 };
+        alignas(16) static const uint64_t poly[] = { 0x01db710641, 0x01f7011641 };
+
+        __m128i x0, x1, x2, x3, x4, x5, x6, x7, x8;
+
+        x1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 0x00));
+        x2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 0x10));
+        x3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 0x20));
+        x4 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 0x30));
+        x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128(static_cast<int>(state)));
+        x0 = _mm_load_si128(reinterpret_cast<const __m128i*>(k1k2));
+
+        p    += 64;
+        size -= 64;
+
+        // fold 4 lanes by 64 bytes
+        for (; size >= 64; p += 64, size -= 64)
+        {
+            x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+            x6 = _mm_clmulepi64_si128(x2, x0, 0x00);
+            x7 = _mm_clmulepi64_si128(x3, x0, 0x00);
+            x8 = _mm_clmulepi64_si128(x4, x0, 0x00);
+
+            x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+            x2 = _mm_clmulepi64_si128(x2, x0, 0x11);
+            x3 = _mm_clmulepi64_si128(x3, x0, 0x11);
+            x4 = _mm_clmulepi64_si128(x4, x0, 0x11);
+
+            x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 0x00)));
+            x2 = _mm_xor_si128(_mm_xor_si128(x2, x6), _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 0x10)));
+            x3 = _mm_xor_si128(_mm_xor_si128(x3, x7), _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 0x20)));
+            x4 = _mm_xor_si128(_mm_xor_si128(x4, x8), _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 0x30)));
+        }
+
+        // fold lanes into one 128-bit value
+        x0 = _mm_load_si128(reinterpret_cast<const __m128i*>(k3k4));
+
+        x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+        x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+
+        x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+        x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, x3), x5);
+
+        x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+        x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, x4), x5);
+
+        // fold remaining 16 byte blocks
+        for (; size >= 16; p += 16, size -= 16)
+        {
+            x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+            x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+            x1 = _mm_xor_si128(_mm_xor_si128(x1, _mm_loadu_si128(reinterpret_cast<const __m128i*>(p))), x5);
+        }
+
+        // 128 -> 64 bits
+        x2 = _mm_clmulepi64_si128(x1, x0, 0x10);
+        x3 = _mm_setr_epi32(~0, 0, ~0, 0);
+        x1 = _mm_srli_si128(x1, 8);
+        x1 = _mm_xor_si128(x1, x2);
+
+        x0 = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(k5k0));
+
+        x2 = _mm_srli_si128(x1, 4);
+        x1 = _mm_and_si128(x1, x3);
+        x1 = _mm_clmulepi64_si128(x1, x0, 0x00);
+        x1 = _mm_xor_si128(x1, x2);
+
+        // Barrett reduction to 32 bits
+        x0 = _mm_load_si128(reinterpret_cast<const __m128i*>(poly));
+
+        x2 = _mm_and_si128(x1, x3);
+        x2 = _mm_clmulepi64_si128(x2, x0, 0x10);
+        x2 = _mm_and_si128(x2, x3);
+        x2 = _mm_clmulepi64_si128(x2, x0, 0x00);
+        x1 = _mm_xor_si128(x1, x2);
+
+        return static_cast<uint32_t>(_mm_cvtsi128_si32(_mm_srli_si128(x1, 4)));
+    }
+
+    bool detect_clmul()
+    {
+#if defined(_MSC_VER)
+        int regs[4];
+        __cpuid(regs, 1);
+        return (regs[2] & (1 << 1)) && (regs[3] & (1 << 26)); // PCLMULQDQ & SSE2
+#else
+        unsigned int eax, ebx, ecx, edx;
+        return __get_cpuid(1, &eax, &ebx, &ecx, &edx) && (ecx & bit_PCLMUL) && (edx & bit_SSE2);
+#endif
+    }
+
+    // a * b modulo polynomial (bit-reflected)
+    uint32_t multiply_modp(uint32_t a, uint32_t b)
+    {
+        uint32_t m = 1u << 31;
+        uint32_t p = 0;
+        for (;;)
+        {
+            if (a & m)
+            {
+                p ^= b;
+                if ((a & (m - 1)) == 0)
+                    break;
+            }
+            m >>= 1;
+            b = b & 1 ? (b >> 1) ^ Polynomial : b >> 1;
+        }
+        return p;
+    }
+    // x^(n * 2^k) modulo polynomial
+    uint32_t x2n_modp(uint64_t n, unsigned int k)
+    {
+        static auto const powers = []()
+        {
+            std::array<uint32_t, 32> table {};
+            uint32_t p = 1u << 30; // x^1
+            table[0] = p;
+            for (size_t i = 1; i < table.size(); i++)
+                table[i] = p = multiply_modp(p, p);
+            return table;
+        }();
+
+        uint32_t p = 1u << 31; // x^0
+        for (; n; n >>= 1, k++)
+            if (n & 1)
+                p = multiply_modp(powers[k & 31], p);
+        return p;
+    }
+}
+
+bool Crc32::hardware_accelerated()
+{
+    static bool const supported = detect_clmul();
+    return supported;
+}
+unsigned int Crc32::compute(const void* data, size_t size, unsigned int crc)
+{
+    auto const* p = static_cast<const uint8_t*>(data);
+    uint32_t state = ~static_cast<uint32_t>(crc);
+
+    if (size >= 64 && hardware_accelerated())
+    {
+        size_t const folded = size & ~static_cast<size_t>(15);
+        state = crc32_clmul(p, folded, state);
+        p    += folded;
+        size -= folded;
+    }
+    return ~crc32_slice16(p, size, state);
+}
+unsigned int Crc32::combine(unsigned int crcA, unsigned int crcB, size_t sizeB)
+{
+    return multiply_modp(x2n_modp(sizeB, 3), crcA) ^ crcB;
+}
+unsigned int Crc32::compute_parallel(const void* data, size_t size, size_t threads)
+{
+    if (threads == 0)
+        threads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+
+    size_t const workers = std::min(threads, (size + ParallelChunkSize - 1) / ParallelChunkSize);
+    if (workers <= 1)
+        return compute(data, size);
+
+    auto const* p = static_cast<const uint8_t*>(data);
+    size_t const chunk = (size + workers - 1) / workers;
+
+    std::vector<std::future<unsigned int>> parts;
+    parts.reserve(workers);
+    for (size_t offset = 0; offset < size; offset += chunk)
+    {
+        size_t const length = std::min(chunk, size - offset);
+        parts.push_back(std::async(std::launch::async, [p, offset, length]() { return compute(p + offset, length); }));
+    }
+
+    unsigned int crc = 0;
+    size_t offset = 0;
+    for (auto& part : parts)
+    {
+        size_t const length = std::min(chunk, size - offset);
+        crc     = combine(crc, part.get(), length);
+        offset += length;
+    }
+    return crc;
+}
+unsigned int Crc32::compute_file(std::string const& fileName)
+{
+    MappedFile file { fileName };
+    return compute_parallel(file.data(), file.size());
+}
+
+ChecksumRegistry& ChecksumRegistry::instance()
+{
+    static ChecksumRegistry registry;
+    return registry;
+}
+std::string ChecksumRegistry::normalize(std::string_view const& fileName)
+{
+    std::error_code ec;
+    auto path = std::filesystem::absolute(std::filesystem::path(fileName), ec);
+    auto key  = (ec ? std::filesystem::path(fileName) : path).lexically_normal().string();
+
+    std::transform(key.begin(), key.end(), key.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return key;
+}
+unsigned int ChecksumRegistry::get(std::string_view const& fileName)
+{
+    auto const key = normalize(fileName);
+    {
+        std::lock_guard lock(_mutex);
+        if (auto it = _checksums.find(key); it != _checksums.end())
+        {
+            _hits++;
+            return it->second;
+        }
+        _misses++;
+    }
+
+    // hashing is done without lock, the same file requested concurrently may be hashed twice but result is the same
+    unsigned int checksum = 0;
+    FileIdentity identity;
+    auto* persistent = this->persistent();
+    if (persistent && FileIdentity::query(std::string(fileName), identity))
+    {
+        if (!persistent->find_checksum(key, identity, checksum))
+        {
+            checksum = Crc32::compute_file(std::string(fileName));
+            persistent->store_checksum(key, identity, checksum);
+        }
+    }
+    else checksum = Crc32::compute_file(std::string(fileName));
+
+    std::lock_guard lock(_mutex);
+    _checksums.emplace(key, checksum);
+    return checksum;
+}
+void ChecksumRegistry::clear()
+{
+    std::lock_guard lock(_mutex);
+    _checksums.clear();
+    _hits   = 0;
+    _misses = 0;
+}
+bool ChecksumRegistry::load_version(std::string_view const& fileName, Utilities::FileVersionInformation& fvi)
+{
+    auto const load = [&fileName, &fvi]
+    {
+        try { fvi.Load(std::string(fileName)); }
+        catch (const Utilities::FileVersionInformation::fvi_load_error&) { fvi.Loaded = false; }
+        return fvi.Loaded;
+    };
+
+    auto* persistent = this->persistent();
+    FileIdentity identity;
+    if (!persistent || !FileIdentity::query(std::string(fileName), identity))
+        return load();
+
+    auto const key = normalize(fileName);
+    std::string originalFilename;
+    bool        loaded = false;
+    if (persistent->find_version(key, identity, originalFilename, loaded))
+    {
+        fvi.OriginalFilename = originalFilename;
+        fvi.Loaded           = loaded;
+        return loaded;
+    }
+
+    loaded = load();
+    persistent->store_version(key, identity, loaded ? fvi.OriginalFilename : std::string(), loaded);
+    return loaded;
+}
@@ -0,0 +1,76 @@
+#ifndef DEBUGGER_CHECKSUM_HPP
+#define DEBUGGER_CHECKSUM_HPP
+
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include <winapi.utilities.hpp>
+
+#include "typedefs.hpp"
+#include "file_identity_cache.hpp"
+
+/*!
+* @brief CRC-32 (IEEE 802.3, reflected, same values as Utilities::CRC32) over memory blocks and whole files.
+* @brief Uses carry-less multiplication folding (PCLMULQDQ) when CPU supports it, otherwise slice-by-16 tables.
+* @brief Big files are split into chunks which are hashed in parallel, results are joined with combine().
+*/
+class Crc32 final
+{
+public:
+    // Chunk of file hashed by single worker, smaller files are hashed on calling thread
+    static constexpr size_t ParallelChunkSize = 4 * 1024 * 1024;
+
+    Crc32() = delete;
+
+    // Continues checksum `crc` (0 - empty data) over next block
+    static unsigned int compute(const void* data, size_t size, unsigned int crc = 0);
+    // Checksum of A+B from checksums of A and B, `sizeB` is size of B in bytes
+    static unsigned int combine(unsigned int crcA, unsigned int crcB, size_t sizeB);
+    // Same as compute() but splits block into chunks across worker threads (0 - hardware concurrency)
+    static unsigned int compute_parallel(const void* data, size_t size, size_t threads = 0);
+    // Maps file and computes checksum of whole content
+    static unsigned int compute_file(std::string const& fileName);
+
+    static bool hardware_accelerated();
+};
+
+/*!
+* @brief Per-run cache of file checksums, so each file is hashed once no matter how many components ask for it.
+* @brief Files are identified by normalized absolute path (case insensitive).
+* @brief When persistent cache is attached, it's queried by file identity before file is read.
+* @brief Thread-safe.
+*/
+class ChecksumRegistry final
+{
+    mutable std::mutex                            _mutex;
+    std::unordered_map<std::string, unsigned int> _checksums;
+    size_t                                        _hits   = 0;
+    size_t                                        _misses = 0;
+    FileIdentityCache*                            _persistent = nullptr;
+
+    ChecksumRegistry() = default;
+public:
+    ChecksumRegistry(ChecksumRegistry const&)            = delete;
+    ChecksumRegistry& operator=(ChecksumRegistry const&) = delete;
+
+    static ChecksumRegistry& instance();
+    static std::string normalize(std::string_view const& fileName);
+
+    // Cached checksum of file, computes it on first request
+    unsigned int get(std::string_view const& fileName);
+    void         clear();
+    // Loads version info of file, returns false if file has none. Original file name (or absence of version info)
+    // is taken from persistent cache when file is not changed.
+    bool         load_version(std::string_view const& fileName, Utilities::FileVersionInformation& fvi);
+
+    // Persistent cache must outlive registry usage, nullptr detaches it
+    void               attach(FileIdentityCache* cache) { std::lock_guard lock(_mutex); _persistent = cache; }
+    FileIdentityCache* persistent() const { std::lock_guard lock(_mutex); return _persistent; }
+
+    size_t hits()   const { std::lock_guard lock(_mutex); return _hits; }
+    size_t misses() const { std::lock_guard lock(_mutex); return _misses; }
+};
+
+#endif //DEBUGGER_CHECKSUM_HPP
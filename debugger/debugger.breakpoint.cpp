@@ -18,14 +18,22 @@ namespace Debugger
         OnReached(std::exchange(other.OnReached, { nullptr })),
         Addr(std::exchange(other.Addr, nullptr)),
         OpCode(std::exchange(other.OpCode, 0)),
-        IsWritten(std::exchange(other.IsWritten, false))
+        IsWritten(std::exchange(other.IsWritten, false)),
+        OneShot(other.OneShot),
+        Hardware(other.Hardware),
+        Slot(other.Slot),
+        Owner(other.Owner)
     {}
     DebugLoop::Breakpoint& DebugLoop::Breakpoint::operator=(DebugLoop::Breakpoint&& other) noexcept
     {
         OnReached = std::exchange(other.OnReached, { nullptr });
-        Addr = std::exchange(Addr, nullptr);
-        OpCode = std::exchange(OpCode, 0);
+        Addr = std::exchange(other.Addr, nullptr);
+        OpCode = std::exchange(other.OpCode, 0);
         IsWritten = std::exchange(other.IsWritten, false);
+        OneShot = other.OneShot;
+        Hardware = other.Hardware;
+        Slot = other.Slot;
+        Owner = other.Owner;
         return *this;
     }
 }
@@ -29,6 +29,10 @@ namespace Debugger
         OnDllUnloaded(this),
         OnThreadAdded(this),
         OnThreadRemoved(this),
+        OnDebugString(this),
+        OnProcessExited(this),
+        OnTick(this),
+        OnDetached(this),
         ExecutablePath(executablePath)
     {
         SetEnvironmentVariable("_NO_DEBUG_HEAP", "1");
@@ -59,20 +63,15 @@ namespace Debugger
 
     DllInfo& DebugLoop::Find(string_view const& dllBaseName)
     {
-        for (auto& pair : Dlls)
-        {
-            std::filesystem::path dllPath = pair.second.FileName;
-            if(dllBaseName == dllPath.filename())
-                return pair.second;
-        }
+        if (DllInfo* dll = Dlls.FindByFileName(dllBaseName))
+            return *dll;
         throw dll_not_found_error { dllBaseName };
     }
 
     void DebugLoop::SetBreakpoint(Address address)
     {
-        Breakpoint& bp = Breakpoints[address];
-        Memory.Write(bp.Addr, &INT3, sizeof(BYTE));
-        bp.IsWritten = true;
+        if (Breakpoint* bp = FindBreakpoint(address))
+            SetBreakpoint(*bp);
     }
     void DebugLoop::SetBreakpoint(Breakpoint& bp)
     {
@@ -81,9 +80,8 @@ namespace Debugger
     }
     void DebugLoop::RestoreBreakpoint(Address address)
     {
-        Breakpoint& bp = Breakpoints[address];
-        Memory.Write(bp.Addr, &bp.OpCode, sizeof(BYTE));
-        bp.IsWritten = false;
+        if (Breakpoint* bp = FindBreakpoint(address))
+            RestoreOpcode(*bp);
     }
     void DebugLoop::RestoreOpcode(Breakpoint& bp)
     {
@@ -92,24 +90,87 @@ namespace Debugger
     }
     DebugLoop::Breakpoint& DebugLoop::AddBreakpoint(Address address, bool write)
     {
-        Breakpoint& bp = Breakpoints.emplace(address, Breakpoint { address }).first->second;
-        Memory.Read(bp.Addr, &bp.OpCode, sizeof(BYTE));
+        Breakpoint& bp = *Breakpoints.emplace(address, std::make_unique<Breakpoint>(address)).first->second;
+        if(!bp.IsWritten)
+            Memory.Read(bp.Addr, &bp.OpCode, sizeof(BYTE));
         if(write)
             SetBreakpoint(bp);
         return bp;
     }
+    DebugLoop::Breakpoint& DebugLoop::AddOneShotBreakpoint(Address address)
+    {
+        Breakpoint& bp = AddBreakpoint(address, false);
+        bp.OneShot = true;
+        // INT3 of injected program is used as is
+        if(bp.OpCode != INT3)
+            SetBreakpoint(bp);
+        return bp;
+    }
+    DebugLoop::Breakpoint& DebugLoop::AddHardwareBreakpoint(Address address, Thread& thread, bool oneShot)
+    {
+        // software breakpoint keeps its INT3 & opcode, it isn't converted
+        if (Breakpoint* const existing = FindBreakpoint(address))
+            return *existing;
+
+        BYTE slot = 0;
+        while (slot < std::size(_hardwareSlots) && _hardwareSlots[slot])
+            slot++;
+        if (slot == std::size(_hardwareSlots))
+            throw no_free_debug_register_error();
+
+        Breakpoint& bp = *Breakpoints.emplace(address, std::make_unique<Breakpoint>(address)).first->second;
+        bp.Hardware = true;
+        bp.OneShot  = oneShot;
+        bp.Slot     = slot;
+        bp.Owner    = thread.Id;
+
+        _hardwareSlots[slot] = &bp;
+        SetDebugRegister(thread, slot, address);
+        return bp;
+    }
+    DebugLoop::Breakpoint* DebugLoop::FindBreakpoint(Address address)
+    {
+        auto const it = Breakpoints.find(address);
+        return it != Breakpoints.end() ? it->second.get() : nullptr;
+    }
     bool DebugLoop::RemoveBreakpoint(Address address)
     {
-        if(auto const it = Breakpoints.find(address); it != Breakpoints.end())
-        {
-            Breakpoint& bp = it->second;
-            if(bp.IsWritten)
-                RestoreOpcode(bp);
+        Breakpoint* const bp = FindBreakpoint(address);
+        if(!bp)
+            return false;
 
-            Breakpoints.erase(it);
+        if(bp->IsWritten)
+            RestoreOpcode(*bp);
+        if(bp->Hardware)
+            ReleaseDebugRegister(*bp);
+        // pending single step must not write removed breakpoint back
+        for(auto it = DefferedBreakpoints.begin(); it != DefferedBreakpoints.end();)
+            it = it->second == bp ? DefferedBreakpoints.erase(it) : std::next(it);
 
-            return true;
-        }
-        return false;
+        Breakpoints.erase(address);
+        return true;
+    }
+
+    void DebugLoop::SetDebugRegister(Thread& thread, BYTE slot, Address address)
+    {
+        CONTEXT& context = thread.GetContext(CONTEXT_DEBUG_REGISTERS);
+        // Dr0-Dr3 are adjacent in CONTEXT
+        (&context.Dr0)[slot] = reinterpret_cast<DWORD>(address);
+        // local enable bit; condition & length bits are zero for execution breakpoint
+        DWORD const enable    = 1 << (slot * 2);
+        DWORD const condition = 0xF << (16 + slot * 4);
+        if (address)
+            context.Dr7 = (context.Dr7 | enable) & ~condition;
+        else
+            context.Dr7 &= ~(enable | condition);
+        thread.SetContext(CONTEXT_DEBUG_REGISTERS);
+    }
+    void DebugLoop::ReleaseDebugRegister(Breakpoint& bp)
+    {
+        if (_hardwareSlots[bp.Slot] == &bp)
+            _hardwareSlots[bp.Slot] = nullptr;
+        // thread can be gone already
+        if (auto const it = ThreadMgr.Threads.find(bp.Owner); it != ThreadMgr.Threads.end())
+            SetDebugRegister(it->second, bp.Slot, nullptr);
     }
 }
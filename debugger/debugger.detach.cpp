@@ -0,0 +1,98 @@
+#include <set>
+
+#include "debugger.hpp"
+
+namespace Debugger
+{
+    bool DebugLoop::DetachNow()
+    {
+        _detachRequested = false;
+
+        // INT3 or debug registers left in process would crash it without debugger
+        std::set<Address> written;
+        for (auto& [address, bp] : Breakpoints)
+        {
+            if (bp->IsWritten)
+            {
+                written.insert(address);
+                RestoreOpcode(*bp);
+            }
+            if (bp->Hardware)
+                ReleaseDebugRegister(*bp);
+        }
+        // the same for pending single steps (deferred breakpoints are re-armed by them)
+        for (auto& [threadId, bp] : DefferedBreakpoints)
+        {
+            auto const it = ThreadMgr.Threads.find(threadId);
+            if (it == ThreadMgr.Threads.end())
+                continue;
+            it->second.DisableSingleStep();
+        }
+        DefferedBreakpoints.clear();
+
+        // events already queued are continued before stop: thread stopped by removed INT3 would resume after its first byte
+        bool exited = false;
+        DEBUG_EVENT dbgEvent;
+        while (WaitForDebugEvent(&dbgEvent, 0))
+        {
+            EventRecorder::DebugEvent(dbgEvent);
+            switch (dbgEvent.dwDebugEventCode)
+            {
+            case CREATE_THREAD_DEBUG_EVENT:
+                ThreadMgr.FindOrEmplace(dbgEvent.dwThreadId, dbgEvent.u.CreateThread.hThread);
+                break;
+            case LOAD_DLL_DEBUG_EVENT:
+                if (dbgEvent.u.LoadDll.hFile)
+                    CloseHandle(dbgEvent.u.LoadDll.hFile);
+                break;
+            case EXIT_PROCESS_DEBUG_EVENT:
+                exited = true;
+                break;
+            case EXCEPTION_DEBUG_EVENT:
+                {
+                    auto const& record = dbgEvent.u.Exception.ExceptionRecord;
+                    auto const  it     = ThreadMgr.Threads.find(dbgEvent.dwThreadId);
+                    if (record.ExceptionCode != EXCEPTION_BREAKPOINT || !written.count(record.ExceptionAddress) || it == ThreadMgr.Threads.end())
+                        break;
+                    CONTEXT& context = it->second.GetContext(CONTEXT_CONTROL);
+                    if (context.Eip == reinterpret_cast<DWORD>(record.ExceptionAddress) + 1)
+                    {
+                        context.Eip--;
+                        it->second.SetContext(CONTEXT_CONTROL);
+                    }
+                }   break;
+            }
+            ContinueDebugEvent(dbgEvent.dwProcessId, dbgEvent.dwThreadId, DBG_CONTINUE);
+            EventRecorder::Continued(dbgEvent.dwThreadId, DBG_CONTINUE);
+        }
+        // process is gone, its exit is reported by WaitDetached
+        if (exited)
+        {
+            Detached = true;
+            return true;
+        }
+
+        DebugSetProcessKillOnExit(FALSE);
+        if (!DebugActiveProcessStop(ProcessInfo.dwProcessId))
+            return false;
+
+        Detached = true;
+        OnDetached();
+        return true;
+    }
+
+    void DebugLoop::WaitDetached()
+    {
+        // ticks go on (threads created from now on are unknown), exit is reported as usual
+        for (;;)
+        {
+            if (WaitForSingleObject(_dbgProcessHandle, TickInterval) == WAIT_TIMEOUT)
+            {
+                OnTick();
+                continue;
+            }
+            OnProcessExited();
+            break;
+        }
+    }
+}
@@ -11,8 +11,10 @@ namespace Debugger
         switch (exceptCode)
         {
         case(EXCEPTION_BREAKPOINT):
+            Stats.Breakpoints++;
             return HandleBreakpoint(dbgEvent);
         case(EXCEPTION_SINGLE_STEP):
+            Stats.SingleSteps++;
             return HandleSingleStep(dbgEvent);
         case(EXCEPTION_ACCESS_VIOLATION):
             return HandleAccessViolation(dbgEvent);
@@ -29,12 +31,25 @@ namespace Debugger
         Thread& thread        = ThreadMgr[threadId];
         thread.LastBreakpoint = address;
 
-        if(auto const it = Breakpoints.find(address); it != Breakpoints.end())
+        if(Breakpoint* const found = FindBreakpoint(address); found && !found->Hardware)
         {
-            Breakpoint& bp = it->second;
+            Breakpoint& bp = *found;
             OnBreakpoint(thread, bp);
             bp.OnReached(*this, thread);
 
+            if(bp.OneShot)
+            {
+                // EIP is after INT3: if handler didn't move it, original instruction is executed from its start
+                CONTEXT& context = thread.GetContext(CONTEXT_CONTROL);
+                if(bp.IsWritten && context.Eip == reinterpret_cast<DWORD>(address) + 1)
+                {
+                    context.Eip--;
+                    thread.SetContext(CONTEXT_CONTROL);
+                }
+                RemoveBreakpoint(address);
+                return DBG_CONTINUE;
+            }
+
             RestoreOpcode(bp);
 
             auto* pBp = &bp;
@@ -70,10 +85,37 @@ namespace Debugger
             }
         }
 
+        if(Breakpoint* const bp = FindBreakpoint(address); bp && bp->Hardware && bp->Owner == threadId)
+            return HandleHardwareBreakpoint(*bp, thread);
+
         OnSingleStep(thread, address);
         return DBG_CONTINUE;
     }
 
+    DWORD DebugLoop::HandleHardwareBreakpoint(Breakpoint& bp, Thread& thread)
+    {
+        Address const address = bp.Addr;
+        thread.LastBreakpoint = address;
+
+        OnBreakpoint(thread, bp);
+        bp.OnReached(*this, thread);
+
+        if(bp.OneShot)
+        {
+            RemoveBreakpoint(address);
+            return DBG_CONTINUE;
+        }
+
+        // fault is raised before instruction is executed: resume flag lets it run once, if handler didn't move EIP
+        CONTEXT& context = thread.GetContext(CONTEXT_CONTROL);
+        if(context.Eip == reinterpret_cast<DWORD>(address))
+        {
+            context.EFlags |= 0x10000;
+            thread.SetContext(CONTEXT_CONTROL);
+        }
+        return DBG_CONTINUE;
+    }
+
     DWORD DebugLoop::HandleAccessViolation(DEBUG_EVENT& dbgEvent)
     {
         auto const exceptCode = dbgEvent.u.Exception.ExceptionRecord.ExceptionCode;
@@ -86,4 +128,24 @@ namespace Debugger
 
         return DBG_EXCEPTION_NOT_HANDLED;
     }
+
+    string DebugLoop::ReadDebugString(OUTPUT_DEBUG_STRING_INFO const& info)
+    {
+        if (info.fUnicode)
+        {
+            std::wstring wide(info.nDebugStringLength, L'\0');
+            if (!Memory.Read(info.lpDebugStringData, wide.data(), static_cast<DWORD>(wide.size() * sizeof(wchar_t))))
+                return {};
+            // only ASCII is expected from hooks, rest is replaced
+            string result;
+            for (wchar_t c : wide)
+                result.push_back(c < 0x80 ? static_cast<char>(c) : '?');
+            return result.substr(0, result.find('\0'));
+        }
+
+        string result(info.nDebugStringLength, '\0');
+        if (!Memory.Read(info.lpDebugStringData, result.data(), static_cast<DWORD>(result.size())))
+            return {};
+        return result.substr(0, result.find('\0'));
+    }
 }
@@ -1,16 +1,19 @@
 ﻿#ifndef DEBUGGER_DEBUGGER_HPP
 #define DEBUGGER_DEBUGGER_HPP
 
+#include <chrono>
 #include <map>
+#include <memory>
 #include <string>
 #include <string_view>
 
 #include <events.hpp>
 
 #include "typedefs.hpp"
-#include "dll_info.hpp"
+#include "dll_registry.hpp"
 #include "thread_manager.hpp"
 #include "process_memory.hpp"
+#include "flat_map.hpp"
 
 namespace Debugger
 {
@@ -25,6 +28,10 @@ namespace Debugger
     * @brief First, it handles basic debug loop events: DLL load\\unload, Thread create\\exit.
     * @brief Second, it allow to set breakpoints and handles event when (any) breakpoint reached. Also able to use single step mode.
     * @brief Thrid, it will notice when access violation occurs.
+    * @brief Breakpoint kinds:
+    * @brief - software: INT3 is written, after hit opcode is restored for one single step and INT3 is written back (3 events per hit);
+    * @brief - one-shot: INT3 is written and removed with breakpoint on hit, no single step;
+    * @brief - hardware: DR0-DR3 of one thread, nothing is written into memory, one event per hit (single step exception).
     */
     class DebugLoop
     {
@@ -41,8 +48,10 @@ namespace Debugger
         using DllEvent               = ObjectEvent<DebugLoop, DllInfo&>;
         using DebuggerEvent          = ObjectEvent<DebugLoop>;
         using ThreadActionEvent      = ObjectEvent<DebugLoop, Thread&>;
+        using DebugStringEvent       = ObjectEvent<DebugLoop, Thread&, string const&>;
 
-        using BreakpointMap          = map<Address, Breakpoint>;
+        // breakpoints are owned by pointer: references given to handlers stay valid while the table grows
+        using BreakpointMap          = FlatMap<Address, std::unique_ptr<Breakpoint>>;
 
         BYTE  INT3                   = 0xCC;
     public:
@@ -57,9 +66,15 @@ namespace Debugger
 
             Event   OnReached;
 
-            Address Addr;
-            BYTE    OpCode;
-            bool    IsWritten;
+            Address  Addr;
+            BYTE     OpCode;
+            bool     IsWritten;
+            // removed after OnReached
+            bool     OneShot  = false;
+            // set in debug register Slot of thread Owner
+            bool     Hardware = false;
+            BYTE     Slot     = 0;
+            ThreadId Owner    = 0;
 
             Breakpoint() noexcept;
             Breakpoint(Address address);
@@ -73,6 +88,7 @@ namespace Debugger
         };
 
         struct process_creation_error : std::exception {    };
+        struct no_free_debug_register_error : std::exception {    };
         struct dll_not_found_error : std::exception
         {
             string const BaseName;
@@ -93,13 +109,37 @@ namespace Debugger
         ThreadActionEvent          OnThreadAdded;
         ThreadActionEvent          OnThreadRemoved;
 
+        // OutputDebugString of process
+        DebugStringEvent           OnDebugString;
+        // Process is gone, but its memory mapped into debugger (shared sections) is still readable
+        DebuggerEvent              OnProcessExited;
+        // Raised every TickInterval ms while process runs (not stopped at debug event)
+        DebuggerEvent              OnTick;
+        DWORD                      TickInterval = INFINITE;
+        // Debugger is detached from process, process keeps running. No debug events follow, except OnTick & OnProcessExited.
+        DebuggerEvent              OnDetached;
+
+        /*!
+        * @brief Cost of being attached: debug events received and total time process was stopped by them (from report to continue).
+        */
+        struct Statistics
+        {
+            size_t                                    Events[RIP_EVENT + 1] { };
+            size_t                                    FirstChanceExceptions = 0;
+            size_t                                    Breakpoints = 0;
+            size_t                                    SingleSteps = 0;
+            std::chrono::steady_clock::duration       Stopped { };
+        };
+        Statistics                 Stats;
+        bool                       Detached = false;
+
         STARTUPINFO                StartupInfo{};
         CREATE_PROCESS_DEBUG_INFO  ProcessDebugInfo{};
         PROCESS_INFORMATION        ProcessInfo{};
         //MODULEINFO               ProcessModuleInfo;
 
         BreakpointMap              Breakpoints;
-        DllMap                     Dlls;
+        DllRegistry                Dlls;
 
         Thread*                    MainThread;
         map<ThreadId, Breakpoint*> DefferedBreakpoints;
@@ -123,14 +163,35 @@ namespace Debugger
         void RestoreBreakpoint(Address address);
         void RestoreOpcode(Breakpoint& bp);
         Breakpoint& AddBreakpoint(Address address, bool write = true);
+        // INT3 which is removed on hit, so it costs one event. Handler is expected to move EIP, otherwise it's rewound to original instruction.
+        Breakpoint& AddOneShotBreakpoint(Address address);
+        // Execution breakpoint in debug registers of thread, throws no_free_debug_register_error if all 4 are used.
+        // Breakpoint which already exists at address is returned as is.
+        Breakpoint& AddHardwareBreakpoint(Address address, Thread& thread, bool oneShot = false);
+        Breakpoint* FindBreakpoint(Address address);
         bool RemoveBreakpoint(Address address);
 
         void Run();
+        // Debugger detaches after current debug event is continued: breakpoints are removed, process is not killed on exit of debugger.
+        // Memory allocated in process is kept (as long as it's not freed explicitly).
+        void Detach() { _detachRequested = true; }
     private:
+        bool  _detachRequested = false;
+        // breakpoints in debug registers DR0-DR3
+        Breakpoint* _hardwareSlots[4] { };
+
+        // nullptr disables slot
+        void SetDebugRegister(Thread& thread, BYTE slot, Address address);
+        void ReleaseDebugRegister(Breakpoint& bp);
+
+        bool DetachNow();
+        void WaitDetached();
         DWORD HandleException(DEBUG_EVENT& dbgEvent);
         DWORD HandleBreakpoint(DEBUG_EVENT& dbgEvent);
         DWORD HandleSingleStep(DEBUG_EVENT& dbgEvent);
+        DWORD HandleHardwareBreakpoint(Breakpoint& bp, Thread& thread);
         DWORD HandleAccessViolation(DEBUG_EVENT& dbgEvent);
+        string ReadDebugString(OUTPUT_DEBUG_STRING_INFO const& info);
     };
 }
 #endif //DEBUGGER_DEBUGGER_HPP
@@ -1,3 +1,5 @@
+#include <spdlog/spdlog.h>
+
 #include "debugger.hpp"
 
 namespace Debugger
@@ -16,10 +18,34 @@ namespace Debugger
         //Log::WriteLine(__FUNCTION__ ": Entering debug loop...");
 
         auto exit_code = static_cast<DWORD>(-1);
+        ULONGLONG nextTick = GetTickCount64() + TickInterval;
 
         for (;;)
         {
-            WaitForDebugEvent(&dbgEvent, INFINITE);
+            if (!WaitForDebugEvent(&dbgEvent, TickInterval))
+            {
+                // anything but timeout is real failure (e.g. invalid handle), waiting again would fail the same way
+                DWORD const error = GetLastError();
+                if (error != ERROR_SEM_TIMEOUT)
+                {
+                    spdlog::error("WaitForDebugEvent failed, error: {0}. Debug loop is stopped.", error);
+                    break;
+                }
+                // no debug event in time - process is running
+                if (TickInterval != INFINITE)
+                {
+                    OnTick();
+                    nextTick = GetTickCount64() + TickInterval;
+                }
+                continue;
+            }
+
+            auto const stopped = std::chrono::steady_clock::now();
+            EventRecorder::DebugEvent(dbgEvent);
+            if (dbgEvent.dwDebugEventCode <= RIP_EVENT)
+                Stats.Events[dbgEvent.dwDebugEventCode]++;
+            if (dbgEvent.dwDebugEventCode == EXCEPTION_DEBUG_EVENT && dbgEvent.u.Exception.dwFirstChance)
+                Stats.FirstChanceExceptions++;
 
             DWORD continueStatus = DBG_CONTINUE;
 
@@ -57,25 +83,28 @@ namespace Debugger
                 }    break;
             case LOAD_DLL_DEBUG_EVENT:
                 {
-                    auto const base = dbgEvent.u.LoadDll.lpBaseOfDll;
-                    auto       p    = Dlls.emplace(base, dbgEvent.u.LoadDll);
-                    p.first->second.LoadVersion();
-                    OnDllLoaded(p.first->second);
+                    DllInfo& dll = Dlls.Load(dbgEvent.u.LoadDll);
+                    EventRecorder::Name(EventRecordKind::DllName, dll.Base, dll.FileName);
+                    OnDllLoaded(dll);
                 }    break;
             case UNLOAD_DLL_DEBUG_EVENT:
                 {
-                    auto const base = dbgEvent.u.UnloadDll.lpBaseOfDll;
-                    DllInfo& dll = Dlls[base];
-                    dll.Unloaded = true;
-                    OnDllUnloaded(dll);
+                    if (DllInfo* dll = Dlls.Unload(dbgEvent.u.UnloadDll.lpBaseOfDll))
+                        OnDllUnloaded(*dll);
                 }    break;
             case OUTPUT_DEBUG_STRING_EVENT:
-                { } break;
+                {
+                    Thread& thread = ThreadMgr[dbgEvent.dwThreadId];
+                    string const text = ReadDebugString(dbgEvent.u.DebugString);
+                    EventRecorder::Name(EventRecordKind::DebugString, dbgEvent.u.DebugString.lpDebugStringData, text);
+                    OnDebugString(thread, text);
+                }    break;
             }
 
             if (dbgEvent.dwDebugEventCode == EXIT_PROCESS_DEBUG_EVENT)
             {
                 exit_code = dbgEvent.u.ExitProcess.dwExitCode;
+                OnProcessExited();
                 break;
             }
             else if (dbgEvent.dwDebugEventCode == RIP_EVENT)
@@ -84,8 +113,23 @@ namespace Debugger
             }
 
             ContinueDebugEvent(dbgEvent.dwProcessId, dbgEvent.dwThreadId, continueStatus);
+            EventRecorder::Continued(dbgEvent.dwThreadId, continueStatus);
+            Stats.Stopped += std::chrono::steady_clock::now() - stopped;
+
+            if (_detachRequested && DetachNow())
+                break;
+
+            // frequent debug events must not starve ticks
+            if (TickInterval != INFINITE && GetTickCount64() >= nextTick)
+            {
+                OnTick();
+                nextTick = GetTickCount64() + TickInterval;
+            }
         }
 
+        if (Detached)
+            WaitDetached();
+
         CloseHandle(ProcessInfo.hProcess);
 
         //Log::WriteLine(
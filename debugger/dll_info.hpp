@@ -6,12 +6,18 @@
 #include <handle.win.hpp>
 #include <winapi.utilities.hpp>
 
+#include <filesystem>
+#include <optional>
+
 #include "typedefs.hpp"
+#include "checksum.hpp"
 
 /*!
 * @author multfinite
 * @brief Just container for dynamic loaded module (DLL) data inside process.
 * @brief Used by debugger.
+* @brief Only cheap data (base, file name & size) is taken at load event. PE, checksum and version info are computed on first access,
+* @brief so DLLs which are never targeted by hooks don't cost anything while debuggee is stopped.
 */
 struct DllInfo
 {
@@ -19,21 +25,17 @@ struct DllInfo
     LPVOID                            Base      { nullptr };
     DWORD                             FileSize  { 0 };
     std::string                       FileName;
-    DWORD                             ImageSize { 0 };
     bool                              Unloaded  { false };
-    PECOFF::PortableExecutable        PE;
-    unsigned int                      Checksum  { 0 };
-    Utilities::FileVersionInformation FVI;
-
+private:
+    mutable std::optional<PECOFF::PortableExecutable>        _pe;
+    mutable std::optional<unsigned int>                      _checksum;
+    mutable std::optional<Utilities::FileVersionInformation> _fvi;
 public:
     DllInfo() = default;
     DllInfo(LOAD_DLL_DEBUG_INFO& info) :
         FileName(Utilities::GetFileNameFromHandle(info.hFile)),
-        PE(Utilities::file_open_binary(FileName)),
-        ImageSize(PE.PEHeader.OptionalHeader.SizeOfImage),
         Base(info.lpBaseOfDll),
-        FileSize(GetFileSize(info.hFile, nullptr)),
-        Checksum(Utilities::CRC32::compute_stream(Utilities::file_open_binary(FileName)))
+        FileSize(GetFileSize(info.hFile, nullptr))
     {
         GetModuleHandleEx(
             GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS | GET_MODULE_HANDLE_EX_FLAG_UNCHANGED_REFCOUNT,
@@ -41,17 +43,46 @@ public:
             &Handle
         );
     }
+    // DLL found in process without debugger (module of process is its base)
+    DllInfo(LPVOID base, std::string fileName) :
+        Handle(static_cast<HMODULE>(base)),
+        Base(base),
+        FileName(std::move(fileName))
+    {
+        std::error_code error;
+        auto const size = std::filesystem::file_size(FileName, error);
+        FileSize = error ? 0 : static_cast<DWORD>(size);
+    }
     ~DllInfo() = default;
-    bool OwnsAddress(Address address) const { return (address >= Base) && (address < reinterpret_cast<BYTE*>(Base) + ImageSize); };
+    bool OwnsAddress(Address address) const { return (address >= Base) && (address < reinterpret_cast<BYTE*>(Base) + ImageSize()); };
 
-    void LoadVersion()
+    PECOFF::PortableExecutable const& PE() const
+    {
+        if (!_pe)
+            _pe.emplace(Utilities::file_open_binary(FileName));
+        return *_pe;
+    }
+    DWORD ImageSize() const { return PE().PEHeader.OptionalHeader.SizeOfImage; }
+    unsigned int Checksum() const
+    {
+        if (!_checksum)
+            _checksum = ChecksumRegistry::instance().get(FileName);
+        return *_checksum;
+    }
+    Utilities::FileVersionInformation const& FVI() const
     {
-        try
+        if (!_fvi)
         {
-            FVI.Load(FileName);
+            auto& fvi = _fvi.emplace();
+            try
+            {
+                ChecksumRegistry::instance().load_version(FileName, fvi);
+            }
+            catch(...) {}
         }
-        catch(...) {}
+        return *_fvi;
     }
+    bool VersionLoaded() const { return _fvi.has_value(); }
 };
 
 using DllBase        = LPVOID;
@@ -0,0 +1,115 @@
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+
+#include "dll_registry.hpp"
+
+std::string DllRegistry::normalize(std::string_view const& fileName)
+{
+    auto name = std::filesystem::path(fileName).filename().string();
+    std::transform(name.begin(), name.end(), name.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return name;
+}
+
+void DllRegistry::index_remove(NameIndex& index, std::string const& key, DllBase base)
+{
+    auto it = index.find(key);
+    if (it == index.end())
+        return;
+
+    auto& bases = it->second;
+    bases.erase(std::remove(bases.begin(), bases.end(), base), bases.end());
+    if (bases.empty())
+        index.erase(it);
+}
+void DllRegistry::index_add(NameIndex& index, std::string const& key, DllBase base)
+{
+    index[key].push_back(base);
+}
+
+DllInfo* DllRegistry::first_loaded(NameIndex const& index, std::string const& key)
+{
+    auto it = index.find(key);
+    if (it == index.end())
+        return nullptr;
+
+    // the lowest base wins, as it was with ordered search over all DLLs
+    DllInfo* result = nullptr;
+    for (DllBase base : it->second)
+    {
+        auto& dll = _dlls.at(base);
+        if (!dll.Unloaded && (!result || base < result->Base))
+            result = &dll;
+    }
+    return result;
+}
+void DllRegistry::index_version(DllInfo& dll)
+{
+    if (_originalKeys.count(dll.Base))
+        return;
+
+    auto const& fvi = dll.FVI();
+    auto key = normalize(fvi.Loaded ? fvi.OriginalFilename : dll.FileName);
+    index_add(_byOriginalName, key, dll.Base);
+    _originalKeys.emplace(dll.Base, std::move(key));
+}
+
+DllInfo& DllRegistry::Load(LOAD_DLL_DEBUG_INFO& info)
+{
+    return Load(DllInfo { info });
+}
+DllInfo& DllRegistry::Load(DllInfo dll)
+{
+    DllBase const base = dll.Base;
+
+    auto it = _dlls.find(base);
+    if (it != _dlls.end())
+    {
+        index_remove(_byFileName, normalize(it->second.FileName), base);
+        if (auto key = _originalKeys.find(base); key != _originalKeys.end())
+        {
+            index_remove(_byOriginalName, key->second, base);
+            _originalKeys.erase(key);
+        }
+        it->second = std::move(dll);
+    }
+    else it = _dlls.emplace(base, std::move(dll)).first;
+
+    index_add(_byFileName, normalize(it->second.FileName), base);
+    return it->second;
+}
+DllInfo* DllRegistry::Unload(DllBase base)
+{
+    auto* dll = Find(base);
+    if (dll)
+        dll->Unloaded = true;
+    return dll;
+}
+
+DllInfo* DllRegistry::Find(DllBase base)
+{
+    auto it = _dlls.find(base);
+    return it == _dlls.end() ? nullptr : &it->second;
+}
+DllInfo* DllRegistry::FindByFileName(std::string_view const& fileName)
+{
+    return first_loaded(_byFileName, normalize(fileName));
+}
+DllInfo* DllRegistry::FindByOriginalName(std::string_view const& name)
+{
+    auto const key = normalize(name);
+
+    // usually original name is the same as file name, so version info of those candidates is loaded first
+    if (auto it = _byFileName.find(key); it != _byFileName.end())
+        for (DllBase base : it->second)
+            index_version(_dlls.at(base));
+    if (auto* dll = first_loaded(_byOriginalName, key))
+        return dll;
+
+    if (_originalKeys.size() == _dlls.size())
+        return nullptr;
+
+    for (auto& [base, dll] : _dlls)
+        index_version(dll);
+    return first_loaded(_byOriginalName, key);
+}
@@ -0,0 +1,59 @@
+#ifndef DEBUGGER_DLL_REGISTRY_HPP
+#define DEBUGGER_DLL_REGISTRY_HPP
+
+#include <map>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "typedefs.hpp"
+#include "dll_info.hpp"
+
+/*!
+* @brief Set of DLLs loaded by debuggee, ordered by base address.
+* @brief Lookups go through hash indexes: by normalized (lower case) file name and by version info original name.
+* @brief Original name index is filled lazily: version info is loaded for DLLs with matching file name first,
+* @brief and for the rest of DLLs only when those can't answer the query.
+*/
+class DllRegistry final
+{
+    using NameIndex = std::unordered_map<std::string, std::vector<DllBase>>;
+
+    DllMap                           _dlls;
+    NameIndex                        _byFileName;
+    NameIndex                        _byOriginalName;
+    // DLLs which version info is already indexed, with their original name key
+    std::map<DllBase, std::string>   _originalKeys;
+
+    static void index_remove(NameIndex& index, std::string const& key, DllBase base);
+    static void index_add(NameIndex& index, std::string const& key, DllBase base);
+
+    DllInfo* first_loaded(NameIndex const& index, std::string const& key);
+    void     index_version(DllInfo& dll);
+public:
+    // Lower case file name without directory
+    static std::string normalize(std::string_view const& fileName);
+
+    // Registers DLL from load event, DLL previously known at the same base is replaced
+    DllInfo& Load(LOAD_DLL_DEBUG_INFO& info);
+    DllInfo& Load(DllInfo dll);
+    // Marks DLL as unloaded, returns nullptr for unknown base
+    DllInfo* Unload(DllBase base);
+
+    DllInfo* Find(DllBase base);
+    // Loaded DLL by file name (directory is ignored)
+    DllInfo* FindByFileName(std::string_view const& fileName);
+    // Loaded DLL which version info original name (or file name, if version info is absent) equals to name
+    DllInfo* FindByOriginalName(std::string_view const& name);
+
+    size_t size()  const { return _dlls.size(); }
+    bool   empty() const { return _dlls.empty(); }
+
+    DllMap::iterator       begin()       { return _dlls.begin(); }
+    DllMap::iterator       end()         { return _dlls.end(); }
+    DllMap::const_iterator begin() const { return _dlls.cbegin(); }
+    DllMap::const_iterator end()   const { return _dlls.cend(); }
+};
+
+#endif //DEBUGGER_DLL_REGISTRY_HPP
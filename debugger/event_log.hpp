@@ -0,0 +1,191 @@
+#ifndef DEBUGGER_EVENT_LOG_HPP
+#define DEBUGGER_EVENT_LOG_HPP
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/*!
+* @brief Binary log of debug session: debug events, remote memory reads & writes, allocations and thread context changes, in order of occurrence.
+* @brief Written by EventRecorder on Windows, read by EventLogReader anywhere: records are fixed width little-endian fields of 32 bit process,
+* @brief no Windows types are stored. Data read from process is kept, so the log is enough to answer the same reads again.
+* @brief Layout: EventLogHeader, then records [EventRecordHeader, payload struct, trailing bytes (data or text)].
+*/
+enum class EventRecordKind : uint8_t
+{
+    DebugEvent  = 1, // DebugEventRecord
+    Continue    = 2, // ContinueRecord
+    MemoryRead  = 3, // MemoryRecord + data read
+    MemoryWrite = 4, // MemoryRecord + data written
+    Allocation  = 5, // AllocationRecord
+    ContextGet  = 6, // ContextRecord
+    ContextSet  = 7, // ContextRecord
+    DllName     = 8, // NameRecord + file name of DLL loaded by previous event
+    DebugString = 9, // NameRecord + text of previous OUTPUT_DEBUG_STRING event
+};
+
+#pragma pack(push, 1)
+struct EventLogHeader
+{
+    static constexpr uint32_t Magic   = 0x56455953; // 'SYEV'
+    static constexpr uint32_t Version = 1;
+
+    uint32_t Signature = Magic;
+    uint32_t Revision  = Version;
+};
+struct EventRecordHeader
+{
+    EventRecordKind Kind;
+    // size of payload struct & trailing bytes
+    uint32_t        Size;
+};
+struct DebugEventRecord
+{
+    uint32_t Code;
+    uint32_t ProcessId;
+    uint32_t ThreadId;
+    // exception
+    uint32_t ExceptionCode;
+    uint32_t ExceptionAddress;
+    uint32_t FirstChance;
+    // image base (process), DLL base (load/unload), start address (thread)
+    uint32_t Base;
+    // process/thread exit code
+    uint32_t ExitCode;
+};
+struct ContinueRecord
+{
+    uint32_t ThreadId;
+    uint32_t Status;
+};
+struct MemoryRecord
+{
+    uint32_t Address;
+    uint32_t Size;
+    uint8_t  Succeeded;
+};
+struct AllocationRecord
+{
+    uint32_t Address;
+    uint32_t Size;
+    uint32_t Protection;
+};
+// x86 registers used by injector; segment & floating point state are not recorded
+struct ContextRecord
+{
+    uint32_t ThreadId;
+    uint32_t Flags;
+    uint32_t Dr0, Dr1, Dr2, Dr3, Dr6, Dr7;
+    uint32_t Edi, Esi, Ebx, Edx, Ecx, Eax;
+    uint32_t Ebp, Eip, EFlags, Esp;
+};
+struct NameRecord
+{
+    uint32_t Base;
+};
+#pragma pack(pop)
+
+class EventLogWriter final
+{
+    std::ofstream _file;
+    size_t        _records = 0;
+    size_t        _bytes   = 0;
+public:
+    EventLogWriter() = default;
+    explicit EventLogWriter(std::string const& fileName) :
+        _file(fileName, std::ios::binary | std::ios::trunc)
+    {
+        EventLogHeader const header;
+        _file.write(reinterpret_cast<char const*>(&header), sizeof(header));
+        _bytes = sizeof(header);
+    }
+
+    bool IsOpen() const { return _file.is_open() && _file.good(); }
+
+    template<typename TPayload>
+    void Write(EventRecordKind kind, TPayload const& payload, void const* trailing = nullptr, size_t trailingSize = 0)
+    {
+        EventRecordHeader const header { kind, static_cast<uint32_t>(sizeof(TPayload) + trailingSize) };
+        _file.write(reinterpret_cast<char const*>(&header), sizeof(header));
+        _file.write(reinterpret_cast<char const*>(&payload), sizeof(TPayload));
+        if (trailingSize)
+            _file.write(static_cast<char const*>(trailing), trailingSize);
+        _records++;
+        _bytes += sizeof(header) + header.Size;
+    }
+    void Flush() { _file.flush(); }
+
+    size_t Records() const noexcept { return _records; }
+    size_t Bytes()   const noexcept { return _bytes; }
+};
+
+class EventLogReader final
+{
+public:
+    struct Record
+    {
+        EventRecordKind Kind;
+        uint8_t const*  Payload;
+        uint32_t        Size;
+
+        template<typename TPayload>
+        TPayload As() const
+        {
+            TPayload value { };
+            std::memcpy(&value, Payload, sizeof(TPayload) <= Size ? sizeof(TPayload) : Size);
+            return value;
+        }
+        // bytes after payload struct TPayload
+        template<typename TPayload>
+        std::string_view Trailing() const
+        {
+            if (Size <= sizeof(TPayload))
+                return { };
+            return { reinterpret_cast<char const*>(Payload + sizeof(TPayload)), Size - sizeof(TPayload) };
+        }
+    };
+private:
+    std::vector<uint8_t> _data;
+    size_t               _position = 0;
+public:
+    // Whole log is loaded at once, records point into it
+    bool Open(std::string const& fileName)
+    {
+        std::ifstream file(fileName, std::ios::binary | std::ios::ate);
+        if (!file)
+            return false;
+        _data.resize(static_cast<size_t>(file.tellg()));
+        file.seekg(0);
+        file.read(reinterpret_cast<char*>(_data.data()), _data.size());
+
+        EventLogHeader header;
+        if (!file || _data.size() < sizeof(header))
+            return false;
+        std::memcpy(&header, _data.data(), sizeof(header));
+        _position = sizeof(header);
+        return header.Signature == EventLogHeader::Magic && header.Revision == EventLogHeader::Version;
+    }
+
+    // False at end of log (or at truncated record)
+    bool Next(Record& record)
+    {
+        EventRecordHeader header;
+        if (_position + sizeof(header) > _data.size())
+            return false;
+        std::memcpy(&header, _data.data() + _position, sizeof(header));
+        if (_position + sizeof(header) + header.Size > _data.size())
+            return false;
+
+        record = { header.Kind, _data.data() + _position + sizeof(header), header.Size };
+        _position += sizeof(header) + header.Size;
+        return true;
+    }
+    void Rewind() noexcept { _position = sizeof(EventLogHeader); }
+
+    size_t Size() const noexcept { return _data.size(); }
+};
+
+#endif //DEBUGGER_EVENT_LOG_HPP
@@ -0,0 +1,127 @@
+#ifndef DEBUGGER_EVENT_RECORDER_HPP
+#define DEBUGGER_EVENT_RECORDER_HPP
+
+#include <string>
+#include <string_view>
+
+#include "typedefs.hpp"
+#include "event_log.hpp"
+
+static constexpr const char* EventLogFileName = "syringe.events";
+
+/*!
+* @brief Records debug session into event log (see EventLogWriter): DebugLoop reports events & continues,
+* @brief ProcessMemory & VirtualMemoryHandle report reads, writes and allocations, Thread reports context get/set.
+* @brief Reporters call static functions, which do nothing while no recorder is active, so the cost of disabled recording is one test.
+* @brief Only one recorder is active at time; it's expected to be used by debugger thread only.
+*/
+class EventRecorder final
+{
+    static inline EventRecorder* _active = nullptr;
+
+    EventLogWriter _writer;
+
+    static uint32_t address_of(void const* address) noexcept { return static_cast<uint32_t>(reinterpret_cast<uintptr_t>(address)); }
+public:
+    explicit EventRecorder(std::string const& fileName) : _writer(fileName)
+    {
+        if (_writer.IsOpen())
+            _active = this;
+    }
+    ~EventRecorder()
+    {
+        if (_active == this)
+            _active = nullptr;
+        _writer.Flush();
+    }
+
+    EventRecorder(EventRecorder const&) = delete;
+    EventRecorder& operator=(EventRecorder const&) = delete;
+
+    bool   IsActive() const noexcept { return _active == this; }
+    size_t Records()  const noexcept { return _writer.Records(); }
+    size_t Bytes()    const noexcept { return _writer.Bytes(); }
+
+#ifdef _WIN32
+    static void DebugEvent(DEBUG_EVENT const& event)
+    {
+        if (!_active)
+            return;
+        DebugEventRecord record { event.dwDebugEventCode, event.dwProcessId, event.dwThreadId };
+        switch (event.dwDebugEventCode)
+        {
+        case EXCEPTION_DEBUG_EVENT:
+            record.ExceptionCode    = event.u.Exception.ExceptionRecord.ExceptionCode;
+            record.ExceptionAddress = address_of(event.u.Exception.ExceptionRecord.ExceptionAddress);
+            record.FirstChance      = event.u.Exception.dwFirstChance;
+            break;
+        case CREATE_PROCESS_DEBUG_EVENT:
+            record.Base = address_of(event.u.CreateProcessInfo.lpBaseOfImage);
+            break;
+        case CREATE_THREAD_DEBUG_EVENT:
+            record.Base = address_of(reinterpret_cast<void const*>(event.u.CreateThread.lpStartAddress));
+            break;
+        case LOAD_DLL_DEBUG_EVENT:
+            record.Base = address_of(event.u.LoadDll.lpBaseOfDll);
+            break;
+        case UNLOAD_DLL_DEBUG_EVENT:
+            record.Base = address_of(event.u.UnloadDll.lpBaseOfDll);
+            break;
+        case EXIT_THREAD_DEBUG_EVENT:
+            record.ExitCode = event.u.ExitThread.dwExitCode;
+            break;
+        case EXIT_PROCESS_DEBUG_EVENT:
+            record.ExitCode = event.u.ExitProcess.dwExitCode;
+            break;
+        }
+        _active->_writer.Write(EventRecordKind::DebugEvent, record);
+    }
+    static void Continued(ThreadId threadId, DWORD status)
+    {
+        if (_active)
+            _active->_writer.Write(EventRecordKind::Continue, ContinueRecord { threadId, status });
+    }
+#endif
+    // DLL file name or debug string of last event
+    static void Name(EventRecordKind kind, void const* base, std::string_view const& text)
+    {
+        if (_active)
+            _active->_writer.Write(kind, NameRecord { address_of(base) }, text.data(), text.size());
+    }
+
+    static void MemoryRead(void const* address, void const* buffer, size_t size, bool succeeded)
+    {
+        if (_active)
+            _active->_writer.Write(EventRecordKind::MemoryRead, MemoryRecord { address_of(address), static_cast<uint32_t>(size), succeeded },
+                buffer, succeeded ? size : 0);
+    }
+    static void MemoryWritten(void const* address, void const* buffer, size_t size, bool succeeded)
+    {
+        if (_active)
+            _active->_writer.Write(EventRecordKind::MemoryWrite, MemoryRecord { address_of(address), static_cast<uint32_t>(size), succeeded },
+                buffer, size);
+    }
+    static void Allocated(void const* address, size_t size, DWORD protection)
+    {
+        if (_active)
+            _active->_writer.Write(EventRecordKind::Allocation, AllocationRecord { address_of(address), static_cast<uint32_t>(size), protection });
+    }
+
+#ifdef _WIN32
+    static void Context(bool set, ThreadId threadId, CONTEXT const& context)
+    {
+        if (!_active)
+            return;
+        ContextRecord const record
+        {
+            threadId, context.ContextFlags,
+            context.Dr0, context.Dr1, context.Dr2, context.Dr3, context.Dr6, context.Dr7,
+            context.Edi, context.Esi, context.Ebx, context.Edx, context.Ecx, context.Eax,
+            context.Ebp, context.Eip, context.EFlags, context.Esp
+        };
+        _active->_writer.Write(set ? EventRecordKind::ContextSet : EventRecordKind::ContextGet, record);
+    }
+#endif
+};
+
+#endif //DEBUGGER_EVENT_RECORDER_HPP
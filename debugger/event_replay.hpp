@@ -0,0 +1,228 @@
+#ifndef DEBUGGER_EVENT_REPLAY_HPP
+#define DEBUGGER_EVENT_REPLAY_HPP
+
+#include <functional>
+#include <map>
+#include <string_view>
+#include <vector>
+
+#include "event_log.hpp"
+#include "simulated_process.hpp"
+#include "process_memory.hpp"
+
+/*!
+* @brief Replays event log of real session (see EventRecorder) without process, on any platform.
+* @brief Debug events are raised in recorded order as DebugLoop raises them (DLL names & debug strings are taken from the log),
+* @brief memory operations of the session go through ProcessMemory backed by SimulatedProcess: allocations at recorded addresses,
+* @brief writes as they were done. Each read is checked against simulated memory before its recorded data is applied, so matching
+* @brief reads tell how much of the session is reproduced by replayed writes (the rest was changed by process itself).
+* @brief Handlers may read & write Memory like handlers of DebugLoop do; replay of the same log with the same handlers is deterministic.
+*/
+class EventReplay final
+{
+public:
+    // codes of DEBUG_EVENT & exceptions as recorded (values of Windows), so replay needs no Windows headers
+    static constexpr uint32_t ExceptionEvent          = 1;
+    static constexpr uint32_t CreateThreadEvent       = 2;
+    static constexpr uint32_t CreateProcessEvent      = 3;
+    static constexpr uint32_t ExitThreadEvent         = 4;
+    static constexpr uint32_t ExitProcessEvent        = 5;
+    static constexpr uint32_t LoadDllEvent            = 6;
+    static constexpr uint32_t UnloadDllEvent          = 7;
+    static constexpr uint32_t DebugStringEvent        = 8;
+    static constexpr uint32_t RipEvent                = 9;
+    static constexpr uint32_t BreakpointException     = 0x80000003;
+    static constexpr uint32_t SingleStepException     = 0x80000004;
+    static constexpr uint32_t AccessViolationException = 0xC0000005;
+
+    using Handler        = std::function<void(DebugEventRecord const& event)>;
+    // DLL file name or text of debug string, empty if it was not recorded
+    using NameHandler    = std::function<void(DebugEventRecord const& event, std::string_view const& name)>;
+    using ContextHandler = std::function<void(ContextRecord const& context, bool set)>;
+
+    struct Statistics
+    {
+        size_t Records           = 0;
+        size_t Events[RipEvent + 1] { };
+        size_t Breakpoints       = 0;
+        size_t SingleSteps       = 0;
+        size_t Continues         = 0;
+        // successful reads of session & those which simulated memory answered with the same data
+        size_t Reads             = 0;
+        size_t ReadBytes         = 0;
+        size_t MatchingReads     = 0;
+        size_t Writes            = 0;
+        size_t WrittenBytes      = 0;
+        // writes into memory which was never read nor allocated before (applied without ProcessMemory)
+        size_t UnmappedWrites    = 0;
+        size_t Allocations       = 0;
+        size_t FailedAllocations = 0;
+        size_t Contexts          = 0;
+    };
+
+    SimulatedProcess Process;
+    ProcessMemory    Memory { Process };
+    Statistics       Stats;
+    // last context of each thread, got or set
+    std::map<uint32_t, ContextRecord> Contexts;
+
+    Handler        OnProcessCreated;
+    Handler        OnThreadAdded;
+    Handler        OnThreadRemoved;
+    Handler        OnBreakpoint;
+    Handler        OnSingleStep;
+    Handler        OnAccessViolation;
+    NameHandler    OnDllLoaded;
+    Handler        OnDllUnloaded;
+    NameHandler    OnDebugString;
+    Handler        OnProcessExited;
+    ContextHandler OnContext;
+
+    EventReplay() = default;
+
+    EventReplay(EventReplay const&) = delete;
+    EventReplay& operator=(EventReplay const&) = delete;
+
+    // Replays log from its current position to the end, returns count of records replayed
+    size_t Run(EventLogReader& log)
+    {
+        size_t const before = Stats.Records;
+        EventLogReader::Record record;
+        while (log.Next(record))
+        {
+            Stats.Records++;
+            // name follows event it belongs to, event is raised once it's known whether it's there
+            if (_pending)
+            {
+                bool const named = (record.Kind == EventRecordKind::DllName && _event.Code == LoadDllEvent)
+                    || (record.Kind == EventRecordKind::DebugString && _event.Code == DebugStringEvent);
+                raise_pending(named ? record.Trailing<NameRecord>() : std::string_view { });
+                if (named)
+                    continue;
+            }
+            apply(record);
+        }
+        if (_pending)
+            raise_pending({ });
+        return Stats.Records - before;
+    }
+private:
+    bool             _pending = false;
+    DebugEventRecord _event { };
+
+    template<typename THandler, typename... TArgs>
+    static void invoke(THandler const& handler, TArgs const&... args)
+    {
+        if (handler)
+            handler(args...);
+    }
+
+    void raise_pending(std::string_view const& name)
+    {
+        _pending = false;
+        invoke(_event.Code == LoadDllEvent ? OnDllLoaded : OnDebugString, _event, name);
+    }
+
+    void apply(EventLogReader::Record const& record)
+    {
+        switch (record.Kind)
+        {
+        case EventRecordKind::DebugEvent:
+            debug_event(record.As<DebugEventRecord>());
+            break;
+        case EventRecordKind::Continue:
+            Stats.Continues++;
+            break;
+        case EventRecordKind::MemoryRead:
+        {
+            auto const read = record.As<MemoryRecord>();
+            auto const data = record.Trailing<MemoryRecord>();
+            if (!read.Succeeded || data.size() != read.Size)
+                break;
+            Stats.Reads++;
+            Stats.ReadBytes += read.Size;
+
+            std::vector<BYTE> buffer(read.Size);
+            if (Memory.Read(address_of(read.Address), buffer.data(), read.Size) && std::memcmp(buffer.data(), data.data(), data.size()) == 0)
+                Stats.MatchingReads++;
+            else
+                Process.Fill(read.Address, data.data(), data.size());
+        } break;
+        case EventRecordKind::MemoryWrite:
+        {
+            auto const write = record.As<MemoryRecord>();
+            auto const data  = record.Trailing<MemoryRecord>();
+            if (!write.Succeeded || data.size() != write.Size)
+                break;
+            Stats.Writes++;
+            Stats.WrittenBytes += write.Size;
+            if (!Memory.Write(address_of(write.Address), data.data(), write.Size))
+            {
+                Stats.UnmappedWrites++;
+                Process.Fill(write.Address, data.data(), data.size());
+            }
+        } break;
+        case EventRecordKind::Allocation:
+        {
+            auto const allocation = record.As<AllocationRecord>();
+            if (!allocation.Address)
+                break;
+            Stats.Allocations++;
+            if (!Process.Allocate(address_of(allocation.Address), allocation.Size, allocation.Protection))
+            {
+                Stats.FailedAllocations++;
+                Process.Fill(allocation.Address, nullptr, allocation.Size);
+            }
+        } break;
+        case EventRecordKind::ContextGet:
+        case EventRecordKind::ContextSet:
+        {
+            auto const context = record.As<ContextRecord>();
+            Stats.Contexts++;
+            Contexts[context.ThreadId] = context;
+            invoke(OnContext, context, record.Kind == EventRecordKind::ContextSet);
+        } break;
+        default:
+            // name without event is not expected, it's skipped
+            break;
+        }
+    }
+
+    void debug_event(DebugEventRecord const& event)
+    {
+        if (event.Code <= RipEvent)
+            Stats.Events[event.Code]++;
+
+        switch (event.Code)
+        {
+        case CreateProcessEvent: invoke(OnProcessCreated, event); break;
+        case CreateThreadEvent:  invoke(OnThreadAdded, event);    break;
+        case ExitThreadEvent:    invoke(OnThreadRemoved, event);  break;
+        case UnloadDllEvent:     invoke(OnDllUnloaded, event);    break;
+        case ExitProcessEvent:   invoke(OnProcessExited, event);  break;
+        case LoadDllEvent:
+        case DebugStringEvent:
+            _pending = true;
+            _event   = event;
+            break;
+        case ExceptionEvent:
+            if (event.ExceptionCode == BreakpointException)
+            {
+                Stats.Breakpoints++;
+                invoke(OnBreakpoint, event);
+            }
+            else if (event.ExceptionCode == SingleStepException)
+            {
+                Stats.SingleSteps++;
+                invoke(OnSingleStep, event);
+            }
+            else if (event.ExceptionCode == AccessViolationException)
+                invoke(OnAccessViolation, event);
+            break;
+        }
+    }
+
+    static Address address_of(uint32_t address) noexcept { return reinterpret_cast<Address>(static_cast<uintptr_t>(address)); }
+};
+
+#endif //DEBUGGER_EVENT_REPLAY_HPP
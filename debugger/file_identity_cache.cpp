@@ -0,0 +1,215 @@
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+
+#include "file_identity_cache.hpp"
+
+namespace
+{
+    struct format_error : std::runtime_error
+    {
+        format_error() : std::runtime_error("Unexpected end of file identity cache") {}
+    };
+
+    template<typename T>
+    inline void write_pod(std::ostream& os, T const& value)
+    {
+        os.write(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+    template<typename T>
+    inline T read_pod(std::istream& is)
+    {
+        T value;
+        if (!is.read(reinterpret_cast<char*>(&value), sizeof(T)))
+            throw format_error();
+        return value;
+    }
+    inline void write_string(std::ostream& os, std::string const& str)
+    {
+        write_pod<DWORD>(os, static_cast<DWORD>(str.size()));
+        os.write(str.data(), str.size());
+    }
+    inline std::string read_string(std::istream& is)
+    {
+        auto const size = read_pod<DWORD>(is);
+        std::string str(size, '\0');
+        if (!is.read(str.data(), size))
+            throw format_error();
+        return str;
+    }
+
+    constexpr BYTE EntryHasChecksum = 1 << 0;
+    constexpr BYTE EntryHasVersion  = 1 << 1;
+    constexpr BYTE EntryNoVersion   = 1 << 2;
+}
+
+bool FileIdentity::query(std::string const& fileName, FileIdentity& identity)
+{
+    HANDLE file = CreateFileA(fileName.c_str(), FILE_READ_ATTRIBUTES,
+        FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+        nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+
+    BY_HANDLE_FILE_INFORMATION info;
+    bool const result = GetFileInformationByHandle(file, &info) != FALSE;
+    CloseHandle(file);
+    if (!result)
+        return false;
+
+    identity.Size          = (static_cast<uint64_t>(info.nFileSizeHigh) << 32) | info.nFileSizeLow;
+    identity.LastWriteTime = (static_cast<uint64_t>(info.ftLastWriteTime.dwHighDateTime) << 32) | info.ftLastWriteTime.dwLowDateTime;
+    identity.FileIndex     = (static_cast<uint64_t>(info.nFileIndexHigh) << 32) | info.nFileIndexLow;
+    identity.VolumeSerial  = info.dwVolumeSerialNumber;
+    return true;
+}
+
+FileIdentityCache::FileIdentityCache(std::string_view const& fileName) :
+    FileName(fileName)
+{}
+
+bool FileIdentityCache::load()
+{
+    std::lock_guard lock(_mutex);
+    _entries.clear();
+
+    std::ifstream is(FileName, std::ios::binary);
+    if (!is)
+        return false;
+
+    try
+    {
+        if (read_pod<DWORD>(is) != Magic || read_pod<DWORD>(is) != Version)
+            return false;
+
+        auto count = read_pod<DWORD>(is);
+        while (count--)
+        {
+            auto  key   = read_string(is);
+            Entry entry;
+            entry.Identity.Size          = read_pod<uint64_t>(is);
+            entry.Identity.LastWriteTime = read_pod<uint64_t>(is);
+            entry.Identity.FileIndex     = read_pod<uint64_t>(is);
+            entry.Identity.VolumeSerial  = read_pod<DWORD>(is);
+
+            auto const flags  = read_pod<BYTE>(is);
+            entry.HasChecksum = flags & EntryHasChecksum;
+            entry.HasVersion  = flags & EntryHasVersion;
+            entry.NoVersion   = flags & EntryNoVersion;
+            entry.Checksum    = read_pod<unsigned int>(is);
+            entry.OriginalFilename = read_string(is);
+
+            _entries.insert_or_assign(std::move(key), std::move(entry));
+        }
+    }
+    catch (const format_error&)
+    {
+        _entries.clear();
+        return false;
+    }
+    return true;
+}
+void FileIdentityCache::save()
+{
+    std::lock_guard lock(_mutex);
+
+    // files which were not requested in this run may be deleted meanwhile
+    for (auto it = _entries.begin(); it != _entries.end();)
+    {
+        std::error_code ec;
+        if (!it->second.Used && !std::filesystem::exists(it->first, ec))
+        {
+            it     = _entries.erase(it);
+            _dirty = true;
+        }
+        else ++it;
+    }
+
+    if (!_dirty)
+        return;
+
+    std::ofstream os(FileName, std::ios::binary | std::ios::trunc);
+    if (!os)
+        return;
+
+    write_pod(os, Magic);
+    write_pod(os, Version);
+    write_pod<DWORD>(os, static_cast<DWORD>(_entries.size()));
+    for (auto const& [key, entry] : _entries)
+    {
+        write_string(os, key);
+        write_pod(os, entry.Identity.Size);
+        write_pod(os, entry.Identity.LastWriteTime);
+        write_pod(os, entry.Identity.FileIndex);
+        write_pod(os, entry.Identity.VolumeSerial);
+        write_pod<BYTE>(os, (entry.HasChecksum ? EntryHasChecksum : 0) | (entry.HasVersion ? EntryHasVersion : 0) | (entry.NoVersion ? EntryNoVersion : 0));
+        write_pod(os, entry.Checksum);
+        write_string(os, entry.OriginalFilename);
+    }
+
+    _dirty = false;
+}
+
+FileIdentityCache::Entry& FileIdentityCache::actual_entry(std::string const& key, FileIdentity const& identity)
+{
+    auto& entry = _entries[key];
+    if (entry.Identity != identity)
+    {
+        entry          = Entry();
+        entry.Identity = identity;
+    }
+    entry.Used = true;
+    return entry;
+}
+bool FileIdentityCache::find_checksum(std::string const& key, FileIdentity const& identity, unsigned int& checksum)
+{
+    std::lock_guard lock(_mutex);
+
+    auto it = _entries.find(key);
+    if (it == _entries.end() || it->second.Identity != identity || !it->second.HasChecksum)
+    {
+        _misses++;
+        return false;
+    }
+
+    it->second.Used = true;
+    checksum = it->second.Checksum;
+    _hits++;
+    return true;
+}
+void FileIdentityCache::store_checksum(std::string const& key, FileIdentity const& identity, unsigned int checksum)
+{
+    std::lock_guard lock(_mutex);
+
+    auto& entry       = actual_entry(key, identity);
+    entry.HasChecksum = true;
+    entry.Checksum    = checksum;
+    _dirty            = true;
+}
+bool FileIdentityCache::find_version(std::string const& key, FileIdentity const& identity, std::string& originalFilename, bool& loaded)
+{
+    std::lock_guard lock(_mutex);
+
+    auto it = _entries.find(key);
+    if (it == _entries.end() || it->second.Identity != identity || !it->second.HasVersion)
+    {
+        _misses++;
+        return false;
+    }
+
+    it->second.Used  = true;
+    originalFilename = it->second.OriginalFilename;
+    loaded           = !it->second.NoVersion;
+    _hits++;
+    return true;
+}
+void FileIdentityCache::store_version(std::string const& key, FileIdentity const& identity, std::string const& originalFilename, bool loaded)
+{
+    std::lock_guard lock(_mutex);
+
+    auto& entry            = actual_entry(key, identity);
+    entry.HasVersion       = true;
+    entry.NoVersion        = !loaded;
+    entry.OriginalFilename = originalFilename;
+    _dirty                 = true;
+}
@@ -0,0 +1,89 @@
+#ifndef DEBUGGER_FILE_IDENTITY_CACHE_HPP
+#define DEBUGGER_FILE_IDENTITY_CACHE_HPP
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include "typedefs.hpp"
+
+static constexpr const char* FileIdentityCacheFileName = "syringe.files";
+
+/*!
+* @brief Identity of file on disk: volume & file id, size and last write time.
+* @brief Any change of file content changes at least one of them (replace changes file id, write changes time & size).
+*/
+struct FileIdentity
+{
+    uint64_t Size          = 0;
+    uint64_t LastWriteTime = 0;
+    uint64_t FileIndex     = 0;
+    DWORD    VolumeSerial  = 0;
+
+    bool operator==(FileIdentity const& other) const
+    {
+        return Size == other.Size && LastWriteTime == other.LastWriteTime &&
+            FileIndex == other.FileIndex && VolumeSerial == other.VolumeSerial;
+    }
+    bool operator!=(FileIdentity const& other) const { return !(*this == other); }
+
+    // Reads identity of file, returns false if file is not accessible
+    static bool query(std::string const& fileName, FileIdentity& identity);
+};
+
+/*!
+* @brief Persistent (on-disk) index: normalized path + file identity -> CRC32 and version info original file name (or its absence).
+* @brief Entry is used only if current file identity equals stored one, otherwise entry is rewritten (invalidation).
+* @brief Entries of files which don't exist anymore are dropped on save.
+* @brief Thread-safe.
+*/
+class FileIdentityCache final
+{
+public:
+    static constexpr DWORD Magic   = 0x43465953; // 'SYFC'
+    static constexpr DWORD Version = 2;
+
+    struct Entry
+    {
+        FileIdentity Identity;
+        bool         HasChecksum = false;
+        unsigned int Checksum    = 0;
+        bool         HasVersion  = false;
+        // file has no version info, it's not loaded again while file is not changed
+        bool         NoVersion   = false;
+        std::string  OriginalFilename;
+        bool         Used        = false;
+    };
+private:
+    mutable std::mutex                     _mutex;
+    std::unordered_map<std::string, Entry> _entries;
+    bool                                   _dirty  = false;
+    size_t                                 _hits   = 0;
+    size_t                                 _misses = 0;
+
+    // Entry for current identity of file, stale entry is reset
+    Entry& actual_entry(std::string const& key, FileIdentity const& identity);
+public:
+    std::string const FileName;
+
+    FileIdentityCache(std::string_view const& fileName);
+
+    // Reads index file. Returns false (and keeps index empty) if file is missing or corrupted.
+    bool load();
+    void save();
+
+    // `key` is normalized path (see ChecksumRegistry::normalize), `identity` is current identity of file
+    bool find_checksum(std::string const& key, FileIdentity const& identity, unsigned int& checksum);
+    void store_checksum(std::string const& key, FileIdentity const& identity, unsigned int checksum);
+    // `loaded` is false if file is known to have no version info
+    bool find_version(std::string const& key, FileIdentity const& identity, std::string& originalFilename, bool& loaded);
+    void store_version(std::string const& key, FileIdentity const& identity, std::string const& originalFilename, bool loaded = true);
+
+    size_t size()   const { std::lock_guard lock(_mutex); return _entries.size(); }
+    size_t hits()   const { std::lock_guard lock(_mutex); return _hits; }
+    size_t misses() const { std::lock_guard lock(_mutex); return _misses; }
+};
+
+#endif //DEBUGGER_FILE_IDENTITY_CACHE_HPP
@@ -0,0 +1,149 @@
+#ifndef DEBUGGER_FLAT_MAP_HPP
+#define DEBUGGER_FLAT_MAP_HPP
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "typedefs.hpp"
+
+/*!
+* @brief Open addressing hash table keyed by pointer: slots are one contiguous array, collisions are resolved by linear probing.
+* @brief Lookup of a hit touches one or two cache lines instead of a walk over tree nodes.
+* @brief Key{} (nullptr) marks a free slot, so it can't be stored. Erase shifts following entries back (no tombstones).
+* @brief Values are moved on growth and erase - keep them small or store them by pointer, if references must stay valid.
+*/
+template<typename Key, typename Value>
+class FlatMap final
+{
+public:
+    using value_type = std::pair<Key, Value>;
+private:
+    static constexpr size_t MinCapacity = 16;
+
+    std::vector<value_type> _slots;
+    size_t                  _size = 0;
+
+    size_t mask() const noexcept { return _slots.size() - 1; }
+    // Fibonacci hashing: low bits of addresses are mostly aligned, multiplication spreads high bits into index
+    size_t home(Key key) const noexcept
+    {
+        return static_cast<size_t>((static_cast<uint64_t>(reinterpret_cast<uintptr_t>(key)) * 0x9E3779B97F4A7C15ull) >> 32) & mask();
+    }
+
+    void grow()
+    {
+        std::vector<value_type> old = std::exchange(_slots, std::vector<value_type>(_slots.empty() ? MinCapacity : _slots.size() * 2));
+        for (value_type& slot : old)
+            if (slot.first != Key{})
+            {
+                size_t index = home(slot.first);
+                while (_slots[index].first != Key{})
+                    index = (index + 1) & mask();
+                _slots[index] = std::move(slot);
+            }
+    }
+
+    size_t index_of(Key key) const noexcept
+    {
+        if (_slots.empty())
+            return _slots.size();
+        for (size_t index = home(key);; index = (index + 1) & mask())
+        {
+            if (_slots[index].first == key)
+                return index;
+            if (_slots[index].first == Key{})
+                return _slots.size();
+        }
+    }
+public:
+    template<typename Slot>
+    class basic_iterator
+    {
+        Slot* _slot;
+        Slot* _end;
+
+        void skip() noexcept { while (_slot != _end && _slot->first == Key{}) ++_slot; }
+    public:
+        basic_iterator(Slot* slot, Slot* end) noexcept : _slot(slot), _end(end) { skip(); }
+
+        Slot& operator*()  const noexcept { return *_slot; }
+        Slot* operator->() const noexcept { return _slot; }
+        basic_iterator& operator++() noexcept { ++_slot; skip(); return *this; }
+        bool operator==(basic_iterator const& other) const noexcept { return _slot == other._slot; }
+        bool operator!=(basic_iterator const& other) const noexcept { return _slot != other._slot; }
+    };
+    using iterator       = basic_iterator<value_type>;
+    using const_iterator = basic_iterator<value_type const>;
+
+    iterator       begin()       noexcept { return { _slots.data(), _slots.data() + _slots.size() }; }
+    iterator       end()         noexcept { return { _slots.data() + _slots.size(), _slots.data() + _slots.size() }; }
+    const_iterator begin() const noexcept { return { _slots.data(), _slots.data() + _slots.size() }; }
+    const_iterator end()   const noexcept { return { _slots.data() + _slots.size(), _slots.data() + _slots.size() }; }
+
+    size_t size()  const noexcept { return _size; }
+    bool   empty() const noexcept { return _size == 0; }
+
+    iterator find(Key key) noexcept
+    {
+        size_t const index = index_of(key);
+        return { _slots.data() + index, _slots.data() + _slots.size() };
+    }
+    const_iterator find(Key key) const noexcept
+    {
+        size_t const index = index_of(key);
+        return { _slots.data() + index, _slots.data() + _slots.size() };
+    }
+    bool contains(Key key) const noexcept { return index_of(key) != _slots.size(); }
+
+    // Existing value is kept (as std::map does), second is true if value is inserted
+    std::pair<iterator, bool> emplace(Key key, Value value)
+    {
+        if (auto const it = find(key); it != end())
+            return { it, false };
+
+        // load factor is kept at 1/2 or lower, probe sequences stay short
+        if ((_size + 1) * 2 > _slots.size())
+            grow();
+
+        size_t index = home(key);
+        while (_slots[index].first != Key{})
+            index = (index + 1) & mask();
+        _slots[index] = { key, std::move(value) };
+        _size++;
+        return { { _slots.data() + index, _slots.data() + _slots.size() }, true };
+    }
+
+    bool erase(Key key)
+    {
+        size_t hole = index_of(key);
+        if (hole == _slots.size())
+            return false;
+
+        _slots[hole] = { };
+        _size--;
+        // backward shift: entry is moved into the hole, if the hole is between its home slot and its current slot
+        for (size_t index = (hole + 1) & mask(); _slots[index].first != Key{}; index = (index + 1) & mask())
+        {
+            size_t const desired = home(_slots[index].first);
+            bool const movable = hole <= index
+                ? (desired <= hole || desired > index)
+                : (desired <= hole && desired > index);
+            if (movable)
+            {
+                _slots[hole] = std::move(_slots[index]);
+                _slots[index] = { };
+                hole = index;
+            }
+        }
+        return true;
+    }
+
+    void clear()
+    {
+        _slots.clear();
+        _size = 0;
+    }
+};
+
+#endif //DEBUGGER_FLAT_MAP_HPP
@@ -0,0 +1,122 @@
+#ifndef DEBUGGER_MAPPED_FILE_HPP
+#define DEBUGGER_MAPPED_FILE_HPP
+
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <string.hpp>
+
+#include "typedefs.hpp"
+
+/*!
+* @brief Read-only view of whole file mapped into injector address space.
+* @brief Should be used when file must be scanned many times at different offsets (PE sections, checksums) - no stream seeks and small reads.
+* @brief It wraps WINAPI calls.
+* @brief Not copyable.
+* @brief Moveable.
+*/
+class MappedFile final
+{
+public:
+    struct MappingException : std::runtime_error
+    {
+        std::string const FileName;
+        DWORD       const LastError;
+
+        // error is taken before anything else can change it
+        MappingException(std::string const& fileName, DWORD lastError = GetLastError()) :
+            std::runtime_error(Utilities::string_format("Unable to map file \"%s\", error: %u", fileName.c_str(), lastError)),
+            FileName(fileName), LastError(lastError) {}
+    };
+private:
+    HANDLE      _file    { INVALID_HANDLE_VALUE };
+    HANDLE      _mapping { nullptr };
+    BYTE const* _data    { nullptr };
+    size_t      _size    = 0;
+
+    void close() noexcept
+    {
+        if (_data)
+            UnmapViewOfFile(_data);
+        if (_mapping)
+            CloseHandle(_mapping);
+        if (_file != INVALID_HANDLE_VALUE)
+            CloseHandle(_file);
+
+        _data    = nullptr;
+        _mapping = nullptr;
+        _file    = INVALID_HANDLE_VALUE;
+        _size    = 0;
+    }
+public:
+    MappedFile() noexcept = default;
+    MappedFile(std::string const& fileName)
+    {
+        _file = CreateFileA(fileName.c_str(), GENERIC_READ,
+            FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+            nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (_file == INVALID_HANDLE_VALUE)
+            throw MappingException { fileName };
+
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(_file, &size))
+        {
+            MappingException ex { fileName };
+            close();
+            throw ex;
+        }
+        _size = static_cast<size_t>(size.QuadPart);
+        if (_size == 0)
+            return; // empty file can not be mapped, but it's valid empty view
+
+        _mapping = CreateFileMappingA(_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (_mapping)
+            _data = static_cast<BYTE const*>(MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0));
+        if (!_data)
+        {
+            MappingException ex { fileName };
+            close();
+            throw ex;
+        }
+    }
+    ~MappedFile() { close(); }
+
+    MappedFile(MappedFile const&)            = delete;
+    MappedFile& operator=(MappedFile const&) = delete;
+
+    MappedFile(MappedFile&& other) noexcept :
+        _file(std::exchange(other._file, INVALID_HANDLE_VALUE)),
+        _mapping(std::exchange(other._mapping, nullptr)),
+        _data(std::exchange(other._data, nullptr)),
+        _size(std::exchange(other._size, 0)) { }
+    MappedFile& operator=(MappedFile&& other) noexcept
+    {
+        if (this != &other)
+        {
+            close();
+            _file    = std::exchange(other._file, INVALID_HANDLE_VALUE);
+            _mapping = std::exchange(other._mapping, nullptr);
+            _data    = std::exchange(other._data, nullptr);
+            _size    = std::exchange(other._size, 0);
+        }
+        return *this;
+    }
+
+    BYTE const* data() const noexcept { return _data; }
+    size_t      size() const noexcept { return _size; }
+    bool        empty() const noexcept { return _size == 0; }
+
+    bool contains(size_t offset, size_t count) const noexcept { return offset <= _size && count <= _size - offset; }
+
+    // Zero terminated string at file offset, bounded by end of file. Empty if offset is out of file.
+    std::string_view cstring(size_t offset) const noexcept
+    {
+        if (offset >= _size)
+            return {};
+        auto const* str = reinterpret_cast<const char*>(_data + offset);
+        return std::string_view(str, strnlen(str, _size - offset));
+    }
+};
+#endif //DEBUGGER_MAPPED_FILE_HPP
@@ -0,0 +1,44 @@
+#ifndef DEBUGGER_MEMORY_COUNTERS_HPP
+#define DEBUGGER_MEMORY_COUNTERS_HPP
+
+#include <atomic>
+#include <cstddef>
+
+/*!
+* @brief Process-wide counters of remote memory syscalls (ReadProcessMemory / WriteProcessMemory).
+* @brief Updated by ProcessMemory & VirtualMemoryHandle. Snapshots can be subtracted to measure a stage.
+*/
+struct MemoryCounters
+{
+    size_t ReadCalls    = 0;
+    size_t ReadBytes    = 0;
+    size_t WriteCalls   = 0;
+    size_t WrittenBytes = 0;
+
+    static MemoryCounters current() noexcept
+    {
+        return { _readCalls.load(), _readBytes.load(), _writeCalls.load(), _writtenBytes.load() };
+    }
+    static void count_read(size_t bytes) noexcept
+    {
+        _readCalls++;
+        _readBytes += bytes;
+    }
+    static void count_write(size_t bytes) noexcept
+    {
+        _writeCalls++;
+        _writtenBytes += bytes;
+    }
+
+    MemoryCounters operator-(MemoryCounters const& other) const noexcept
+    {
+        return { ReadCalls - other.ReadCalls, ReadBytes - other.ReadBytes, WriteCalls - other.WriteCalls, WrittenBytes - other.WrittenBytes };
+    }
+private:
+    static inline std::atomic<size_t> _readCalls    { 0 };
+    static inline std::atomic<size_t> _readBytes    { 0 };
+    static inline std::atomic<size_t> _writeCalls   { 0 };
+    static inline std::atomic<size_t> _writtenBytes { 0 };
+};
+
+#endif //DEBUGGER_MEMORY_COUNTERS_HPP
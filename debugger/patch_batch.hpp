@@ -0,0 +1,133 @@
+#ifndef DEBUGGER_PATCH_BATCH_HPP
+#define DEBUGGER_PATCH_BATCH_HPP
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include "typedefs.hpp"
+#include "process_memory.hpp"
+
+/*!
+* @brief Collects small patches of process memory (e.g. jumps at hook sites) and applies them sorted by address and grouped by page:
+* @brief one read and one write per page instead of one write per patch, so copy-on-write work is done once per page.
+* @brief Patches are applied in order of addition, so where patches overlap the later one wins (as with sequential writes).
+* @brief Patched memory must not be executed or modified by process while batch is applied (threads suspended).
+*/
+class PatchBatch final
+{
+public:
+    static constexpr size_t PageSize = 0x1000;
+
+    struct Patch
+    {
+        BYTE*             Address;
+        std::vector<BYTE> Bytes;
+        size_t            Sequence;
+    };
+    struct ReadRequest
+    {
+        BYTE*  Address;
+        BYTE*  Buffer;
+        size_t Size;
+    };
+private:
+    ProcessMemory&     _memory;
+    std::vector<Patch> _patches;
+
+    static DWORD page_of(BYTE const* address) { return reinterpret_cast<DWORD>(address) & ~static_cast<DWORD>(PageSize - 1); }
+
+    // Calls `group(first, last, begin, end)` for ranges of items (sorted by address) which start at the same page
+    template<typename TItem, typename TAddress, typename TSize, typename TGroup>
+    static void for_each_page_group(std::vector<TItem>& items, TAddress address, TSize size, TGroup group)
+    {
+        for (size_t first = 0; first < items.size();)
+        {
+            DWORD const page = page_of(address(items[first]));
+            BYTE* const begin = address(items[first]);
+            BYTE*       end   = begin + size(items[first]);
+
+            size_t last = first + 1;
+            for (; last < items.size() && page_of(address(items[last])) == page; last++)
+                end = (std::max)(end, address(items[last]) + size(items[last]));
+
+            group(first, last, begin, end);
+            first = last;
+        }
+    }
+public:
+    // Page groups written by last Apply()
+    size_t Groups = 0;
+
+    explicit PatchBatch(ProcessMemory& memory) : _memory(memory) { }
+
+    void Add(Address address, void const* data, size_t size)
+    {
+        auto const* bytes = static_cast<BYTE const*>(data);
+        _patches.push_back({ static_cast<BYTE*>(address), std::vector<BYTE>(bytes, bytes + size), _patches.size() });
+    }
+    size_t Size() const { return _patches.size(); }
+
+    // Writes all patches and clears batch. Returns false if any write failed.
+    bool Apply()
+    {
+        std::stable_sort(_patches.begin(), _patches.end(), [](Patch const& a, Patch const& b) { return a.Address < b.Address; });
+
+        bool result = true;
+        Groups = 0;
+        for_each_page_group(_patches,
+            [](Patch const& p) { return p.Address; },
+            [](Patch const& p) { return p.Bytes.size(); },
+            [this, &result](size_t first, size_t last, BYTE* begin, BYTE* end)
+            {
+                Groups++;
+
+                std::vector<Patch const*> group;
+                for (size_t i = first; i < last; i++)
+                    group.push_back(&_patches[i]);
+                std::sort(group.begin(), group.end(), [](Patch const* a, Patch const* b) { return a->Sequence < b->Sequence; });
+
+                std::vector<BYTE> buffer(end - begin);
+                if (group.size() > 1 && _memory.Read(begin, buffer.data(), static_cast<DWORD>(buffer.size())))
+                {
+                    for (Patch const* p : group)
+                        memcpy(buffer.data() + (p->Address - begin), p->Bytes.data(), p->Bytes.size());
+                    result &= _memory.Write(begin, buffer.data(), static_cast<DWORD>(buffer.size()));
+                    return;
+                }
+
+                // single patch or gap between patches is not readable
+                for (Patch const* p : group)
+                    result &= _memory.Write(p->Address, p->Bytes.data(), static_cast<DWORD>(p->Bytes.size()));
+            });
+
+        _patches.clear();
+        return result;
+    }
+
+    // Reads several small regions with one read per page group. Returns false if any read failed.
+    static bool ReadGrouped(ProcessMemory& memory, std::vector<ReadRequest>& requests)
+    {
+        std::sort(requests.begin(), requests.end(), [](ReadRequest const& a, ReadRequest const& b) { return a.Address < b.Address; });
+
+        bool result = true;
+        for_each_page_group(requests,
+            [](ReadRequest const& r) { return r.Address; },
+            [](ReadRequest const& r) { return r.Size; },
+            [&memory, &requests, &result](size_t first, size_t last, BYTE* begin, BYTE* end)
+            {
+                std::vector<BYTE> buffer(end - begin);
+                if (last - first > 1 && memory.Read(begin, buffer.data(), static_cast<DWORD>(buffer.size())))
+                {
+                    for (size_t i = first; i < last; i++)
+                        memcpy(requests[i].Buffer, buffer.data() + (requests[i].Address - begin), requests[i].Size);
+                    return;
+                }
+                for (size_t i = first; i < last; i++)
+                    result &= memory.Read(requests[i].Address, requests[i].Buffer, static_cast<DWORD>(requests[i].Size));
+            });
+        return result;
+    }
+};
+
+#endif //DEBUGGER_PATCH_BATCH_HPP
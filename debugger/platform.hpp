@@ -0,0 +1,60 @@
+#ifndef DEBUGGER_PLATFORM_HPP
+#define DEBUGGER_PLATFORM_HPP
+
+/*!
+* @brief Win32 types & constants used by process independent code (memory handles, hook planning & code generation).
+* @brief On Windows it's Windows.h itself. Elsewhere the subset is defined here, so that code builds against SimulatedProcess;
+* @brief it must be built as 32 bit (-m32): code templates store addresses of 32 bit process as pointers.
+*/
+#ifdef _WIN32
+//#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+//#undef WIN32_LEAN_AND_MEAN
+#else
+#include <cstddef>
+#include <cstdint>
+
+static_assert(sizeof(void*) == 4, "Injector core must be built for 32 bit target (-m32)");
+
+#ifndef __cdecl
+#define __cdecl   __attribute__((cdecl))
+#endif
+#ifndef __stdcall
+#define __stdcall __attribute__((stdcall))
+#endif
+#ifndef __fastcall
+#define __fastcall __attribute__((fastcall))
+#endif
+#define WINAPI __stdcall
+
+using BYTE      = unsigned char;
+using WORD      = unsigned short;
+using DWORD     = unsigned long;
+using BOOL      = int;
+using LONG      = long;
+using HRESULT   = long;
+using SIZE_T    = size_t;
+using ULONG_PTR = uintptr_t;
+using LPVOID    = void*;
+using LPCVOID   = void const*;
+using HANDLE    = void*;
+using HMODULE   = struct HINSTANCE__*;
+using FARPROC   = int (__stdcall*)();
+using LPTHREAD_START_ROUTINE = DWORD (__stdcall*)(LPVOID);
+
+#define TRUE  1
+#define FALSE 0
+
+#define MEM_COMMIT             0x00001000
+#define MEM_RESERVE            0x00002000
+#define MEM_RELEASE            0x00008000
+
+#define PAGE_NOACCESS          0x01
+#define PAGE_READONLY          0x02
+#define PAGE_READWRITE         0x04
+#define PAGE_EXECUTE           0x10
+#define PAGE_EXECUTE_READ      0x20
+#define PAGE_EXECUTE_READWRITE 0x40
+#endif
+
+#endif //DEBUGGER_PLATFORM_HPP
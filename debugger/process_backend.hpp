@@ -0,0 +1,29 @@
+#ifndef DEBUGGER_PROCESS_BACKEND_HPP
+#define DEBUGGER_PROCESS_BACKEND_HPP
+
+#include "typedefs.hpp"
+
+/*!
+* @brief Access to virtual memory of 32 bit process: read, write, allocate, free & protect.
+* @brief VirtualMemoryHandle, RemoteArena & ProcessMemory work through it, so the same hook planning and code generation
+* @brief run against real process (Win32ProcessBackend) or against SimulatedProcess (any platform, no process at all).
+* @brief Semantics follow ReadProcessMemory / WriteProcessMemory / VirtualAllocEx / VirtualFreeEx / VirtualProtectEx.
+*/
+class ProcessBackend
+{
+public:
+    virtual ~ProcessBackend() = default;
+
+    // `transferred` (if set) receives count of bytes actually read, the read fails if it's not the whole range
+    virtual bool    Read(void const* address, void* buffer, size_t size, size_t* transferred = nullptr) = 0;
+    virtual bool    Write(void* address, void const* buffer, size_t size, size_t* transferred = nullptr) = 0;
+    // Reserves & commits memory at address (nullptr - anywhere), returns nullptr on failure
+    virtual Address Allocate(Address address, size_t size, DWORD protection) = 0;
+    // Releases whole allocation which starts at address
+    virtual bool    Free(Address address) = 0;
+    virtual bool    Protect(Address address, size_t size, DWORD protection, DWORD* previous = nullptr) = 0;
+    // Error code of last failed call (GetLastError on Windows)
+    virtual DWORD   LastError() const = 0;
+};
+
+#endif //DEBUGGER_PROCESS_BACKEND_HPP
@@ -1,59 +1,112 @@
 #ifndef DEBUGGER_PROCESS_MEMORY_HPP
 #define DEBUGGER_PROCESS_MEMORY_HPP
 
+#include <algorithm>
 #include <list>
+#include <map>
+#include <memory>
+#include "process_backend.hpp"
+#include "win32_process_backend.hpp"
 #include "virtual_memory_handle.hpp"
+#include "remote_arena.hpp"
 
 /*!
 * @autor multfinite
 * @brief First, it provides functions to read\\write\\allocate\\free memory of process.
 * @brief Second, it is container of VirtualMemoryHandle instances.
+* @brief Handles are blocks of RemoteArena: code and data are sub-allocated from separate reservations.
 * @brief Used by Debugger to manipulate memory of debugged process.
-* @brief It wraps WINAPI calls.
+* @brief It works through ProcessBackend: Win32ProcessBackend (owned) for process handle, any backend (not owned) otherwise.
 * @brief Should be used when needs to access memory of different process.
 */
 class ProcessMemory final
 {
 private:
-    HANDLE _process { nullptr };
+    using HandleIterator = std::list<VirtualMemoryHandle>::iterator;
+
+    // owned backend of process handle, heap allocated so pointers of arena & handles survive move
+    std::unique_ptr<ProcessBackend> _ownBackend;
+    ProcessBackend* _process { nullptr };
     bool _freeMemory = true;
+    RemoteArena _arena;
+    // handles with allocated memory by address
+    std::map<BYTE*, HandleIterator> _handleIndex;
 
+    VirtualMemoryHandle& emplace_handle(size_t size, MemoryPool pool)
+    {
+        BYTE* const block = _arena.Allocate(size, pool);
+        // blocks are owned by arena, so handle must not free them itself
+        auto& vmh = MemoryHandles.emplace_back(block, block ? size : 0, _process, false);
+        if (block)
+            _handleIndex.emplace(block, std::prev(MemoryHandles.end()));
+        return vmh;
+    }
 public:
     std::list<VirtualMemoryHandle> MemoryHandles;
 
     ProcessMemory() noexcept = default;
-    ProcessMemory(HANDLE process, bool freeMemory = true) : _process(process), _freeMemory(freeMemory) { }
+#ifdef _WIN32
+    ProcessMemory(HANDLE process, bool freeMemory = true) : ProcessMemory(std::make_unique<Win32ProcessBackend>(process), freeMemory) { }
+#endif
+    ProcessMemory(ProcessBackend& backend, bool freeMemory = true) : _process(&backend), _freeMemory(freeMemory), _arena(&backend, freeMemory) { }
+    ProcessMemory(std::unique_ptr<ProcessBackend> backend, bool freeMemory = true) : ProcessMemory(*backend, freeMemory)
+    {
+        _ownBackend = std::move(backend);
+    }
+    // handles are destroyed before arena releases their reservations
     ~ProcessMemory() = default;
 
     ProcessMemory(ProcessMemory& other) = delete;
     ProcessMemory& operator=(ProcessMemory& other) = delete;
 
     ProcessMemory(ProcessMemory&& other) noexcept :
+        _ownBackend(std::move(other._ownBackend)),
         _process(std::exchange(other._process, nullptr)),
+        _freeMemory(other._freeMemory),
+        _arena(std::move(other._arena)),
+        _handleIndex(std::exchange(other._handleIndex, {})),
         MemoryHandles(std::exchange(other.MemoryHandles, {})) { }
     ProcessMemory& operator=(ProcessMemory&& other) noexcept
     {
         _process = std::exchange(other._process, nullptr);
+        _freeMemory = other._freeMemory;
         MemoryHandles = std::exchange(other.MemoryHandles, {});
+        _handleIndex = std::exchange(other._handleIndex, {});
+        _arena = std::move(other._arena);
+        // previous backend is released after memory which it served
+        _ownBackend = std::move(other._ownBackend);
         return  *this;
     }
 
-    bool Read(void const* address, void* buffer, DWORD size) { return (ReadProcessMemory(_process, address, buffer, size, nullptr) != FALSE); }
+    bool Read(void const* address, void* buffer, DWORD size)
+    {
+        MemoryCounters::count_read(size);
+        bool const result = _process && _process->Read(address, buffer, size);
+        EventRecorder::MemoryRead(address, buffer, size, result);
+        return result;
+    }
     bool ReadSingleByte(Address address, BYTE* returnValue)
     {
-        SIZE_T sz = 0;
-        bool const result = ReadProcessMemory(_process, address, returnValue, sizeof(BYTE), &sz);
+        MemoryCounters::count_read(sizeof(BYTE));
+        bool const result = _process && _process->Read(address, returnValue, sizeof(BYTE));
+        EventRecorder::MemoryRead(address, returnValue, sizeof(BYTE), result);
+        return result;
+    }
+    bool Write(void* address, void const* buffer, DWORD size)
+    {
+        MemoryCounters::count_write(size);
+        bool const result = _process && _process->Write(address, buffer, size);
+        EventRecorder::MemoryWritten(address, buffer, size, result);
         return result;
     }
-    bool Write(void* address, void const* buffer, DWORD size) { return (WriteProcessMemory(_process, address, buffer, size, nullptr) != FALSE); }
 
-    VirtualMemoryHandle& Allocate(size_t size)
+    VirtualMemoryHandle& Allocate(size_t size, MemoryPool pool = MemoryPool::Data)
     {
-        return MemoryHandles.emplace_back(_process, size, _freeMemory);
+        return emplace_handle(size, pool);
     }
-    VirtualMemoryHandle& Allocate(BYTE* pData, size_t size)
+    VirtualMemoryHandle& Allocate(BYTE* pData, size_t size, MemoryPool pool = MemoryPool::Data)
     {
-        auto& vmh = MemoryHandles.emplace_back(_process, size, _freeMemory);
+        auto& vmh = emplace_handle(size, pool);
         vmh.Write(pData, size, 0);
         return vmh;
     }
@@ -61,13 +114,24 @@ public:
     VirtualMemoryHandle& Allocate(TInput& val)
     {
         size_t const size = sizeof(TInput);
-        auto& vmh = MemoryHandles.emplace_back(_process, size, _freeMemory);
+        auto& vmh = emplace_handle(size, MemoryPool::Data);
         vmh.Write(&val, size, 0);
         return vmh;
     }
 
     bool Free(VirtualMemoryHandle& handle)
     {
+        BYTE* const block = handle.Pointer();
+        auto const indexed = _handleIndex.find(block);
+        if (indexed != _handleIndex.end())
+        {
+            MemoryHandles.erase(indexed->second);
+            _handleIndex.erase(indexed);
+            _arena.Free(block);
+            return true;
+        }
+
+        // handle without memory (allocation failed)
         std::list<VirtualMemoryHandle>::iterator iterator = std::find(MemoryHandles.begin(), MemoryHandles.end(), handle);
         const bool contains = iterator != MemoryHandles.end();
         if (contains)
@@ -75,12 +139,15 @@ public:
         return contains;
     }
 
+    // Code allocated so far becomes read-execute, further code allocations go to new reservation
+    bool SealCode()
+    {
+        return _arena.SealCode();
+    }
+
     bool IsVirtualAddress(Address address) const noexcept
     {
-        for (VirtualMemoryHandle const& mh : MemoryHandles)
-            if (mh.IsOwned(address))
-                return true;
-        return false;
+        return _arena.IsOwned(address);
     }
 };
 #endif //DEBUGGER_PROCESS_MEMORY_HPP
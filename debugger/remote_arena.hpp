@@ -0,0 +1,168 @@
+#ifndef DEBUGGER_REMOTE_ARENA_HPP
+#define DEBUGGER_REMOTE_ARENA_HPP
+
+#include <list>
+#include <map>
+#include <utility>
+
+#include "typedefs.hpp"
+#include "virtual_memory_handle.hpp"
+
+enum class MemoryPool
+{
+    Data = 0, // read-write
+    Code = 1, // read-write-execute until sealed, read-execute after
+};
+
+/*!
+* @brief Sub-allocates memory of process from a few big reservations instead of one VirtualAllocEx per request.
+* @brief Code and data live in separate reservations: data pages are never executable,
+* @brief code pages become read-execute when pool is sealed (new code requests go to a fresh reservation).
+* @brief Live blocks are indexed by start address, so ownership lookups are O(log n).
+* @brief Reservation is released when its last block is freed.
+*/
+class RemoteArena final
+{
+public:
+    // Allocation granularity of VirtualAllocEx - smaller reservations would waste the rest of granule anyway
+    static constexpr size_t ReservationSize = 0x10000;
+    static constexpr size_t BlockAlignment  = 0x10;
+private:
+    struct Reservation
+    {
+        VirtualMemoryHandle Memory;
+        MemoryPool          Pool;
+        size_t              Used   = 0;
+        size_t              Live   = 0;
+        bool                Sealed = false;
+    };
+    struct Block
+    {
+        size_t       Size;
+        Reservation* Owner;
+    };
+
+    ProcessBackend*         _process    { nullptr };
+    bool                    _freeMemory = true;
+    std::list<Reservation>  _reservations;
+    // reservation which serves next requests of pool
+    Reservation*            _open[2]    { nullptr, nullptr };
+    // live blocks by start address
+    std::map<BYTE*, Block>  _blocks;
+
+    static size_t align(size_t value, size_t alignment) noexcept { return (value + alignment - 1) & ~(alignment - 1); }
+    static DWORD  protection_of(MemoryPool pool) noexcept { return pool == MemoryPool::Code ? PAGE_EXECUTE_READWRITE : PAGE_READWRITE; }
+
+    Reservation* reserve(MemoryPool pool, size_t size)
+    {
+        size_t const reservationSize = align(size > ReservationSize ? size : ReservationSize, ReservationSize);
+        VirtualMemoryHandle memory { _process, nullptr, reservationSize, _freeMemory, protection_of(pool) };
+        if (!memory.Pointer())
+            return nullptr;
+        return &_reservations.emplace_back(Reservation { std::move(memory), pool });
+    }
+    void release(Reservation* reservation)
+    {
+        for (Reservation*& open : _open)
+            if (open == reservation)
+                open = nullptr;
+        _reservations.remove_if([reservation](Reservation const& r) { return &r == reservation; });
+    }
+public:
+    RemoteArena() noexcept = default;
+    RemoteArena(ProcessBackend* process, bool freeMemory = true) noexcept : _process(process), _freeMemory(freeMemory) { }
+
+    RemoteArena(RemoteArena const&) = delete;
+    RemoteArena& operator=(RemoteArena const&) = delete;
+
+    // list nodes are not relocated by move, so pointers to reservations remain valid
+    RemoteArena(RemoteArena&& other) noexcept :
+        _process(std::exchange(other._process, nullptr)),
+        _freeMemory(other._freeMemory),
+        _reservations(std::exchange(other._reservations, {})),
+        _open { std::exchange(other._open[0], nullptr), std::exchange(other._open[1], nullptr) },
+        _blocks(std::exchange(other._blocks, {})) { }
+    RemoteArena& operator=(RemoteArena&& other) noexcept
+    {
+        if (this != &other)
+        {
+            _process      = std::exchange(other._process, nullptr);
+            _freeMemory   = other._freeMemory;
+            _reservations = std::exchange(other._reservations, {});
+            _open[0]      = std::exchange(other._open[0], nullptr);
+            _open[1]      = std::exchange(other._open[1], nullptr);
+            _blocks       = std::exchange(other._blocks, {});
+        }
+        return *this;
+    }
+
+    // Returns nullptr if memory can't be reserved
+    BYTE* Allocate(size_t size, MemoryPool pool = MemoryPool::Data)
+    {
+        if (!_process || !size)
+            return nullptr;
+
+        size_t const blockSize = align(size, BlockAlignment);
+        Reservation*& open = _open[static_cast<size_t>(pool)];
+        Reservation* target = open;
+        if (!target || target->Sealed || target->Used + blockSize > target->Memory.Size())
+        {
+            target = reserve(pool, blockSize);
+            if (!target)
+                return nullptr;
+            // big requests get a reservation of their own, open one keeps serving small requests
+            if (blockSize < ReservationSize)
+                open = target;
+        }
+
+        BYTE* const block = target->Memory.Pointer(target->Used);
+        target->Used += blockSize;
+        target->Live++;
+        _blocks.emplace(block, Block { blockSize, target });
+        return block;
+    }
+
+    // Returns false if address is not a start of live block
+    bool Free(Address address)
+    {
+        auto const it = _blocks.find(static_cast<BYTE*>(address));
+        if (it == _blocks.end())
+            return false;
+
+        Reservation* const reservation = it->second.Owner;
+        _blocks.erase(it);
+        if (--reservation->Live == 0)
+            release(reservation);
+        return true;
+    }
+
+    // Whether address belongs to a live block
+    bool IsOwned(Address address) const noexcept
+    {
+        BYTE* const where = static_cast<BYTE*>(address);
+        auto it = _blocks.upper_bound(where);
+        if (it == _blocks.begin())
+            return false;
+        --it;
+        return where < it->first + it->second.Size;
+    }
+
+    // Makes all code reservations read-execute, returns false if protection of any of them wasn't changed
+    bool SealCode()
+    {
+        bool result = true;
+        for (Reservation& reservation : _reservations)
+        {
+            if (reservation.Pool != MemoryPool::Code || reservation.Sealed)
+                continue;
+            result &= reservation.Memory.Protect(PAGE_EXECUTE_READ);
+            reservation.Sealed = true;
+        }
+        return result;
+    }
+
+    size_t Reservations() const noexcept { return _reservations.size(); }
+    size_t Blocks()       const noexcept { return _blocks.size(); }
+};
+
+#endif //DEBUGGER_REMOTE_ARENA_HPP
@@ -0,0 +1,128 @@
+#ifndef DEBUGGER_SHARED_SECTION_HPP
+#define DEBUGGER_SHARED_SECTION_HPP
+
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <string.hpp>
+
+#include "typedefs.hpp"
+
+/*!
+* @brief Named pagefile-backed section mapped both into injector and into debugged process.
+* @brief Injector reads & writes it through local view (no ReadProcessMemory), code in process uses remote view.
+* @brief Local view stays readable after process exit, so data written by process can be collected at exit.
+* @brief Remote view is created by NtMapViewOfSection - process doesn't need to cooperate.
+* @brief Not copyable.
+* @brief Moveable.
+*/
+class SharedSection final
+{
+public:
+    struct MappingException : std::runtime_error
+    {
+        std::string const Name;
+        DWORD       const LastError;
+
+        MappingException(std::string const& name, DWORD lastError) :
+            std::runtime_error(Utilities::string_format("Unable to map shared section \"%s\", error: 0x%x", name.c_str(), lastError)),
+            Name(name), LastError(lastError) {}
+    };
+private:
+    using NtMapViewOfSectionFunction   = NTSTATUS(NTAPI*)(HANDLE, HANDLE, PVOID*, ULONG_PTR, SIZE_T, LARGE_INTEGER*, SIZE_T*, DWORD, ULONG, ULONG);
+    using NtUnmapViewOfSectionFunction = NTSTATUS(NTAPI*)(HANDLE, PVOID);
+    // SECTION_INHERIT::ViewUnmap - view is not inherited by child processes
+    static constexpr DWORD ViewUnmap = 2;
+
+    std::string _name;
+    HANDLE      _mapping { nullptr };
+    HANDLE      _process { nullptr };
+    BYTE*       _local   { nullptr };
+    Address     _remote  { nullptr };
+    size_t      _size    = 0;
+
+    static FARPROC ntdll(const char* name) { return GetProcAddress(GetModuleHandleA("ntdll.dll"), name); }
+
+    void close() noexcept
+    {
+        if (_remote && _process)
+            if (auto unmap = reinterpret_cast<NtUnmapViewOfSectionFunction>(ntdll("NtUnmapViewOfSection")))
+                unmap(_process, _remote);
+        if (_local)
+            UnmapViewOfFile(_local);
+        if (_mapping)
+            CloseHandle(_mapping);
+
+        _remote  = nullptr;
+        _local   = nullptr;
+        _mapping = nullptr;
+        _size    = 0;
+    }
+public:
+    SharedSection() noexcept = default;
+    SharedSection(HANDLE process, std::string const& name, size_t size) : _name(name), _process(process), _size(size)
+    {
+        _mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, 0, static_cast<DWORD>(size), _name.c_str());
+        if (_mapping)
+            _local = static_cast<BYTE*>(MapViewOfFile(_mapping, FILE_MAP_ALL_ACCESS, 0, 0, size));
+        if (!_local)
+        {
+            MappingException ex { _name, GetLastError() };
+            close();
+            throw ex;
+        }
+        memset(_local, 0, size);
+
+        auto map = reinterpret_cast<NtMapViewOfSectionFunction>(ntdll("NtMapViewOfSection"));
+        SIZE_T viewSize = 0;
+        NTSTATUS const status = map
+            ? map(_mapping, _process, &_remote, 0, 0, nullptr, &viewSize, ViewUnmap, 0, PAGE_READWRITE)
+            : static_cast<NTSTATUS>(ERROR_PROC_NOT_FOUND);
+        if (status < 0 || !_remote)
+        {
+            _remote = nullptr;
+            close();
+            throw MappingException { _name, static_cast<DWORD>(status) };
+        }
+    }
+    ~SharedSection() { close(); }
+
+    SharedSection(SharedSection const&)            = delete;
+    SharedSection& operator=(SharedSection const&) = delete;
+
+    SharedSection(SharedSection&& other) noexcept :
+        _name(std::move(other._name)),
+        _mapping(std::exchange(other._mapping, nullptr)),
+        _process(std::exchange(other._process, nullptr)),
+        _local(std::exchange(other._local, nullptr)),
+        _remote(std::exchange(other._remote, nullptr)),
+        _size(std::exchange(other._size, 0)) { }
+    SharedSection& operator=(SharedSection&& other) noexcept
+    {
+        if (this != &other)
+        {
+            close();
+            _name    = std::move(other._name);
+            _mapping = std::exchange(other._mapping, nullptr);
+            _process = std::exchange(other._process, nullptr);
+            _local   = std::exchange(other._local, nullptr);
+            _remote  = std::exchange(other._remote, nullptr);
+            _size    = std::exchange(other._size, 0);
+        }
+        return *this;
+    }
+
+    std::string const& Name() const noexcept { return _name; }
+    size_t Size() const noexcept { return _size; }
+    bool   Empty() const noexcept { return _local == nullptr; }
+
+    // Address in injector
+    BYTE* Local(size_t offset = 0) const noexcept { return _local + offset; }
+    // Address in debugged process
+    BYTE* Remote(size_t offset = 0) const noexcept { return static_cast<BYTE*>(_remote) + offset; }
+
+    // Process is gone, remote view is released with it
+    void Orphan() noexcept { _remote = nullptr; }
+};
+
+#endif //DEBUGGER_SHARED_SECTION_HPP
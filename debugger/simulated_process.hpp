@@ -0,0 +1,280 @@
+#ifndef DEBUGGER_SIMULATED_PROCESS_HPP
+#define DEBUGGER_SIMULATED_PROCESS_HPP
+
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <iterator>
+#include <map>
+#include <vector>
+
+#include "process_backend.hpp"
+#include "event_log.hpp"
+
+/*!
+* @brief ProcessBackend without process: flat 32 bit address space of regions kept in local memory.
+* @brief Regions are either mapped by caller (images of executable & DLLs, seeded memory) or allocated through backend;
+* @brief allocations are tracked (count, live & peak bytes), so footprint of injection can be measured without Windows.
+* @brief Read & write fail on unmapped or no-access bytes like ReadProcessMemory / WriteProcessMemory do. Code is never executed.
+*/
+class SimulatedProcess final : public ProcessBackend
+{
+public:
+    static constexpr DWORD PageSize               = 0x1000;
+    // VirtualAllocEx places allocations at 64K boundaries
+    static constexpr DWORD AllocationGranularity  = 0x10000;
+    static constexpr DWORD LowestAllocation       = 0x00400000;
+    static constexpr DWORD HighestAllocation      = 0x7FFE0000;
+
+    static constexpr DWORD ErrorNotEnoughMemory   = 8;   // ERROR_NOT_ENOUGH_MEMORY
+    static constexpr DWORD ErrorInvalidParameter  = 87;  // ERROR_INVALID_PARAMETER
+    static constexpr DWORD ErrorPartialCopy       = 299; // ERROR_PARTIAL_COPY
+    static constexpr DWORD ErrorInvalidAddress    = 487; // ERROR_INVALID_ADDRESS
+
+    struct Statistics
+    {
+        size_t Allocations    = 0;
+        size_t Frees          = 0;
+        size_t AllocatedBytes = 0;
+        size_t PeakBytes      = 0;
+        size_t Reads          = 0;
+        size_t ReadBytes      = 0;
+        size_t Writes         = 0;
+        size_t WrittenBytes   = 0;
+    };
+private:
+    struct Region
+    {
+        std::vector<BYTE> Bytes;
+        DWORD             Protection;
+        // allocated through backend (tracked), mapped otherwise
+        bool              Allocated;
+    };
+
+    // regions by base address, they never overlap
+    std::map<DWORD, Region> _regions;
+    // addresses of allocations of recorded session, they are given out first (see Seed)
+    std::deque<DWORD>       _recordedAllocations;
+    DWORD                   _lastError = 0;
+
+    static DWORD value_of(void const* address) noexcept { return static_cast<DWORD>(reinterpret_cast<uintptr_t>(address)); }
+    static DWORD align_up(DWORD value, DWORD alignment) noexcept { return (value + alignment - 1) & ~(alignment - 1); }
+
+    bool fail(DWORD error) noexcept { _lastError = error; return false; }
+
+    // Whether [begin, begin + size) touches no region
+    bool is_free(DWORD begin, DWORD size) const
+    {
+        if (!size || begin + size < begin)
+            return false;
+        auto it = _regions.lower_bound(begin + size);
+        if (it == _regions.begin())
+            return true;
+        --it;
+        return it->first + it->second.Bytes.size() <= begin;
+    }
+    // Copies between range of process and local buffer, range must be covered by accessible regions without gaps
+    template<typename TCopy>
+    size_t transfer(DWORD address, size_t size, TCopy&& copy)
+    {
+        size_t done = 0;
+        auto it = _regions.upper_bound(address);
+        if (it == _regions.begin())
+            return 0;
+        --it;
+        for (; done < size && it != _regions.end(); ++it)
+        {
+            DWORD const where = address + static_cast<DWORD>(done);
+            if (it->first > where || it->second.Protection == PAGE_NOACCESS)
+                break;
+            size_t const offset = where - it->first;
+            if (offset >= it->second.Bytes.size())
+                break;
+            size_t const count = (std::min)(size - done, it->second.Bytes.size() - offset);
+            copy(it->second.Bytes.data() + offset, done, count);
+            done += count;
+        }
+        return done;
+    }
+public:
+    Statistics Stats;
+
+    SimulatedProcess() = default;
+
+    SimulatedProcess(SimulatedProcess const&) = delete;
+    SimulatedProcess& operator=(SimulatedProcess const&) = delete;
+
+    // Maps bytes at address (e.g. image of module at its base), size is rounded up to pages. Fails if range is taken.
+    bool Map(Address address, void const* data, size_t size, DWORD protection = PAGE_EXECUTE_READ)
+    {
+        DWORD const base = value_of(address) & ~(PageSize - 1);
+        DWORD const head = value_of(address) - base;
+        DWORD const mapped = align_up(static_cast<DWORD>(head + size), PageSize);
+        if (!is_free(base, mapped))
+            return fail(ErrorInvalidAddress);
+
+        Region& region = _regions.emplace(base, Region { std::vector<BYTE>(mapped), protection, false }).first->second;
+        if (data)
+            std::memcpy(region.Bytes.data() + head, data, size);
+        return true;
+    }
+
+    /*!
+    * @brief Fills address space from event log of real session (see EventRecorder): data of successful reads is mapped
+    * @brief (read-write-execute, pages which were not read are zero), addresses of recorded allocations are given out
+    * @brief by next allocations in the same order. Returns count of records applied.
+    */
+    size_t Seed(EventLogReader& log)
+    {
+        size_t applied = 0;
+        EventLogReader::Record record;
+        while (log.Next(record))
+        {
+            if (record.Kind == EventRecordKind::Allocation)
+            {
+                _recordedAllocations.push_back(record.As<AllocationRecord>().Address);
+                applied++;
+                continue;
+            }
+            if (record.Kind != EventRecordKind::MemoryRead)
+                continue;
+
+            auto const read = record.As<MemoryRecord>();
+            auto const data = record.Trailing<MemoryRecord>();
+            if (!read.Succeeded || data.size() != read.Size)
+                continue;
+
+            Fill(read.Address, data.data(), data.size());
+            applied++;
+        }
+        return applied;
+    }
+
+    // Copies bytes into range (nullptr - only maps it), pages which are not mapped yet are mapped read-write-execute.
+    // Protection is ignored and Stats are not counted: it's memory of process as it was, not access of injector.
+    void Fill(DWORD address, void const* data, size_t size)
+    {
+        for (DWORD page = address & ~(PageSize - 1); page < address + size; page += PageSize)
+            if (is_free(page, PageSize))
+                _regions.emplace(page, Region { std::vector<BYTE>(PageSize), PAGE_EXECUTE_READWRITE, false });
+        if (data)
+            transfer(address, size, [data](BYTE* bytes, size_t offset, size_t count) { std::memcpy(bytes, static_cast<BYTE const*>(data) + offset, count); });
+    }
+
+    bool Read(void const* address, void* buffer, size_t size, size_t* transferred = nullptr) override
+    {
+        size_t const done = transfer(value_of(address), size,
+            [buffer](BYTE* bytes, size_t offset, size_t count) { std::memcpy(static_cast<BYTE*>(buffer) + offset, bytes, count); });
+        Stats.Reads++;
+        Stats.ReadBytes += done;
+        if (transferred)
+            *transferred = done;
+        return done == size || fail(ErrorPartialCopy);
+    }
+    bool Write(void* address, void const* buffer, size_t size, size_t* transferred = nullptr) override
+    {
+        // as WriteProcessMemory, read-only pages are written too (protection is changed for the write)
+        size_t const done = transfer(value_of(address), size,
+            [buffer](BYTE* bytes, size_t offset, size_t count) { std::memcpy(bytes, static_cast<BYTE const*>(buffer) + offset, count); });
+        Stats.Writes++;
+        Stats.WrittenBytes += done;
+        if (transferred)
+            *transferred = done;
+        return done == size || fail(ErrorPartialCopy);
+    }
+
+    Address Allocate(Address address, size_t size, DWORD protection) override
+    {
+        if (!size || size > HighestAllocation)
+        {
+            fail(ErrorInvalidParameter);
+            return nullptr;
+        }
+
+        DWORD const allocated = align_up(static_cast<DWORD>(size), PageSize);
+        DWORD base = 0;
+        if (address)
+        {
+            base = value_of(address) & ~(AllocationGranularity - 1);
+            if (!is_free(base, allocated))
+            {
+                fail(ErrorInvalidAddress);
+                return nullptr;
+            }
+        }
+        else
+        {
+            while (!_recordedAllocations.empty() && !base)
+            {
+                DWORD const recorded = _recordedAllocations.front();
+                _recordedAllocations.pop_front();
+                if (is_free(recorded, allocated))
+                    base = recorded;
+            }
+            for (DWORD candidate = LowestAllocation; !base && candidate + allocated <= HighestAllocation; candidate += AllocationGranularity)
+            {
+                if (is_free(candidate, allocated))
+                {
+                    base = candidate;
+                    break;
+                }
+                // skip behind region which takes candidate
+                auto it = _regions.upper_bound(candidate + allocated - 1);
+                --it;
+                candidate = align_up(it->first + static_cast<DWORD>(it->second.Bytes.size()), AllocationGranularity) - AllocationGranularity;
+            }
+            if (!base)
+            {
+                fail(ErrorNotEnoughMemory);
+                return nullptr;
+            }
+        }
+
+        _regions.emplace(base, Region { std::vector<BYTE>(allocated), protection, true });
+        Stats.Allocations++;
+        Stats.AllocatedBytes += allocated;
+        Stats.PeakBytes = (std::max)(Stats.PeakBytes, Stats.AllocatedBytes);
+        return reinterpret_cast<Address>(static_cast<uintptr_t>(base));
+    }
+    bool Free(Address address) override
+    {
+        auto const it = _regions.find(value_of(address));
+        if (it == _regions.end() || !it->second.Allocated)
+            return fail(ErrorInvalidAddress);
+
+        Stats.Frees++;
+        Stats.AllocatedBytes -= it->second.Bytes.size();
+        _regions.erase(it);
+        return true;
+    }
+    bool Protect(Address address, size_t size, DWORD protection, DWORD* previous = nullptr) override
+    {
+        // whole regions only, regions are not split
+        DWORD const begin = value_of(address);
+        auto it = _regions.upper_bound(begin);
+        if (it == _regions.begin())
+            return fail(ErrorInvalidAddress);
+        --it;
+        if (begin + size > it->first + it->second.Bytes.size())
+            return fail(ErrorInvalidAddress);
+        if (previous)
+            *previous = it->second.Protection;
+        it->second.Protection = protection;
+        return true;
+    }
+    DWORD LastError() const override { return _lastError; }
+
+    // Protection of region which holds address, PAGE_NOACCESS if address is not mapped
+    DWORD ProtectionOf(Address address) const
+    {
+        DWORD const where = value_of(address);
+        auto it = _regions.upper_bound(where);
+        if (it == _regions.begin())
+            return PAGE_NOACCESS;
+        --it;
+        return where < it->first + it->second.Bytes.size() ? it->second.Protection : PAGE_NOACCESS;
+    }
+    size_t Regions() const noexcept { return _regions.size(); }
+};
+
+#endif //DEBUGGER_SIMULATED_PROCESS_HPP
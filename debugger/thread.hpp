@@ -2,6 +2,7 @@
 #define DEBUGGER_THREAD_HPP
 
 #include "typedefs.hpp"
+#include "event_recorder.hpp"
 
 /*!
 * @autor multfinite
@@ -80,30 +81,37 @@ public:
         {
             Context.ContextFlags = CONTEXT_CONTROL;
             auto r = GetThreadContext(Handle, &Context);
+            EventRecorder::Context(false, Id, Context);
             Context.EFlags |= 0x100;
             SetThreadContext(Handle, &Context);
+            EventRecorder::Context(true, Id, Context);
         }
     void DisableSingleStep()
         {
             Context.ContextFlags = CONTEXT_FULL;
             auto r = GetThreadContext(Handle, &Context);
-            Context.EFlags &= 0x100;
+            EventRecorder::Context(false, Id, Context);
+            Context.EFlags &= ~0x100;
             r = SetThreadContext(Handle, &Context);
+            EventRecorder::Context(true, Id, Context);
         }
     CONTEXT& GetContext(ContextFlags flags)
         {
             Context.ContextFlags = flags;
             auto r = GetThreadContext(Handle, &Context);
+            EventRecorder::Context(false, Id, Context);
             return Context;
         }
     BOOL SetContext(ContextFlags flags)
         {
             Context.ContextFlags = flags;
+            EventRecorder::Context(true, Id, Context);
             return SetThreadContext(Handle, &Context);
         }
     BOOL SetContext(CONTEXT& context)
         {
             Context = context;
+            EventRecorder::Context(true, Id, Context);
             return SetThreadContext(Handle, &Context);
         }
     DWORD Resume()                  { return ResumeThread(Handle); }
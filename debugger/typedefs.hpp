@@ -1,9 +1,7 @@
 ﻿#ifndef DEBUGGER_TYPEDEFS_HPP
 #define DEBUGGER_TYPEDEFS_HPP
 
-//#define WIN32_LEAN_AND_MEAN
-#include <Windows.h>
-//#undef WIN32_LEAN_AND_MEAN
+#include "platform.hpp"
 
 using ProcessHandle          = HANDLE;
 using ProcessId              = DWORD;
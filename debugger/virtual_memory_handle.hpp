@@ -2,14 +2,18 @@
 #define DEBUGGER_VIRTUAL_MEMORY_HANDLE_HPP
 
 #include <stdexcept>
+#include <utility>
 #include <string.hpp>
 #include "typedefs.hpp"
+#include "process_backend.hpp"
+#include "memory_counters.hpp"
+#include "event_recorder.hpp"
 
 /*!
 * @autor multfinite
 * @brief Manage virtual memory allocation in any process.
 * @brief Should be used when need to allocate a memory space in different process.
-* @brief It wraps WINAPI calls.
+* @brief It works through ProcessBackend (WINAPI calls for real process).
 */
 class VirtualMemoryHandle final
 {
@@ -33,7 +37,7 @@ public:
         DWORD               const  LastError;
 
         WriteMemoryException(VirtualMemoryHandle const& handle, void* pWhere, size_t size, size_t writtenSize) :
-            Handle(handle), Where(pWhere), Size(size), WrittenSize(writtenSize), LastError(GetLastError()),
+            Handle(handle), Where(pWhere), Size(size), WrittenSize(writtenSize), LastError(handle.last_error()),
             std::runtime_error(Utilities::string_format("VMH Write error [address = 0x%x] at 0x%x, count: %u, written: %u", (DWORD) Handle[0], (DWORD) pWhere, size, writtenSize)) {}
     };
     struct ReadMemoryException : std::runtime_error
@@ -45,27 +49,30 @@ public:
         DWORD               const  LastError;
 
         ReadMemoryException(VirtualMemoryHandle const& handle, void* pWhere, size_t size, size_t readdenSize) :
-            Handle(handle), Where(pWhere), Size(size), ReaddenSize(readdenSize), LastError(GetLastError()),
+            Handle(handle), Where(pWhere), Size(size), ReaddenSize(readdenSize), LastError(handle.last_error()),
             std::runtime_error(Utilities::string_format("VMH Read error [address = 0x%x] at 0x%x, count: %u, readden: %u", (DWORD) Handle[0], (DWORD) pWhere, size, readdenSize)) {}
     };
 private:
-    LPVOID _value      { nullptr };
-    HANDLE _process    { nullptr };
-    SIZE_T _size       = 0;
-    bool   _freeMemory = true;
+    LPVOID          _value      { nullptr };
+    ProcessBackend* _process    { nullptr };
+    SIZE_T          _size       = 0;
+    bool            _freeMemory = true;
+
+    DWORD last_error() const noexcept { return _process ? _process->LastError() : 0; }
 public:
     VirtualMemoryHandle() noexcept;
-    VirtualMemoryHandle(HANDLE process, SIZE_T size, bool freeMemory = true) noexcept : VirtualMemoryHandle(process, nullptr, size, freeMemory) { }
-    VirtualMemoryHandle(HANDLE process, LPVOID address, SIZE_T size, bool freeMemory = true) noexcept
+    VirtualMemoryHandle(ProcessBackend* process, SIZE_T size, bool freeMemory = true) noexcept : VirtualMemoryHandle(process, nullptr, size, freeMemory) { }
+    VirtualMemoryHandle(ProcessBackend* process, LPVOID address, SIZE_T size, bool freeMemory = true, DWORD protection = PAGE_EXECUTE_READWRITE) noexcept
         : _process(process), _freeMemory(freeMemory)
     {
         if (process && size)
         {
-            this->_value = VirtualAllocEx(process, address, size, MEM_RESERVE | MEM_COMMIT, PAGE_EXECUTE_READWRITE);
+            this->_value = process->Allocate(address, size, protection);
             _size = size;
+            EventRecorder::Allocated(this->_value, size, protection);
         }
     }
-    VirtualMemoryHandle(LPVOID allocated, SIZE_T size, HANDLE process, bool freeMemory = true) noexcept
+    VirtualMemoryHandle(LPVOID allocated, SIZE_T size, ProcessBackend* process, bool freeMemory = true) noexcept
         : _value(allocated), _process(process), _size(size), _freeMemory(freeMemory) { }
 
     VirtualMemoryHandle(VirtualMemoryHandle&& other) noexcept :
@@ -91,7 +98,7 @@ public:
     ~VirtualMemoryHandle() noexcept
     {
         if (_freeMemory && this->_value && this->_process)
-            VirtualFreeEx(this->_process, this->_value, 0, MEM_RELEASE);
+            this->_process->Free(this->_value);
     }
 
     friend bool operator==(VirtualMemoryHandle const& lhs, VirtualMemoryHandle const& rhs)
@@ -109,8 +116,10 @@ public:
         BYTE* max = operator[](_size);
         if (max < pLast)
             throw OutOfRangeException { *this, (void*) dest, count };
-        SIZE_T writtenCount = 0;
-        const bool result = WriteProcessMemory(_process, dest, data, count, &writtenCount) != FALSE;
+        size_t writtenCount = 0;
+        const bool result = _process && _process->Write(dest, data, count, &writtenCount);
+        MemoryCounters::count_write(count);
+        EventRecorder::MemoryWritten(dest, data, count, result);
         if (!result)
             throw WriteMemoryException { *this, (void*) dest, count, writtenCount };
         if (writtenCount != count)
@@ -125,14 +134,21 @@ public:
         if (max < pLast)
             throw OutOfRangeException { *this, (void*) pFirst, count };
 
-        SIZE_T readdenBytes;
-        const bool result = ReadProcessMemory(_process, pFirst, buffer, count, &readdenBytes) != FALSE;
+        size_t readdenBytes = 0;
+        const bool result = _process && _process->Read(pFirst, buffer, count, &readdenBytes);
+        MemoryCounters::count_read(count);
+        EventRecorder::MemoryRead(pFirst, buffer, count, result && readdenBytes == count);
         if (!result)
             throw ReadMemoryException { *this, (void*) pFirst, count, readdenBytes };
         if (readdenBytes != count)
             throw ReadMemoryException { *this, (void*) pFirst, count, readdenBytes };
     }
 
+    bool Protect(DWORD protection) const noexcept
+    {
+        return _value && _process->Protect(_value, _size, protection);
+    }
+
     bool IsOwned(Address address) const noexcept
     {
         Address const min = _value;
@@ -0,0 +1,54 @@
+#ifndef DEBUGGER_WIN32_PROCESS_BACKEND_HPP
+#define DEBUGGER_WIN32_PROCESS_BACKEND_HPP
+
+#ifdef _WIN32
+#include "process_backend.hpp"
+
+/*!
+* @brief ProcessBackend of real process: WINAPI calls on process handle. Handle is not owned.
+*/
+class Win32ProcessBackend final : public ProcessBackend
+{
+    HANDLE _process { nullptr };
+public:
+    explicit Win32ProcessBackend(HANDLE process) noexcept : _process(process) { }
+
+    HANDLE Handle() const noexcept { return _process; }
+
+    bool Read(void const* address, void* buffer, size_t size, size_t* transferred = nullptr) override
+    {
+        SIZE_T count = 0;
+        bool const result = ReadProcessMemory(_process, address, buffer, size, &count) != FALSE;
+        if (transferred)
+            *transferred = count;
+        return result;
+    }
+    bool Write(void* address, void const* buffer, size_t size, size_t* transferred = nullptr) override
+    {
+        SIZE_T count = 0;
+        bool const result = WriteProcessMemory(_process, address, buffer, size, &count) != FALSE;
+        if (transferred)
+            *transferred = count;
+        return result;
+    }
+    Address Allocate(Address address, size_t size, DWORD protection) override
+    {
+        return VirtualAllocEx(_process, address, size, MEM_RESERVE | MEM_COMMIT, protection);
+    }
+    bool Free(Address address) override
+    {
+        return VirtualFreeEx(_process, address, 0, MEM_RELEASE) != FALSE;
+    }
+    bool Protect(Address address, size_t size, DWORD protection, DWORD* previous = nullptr) override
+    {
+        DWORD old = 0;
+        bool const result = VirtualProtectEx(_process, address, size, protection, &old) != FALSE;
+        if (previous)
+            *previous = old;
+        return result;
+    }
+    DWORD LastError() const override { return GetLastError(); }
+};
+#endif
+
+#endif //DEBUGGER_WIN32_PROCESS_BACKEND_HPP
@@ -224,6 +224,12 @@ public:
 //e.g. EXPORT FunctionName(REGISTERS* R)
 #define EXPORT extern "C" __declspec(dllexport) DWORD __cdecl
 #define EXPORT_FUNC(name) extern "C" __declspec(dllexport) DWORD __cdecl name (REGISTERS *R)
+// Lean hook function, arguments are registers declared by LEAN_REGISTERS (missing ones are 0)
+// NOTE: it's exported as decorated "@name@8", injector looks for that name
+#define EXPORT_LEAN_FUNC(name) extern "C" __declspec(dllexport) DWORD __fastcall name (DWORD A1, DWORD A2)
+// Functions of direct hooks are referred by address from hook manifest, they aren't exported
+#define DIRECT_FUNC(name) extern "C" DWORD __cdecl name (REGISTERS *R)
+#define DIRECT_LEAN_FUNC(name) extern "C" DWORD __fastcall name (DWORD A1, DWORD A2)
 
 
 //Handshake definitions
@@ -257,6 +263,9 @@ namespace SyringeData { namespace Hosts { __declspec(allocate(".syexe00")) HostD
 #define declhook(hook, funcname, size) \
 namespace SyringeData { namespace Hooks { __declspec(allocate(".syhks00")) HookDecl _hk__ ## hook ## funcname = { ## hook, ## size, #funcname }; }; };
 
+#define declleanhook(hook, funcname, size, registers) \
+namespace SyringeData { namespace Hooks { __declspec(allocate(".syhks02")) LeanHookDecl _hk__ ## hook ## funcname = { ## hook, ## size, #funcname, registers }; }; };
+
 #define decldllhook(prefix, name, checksum, hook, funcname, size) \
 namespace SyringeData { namespace Hooks { __declspec(allocate(".syhks01")) ExtendedHookDecl _hk__ ## prefix ## hook ## funcname = { ## hook, ## size, #funcname, #name, ## checksum }; }; };
 
@@ -266,6 +275,13 @@ namespace SyringeData { namespace FunctionReplacements { __declspec(allocate(".s
 #define declarefunctionreplacement1(prefix, name, checksum, targetaddr, funcname) \
 namespace SyringeData { namespace FunctionReplacements { __declspec(allocate(".syfrh01")) FunctionReplacement1Decl _fr1__ ## prefix ## hook ## funcname = { #targetaddr, #funcname, #name, ## checksum }; }; };
 
+// Header of direct hook manifest, must be used once per module (in any source file) for DEFINE_HOOK_DIRECT* to take effect
+#define SYRINGE_HOOK_MANIFEST \
+namespace SyringeData { namespace Hooks { __declspec(allocate(".syhkm$a")) HookManifestHeader _hkm__header = { HookManifestSignature, HookManifestVersion, 0, sizeof(HookManifestEntry) }; }; };
+
+#define decldirecthook(prefix, type, hook, funcname, size, registers, name, checksum) \
+namespace SyringeData { namespace Hooks { __declspec(allocate(".syhkm$b")) HookManifestEntry _hkm__ ## prefix ## hook ## funcname = { hook, size, type, reinterpret_cast<const void*>(&funcname), registers, name, checksum }; }; };
+
 // Defines a hook at the specified address with the specified name and saving the specified amount of instruction bytes to be restored if return to the same address is used. In addition to the injgen-declaration, also includes the function opening.
 #define DEFINE_HOOK(hook, funcname, size) \
 declhook(hook, funcname, size) \
@@ -275,6 +291,18 @@ EXPORT_FUNC(funcname)
 #define DEFINE_HOOK_AGAIN(hook, funcname, size) \
 declhook(hook, funcname, size)
 
+// Defines a lean hook on executable: no REGISTERS frame, only EAX, ECX, EDX (and flags, if requested) are saved around the call.
+// registers: LEAN_REGISTERS(arg1, arg2, result, preserveFlags) - registers passed as A1 & A2, register which receives returned value (LHR_None - value is ignored).
+// Lean hook always continues with overridden instructions, returned value is not an address.
+// DEFINE_HOOK_LEAN(0x401000, CountCalls, 5, LEAN_REGISTERS(LHR_ECX, LHR_None, LHR_None, false))
+#define DEFINE_HOOK_LEAN(hook, funcname, size, registers) \
+declleanhook(hook, funcname, size, registers) \
+EXPORT_LEAN_FUNC(funcname)
+// Does the same as DEFINE_HOOK_LEAN but no function opening.
+// CAUTION: funcname must be the same as in DEFINE_HOOK_LEAN.
+#define DEFINE_HOOK_LEAN_AGAIN(hook, funcname, size, registers) \
+declleanhook(hook, funcname, size, registers)
+
 // Defines a hook at the specified address with the specified name and saving the specified amount of instruction bytes to be restored if return to the same address is used. In addition to the injgen-declaration, also includes the function opening.
 // checksum: 0 - any module version, specific value - for module with specific checksum
 // name: nullptr - on executable, any string literal "Ares.dll" - for specific module
@@ -288,6 +316,34 @@ EXPORT_FUNC(funcname)
 #define DEFINE_HOOK_EX_AGAIN(hook, funcname, size, prefix, name, checksum) \
 decldllhook(prefix, name, checksum, hook, funcname, size)
 
+// Direct hooks: the same as DEFINE_HOOK, DEFINE_HOOK_LEAN & DEFINE_HOOK_EX, but hook function is stored in hook manifest by address,
+// so it's neither exported nor looked up by name. See SYRINGE_HOOK_MANIFEST.
+// DEFINE_HOOK_DIRECT(0x401000, MyHook, 5)
+#define DEFINE_HOOK_DIRECT(hook, funcname, size) \
+DIRECT_FUNC(funcname); \
+decldirecthook(, HMT_Generic, hook, funcname, size, 0, nullptr, 0) \
+DIRECT_FUNC(funcname)
+// CAUTION: funcname must be declared before, e.g. by DEFINE_HOOK_DIRECT.
+#define DEFINE_HOOK_DIRECT_AGAIN(hook, funcname, size) \
+decldirecthook(, HMT_Generic, hook, funcname, size, 0, nullptr, 0)
+
+#define DEFINE_HOOK_DIRECT_LEAN(hook, funcname, size, registers) \
+DIRECT_LEAN_FUNC(funcname); \
+decldirecthook(, HMT_Lean, hook, funcname, size, registers, nullptr, 0) \
+DIRECT_LEAN_FUNC(funcname)
+// CAUTION: funcname must be declared before, e.g. by DEFINE_HOOK_DIRECT_LEAN.
+#define DEFINE_HOOK_DIRECT_LEAN_AGAIN(hook, funcname, size, registers) \
+decldirecthook(, HMT_Lean, hook, funcname, size, registers, nullptr, 0)
+
+// DEFINE_HOOK_DIRECT_EX(0x10001000, MyHook, 5, ares, "Ares.dll", 0)
+#define DEFINE_HOOK_DIRECT_EX(hook, funcname, size, prefix, name, checksum) \
+DIRECT_FUNC(funcname); \
+decldirecthook(prefix, HMT_Extended, hook, funcname, size, 0, name, checksum) \
+DIRECT_FUNC(funcname)
+// CAUTION: funcname must be declared before, e.g. by DEFINE_HOOK_DIRECT_EX.
+#define DEFINE_HOOK_DIRECT_EX_AGAIN(hook, funcname, size, prefix, name, checksum) \
+decldirecthook(prefix, HMT_Extended, hook, funcname, size, 0, name, checksum)
+
 // this is only static declaration like DEFINE_HOOK_AGAIN & DEFINE_HOOK_AGAIN_EX and can be in any place of program
 // originalname is the function name which will be decorated
 #define REDEFINE_FUNCTION(originalname, funcname, prefix, name, checksum) \
@@ -7,6 +7,8 @@
 #include <Windows.h>
 #undef WIN32_LEAN_AND_MEAN
 
+#include "context_layout.hpp"
+
 namespace Injector
 {
     template<typename T>
@@ -24,21 +26,13 @@ namespace Injector
     /*!
     * @author Multfinite Multfinite@gmail.com
     * @brief This class should be used in injected dll to get access to injection context.
+    * @brief Context is mapped once as a whole; Header is null if it's absent or made by incompatible Syringe.
     */
     struct InjectionContextHandle
     {
-        HANDLE   ShMemHandle;
-        BYTE*    ShMemPtr;
-
-        size_t*  DataSize;
-        size_t*  ExecutableNameSize;
-        char*    ExecutableNameInStruct;
-        size_t*  ArgumentsSize;
-        char*    ArgumentsInStruct;
-        size_t*  NameLength;
-        size_t*  ModuleSize;
-        HMODULE* Handles;
-        char*    Names;
+        HANDLE                        ShMemHandle;
+        BYTE*                         ShMemPtr;
+        InjectionContextHeader const* Header;
 
         InjectionContextHandle()
         {
@@ -46,36 +40,61 @@ namespace Injector
             string memName             = "InjContext-" + std::to_string(processId);
 
             ShMemHandle                = OpenFileMapping(FILE_MAP_ALL_ACCESS, FALSE, memName.data());
-            ShMemPtr                   = static_cast<BYTE*>(MapViewOfFile(ShMemHandle, FILE_MAP_ALL_ACCESS, 0, 0, sizeof(size_t)));
-            size_t const dataSize      = *reinterpret_cast<size_t*>(ShMemPtr);
-            UnmapViewOfFile(ShMemPtr);
-
-            ShMemPtr                   = static_cast<BYTE*>(MapViewOfFile(ShMemHandle, FILE_MAP_ALL_ACCESS, 0, 0, dataSize));
-            DataSize                   = offset_ptr<size_t>(ShMemPtr, 0);
-            ExecutableNameSize         = offset_ptr<size_t>(DataSize, sizeof(size_t));
-            ExecutableNameInStruct     = offset_ptr<char>(ExecutableNameSize, sizeof(size_t));
-            ArgumentsSize              = offset_ptr<size_t>(ExecutableNameInStruct, *ExecutableNameSize + 1);
-            ArgumentsInStruct          = offset_ptr<char>(ArgumentsSize, sizeof(size_t));
-            NameLength                 = offset_ptr<size_t>(ArgumentsInStruct, *ArgumentsSize + 1);
-            ModuleSize                 = offset_ptr<size_t>(NameLength, sizeof(size_t));
-            Handles                    = offset_ptr<HMODULE>(ModuleSize, sizeof(size_t));
-            Names                      = offset_ptr<char>(Handles, sizeof(HMODULE) * *ModuleSize);
+            ShMemPtr                   = ShMemHandle ? static_cast<BYTE*>(MapViewOfFile(ShMemHandle, FILE_MAP_ALL_ACCESS, 0, 0, 0)) : nullptr;
+            Header                     = ShMemPtr ? offset_ptr<InjectionContextHeader const>(ShMemPtr, 0) : nullptr;
+            if (Header && (Header->Signature != InjectionContextHeader::Magic || Header->Revision != InjectionContextHeader::Version))
+                Header = nullptr;
         }
         ~InjectionContextHandle()
         {
-            UnmapViewOfFile(ShMemPtr);
-            CloseHandle(ShMemHandle);
-
-            ShMemPtr               = nullptr;
-            DataSize               = nullptr;
-            ExecutableNameSize     = nullptr;
-            ExecutableNameInStruct = nullptr;
-            ArgumentsSize          = nullptr;
-            ArgumentsInStruct      = nullptr;
-            NameLength             = nullptr;
-            ModuleSize             = nullptr;
-            Handles                = nullptr;
-            Names                  = nullptr;
+            if (ShMemPtr)
+                UnmapViewOfFile(ShMemPtr);
+            if (ShMemHandle)
+                CloseHandle(ShMemHandle);
+
+            ShMemPtr    = nullptr;
+            ShMemHandle = nullptr;
+            Header      = nullptr;
+        }
+
+        InjectionContextHandle(InjectionContextHandle const&) = delete;
+        InjectionContextHandle& operator=(InjectionContextHandle const&) = delete;
+
+        bool IsValid() const { return Header != nullptr; }
+
+        const char* String(DWORD offset) const { return offset_ptr<const char>(ShMemPtr, Header->StringsOffset + offset); }
+        const char* ExecutableName()     const { return String(Header->ExecutableName); }
+        const char* Arguments()          const { return String(Header->Arguments); }
+
+        DWORD                         ModuleCount() const { return Header->Modules; }
+        InjectionContextModule const* Modules()     const { return offset_ptr<InjectionContextModule const>(ShMemPtr, Header->ModulesOffset); }
+        DWORD                         PocketCount() const { return Header->Pockets; }
+        InjectionContextPocket const* Pockets()     const { return offset_ptr<InjectionContextPocket const>(ShMemPtr, Header->PocketsOffset); }
+        DWORD                         HookCount()   const { return Header->Hooks; }
+        InjectionContextHook const*   Hooks()       const { return offset_ptr<InjectionContextHook const>(ShMemPtr, Header->HooksOffset); }
+
+        // Module of process by file name (directory & case are ignored), nullptr if it's not loaded
+        InjectionContextModule const* FindModule(const char* fileName) const
+        {
+            if (!Header || !Header->IndexSize)
+                return nullptr;
+
+            string const key  = context_module_key(fileName);
+            DWORD const  hash = context_hash(key);
+            DWORD const* index = offset_ptr<DWORD const>(ShMemPtr, Header->IndexOffset);
+            DWORD const  mask  = Header->IndexSize - 1;
+            for (DWORD slot = hash & mask; index[slot]; slot = (slot + 1) & mask)
+            {
+                InjectionContextModule const& mdl = Modules()[index[slot] - 1];
+                if (mdl.Hash == hash && key == String(mdl.Key))
+                    return &mdl;
+            }
+            return nullptr;
+        }
+        HMODULE FindModuleHandle(const char* fileName) const
+        {
+            InjectionContextModule const* mdl = FindModule(fileName);
+            return mdl ? mdl->Handle : nullptr;
         }
     };
 }
@@ -0,0 +1,101 @@
+#ifndef INJECTOR_CONTEXT_LAYOUT_HPP
+#define INJECTOR_CONTEXT_LAYOUT_HPP
+
+#include <string>
+
+// Windows types are expected to be declared (Windows.h) by includer: context.hpp for injected DLLs, framework.hpp for injector
+namespace Injector
+{
+    /*!
+    * @brief Layout of injection context (shared memory 'InjContext-$PID'), written by ContextEmplacer.
+    * @brief InjectionContextHeader, then tables at offsets of header: modules, hash index of modules, pockets, hooks
+    * @brief and string pool. Strings are zero terminated, fields which refer to them are offsets into the pool (equal strings are stored once).
+    * @brief Module key is lower case file name without directory; index is open addressed (linear probing) table of
+    * @brief module index + 1 (0 - empty slot), its size is power of 2 and at least twice count of modules.
+    */
+    #pragma pack(push, 1)
+    struct InjectionContextHeader
+    {
+        static constexpr DWORD Magic   = 0x43495953; // 'SYIC'
+        static constexpr DWORD Version = 2;
+
+        DWORD Signature;
+        DWORD Revision;
+        // bytes of whole context
+        DWORD DataSize;
+        DWORD ExecutableName;
+        DWORD Arguments;
+        DWORD Modules;
+        DWORD ModulesOffset;
+        DWORD IndexSize;
+        DWORD IndexOffset;
+        DWORD Pockets;
+        DWORD PocketsOffset;
+        DWORD Hooks;
+        DWORD HooksOffset;
+        DWORD StringsSize;
+        DWORD StringsOffset;
+    };
+    struct InjectionContextModule
+    {
+        HMODULE Handle;
+        DWORD   FileName;
+        DWORD   Key;
+        DWORD   Hash;
+    };
+    struct InjectionContextPocket
+    {
+        DWORD Placement;
+        // address of pocket code in process
+        DWORD Code;
+        DWORD OverriddenCount;
+        // hooks of pocket & pockets merged into it, each hook has its own placement
+        DWORD FirstHook;
+        DWORD LeanHooks;
+        DWORD RegularHooks;
+    };
+    struct InjectionContextHook
+    {
+        DWORD Function;
+        DWORD Placement;
+        DWORD FunctionName;
+        // target module of hook, empty - executable
+        DWORD ModuleName;
+        // HookType
+        DWORD Type;
+        DWORD Size;
+        // index of pocket, NoPocket for facades
+        DWORD Pocket;
+
+        static constexpr DWORD NoPocket = 0xFFFFFFFF;
+    };
+    #pragma pack(pop)
+
+    // Lower case file name without directory, as module keys of context are made
+    inline std::string context_module_key(const char* fileName)
+    {
+        const char* name = fileName;
+        for (const char* c = fileName; *c; c++)
+            if (*c == '\\' || *c == '/')
+                name = c + 1;
+
+        std::string key(name);
+        for (char& c : key)
+            if (c >= 'A' && c <= 'Z')
+                c = static_cast<char>(c - 'A' + 'a');
+        return key;
+    }
+    // FNV-1a of module key
+    inline DWORD context_hash(std::string const& key)
+    {
+        DWORD hash = 2166136261u;
+        for (char c : key)
+        {
+            hash ^= static_cast<unsigned char>(c);
+            hash *= 16777619u;
+        }
+        return hash;
+    }
+}
+
+#endif //INJECTOR_CONTEXT_LAYOUT_HPP
@@ -1,6 +1,29 @@
 #ifndef INJECTOR_DECLARATION_HPP
 #define INJECTOR_DECLARATION_HPP
 
+/* Registers of lean hook: sources of fastcall arguments and destination of result, see LEAN_REGISTERS */
+enum LeanHookRegister : unsigned char
+{
+    LHR_None = 0,
+    LHR_EAX, LHR_ECX, LHR_EDX, LHR_EBX,
+    LHR_ESP, LHR_EBP, LHR_ESI, LHR_EDI,
+};
+
+// Packs lean hook registers: arguments (ECX, EDX of hook function), register for result and whether flags must be preserved
+#define LEAN_REGISTERS(arg1, arg2, result, preserveFlags) \
+    (static_cast<unsigned int>(arg1) | (static_cast<unsigned int>(arg2) << 8) | (static_cast<unsigned int>(result) << 16) | ((preserveFlags) ? 0x01000000u : 0u))
+
+/* Kinds of direct hook manifest entries, values follow Injector::HookType */
+enum HookManifestType : unsigned int
+{
+    HMT_Generic  = 1,
+    HMT_Extended = 2,
+    HMT_Lean     = 5,
+};
+
+static constexpr unsigned int HookManifestSignature = 0x4D485953u; // 'SYHM'
+static constexpr unsigned int HookManifestVersion   = 1u;
+
 #ifdef IS_INJECTOR_SOURCE
 // disable "structures padded due to alignment specifier"
 #pragma warning(push)
@@ -27,6 +50,15 @@ struct alignas(16) HostDecl
     DWORD        NamePtr;
 };
 
+/* Lean hook - called without REGISTERS frame */
+struct alignas(16) LeanHookDecl
+{
+    DWORD  Address;
+    size_t Size;
+    DWORD  FunctionNamePtr;
+    DWORD  Registers;
+};
+
 /* Function Decorator Hook - by name */
 struct alignas(32) FunctionReplacement0Decl
 {
@@ -45,6 +77,29 @@ struct alignas(32) FunctionReplacement1Decl
     unsigned int ModuleChecksum;
 };
 #pragma warning(pop)
+
+/* Direct hook manifest - header, then tightly packed entries of EntrySize; hook function is given by address (RVA + preferred base) */
+struct HookManifestHeader
+{
+    DWORD Signature;
+    DWORD Version;
+    // 0 - entries run to the end of section
+    DWORD Count;
+    DWORD EntrySize;
+};
+
+struct HookManifestEntry
+{
+    DWORD        Address;
+    DWORD        Size;
+    DWORD        Type;
+    DWORD        Function;
+    DWORD        Registers;
+    DWORD        ModuleNamePtr;
+    unsigned int ModuleChecksum;
+};
+static_assert(sizeof(HookManifestHeader) == 16 && sizeof(HookManifestEntry) == 28,
+    "Hook manifest header & entries must have no padding");
 #else
 #pragma pack(push, 16)
 #pragma warning(push)
@@ -71,6 +126,14 @@ __declspec(align(16)) struct HostDecl
     const char*    NamePtr;
 };
 
+__declspec(align(16)) struct LeanHookDecl
+{
+    unsigned int Address;
+    unsigned int Size;
+    const char*  FunctionNamePtr;
+    unsigned int Registers;
+};
+
 __declspec(align(32)) struct FunctionReplacement0Decl
 {
     const char* OriginalFunctionNamePtr;
@@ -89,11 +152,35 @@ __declspec(align(32)) struct FunctionReplacement1Decl
 #pragma warning(pop)
 #pragma pack(pop)
 
+// members are of 4 bytes, so records have no padding and contributions of translation units follow each other without holes
+struct HookManifestHeader
+{
+    unsigned int Signature;
+    unsigned int Version;
+    unsigned int Count;
+    unsigned int EntrySize;
+};
+
+struct HookManifestEntry
+{
+    unsigned int Address;
+    unsigned int Size;
+    unsigned int Type;
+    const void*  Function;
+    unsigned int Registers;
+    const char*  ModuleNamePtr;
+    unsigned int ModuleChecksum;
+};
+
 #pragma section(".syhks00", read, write)
 #pragma section(".syexe00", read, write)
 #pragma section(".syhks01", read, write)
+#pragma section(".syhks02", read, write)
 #pragma section(".syfrh00", read, write)
 #pragma section(".syfrh01", read, write)
+// grouped by linker into ".syhkm": header ($a) goes before entries ($b)
+#pragma section(".syhkm$a", read, write)
+#pragma section(".syhkm$b", read, write)
 #endif
 
 #endif //INJECTOR_DECLARATION_HPP
@@ -7,8 +7,10 @@ namespace Injector
     static constexpr const char*  GenericHooksPESectionName  = ".syhks00";
     static constexpr const char*  HostsPESectionName         = ".syexe00";
     static constexpr const char*  ExtendedHooksPESectionName = ".syhks01";
+    static constexpr const char*  LeanHooksPESectionName     = ".syhks02";
     static constexpr const char* FunctionReplacementsByNamePESectionName = ".syfrh00";
     static constexpr const char* FunctionReplacementsByAddressPESectionName = ".syfrh01";
+    static constexpr const char*  HookManifestPESectionName  = ".syhkm";
     static constexpr const char*  HandshakeFunctionName      = "SyringeHandshake";    
     static constexpr       size_t MaxFilenameLength          = 0x100;
     static constexpr       size_t MaxFunctionNameLength      = 0x100u;
@@ -86,8 +86,50 @@ static size_t constexpr CallR32InstructionLength = 5;
 #define CALL_PTR32(ptr32) 0xFF, 0x15, ptr32
 
 #define CALL_EAX                      0xFF, 0xD0
+
+// reg - register number (EAX = 0, ECX, EDX, EBX, ESP, EBP, ESI, EDI = 7)
+#define PUSH_R32(reg)                 (0x50 + (reg))
+#define POP_R32(reg)                  (0x58 + (reg))
+#define MOV_R32_R32(dst, src)         0x8B, (0xC0 | ((dst) << 3) | (src))
+#define XOR_R32_R32(dst, src)         0x33, (0xC0 | ((dst) << 3) | (src))
+#define MOV_R32_ESP_DISP8(dst, disp8) 0x8B, (0x44 | ((dst) << 3)), 0x24, disp8
+#define LEA_R32_ESP_DISP8(dst, disp8) 0x8D, (0x44 | ((dst) << 3)), 0x24, disp8
+#define MOV_ESP_DISP8_R32(disp8, src) 0x89, (0x44 | ((src) << 3)), 0x24, disp8
 #define CMP_PTR32_IMM32(ptr32, imm32) 0x83, 0x3D, ptr32, imm32
 
+#define LOCK                          0xF0
+#define RET                           0xC3
+#define RDTSC                         0x0F, 0x31
+#define PUSH_ESP_DISP8(disp8)         0xFF, 0x74, 0x24, disp8
+#define SUB_R32_ESP_DISP8(dst, disp8) 0x2B, (0x44 | ((dst) << 3)), 0x24, disp8
+#define SBB_R32_ESP_DISP8(dst, disp8) 0x1B, (0x44 | ((dst) << 3)), 0x24, disp8
+#define ADD_PTR32_IMM8(ptr32, imm8)   0x83, 0x05, ptr32, imm8
+#define ADC_PTR32_IMM8(ptr32, imm8)   0x83, 0x15, ptr32, imm8
+#define ADD_PTR32_R32(ptr32, src)     0x01, (0x05 | ((src) << 3)), ptr32
+#define ADC_PTR32_R32(ptr32, src)     0x11, (0x05 | ((src) << 3)), ptr32
+#define TEST_R32_R32(dst, src)        0x85, (0xC0 | ((src) << 3) | (dst))
+#define BSR_R32_R32(dst, src)         0x0F, 0xBD, (0xC0 | ((dst) << 3) | (src))
+#define ADD_R32_IMM8(dst, imm8)       0x83, (0xC0 | (dst)), imm8
+// inc dword ptr [ptr32 + index * 4]
+#define INC_PTR32_R32X4(ptr32, index) 0xFF, 0x04, (0x85 | ((index) << 3)), ptr32
+
+// little-endian bytes of 32 bit constant
+#define IMM32(value)                  ((value) & 0xFF), (((value) >> 8) & 0xFF), (((value) >> 16) & 0xFF), (((value) >> 24) & 0xFF)
+#define MOV_R32_IMM32(dst, imm32)     (0xB8 + (dst)), imm32
+#define XADD_PTR32_R32(ptr32, src)    0x0F, 0xC1, (0x05 | ((src) << 3)), ptr32
+#define LEA_R32_R32_DISP8(dst, base, disp8) 0x8D, (0x40 | ((dst) << 3) | (base)), disp8
+#define AND_R32_IMM32(dst, imm32)     0x81, (0xE0 | (dst)), imm32
+#define ADD_R32_IMM32(dst, imm32)     0x81, (0xC0 | (dst)), imm32
+#define SHL_R32_IMM8(dst, imm8)       0xC1, (0xE0 | (dst)), imm8
+// base - register except ESP & EBP
+#define MOV_R32PTR_R32(base, src)                  0x89, (((src) << 3) | (base))
+#define MOV_R32PTR_DISP8_R32(base, disp8, src)     0x89, (0x40 | ((src) << 3) | (base)), disp8
+#define MOV_R32PTR_IMM32(base, imm32)              0xC7, (base), imm32
+#define MOV_R32PTR_DISP8_IMM32(base, disp8, imm32) 0xC7, (0x40 | (base)), disp8, imm32
+#define MOV_EAX_FS(ptr32)                          0x64, 0xA1, ptr32
+// return and pop imm16 bytes of arguments (stdcall)
+#define RET_IMM16(imm16)                           0xC2, ((imm16) & 0xFF), (((imm16) >> 8) & 0xFF)
+
 struct invalid_jump_offset_error : std::runtime_error
 {
     int64_t const Value;
@@ -120,156 +162,4 @@ inline int32_t __fastcall correct_relative_offset(int32_t oldOffset, Address pOl
     throw invalid_jump_offset_error{ offset };
 }
 
-struct _rel_cmd
-{
-    std::string       Mnemonic;
-    std::vector<BYTE> Command;
-
-    size_t            Size;
-    size_t            OffsetStart;
-
-    _rel_cmd(std::string mnemonic, size_t size, size_t offsetStart, std::vector<BYTE> command)
-        : Mnemonic(mnemonic), Size(size), OffsetStart(offsetStart), Command(command)
-    {}
-    _rel_cmd() = default;
-};
-struct relative_jump_info
-{
-    bool     IsRelativeJump;
-    // Offset in bytes from command start to jump command offset
-    size_t   Offset;
-    _rel_cmd Cmd;
-
-    relative_jump_info() : IsRelativeJump(false) {}
-    relative_jump_info(_rel_cmd cmd, size_t offset) : IsRelativeJump(true), Offset(offset), Cmd(cmd) {}
-
-    bool operator!() const { return !IsRelativeJump; }
-    operator bool()  const { return IsRelativeJump; }
-};
-
-inline std::vector<_rel_cmd> get_eip_affected_instruction_with_relative_offset()
-{
-    return std::vector<_rel_cmd>
-    {
-        { "JCXZ",   2, 1, { JCXZ(MASK8)      } },
-        { "LOOPNZ", 2, 1, { LOOPNZ(MASK8)    } },
-        { "LOOPZ",  2, 1, { LOOPZ(MASK8)     } },
-        { "LOOP",   2, 1, { LOOP(MASK8)      } },
-
-        { "JO",     2, 1, { JO_R8(MASK8)     } },
-        { "JNO",    2, 1, { JNO_R8(MASK8)    } },
-        { "JB",     2, 1, { JB_R8(MASK8)     } },
-        { "JNB",    2, 1, { JNB_R8(MASK8)    } },
-        { "JZ",     2, 1, { JZ_R8(MASK8)     } },
-        { "JNZ",    2, 1, { JNZ_R8(MASK8)    } },
-        { "JBE",    2, 1, { JBE_R8(MASK8)    } },
-        { "JNBE",   2, 1, { JNBE_R8(MASK8)   } },
-        { "JS",     2, 1, { JS_R8(MASK8)     } },
-        { "JNS",    2, 1, { JNS_R8(MASK8)    } },
-        { "JP",     2, 1, { JP_R8(MASK8)     } },
-        { "JNP",    2, 1, { JNP_R8(MASK8)    } },
-        { "JL",     2, 1, { JL_R8(MASK8)     } },
-        { "JNL",    2, 1, { JNL_R8(MASK8)    } },
-        { "JNG",    2, 1, { JNG_R8(MASK8)    } },
-        { "JG",     2, 1, { JG_R8(MASK8)     } },
-        { "JMP",    2, 1, { JMP_R8(MASK8)    } },
-
-        { "JO",     4, 2, { JO_R32(MASK32)   } },
-        { "JNO",    4, 2, { JNO_R32(MASK32)  } },
-        { "JB",     4, 2, { JB_R32(MASK32)   } },
-        { "JNB",    4, 2, { JNB_R32(MASK32)  } },
-        { "JZ",     4, 2, { JZ_R32(MASK32)   } },
-        { "JNZ",    4, 2, { JNZ_R32(MASK32)  } },
-        { "JBE",    4, 2, { JBE_R32(MASK32)  } },
-        { "JNBE",   4, 2, { JNBE_R32(MASK32) } },
-        { "JS",     4, 2, { JS_R32(MASK32)   } },
-        { "JNS",    4, 2, { JNS_R32(MASK32)  } },
-        { "JP",     4, 2, { JP_R32(MASK32)   } },
-        { "JNP",    4, 2, { JNP_R32(MASK32)  } },
-        { "JL",     4, 2, { JL_R32(MASK32)   } },
-        { "JNL",    4, 2, { JNL_R32(MASK32)  } },
-        { "JNG",    4, 2, { JNG_R32(MASK32)  } },
-        { "JG",     4, 2, { JG_R32(MASK32)   } },
-        { "JMP",    4, 1, { JMP_R32(MASK32)  } },
-
-        { "CALL",   4, 1, { CALL_R32(MASK32) } },
-    };
-}
-
-inline _rel_cmd find_rel_cmd(std::string mnemonic, size_t size)
-{
-    auto instructions = get_eip_affected_instruction_with_relative_offset();
-    auto iter = std::find_if(instructions.cbegin(), instructions.cend(), [&mnemonic, &size](const _rel_cmd& item) -> bool
-    {
-        return item.Mnemonic == mnemonic && item.Size == size;
-    });
-    if (iter == instructions.cend())
-        throw;
-    return *iter;
-}
-
-inline relative_jump_info is_relative_jump(std::vector<BYTE> command)
-{
-    for (auto& instruction : get_eip_affected_instruction_with_relative_offset())
-    {
-        if (instruction.Command.empty())                 continue;
-        if (command.size() < instruction.Command.size()) continue;
-        bool ok = true;
-        for (size_t i = 0; i < instruction.OffsetStart; i++)
-        {
-            auto a = instruction.Command.at(i);
-            auto b = command.at(i);
-            ok     = a == b;
-            if (!ok) break;
-        }
-        if (ok)
-            return relative_jump_info(instruction, 1);
-    }
-    return relative_jump_info{};
-}
-
-template<typename T>
-inline T _get_relative_offset(std::vector<BYTE> command, size_t offset)
-{
-    T value = 0;
-    memcpy(&value, command.data() + offset, sizeof(T));
-    return value;
-}
-inline int32_t get_relative_offset(std::vector<BYTE> command, relative_jump_info& rji)
-{
-    switch (rji.Cmd.Size)
-    {
-        case(1): return _get_relative_offset<int8_t>(command, rji.Offset);
-        case(2): return _get_relative_offset<int16_t>(command, rji.Offset);
-        case(4): return _get_relative_offset<int32_t>(command, rji.Offset);
-        default: throw;
-    }
-}
-
-inline void set_relative_offset(std::vector<BYTE>& command, relative_jump_info& rji, int32_t value)
-{
-    switch (rji.Cmd.Size)
-    {
-        case(1):
-        {
-            if (value <= INT8_MAX && value >= INT8_MIN)
-                memcpy(command.data() + rji.Offset, &value, sizeof(int8_t));
-            else throw invalid_jump_offset_error { value, rji.Cmd.Size };
-        } break;
-        case(2):
-        {
-            if (value <= INT16_MAX && value >= INT16_MIN)
-                memcpy(command.data() + rji.Offset, &value, sizeof(int16_t));
-            else throw invalid_jump_offset_error { value, rji.Cmd.Size };
-        } break;
-        case(4):
-        {
-            if (value <= INT32_MAX && value >= INT32_MIN)
-                memcpy(command.data() + rji.Offset, &value, sizeof(int32_t));
-            else throw invalid_jump_offset_error { value, rji.Cmd.Size };
-        } break;
-        default: throw;
-    }
-}
-
 #endif //INJECTOR_ASM_HPP
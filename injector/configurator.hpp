@@ -1,6 +1,9 @@
 #ifndef INJECTOR_CONFIGURATOR_HPP
 #define INJECTOR_CONFIGURATOR_HPP
 
+#include <chrono>
+#include <numeric>
+
 #include <debugger.hpp>
 #include <portable_executable.hpp>
 
@@ -9,6 +12,11 @@
 #include "module_retriever.hpp"
 #include "hook_injector.hpp"
 #include "context_emplacer.hpp"
+#include "plan_cache.hpp"
+#include "hook_profiler.hpp"
+#include "sampling_profiler.hpp"
+#include "hook_tracer.hpp"
+#include "injection_options.hpp"
 
 namespace Injector
 {
@@ -24,11 +32,16 @@ namespace Injector
     * @brief 2. Place 'waiter': a simple program which includes breakpoint, which will be trapped by debugger. Used for detecting steps.
     * @brief 3. Wait for kernel32.dll
     * @brief 4. Prepare a program to load all injectable modules: generate, write and execute. Extract all laoded handles from process.
-    * @brief 5. Prepare a program to retieve all hook function addresses: generate, write and execute. Extract all data and set it to hooks.
+    * @brief 5. Resolve hook function addresses locally (module base + export RVA). Only for functions which can't be resolved so (forwarded out of modules)
+    * @brief    prepare a program to retieve hook function addresses: generate, write and execute. Extract all data and set it to hooks.
     * @brief 6. Iterate all hooks, check their inejction conditions, checksums, module names and sort it.
     * @brief 7. Generate for each hooked address a program, which will execute all related hook functions. Then write program and write jumps.
     * @brief 8. Assembly a context of execution (look for ContextEmplacer) and write it into shared memory: 'InjContext-$PID'. It is accessible from injected dlls.
     * @brief 9. Terminate loader thread and resume main thread.
+    * @brief Ends of programs (4, 5) are caught by one-shot hardware breakpoints of loader thread: one debug event per step, nothing is written.
+    * @brief If hooks are profiled (InjectionOptions::ProfileHooks), hook profile is written at exit of process (look for HookProfiler).
+    * @brief If process is sampled (InjectionOptions::Sample), collapsed stacks are written at exit of process (look for SamplingProfiler).
+    * @brief If hooks are traced (InjectionOptions::Trace), trace is written while process runs (look for HookTracer).
     * @brief NOTE 1: Executable can be protected via ASLR. Injector does not support it (need to create an algorithm which will seek new bases and perform address correction).
     * @brief NOTE 2: Stack can be protected and then hook invocation to it will cause invalid data inside function.
     */
@@ -61,8 +74,8 @@ namespace Injector
         Kernel32            _kernel;
         list<Module>&       _modules;
 
-        string_view const&  _arguments;
-        string_view const&  _executableName;
+        string const        _arguments;
+        string const        _executableName;
 
         //InjectionContext _context;
         //VirtualMemoryHandle& _contextVmh;
@@ -70,45 +83,64 @@ namespace Injector
         WaiterCode           _waiterCode;
         VirtualMemoryHandle& _waiterVmh;
 
-        ModuleRetriever* _moduleRetriever;
-        HookRetriever*   _hookRetriever;
-        HookInjector*    _hookInjector;
+        ModuleRetriever* _moduleRetriever = nullptr;
+        HookRetriever*   _hookRetriever = nullptr;
+        HookInjector*    _hookInjector = nullptr;
 
         string           _contextSharedMemoryName;
-        ContextEmplacer* _contextEmplacer;
+        ContextEmplacer* _contextEmplacer = nullptr;
 
-        Address _waiterBp;
-        Address _moduleRetrieverBp;
-        Address _hookRetrieverBp;
-        Address _initializerInjectorBp;
+        Address _waiterBp = nullptr;
+        Address _moduleRetrieverBp = nullptr;
+        Address _hookRetrieverBp = nullptr;
+        Address _initializerInjectorBp = nullptr;
 
-        Thread* _loaderThreadInfo;
+        Thread* _loaderThreadInfo = nullptr;
 
         VirtualMemoryHandle&              _moduleHandle;
         std::vector<VirtualMemoryHandle*> _hookHandles;
         std::vector<VirtualMemoryHandle*> _stringHandles;
 
         DllInfo*             _kernelDll = nullptr;
-        VirtualMemoryHandle* _importTable;
+        VirtualMemoryHandle* _importTable = nullptr;
+
+        PlanCache*           _planCache;
+        InjectionOptions     _options;
+        HookProfiler*        _hookProfiler = nullptr;
+        SamplingProfiler*    _samplingProfiler = nullptr;
+        HookTracer*          _hookTracer = nullptr;
+
+        std::chrono::steady_clock::time_point _remoteResolveStart;
     public:
         Configurator(
             PortableExecutable& peFile,
             DebugLoop& debugger,
             list<Module>& modules,
             string_view const& arguments,
-            string_view const& executableName) :
+            string_view const& executableName,
+            PlanCache* planCache = nullptr,
+            InjectionOptions const& options = {}) :
                 _peFile(peFile),
                 _debugger(debugger),
-                _moduleHandle(debugger.Memory.Allocate(sizeof(Module) * modules.size())),
                 _modules(modules),
                 _arguments(arguments),
                 _executableName(executableName),
-                _waiterCode(), _waiterVmh(debugger.Memory.Allocate(WaiterCodeSize))
+                _waiterCode(), _waiterVmh(debugger.Memory.Allocate(WaiterCodeSize, MemoryPool::Code)),
+                _moduleHandle(debugger.Memory.Allocate(sizeof(Module) * modules.size())),
+                _planCache(planCache),
+                _options(options)
         {
             _waiterVmh.Write(&_waiterCode, WaiterCodeSize);
             _debugger.OnProcessCreated += [this] (DebugLoop& sender) { OnProcessCreated(sender); };
             _debugger.OnAccessViolation += [this](DebugLoop& sender, Thread& thread, Address address) { OnAccessViolation(sender, thread, address); };
             _debugger.OnDllLoaded += [this] (DebugLoop& sender, DllInfo& dll) { OnDllLoaded(sender, dll); };
+            if (_options.ProfileHooks)
+                _hookProfiler = new HookProfiler(_debugger, _options.ProfileTop);
+            if (_options.Trace)
+                _hookTracer = new HookTracer(_debugger, _options.TraceCapacity);
+            if (_options.Sample)
+                _samplingProfiler = new SamplingProfiler(_debugger, _modules, _executableName,
+                    _peFile.PEHeader.OptionalHeader.SizeOfImage, _options.SampleInterval, _options.SampleDepth);
         };
         ~Configurator()
         {
@@ -123,6 +155,9 @@ namespace Injector
             delete _moduleRetriever;
             delete _hookRetriever;
             delete _hookInjector;
+            delete _hookProfiler;
+            delete _samplingProfiler;
+            delete _hookTracer;
         }
 
     private:
@@ -151,12 +186,10 @@ namespace Injector
 
         void OnDllLoaded(DebugLoop& sender, DllInfo& dllInfo)
         {
-            spdlog::trace("[Debug event] dll \"{0}\" ({1}) loaded at [0x{2:x}], image size: {3} bytes, checksum: 0x{4:X} ({4:d})",
-                dllInfo.FileName, dllInfo.FVI.OriginalFilename,
-                (uint32_t) dllInfo.Handle, dllInfo.ImageSize, dllInfo.Checksum);
-            auto dllPath = std::filesystem::path{ dllInfo.FileName };
-            auto dllName = dllPath.filename().string();
-            if(strcmpi(dllName.c_str(), "kernel32.dll") == 0)
+            // version info, PE & checksum are not touched here - they are computed only for DLLs targeted by hooks
+            spdlog::trace("[Debug event] dll \"{0}\" loaded at [0x{1:x}], file size: {2} bytes",
+                dllInfo.FileName, (uint32_t) dllInfo.Base, dllInfo.FileSize);
+            if(DllRegistry::normalize(dllInfo.FileName) == "kernel32.dll")
             {
                 _kernelDll = &dllInfo;
 
@@ -201,6 +234,20 @@ namespace Injector
             }
         }
 
+        // Program of loader thread ends once: its INT3 is covered by one-shot hardware breakpoint (one event, nothing is written),
+        // or by one-shot software one, if debug registers are used up
+        Breakpoint& AddStageBreakpoint(Address address)
+        {
+            try
+            {
+                return _debugger.AddHardwareBreakpoint(address, *_loaderThreadInfo, true);
+            }
+            catch (DebugLoop::no_free_debug_register_error const&)
+            {
+                return _debugger.AddOneShotBreakpoint(address);
+            }
+        }
+
         void InitLL()
         {
             spdlog::info("Prepare module loading program (it invokes LoadLibraryA for a list of modules)...");
@@ -208,7 +255,7 @@ namespace Injector
             _moduleRetriever = new ModuleRetriever { _debugger.Memory, _kernel, _modules };
             _moduleRetrieverBp = static_cast<BYTE*>(_moduleRetriever->breakpoint());
             spdlog::trace("::breakpoint = [0x{0:x}]", (uint32_t) _moduleRetrieverBp);
-            auto& mrbp = _debugger.AddBreakpoint(_moduleRetrieverBp);
+            auto& mrbp = AddStageBreakpoint(_moduleRetrieverBp);
             mrbp.OnReached +=
                 [this] (DebugLoop::Breakpoint& bp, DebugLoop& sender, Thread& thread)
                     {    OnLLBreakpoint(bp, sender, thread);    };
@@ -233,11 +280,36 @@ namespace Injector
                 mdl.set_handle(handles[index]);
             }
 
+            // hook functions are resolved locally: module base + RVA from plan cache or from export directory
+            auto const start = std::chrono::steady_clock::now();
+            size_t local  = 0;
+            size_t remote = 0;
+            for (Module& mdl : _modules)
+            {
+                if (mdl.Cached)
+                    mdl.resolve_cached_functions();
+                else
+                    remote += mdl.resolve_exported_functions(_modules);
+                local += mdl.Hooks.size();
+            }
+            local -= remote;
+            spdlog::info("Hook functions resolved locally: {0}, left for function retrievening program: {1} ({2} us).", local, remote,
+                std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count());
+
+            if (remote == 0)
+            {
+                spdlog::info("Function retrievening program is skipped ({0} remote GetProcAddress calls avoided).", local + _modules.size());
+                Inject(thread);
+                StorePlan();
+                return;
+            }
+
             spdlog::info("Prepare function retrievening program (It invoke GetProcAddress for a list of function names)...");
+            _remoteResolveStart = std::chrono::steady_clock::now();
             _hookRetriever = new HookRetriever { _debugger.Memory, _kernel, _modules };
             _hookRetrieverBp = static_cast<BYTE*>(_hookRetriever->breakpoint());
             spdlog::trace("::breakpoint = [0x{0:x}]", (uint32_t) _hookRetrieverBp);
-            auto& hrbp = _debugger.AddBreakpoint(_hookRetrieverBp);
+            auto& hrbp = AddStageBreakpoint(_hookRetrieverBp);
             hrbp.OnReached +=
                 [this] (DebugLoop::Breakpoint& bp, DebugLoop& sender, Thread& thread)
                     { OnGPABreakpoint(bp, sender, thread); };
@@ -252,7 +324,8 @@ namespace Injector
         //DWORD _eip;
         void OnGPABreakpoint(DebugLoop::Breakpoint& bp, DebugLoop& sender, Thread& thread)
         {
-            spdlog::info("Function retrievening program executed.");
+            spdlog::info("Function retrievening program executed ({0} ms).",
+                std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - _remoteResolveStart).count());
 
             vector<InitFunction> initFunctions; initFunctions.resize(_modules.size());
             vector<HookFunction> hookFunctions; hookFunctions.resize(_hookRetriever->TotalHookCount);
@@ -260,30 +333,56 @@ namespace Injector
             _hookRetriever->InitFunctionsVmh->Read(0, sizeof(InitFunction) * initFunctions.size(), initFunctions.data());
             _hookRetriever->HookFunctionsVmh->Read(0, sizeof(HookFunction) * hookFunctions.size(), hookFunctions.data());
 
+            size_t thkIndex = 0;
+            for (size_t index = 0; index < _modules.size(); ++index)
+            {
+                Module& mdl = *std::next(_modules.begin(), index);
+                if (initFunctions[index])
+                    mdl.InitFunction = initFunctions[index];
+
+                for (auto& hook : mdl.Hooks)
+                    if (hook.ResolveRemotely)
+                        hook.Function = hookFunctions[thkIndex++];
+            }
+
+            Inject(thread);
+            StorePlan();
+        }
+
+        void StorePlan()
+        {
+            if (!_planCache)
+                return;
+
+            bool updated = false;
+            for (Module const& mdl : _modules)
+            {
+                if (mdl.Cached)
+                    continue;
+                _planCache->store(mdl);
+                updated = true;
+            }
+            if (updated)
+                _planCache->save();
+        }
+
+        void Inject(Thread& thread)
+        {
             DWORD prefferedImageBase = _peFile.PEHeader.OptionalHeader.ImageBase;
             DWORD currentImageBase = reinterpret_cast<DWORD>(_debugger.ProcessDebugInfo.lpBaseOfImage);
             DWORD imageBaseOffset = prefferedImageBase - currentImageBase;
             if(imageBaseOffset != 0)
                 throw DynamicBaseUnsupportedException(reinterpret_cast<LPVOID>(prefferedImageBase), reinterpret_cast<LPVOID>(currentImageBase));
 
-            size_t initf = 0;
-            size_t thkIndex = 0;
-            for (size_t index = 0; index < _modules.size(); ++index)
-            {
-                Module& mdl = *std::next(_modules.begin(), index);
-                mdl.InitFunction = initFunctions[index];
-                if(mdl.InitFunction)
-                    initf++;
-
+            for (Module& mdl : _modules)
                 for (auto& hook : mdl.Hooks)
-                {
                     hook.Placement = reinterpret_cast<Address>(reinterpret_cast<DWORD>(hook.Placement) + imageBaseOffset);
 
-                    HookFunction const func =  hookFunctions[thkIndex++];
-                    hook.Function = func;
-                }
-            }
-            _hookInjector = new HookInjector(_debugger, _modules);
+            _hookInjector = new HookInjector(_debugger, _modules, _hookProfiler, _hookTracer);
+            if (_samplingProfiler)
+                _samplingProfiler->Index(*_hookInjector);
+            if (!_debugger.Memory.SealCode())
+                spdlog::warn("Unable to make injected code read-execute.");
 
             DWORD processId = _debugger.ProcessInfo.dwProcessId;
             _contextSharedMemoryName = "InjContext-" + std::to_string(processId);
@@ -293,13 +392,23 @@ namespace Injector
                 _executableName.data(),
                 _arguments,
                 _contextSharedMemoryName.data(),
-                _debugger.Dlls    );
+                _debugger.Dlls,
+                _hookInjector->Program);
             spdlog::info("Context injected.");
 
+            auto const& stats = _debugger.Stats;
+            spdlog::info("Debug events until injection: {0} breakpoints, {1} single steps, {2} in total.",
+                stats.Breakpoints, stats.SingleSteps, std::accumulate(std::begin(stats.Events), std::end(stats.Events), size_t { 0 }));
+
             spdlog::info("Terminate loader thread...");
             thread.Terminate(0);
             spdlog::info("Process configured - resume main thread.");
             _debugger.MainThread->Resume();
+            if (_options.Detach)
+            {
+                spdlog::info("Detach from process after this event.");
+                _debugger.Detach();
+            }
         }
 
         void OnAccessViolation(DebugLoop& dbgLoop, Thread& thread, Address address)
@@ -1,3 +1,5 @@
+#include <unordered_map>
+
 #include "context_emplacer.hpp"
 
 namespace Injector
@@ -6,75 +8,130 @@ namespace Injector
         string_view const& executableName,
         string_view const& arguments,
         string_view const& mapFileName,
-        map<LPVOID, DllInfo>& dlls) :
+        DllRegistry& dlls,
+        HookProgram const& program) :
             Dlls(dlls),
             ExecutableName(executableName),
             Arguments(arguments),
             SharedMemoryName(mapFileName)
     {
-        size_t maxNameLength = 0;
-        for (auto& pair : Dlls)
+        // strings are referred by views until the pool is copied, so their sources must outlive layout
+        string                                 strings;
+        std::unordered_map<string_view, DWORD> stringOffsets;
+        auto const intern = [&strings, &stringOffsets](string_view const& str) -> DWORD
+        {
+            auto const it = stringOffsets.find(str);
+            if (it != stringOffsets.cend())
+                return it->second;
+            DWORD const offset = static_cast<DWORD>(strings.size());
+            strings.append(str).push_back('\0');
+            stringOffsets.emplace(str, offset);
+            return offset;
+        };
+
+        InjectionContextHeader header { InjectionContextHeader::Magic, InjectionContextHeader::Version };
+        header.ExecutableName = intern(ExecutableName);
+        header.Arguments      = intern(Arguments);
+
+        vector<DllInfo const*> loaded;
+        for (auto const& pair : Dlls)
+            if (!pair.second.Unloaded)
+                loaded.push_back(&pair.second);
+
+        vector<string> keys;
+        keys.reserve(loaded.size());
+        vector<InjectionContextModule> modules;
+        for (DllInfo const* dll : loaded)
+        {
+            string const& key = keys.emplace_back(context_module_key(dll->FileName.c_str()));
+            modules.push_back({ static_cast<HMODULE>(dll->Base), intern(dll->FileName), intern(key), context_hash(key) });
+        }
+
+        DWORD indexSize = modules.empty() ? 0 : 1;
+        while (indexSize && indexSize < modules.size() * 2)
+            indexSize <<= 1;
+        vector<DWORD> index(indexSize, 0);
+        for (size_t i = 0; i < modules.size(); i++)
+        {
+            DWORD slot = modules[i].Hash & (indexSize - 1);
+            while (index[slot])
+                slot = (slot + 1) & (indexSize - 1);
+            index[slot] = static_cast<DWORD>(i + 1);
+        }
+
+        vector<InjectionContextPocket> pockets;
+        vector<InjectionContextHook>   hooks;
+        auto const addHook = [&](Hook const& hook, Address placement, DWORD pocket)
+        {
+            hooks.push_back({
+                reinterpret_cast<DWORD>(hook.Function), reinterpret_cast<DWORD>(placement),
+                intern(hook.FunctionName), intern(hook.ModuleName),
+                static_cast<DWORD>(hook.Type), static_cast<DWORD>(hook.Size), pocket
+            });
+        };
+        for (auto const& pair : program.Pockets)
         {
-            HMODULE const handle = static_cast<HMODULE>(pair.second.Base);
-            string_view const& fn = pair.second.FileName;
-            maxNameLength = fn.length() > maxNameLength ? fn.length() : maxNameLength;
+            HookPocket const& pocket = pair.second;
+            DWORD const pocketIndex = static_cast<DWORD>(pockets.size());
+            DWORD const firstHook   = static_cast<DWORD>(hooks.size());
+            DWORD       leanHooks   = 0;
+            pocket.ForEachHook(pair.first, [&](Hook const* hook, Address placement)
+            {
+                leanHooks += hook->Type == HookType::Lean;
+                addHook(*hook, placement, pocketIndex);
+            });
+            pockets.push_back({
+                reinterpret_cast<DWORD>(pair.first),
+                program.ProgramVmh ? reinterpret_cast<DWORD>(program.ProgramVmh->Pointer(pocket.Offset)) : 0,
+                static_cast<DWORD>(pocket.OverriddenCount),
+                firstHook,
+                leanHooks,
+                static_cast<DWORD>(hooks.size()) - firstHook - leanHooks
+            });
         }
+        for (auto const& pair : program.Facades)
+            addHook(*pair.second.Redefine, pair.first, InjectionContextHook::NoPocket);
 
-        size_t const handlesSize = sizeof(HMODULE) * Dlls.size();
-        size_t const namesSize   = sizeof(BYTE)    * Dlls.size() * (maxNameLength + 1);
-        size_t const totalSize   = sizeof(size_t)
-                                 + sizeof(size_t)
-                                 + ExecutableName.size() + 1
-                                 + sizeof(size_t)
-                                 + Arguments.size() + 1
-                                 + sizeof(size_t)
-                                 + sizeof(size_t)
-                                 + handlesSize
-                                 + namesSize;
+        DWORD offset = sizeof(InjectionContextHeader);
+        auto const place = [&offset](DWORD& tableOffset, size_t size)
+        {
+            tableOffset = offset;
+            offset += static_cast<DWORD>(size);
+        };
+        header.Modules = static_cast<DWORD>(modules.size());
+        place(header.ModulesOffset, sizeof(InjectionContextModule) * modules.size());
+        header.IndexSize = indexSize;
+        place(header.IndexOffset, sizeof(DWORD) * index.size());
+        header.Pockets = static_cast<DWORD>(pockets.size());
+        place(header.PocketsOffset, sizeof(InjectionContextPocket) * pockets.size());
+        header.Hooks = static_cast<DWORD>(hooks.size());
+        place(header.HooksOffset, sizeof(InjectionContextHook) * hooks.size());
+        header.StringsSize = static_cast<DWORD>(strings.size());
+        place(header.StringsOffset, strings.size());
+        header.DataSize = offset;
 
         SharedMemory = CreateFileMapping(
             INVALID_HANDLE_VALUE,
             NULL,
             PAGE_READWRITE,
             0,
-            totalSize,
+            header.DataSize,
             SharedMemoryName.data());
         SharedMemoryPointer = static_cast<BYTE*>(MapViewOfFile(
             SharedMemory,
             FILE_MAP_ALL_ACCESS,
-            0, 0, totalSize));
-
-        DataSize               = offset_ptr<size_t>(SharedMemoryPointer, 0);
-        ExecutableNameSize     = offset_ptr<size_t>(DataSize, sizeof(size_t));
-        ExecutableNameInStruct = offset_ptr<char>(ExecutableNameSize, sizeof(size_t));
-        ArgumentsSize          = offset_ptr<size_t>(ExecutableNameInStruct, ExecutableName.size() + 1);
-        ArgumentsInStruct      = offset_ptr<char>(ArgumentsSize, sizeof(size_t));
-        NameLength             = offset_ptr<size_t>(ArgumentsInStruct, Arguments.size() + 1);
-        ModuleSize             = offset_ptr<size_t>(NameLength, sizeof(size_t));
-        Handles                = offset_ptr<HMODULE>(ModuleSize, sizeof(size_t));
-        Names                  = offset_ptr<char>(Handles, handlesSize);
+            0, 0, header.DataSize));
 
-        *DataSize              = totalSize;
-        *ExecutableNameSize    = ExecutableName.size();
-        memcpy(ExecutableNameInStruct, ExecutableName.data(), ExecutableName.size() + 1);
-        *ArgumentsSize         = Arguments.size();
-        memcpy(ArgumentsInStruct, Arguments.data(), Arguments.size() + 1);
-        *NameLength            = maxNameLength;
-        *ModuleSize            = Dlls.size();
+        Header = offset_ptr<InjectionContextHeader>(SharedMemoryPointer, 0);
+        *Header = header;
+        memcpy(SharedMemoryPointer + header.ModulesOffset, modules.data(), sizeof(InjectionContextModule) * modules.size());
+        memcpy(SharedMemoryPointer + header.IndexOffset, index.data(), sizeof(DWORD) * index.size());
+        memcpy(SharedMemoryPointer + header.PocketsOffset, pockets.data(), sizeof(InjectionContextPocket) * pockets.size());
+        memcpy(SharedMemoryPointer + header.HooksOffset, hooks.data(), sizeof(InjectionContextHook) * hooks.size());
+        memcpy(SharedMemoryPointer + header.StringsOffset, strings.data(), strings.size());
 
-        char* refName = reinterpret_cast<char*>(Names);
-        HMODULE* refHandle = Handles;
-        for (auto& pair : Dlls)
-        {
-            string_view const& name = pair.second.FileName;
-            memcpy(refName, name.data(), name.size() + 1);
-
-            HMODULE const handle = static_cast<HMODULE>(pair.second.Base);
-            *refHandle = handle;
-
-            refName += (maxNameLength + 1);
-            refHandle++;
-        }
+        spdlog::info("Context: {0} bytes ({1} modules, {2} pockets, {3} hooks, {4} bytes of strings).",
+            header.DataSize, header.Modules, header.Pockets, header.Hooks, header.StringsSize);
     }
     ContextEmplacer::~ContextEmplacer()
     {
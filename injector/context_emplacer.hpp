@@ -2,20 +2,26 @@
 #define INJECTOR_CONTEXT_EMPLACER_HPP
 
 #include <macro.hpp>
+#include <context_layout.hpp>
 
 #include <process_memory.hpp>
-#include <dll_info.hpp>
+#include <dll_registry.hpp>
 
 #include "framework.hpp"
 #include "asm.hpp"
+#include "hook_program.hpp"
 
 namespace Injector
 {
+    /*!
+    * @brief Writes injection context (see InjectionContextHeader) into shared memory: executable name & arguments,
+    * @brief loaded DLLs of process with hash index by file name, pockets & hooks of written hook program.
+    * @brief Layout is computed first, so the section is created & filled by one mapping.
+    */
     class ContextEmplacer final
     {
-    private:
     public:
-        DllMap&            Dlls;
+        DllRegistry&       Dlls;
 
         string_view const& ExecutableName;
         string_view const& Arguments;
@@ -24,21 +30,14 @@ namespace Injector
         HANDLE             SharedMemory { nullptr };
         BYTE*              SharedMemoryPointer { nullptr };
 
-        size_t*            DataSize;
-        size_t*            ExecutableNameSize;
-        char*              ExecutableNameInStruct;
-        size_t*            ArgumentsSize;
-        char*              ArgumentsInStruct;
-        size_t*            NameLength;
-        size_t*            ModuleSize;
-        HMODULE*           Handles;
-        char*              Names;
+        InjectionContextHeader* Header { nullptr };
 
         ContextEmplacer(
             string_view const& executableName,
             string_view const& arguments,
             string_view const& mapFileName,
-            map<LPVOID, DllInfo>& dlls);
+            DllRegistry& dlls,
+            HookProgram const& program);
         ~ContextEmplacer();
     };
 }
@@ -0,0 +1,258 @@
+#include <chrono>
+
+#include <psapi.h>
+
+#include "direct_injector.hpp"
+
+namespace Injector
+{
+    DirectInjector::DirectInjector(
+        PortableExecutable& peFile,
+        list<Module>& modules,
+        string_view const& arguments,
+        string_view const& executableName,
+        PlanCache* planCache) :
+            _peFile(peFile), _modules(modules),
+            _arguments(arguments), _executableName(executableName),
+            _planCache(planCache)
+    {
+        SetEnvironmentVariable("_NO_DEBUG_HEAP", "1");
+
+        if (CreateProcess(
+            executableName.data(),
+            const_cast<LPSTR>(arguments.data()),
+            nullptr, nullptr, false,
+            CREATE_SUSPENDED,
+            nullptr, nullptr, &_startupInfo, &_processInfo) == FALSE)
+        {
+            throw process_creation_error();
+        }
+
+        // memory is kept: it holds hooks of process
+        Memory = ProcessMemory { _processInfo.hProcess, false };
+    }
+    DirectInjector::~DirectInjector()
+    {
+        // process is not started if injection failed
+        if (!_resumed)
+            TerminateProcess(_processInfo.hProcess, EXIT_FAILURE);
+
+        delete _contextEmplacer;
+        delete _hookInjector;
+        delete _hookRetriever;
+        delete _moduleRetriever;
+
+        CloseHandle(_processInfo.hThread);
+        CloseHandle(_processInfo.hProcess);
+    }
+
+    void DirectInjector::run_thread(Address routine, string const& stage)
+    {
+        HANDLE const thread = CreateRemoteThread(_processInfo.hProcess, nullptr, 0,
+            reinterpret_cast<ThreadStartRoutine>(routine), nullptr, 0, nullptr);
+        if (!thread)
+            throw remote_thread_error(stage);
+
+        // loader of process can fail, then process is gone instead of thread
+        HANDLE const handles[] = { thread, _processInfo.hProcess };
+        DWORD const result = WaitForMultipleObjects(2, handles, FALSE, INFINITE);
+        DWORD exitCode = 0;
+        GetExitCodeThread(thread, &exitCode);
+        CloseHandle(thread);
+
+        if (result != WAIT_OBJECT_0)
+            throw remote_thread_error(stage);
+        spdlog::trace("::Remote thread of \"{0}\" done, exit code {1}.", stage, exitCode);
+    }
+
+    void DirectInjector::run_program(VirtualMemoryHandle& programVmh, size_t breakpointOffset, string const& stage)
+    {
+        // INT3 of postfix returns into RemoteThreadCode
+        BYTE ret[] = { RET };
+        programVmh.Write(ret, sizeof(ret), breakpointOffset);
+
+        VirtualMemoryHandle& entryVmh = Memory.Allocate(RemoteThreadCodeSize, MemoryPool::Code);
+        RemoteThreadCode entry { entryVmh.Pointer(), programVmh.Pointer() };
+        entryVmh.Write(&entry, RemoteThreadCodeSize);
+
+        run_thread(entryVmh.Pointer(), stage);
+        Memory.Free(entryVmh);
+    }
+
+    void DirectInjector::enumerate_modules()
+    {
+        vector<HMODULE> handles(256);
+        DWORD needed = 0;
+        for (;;)
+        {
+            if (!EnumProcessModules(_processInfo.hProcess, handles.data(), static_cast<DWORD>(handles.size() * sizeof(HMODULE)), &needed))
+                throw std::runtime_error("Unable to enumerate modules of process");
+            if (needed <= handles.size() * sizeof(HMODULE))
+                break;
+            handles.resize(needed / sizeof(HMODULE));
+        }
+        handles.resize(needed / sizeof(HMODULE));
+
+        // the first one is executable
+        if (!handles.empty())
+            _imageBase = handles.front();
+
+        char fileName[MAX_PATH];
+        size_t added = 0;
+        for (size_t i = 1; i < handles.size(); i++)
+        {
+            if (Dlls.Find(handles[i]))
+                continue;
+            DWORD const length = GetModuleFileNameExA(_processInfo.hProcess, handles[i], fileName, MAX_PATH);
+            if (!length)
+                continue;
+            DllInfo& dll = Dlls.Load(DllInfo { handles[i], string(fileName, length) });
+            spdlog::trace("[Module] dll \"{0}\" at [0x{1:x}], file size: {2} bytes", dll.FileName, (uint32_t) dll.Base, dll.FileSize);
+            added++;
+        }
+        spdlog::info("Modules of process enumerated: {0} new DLLs, {1} in total.", added, Dlls.size());
+    }
+
+    void DirectInjector::load_modules()
+    {
+        spdlog::info("Prepare module loading program (it invokes LoadLibraryA for a list of modules)...");
+        _moduleRetriever = new ModuleRetriever { Memory, _kernel, _modules };
+        spdlog::info("Run module loading program (at [0x{0:x}])...", (uint32_t) _moduleRetriever->instruction());
+        run_program(*_moduleRetriever->ProgramVmh, _moduleRetriever->BreakpointOffset, "module loading");
+        spdlog::info("Module loading program executed.");
+
+        vector<HMODULE> handles;
+        handles.resize(_modules.size());
+        _moduleRetriever->ModuleHandlesVmh->Read(0, sizeof(HMODULE) * handles.size(), handles.data());
+        for (size_t index = 0; index < _modules.size(); ++index)
+            std::next(_modules.begin(), index)->set_handle(handles[index]);
+    }
+
+    void DirectInjector::retrieve_functions()
+    {
+        // hook functions are resolved locally: module base + RVA from plan cache or from export directory
+        auto const start = std::chrono::steady_clock::now();
+        size_t local  = 0;
+        size_t remote = 0;
+        for (Module& mdl : _modules)
+        {
+            if (mdl.Cached)
+                mdl.resolve_cached_functions();
+            else
+                remote += mdl.resolve_exported_functions(_modules);
+            local += mdl.Hooks.size();
+        }
+        local -= remote;
+        spdlog::info("Hook functions resolved locally: {0}, left for function retrievening program: {1} ({2} us).", local, remote,
+            std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count());
+
+        if (remote == 0)
+        {
+            spdlog::info("Function retrievening program is skipped ({0} remote GetProcAddress calls avoided).", local + _modules.size());
+            return;
+        }
+
+        spdlog::info("Prepare function retrievening program (It invoke GetProcAddress for a list of function names)...");
+        auto const remoteStart = std::chrono::steady_clock::now();
+        _hookRetriever = new HookRetriever { Memory, _kernel, _modules };
+        run_program(*_hookRetriever->ProgramVmh, _hookRetriever->BreakpointOffset, "function retrievening");
+        spdlog::info("Function retrievening program executed ({0} ms).",
+            std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - remoteStart).count());
+
+        vector<InitFunction> initFunctions; initFunctions.resize(_modules.size());
+        vector<HookFunction> hookFunctions; hookFunctions.resize(_hookRetriever->TotalHookCount);
+        _hookRetriever->InitFunctionsVmh->Read(0, sizeof(InitFunction) * initFunctions.size(), initFunctions.data());
+        _hookRetriever->HookFunctionsVmh->Read(0, sizeof(HookFunction) * hookFunctions.size(), hookFunctions.data());
+
+        size_t thkIndex = 0;
+        for (size_t index = 0; index < _modules.size(); ++index)
+        {
+            Module& mdl = *std::next(_modules.begin(), index);
+            if (initFunctions[index])
+                mdl.InitFunction = initFunctions[index];
+
+            for (auto& hook : mdl.Hooks)
+                if (hook.ResolveRemotely)
+                    hook.Function = hookFunctions[thkIndex++];
+        }
+    }
+
+    void DirectInjector::store_plan()
+    {
+        if (!_planCache)
+            return;
+
+        bool updated = false;
+        for (Module const& mdl : _modules)
+        {
+            if (mdl.Cached)
+                continue;
+            _planCache->store(mdl);
+            updated = true;
+        }
+        if (updated)
+            _planCache->save();
+    }
+
+    DWORD DirectInjector::Run()
+    {
+        auto const start = std::chrono::steady_clock::now();
+
+        // ntdll.dll is mapped at the same base in all processes since creation, unlike the rest of modules
+        spdlog::info("Process created suspended, initialize it by remote thread...");
+        auto const exitThread = reinterpret_cast<Address>(GetProcAddress(GetModuleHandleA("ntdll.dll"), "RtlExitUserThread"));
+        run_thread(exitThread, "process initialization");
+        enumerate_modules();
+
+        LPVOID const prefferedImageBase = reinterpret_cast<LPVOID>(_peFile.PEHeader.OptionalHeader.ImageBase);
+        if (_imageBase != prefferedImageBase)
+            throw invalid_base_error(string(_executableName), prefferedImageBase, _imageBase);
+
+        DllInfo* kernelDll = Dlls.FindByFileName("kernel32.dll");
+        HMODULE const kernelHandle = GetModuleHandleA("kernel32.dll");
+        if (!kernelDll || kernelDll->Base != kernelHandle)
+            throw invalid_base_error("kernel32.dll", kernelHandle, kernelDll ? kernelDll->Base : nullptr);
+
+        _kernel.GetProcAddressFunc = &GetProcAddress;
+        _kernel.LoadLibraryFunc = &LoadLibraryA;
+        _kernel.FreeLibraryFunc = &FreeLibrary;
+
+        _importTable = &Memory.Allocate(sizeof(Address) * 3);
+        _importTable->Write(&_kernel, sizeof(Kernel32));
+
+        _kernel.GetProcAddressFunc = reinterpret_cast<GetProcAddressFunction>(_importTable->Pointer(sizeof(Address) * 0));
+        _kernel.LoadLibraryFunc = reinterpret_cast<LoadLibraryFunction>(_importTable->Pointer(sizeof(Address) * 1));
+        _kernel.FreeLibraryFunc = reinterpret_cast<FreeLibraryFunction>(_importTable->Pointer(sizeof(Address) * 2));
+
+        load_modules();
+        // modules & their dependencies
+        enumerate_modules();
+        retrieve_functions();
+
+        _hookInjector = new HookInjector(Memory, _executableName, Dlls, _modules);
+        if (!Memory.SealCode())
+            spdlog::warn("Unable to make injected code read-execute.");
+
+        _contextSharedMemoryName = "InjContext-" + std::to_string(_processInfo.dwProcessId);
+        spdlog::info("Inject context into shared memory (\"{}\")...", _contextSharedMemoryName);
+        _contextEmplacer = new ContextEmplacer(
+            _executableName.data(),
+            _arguments,
+            _contextSharedMemoryName.data(),
+            Dlls,
+            _hookInjector->Program);
+        spdlog::info("Context injected.");
+        store_plan();
+
+        spdlog::info("Process configured without debugger ({0} ms) - resume main thread.",
+            std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count());
+        ResumeThread(_processInfo.hThread);
+        _resumed = true;
+
+        WaitForSingleObject(_processInfo.hProcess, INFINITE);
+        DWORD exitCode = 0;
+        GetExitCodeProcess(_processInfo.hProcess, &exitCode);
+        spdlog::info("Process exited with code {0}.", exitCode);
+        return exitCode;
+    }
+}
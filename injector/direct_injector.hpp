@@ -0,0 +1,124 @@
+#ifndef INJECTOR_DIRECT_INJECTOR_HPP
+#define INJECTOR_DIRECT_INJECTOR_HPP
+
+#include <portable_executable.hpp>
+#include <process_memory.hpp>
+#include <dll_registry.hpp>
+
+#include "hook_injector.hpp"
+#include "framework.hpp"
+#include "asm.hpp"
+#include "misc_code.hpp"
+#include "module.hpp"
+#include "module_retriever.hpp"
+#include "hook_retriever.hpp"
+#include "context_emplacer.hpp"
+#include "plan_cache.hpp"
+
+namespace Injector
+{
+    using namespace PECOFF;
+
+    // Entry of remote thread (stdcall, one parameter): calls a retriever program and returns 0
+    BYTE const RemoteThreadCodeData[] =
+    {
+        CALL_R32(INIT_PTR),
+        XOR_R32_R32(EAX, EAX),
+        RET_IMM16(4)
+    };
+    static constexpr size_t RemoteThreadCodeDataSize = sizeof(RemoteThreadCodeData);
+    #pragma pack(push, 1)
+    struct RemoteThreadCode
+    {
+        CallCode Program;
+        BYTE     arr1[5] { 0, 0, 0, 0, 0 };
+
+        RemoteThreadCode(Address base, Address program)
+        {
+            memcpy(this, &RemoteThreadCodeData, RemoteThreadCodeDataSize);
+            Program = CallCode(base, reinterpret_cast<FARPROC>(program));
+        }
+    };
+    static constexpr size_t RemoteThreadCodeSize = sizeof(RemoteThreadCode);
+    #pragma pack(pop)
+    static_assert(RemoteThreadCodeDataSize == RemoteThreadCodeSize, "The code and data are not equals");
+
+    /*!
+    * @brief Injection without debugger: the same modules, retriever programs and HookInjector as Configurator uses,
+    * @brief but steps are synchronized by remote threads instead of breakpoints.
+    * @brief 1. Create process suspended (not debugged).
+    * @brief 2. Run remote thread at ntdll!RtlExitUserThread: loader initializes process (kernel32.dll & imports of executable) before
+    * @brief    start routine of the first thread is called, so kernel32.dll is loaded when the thread is done.
+    * @brief 3. Enumerate modules of process into DllRegistry, check bases of executable & kernel32.dll.
+    * @brief 4. Run module loading program by remote thread (RemoteThreadCode calls it, INT3 of program is replaced by RET)
+    * @brief    and wait for the thread. Resolve hook functions locally, run function retrievening program the same way if needed.
+    * @brief 5. Enumerate modules again (DLLs loaded by modules), write hooks and context, resume main thread.
+    * @brief No debug events are raised, so process runs without debugger overhead. Injector waits for process exit
+    * @brief (context shared memory 'InjContext-$PID' is owned by it).
+    */
+    class DirectInjector final
+    {
+    public:
+        struct process_creation_error : std::exception { };
+        struct remote_thread_error : std::runtime_error
+        {
+            remote_thread_error(string const& stage) : std::runtime_error("Remote thread of \"" + stage + "\" failed") { }
+        };
+        // Executable (ASLR) or kernel32.dll (its functions are taken from injector) is not at expected base
+        struct invalid_base_error : std::runtime_error
+        {
+            LPVOID const Preffered;
+            LPVOID const Current;
+            invalid_base_error(string const& module, LPVOID preffered, LPVOID current) :
+                std::runtime_error("\"" + module + "\" is not at expected base"), Preffered(preffered), Current(current) { }
+        };
+    private:
+        PortableExecutable&  _peFile;
+        list<Module>&        _modules;
+        string const         _arguments;
+        string const         _executableName;
+        PlanCache*           _planCache;
+
+        STARTUPINFO          _startupInfo { };
+        PROCESS_INFORMATION  _processInfo { };
+        LPVOID               _imageBase = nullptr;
+        bool                 _resumed = false;
+
+        Kernel32             _kernel;
+        VirtualMemoryHandle* _importTable = nullptr;
+        ModuleRetriever*     _moduleRetriever = nullptr;
+        HookRetriever*       _hookRetriever = nullptr;
+        HookInjector*        _hookInjector = nullptr;
+        ContextEmplacer*     _contextEmplacer = nullptr;
+        string               _contextSharedMemoryName;
+
+        // Runs routine by new thread of process and waits for its exit
+        void run_thread(Address routine, string const& stage);
+        // Runs retriever program (its breakpoint is replaced by return)
+        void run_program(VirtualMemoryHandle& programVmh, size_t breakpointOffset, string const& stage);
+        // Registers modules of process which are not known yet
+        void enumerate_modules();
+
+        void load_modules();
+        void retrieve_functions();
+        void store_plan();
+    public:
+        ProcessMemory        Memory;
+        DllRegistry          Dlls;
+
+        DirectInjector(
+            PortableExecutable& peFile,
+            list<Module>& modules,
+            string_view const& arguments,
+            string_view const& executableName,
+            PlanCache* planCache = nullptr);
+        ~DirectInjector();
+
+        DirectInjector(DirectInjector const&) = delete;
+        DirectInjector& operator=(DirectInjector const&) = delete;
+
+        // Injects and waits for exit of process, returns its exit code
+        DWORD Run();
+    };
+}
+#endif //INJECTOR_DIRECT_INJECTOR_HPP
@@ -0,0 +1,303 @@
+#include <fstream>
+
+#include <mapped_file.hpp>
+
+#include "dry_run.hpp"
+
+namespace Injector
+{
+    DryRun::DryRun(PortableExecutable const& peExecutable, string_view const& executableFile, list<Module>& modules)
+    {
+        // the first module is executable itself, it's the only image which is not registered as DLL
+        DWORD const imageBase = map_image(string(executableFile), peExecutable);
+        modules.front().set_handle(reinterpret_cast<HMODULE>(imageBase));
+        for (auto mdl = std::next(modules.begin()); mdl != modules.end(); ++mdl)
+        {
+            PortableExecutable const pe { file_open_binary(mdl->FileName) };
+            DWORD const base = map_image(mdl->FileName, pe);
+            Dlls.Load(DllInfo { reinterpret_cast<LPVOID>(base), mdl->FileName });
+            mdl->set_handle(reinterpret_cast<HMODULE>(base));
+        }
+        map_targets(executableFile, modules);
+
+        size_t local  = 0;
+        size_t remote = 0;
+        for (Module& mdl : modules)
+        {
+            if (mdl.Cached)
+                mdl.resolve_cached_functions();
+            else
+                remote += mdl.resolve_exported_functions(modules);
+            local += mdl.Hooks.size();
+        }
+        if (remote)
+            spdlog::warn("{0} hook functions are forwarded out of injectable modules, they are resolved by process only and skipped by plan.", remote);
+        spdlog::info("Hook functions resolved from exports: {0}.", local - remote);
+
+        resolve_redefines(modules);
+        Injector = make_unique<HookInjector>(Memory, executableFile, Dlls, modules);
+        // by sizes planned from decoded instructions, hooks without function are not planned, so they do not conflict
+        Conflicts = Injector->Program.Conflicts();
+    }
+
+    DWORD DryRun::map_image(string const& fileName, PortableExecutable const& pe)
+    {
+        MappedFile const file { fileName };
+        auto const& header = pe.PEHeader.OptionalHeader;
+
+        vector<BYTE> image(header.SizeOfImage);
+        size_t const headersSize = (std::min)(static_cast<size_t>(header.SizeOfHeaders), (std::min)(image.size(), file.size()));
+        memcpy(image.data(), file.data(), headersSize);
+        for (auto const& section : pe.Sections)
+        {
+            size_t size = section.Misc.VirtualSize ? (std::min)(section.Misc.VirtualSize, section.SizeOfRawData) : section.SizeOfRawData;
+            if (section.VirtualAddress >= image.size() || !file.contains(section.PointerToRawData, size))
+                continue;
+            size = (std::min)(size, static_cast<size_t>(image.size() - section.VirtualAddress));
+            memcpy(image.data() + section.VirtualAddress, file.data() + section.PointerToRawData, size);
+        }
+
+        // image is moved like loader does when preferred range is taken, but relocations are not applied
+        DWORD base = header.ImageBase;
+        while (!Process.Map(reinterpret_cast<Address>(base), image.data(), image.size()))
+        {
+            base += SimulatedProcess::AllocationGranularity;
+            if (base + image.size() > SimulatedProcess::HighestAllocation)
+                throw std::runtime_error("No room for image of \"" + fileName + "\" in simulated process");
+        }
+        if (base != header.ImageBase)
+            spdlog::warn("Image \"{0}\" is mapped at [0x{1:x}] instead of preferred [0x{2:x}], its absolute addresses are not relocated.",
+                fileName, base, (uint32_t) header.ImageBase);
+        else
+            spdlog::info("Image \"{0}\" is mapped at [0x{1:x}].", fileName, base);
+
+        Images.push_back({ fileName, base, static_cast<DWORD>(image.size()), ChecksumRegistry::instance().get(fileName) });
+        return base;
+    }
+
+    void DryRun::map_targets(string_view const& executableFile, list<Module> const& modules)
+    {
+        auto const directory = std::filesystem::path(executableFile).parent_path();
+        for (Module const& mdl : modules)
+        {
+            for (Hook const& hook : mdl.Hooks)
+            {
+                if (hook.ModuleName.empty() || Dlls.FindByOriginalName(hook.ModuleName))
+                    continue;
+
+                // DLLs of process are looked for next to executable, then in working directory (system DLLs are not mapped)
+                std::error_code error;
+                auto fileName = directory / hook.ModuleName;
+                if (!std::filesystem::is_regular_file(fileName, error))
+                    fileName = std::filesystem::path(hook.ModuleName).filename();
+                if (!std::filesystem::is_regular_file(fileName, error) || Dlls.FindByFileName(fileName.string()))
+                    continue;
+
+                try
+                {
+                    PortableExecutable const pe { file_open_binary(fileName.string()) };
+                    DWORD const base = map_image(fileName.string(), pe);
+                    Dlls.Load(DllInfo { reinterpret_cast<LPVOID>(base), fileName.string() });
+                }
+                catch (const std::exception& ex)
+                {
+                    spdlog::warn("Target module \"{0}\" is not mapped: {1}", fileName.string(), ex.what());
+                }
+            }
+        }
+    }
+
+    void DryRun::resolve_redefines(list<Module>& modules)
+    {
+        for (Module& mdl : modules)
+        {
+            for (Hook& hook : mdl.Hooks)
+            {
+                if (hook.Type != HookType::FacadeByName || !hook.Function)
+                    continue;
+
+                Module const* target = nullptr;
+                if (hook.ModuleName.empty())
+                    target = &modules.front();
+                else
+                    for (Module const& other : modules)
+                        if (DllRegistry::normalize(other.FVI.Loaded ? other.FVI.OriginalFilename : other.FileName) == DllRegistry::normalize(hook.ModuleName))
+                            target = &other;
+
+                Module::Export const* function = nullptr;
+                if (target)
+                {
+                    auto const it = target->Exports.find(hook.PlacementFunction);
+                    if (it != target->Exports.cend() && it->second.Forwarder.empty())
+                        function = &it->second;
+                }
+                if (!function)
+                {
+                    // skipped by HookInjector like hook without function
+                    spdlog::warn("::Redefine {0} for {1}::{2} can not be resolved from exports of injectable modules, skip.",
+                        hook.FunctionName, hook.ModuleName.empty() ? "executable" : hook.ModuleName, hook.PlacementFunction);
+                    hook.Function = nullptr;
+                    continue;
+                }
+
+                // placement in target module is RVA like for the other hooks (HookInjector adds module base), in executable - address
+                DWORD const base = hook.ModuleName.empty() ? reinterpret_cast<DWORD>(target->get_handle()) : 0;
+                hook.Placement = reinterpret_cast<Address>(base + function->Rva);
+            }
+        }
+    }
+
+    bool DryRun::save(string const& planFileName, string const& summaryFileName) const
+    {
+        HookProgram const& program = Injector->Program;
+
+        string        strings;
+        vector<BYTE>  bytes;
+        auto const    intern = [&strings](string const& str)
+        {
+            auto const offset = static_cast<uint32_t>(strings.size());
+            strings.append(str).push_back('\0');
+            return offset;
+        };
+
+        vector<DryRunImage>  images;
+        vector<DryRunPocket> pockets;
+        vector<DryRunHook>   hooks;
+        vector<DryRunFacade> facades;
+        vector<DryRunConflict> conflicts;
+        for (auto const& image : Images)
+            images.push_back({ intern(image.FileName), image.Base, image.Size, image.Checksum });
+
+        auto const addHook = [&](Hook const* hook)
+        {
+            hooks.push_back({
+                intern(hook->FunctionName), intern(hook->ModuleName), static_cast<uint8_t>(hook->Type),
+                reinterpret_cast<uint32_t>(hook->Function), static_cast<uint32_t>(hook->Size)
+            });
+        };
+        for (auto it = program.Pockets.cbegin(); it != program.Pockets.cend(); ++it)
+        {
+            HookPocket const& pocket = it->second;
+            auto const next = std::next(it);
+            size_t const end = next == program.Pockets.cend() ? program.Code.size() : next->second.Offset;
+
+            pockets.push_back({
+                reinterpret_cast<uint32_t>(it->first),
+                static_cast<uint32_t>(pocket.Offset),
+                static_cast<uint32_t>(end - pocket.Offset),
+                static_cast<uint32_t>(pocket.OverriddenCount),
+                static_cast<uint32_t>(bytes.size()),
+                static_cast<uint32_t>(pocket.OriginalBytes.size()),
+                static_cast<uint32_t>(pocket.Relocatable ? pocket.Relocation.Branches : 0),
+                static_cast<uint8_t>(pocket.Relocatable),
+                static_cast<uint32_t>(hooks.size()),
+                0,
+                0
+            });
+            bytes.insert(bytes.end(), pocket.OriginalBytes.cbegin(), pocket.OriginalBytes.cend());
+            pocket.ForEachHook(it->first, [&](Hook const* hook, Address)
+            {
+                (hook->Type == HookType::Lean ? pockets.back().LeanHooks : pockets.back().RegularHooks)++;
+                addHook(hook);
+            });
+        }
+        for (auto const& pair : program.Facades)
+        {
+            Hook const* hook = pair.second.Redefine;
+            facades.push_back({
+                reinterpret_cast<uint32_t>(pair.first), reinterpret_cast<uint32_t>(hook->Function),
+                intern(hook->FunctionName), intern(hook->ModuleName)
+            });
+        }
+
+        auto const conflictHook = [&](Hook const* hook) -> DryRunConflictHook
+        {
+            return { intern(hook->FunctionName), intern(hook->ModuleName), reinterpret_cast<uint32_t>(hook->Placement), static_cast<uint32_t>(hook->Size) };
+        };
+        for (auto const& conflict : Conflicts)
+            conflicts.push_back({ static_cast<uint8_t>(conflict.Kind), conflictHook(conflict.First), conflictHook(conflict.Second) });
+
+        DryRunHeader header;
+        header.ExecutableChecksum = Images.front().Checksum;
+        header.Images             = static_cast<uint32_t>(images.size());
+        header.Pockets            = static_cast<uint32_t>(pockets.size());
+        header.Hooks              = static_cast<uint32_t>(hooks.size());
+        header.Facades            = static_cast<uint32_t>(facades.size());
+        header.Conflicts          = static_cast<uint32_t>(conflicts.size());
+        header.StringsSize        = static_cast<uint32_t>(strings.size());
+        header.BytesSize          = static_cast<uint32_t>(bytes.size());
+        header.ProgramSize        = static_cast<uint32_t>(program.Code.size());
+
+        bool written = true;
+        {
+            std::ofstream os(planFileName, std::ios::binary | std::ios::trunc);
+            os.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            os.write(reinterpret_cast<const char*>(images.data()), sizeof(DryRunImage) * images.size());
+            os.write(reinterpret_cast<const char*>(pockets.data()), sizeof(DryRunPocket) * pockets.size());
+            os.write(reinterpret_cast<const char*>(hooks.data()), sizeof(DryRunHook) * hooks.size());
+            os.write(reinterpret_cast<const char*>(facades.data()), sizeof(DryRunFacade) * facades.size());
+            os.write(reinterpret_cast<const char*>(conflicts.data()), sizeof(DryRunConflict) * conflicts.size());
+            os.write(strings.data(), strings.size());
+            os.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+            if (!os)
+            {
+                spdlog::warn("Hook plan \"{0}\" is not writable.", planFileName);
+                written = false;
+            }
+        }
+
+        std::ofstream txt(summaryFileName, std::ios::trunc);
+        auto const moduleOf = [](Hook const* hook) { return hook->ModuleName.empty() ? string("executable") : hook->ModuleName; };
+        txt << fmt::format("Hook plan of \"{0}\" (checksum 0x{1:x}): {2} pockets, {3} hooks, {4} facades, {5} conflicts, program {6} bytes.\n",
+            Images.front().FileName, header.ExecutableChecksum, header.Pockets, header.Hooks, header.Facades, header.Conflicts, header.ProgramSize);
+
+        txt << "\nImages:\n";
+        for (auto const& image : Images)
+            txt << fmt::format("  [0x{0:08x}-0x{1:08x}] {2} (checksum 0x{3:x})\n", image.Base, image.Base + image.Size, image.FileName, image.Checksum);
+
+        txt << "\nPockets (placement, offset & size in program, overridden -> relocated bytes):\n";
+        for (size_t index = 0; index < pockets.size(); index++)
+        {
+            auto const& record = pockets[index];
+            auto const& pocket = program.Pockets.at(reinterpret_cast<Address>(record.Placement));
+            string original;
+            for (size_t i = 0; i < record.RelocatedSize; i++)
+                original += fmt::format("{0:02X} ", bytes[record.BytesOffset + i]);
+            txt << fmt::format("  [0x{0:08x}] +0x{1:x} {2} bytes, {3} -> {4} bytes{5}: {6}\n",
+                record.Placement, record.Offset, record.Size, record.OverriddenCount, record.RelocatedSize,
+                !record.Relocatable ? " (not decoded, copied as is)" : record.Branches ? fmt::format(" ({0} relative operands)", record.Branches) : "",
+                original);
+            pocket.ForEachHook(reinterpret_cast<Address>(record.Placement), [&](Hook const* hook, Address placement)
+            {
+                txt << fmt::format("      {0} {1} ({2}) size {3}{4}\n", hook->Type == HookType::Lean ? "lean " : "hook ",
+                    hook->FunctionName, moduleOf(hook), hook->Size,
+                    placement != reinterpret_cast<Address>(record.Placement) ? fmt::format(" at 0x{0:08x} (merged)", reinterpret_cast<uint32_t>(placement)) : "");
+            });
+        }
+
+        txt << "\nFacades (placement -> function):\n";
+        for (auto const& pair : program.Facades)
+        {
+            Hook const* hook = pair.second.Redefine;
+            txt << fmt::format("  [0x{0:08x}] -> 0x{1:08x} {2} ({3}){4}\n", (uint32_t) pair.first, (uint32_t) hook->Function, hook->FunctionName,
+                moduleOf(hook), hook->PlacementFunction.empty() ? "" : " for " + hook->PlacementFunction);
+        }
+
+        txt << "\nConflicts:\n";
+        auto const describe = [&moduleOf](Hook const* hook)
+        {
+            return fmt::format("{0} for {1}::0x{2:x}, {3} bytes", hook->FunctionName, moduleOf(hook), reinterpret_cast<uint32_t>(hook->Placement), hook->Size);
+        };
+        for (auto const& conflict : Conflicts)
+        {
+            static constexpr const char* Kinds[] = { "same redefine", "partial overlap", "redefine in pocket" };
+            txt << fmt::format("  {0}: ({1}) and ({2})\n", Kinds[static_cast<size_t>(conflict.Kind)], describe(conflict.First), describe(conflict.Second));
+        }
+        if (!txt)
+        {
+            spdlog::warn("Hook plan summary \"{0}\" is not writable.", summaryFileName);
+            written = false;
+        }
+        return written;
+    }
+}
@@ -0,0 +1,141 @@
+#ifndef INJECTOR_DRY_RUN_HPP
+#define INJECTOR_DRY_RUN_HPP
+
+#include <portable_executable.hpp>
+#include <simulated_process.hpp>
+#include <process_memory.hpp>
+#include <dll_registry.hpp>
+
+#include "framework.hpp"
+#include "module.hpp"
+#include "hook_injector.hpp"
+
+namespace Injector
+{
+    using namespace PECOFF;
+
+    static constexpr const char* DryRunPlanFileName    = "syringe.dryrun";
+    static constexpr const char* DryRunSummaryFileName = "syringe.dryrun.txt";
+    // exit code of -plan when hooks conflict (plan is written), so CI can fail on it
+    static constexpr int         DryRunConflictsExitCode = 2;
+
+    /*!
+    * @brief Binary hook plan written by DryRun: fixed width little-endian fields of 32 bit process, no Windows types.
+    * @brief Layout: DryRunHeader, DryRunImage[Images], DryRunPocket[Pockets], DryRunHook[Hooks], DryRunFacade[Facades],
+    * @brief DryRunConflict[Conflicts], string pool (zero terminated, fields named *Name are offsets into it), relocated bytes (DryRunPocket::BytesOffset).
+    * @brief Hooks follow pocket order: lean hooks of pocket first, then regular ones, then those of pockets merged into it.
+    */
+    #pragma pack(push, 1)
+    struct DryRunHeader
+    {
+        static constexpr uint32_t Magic   = 0x52445953; // 'SYDR'
+        static constexpr uint32_t Version = 2;
+
+        uint32_t Signature = Magic;
+        uint32_t Revision  = Version;
+        uint32_t ExecutableChecksum;
+        uint32_t Images;
+        uint32_t Pockets;
+        uint32_t Hooks;
+        uint32_t Facades;
+        uint32_t Conflicts;
+        uint32_t StringsSize;
+        uint32_t BytesSize;
+        // bytes of program (pockets) as it would be written into process
+        uint32_t ProgramSize;
+    };
+    struct DryRunImage
+    {
+        uint32_t FileName;
+        uint32_t Base;
+        uint32_t Size;
+        uint32_t Checksum;
+    };
+    struct DryRunPocket
+    {
+        uint32_t Placement;
+        // offset & bytes of pocket in program
+        uint32_t Offset;
+        uint32_t Size;
+        uint32_t OverriddenCount;
+        uint32_t BytesOffset;
+        // bytes of overridden instructions after relocation
+        uint32_t RelocatedSize;
+        uint32_t Branches;
+        uint8_t  Relocatable;
+        uint32_t FirstHook;
+        uint32_t LeanHooks;
+        uint32_t RegularHooks;
+    };
+    struct DryRunHook
+    {
+        uint32_t FunctionName;
+        uint32_t ModuleName;
+        uint8_t  Type;
+        uint32_t Function;
+        uint32_t Size;
+    };
+    struct DryRunFacade
+    {
+        uint32_t Placement;
+        uint32_t Function;
+        uint32_t FunctionName;
+        uint32_t ModuleName;
+    };
+    // hooks as declared: placement is RVA if ModuleName is not empty
+    struct DryRunConflictHook
+    {
+        uint32_t FunctionName;
+        uint32_t ModuleName;
+        uint32_t Placement;
+        uint32_t Size;
+    };
+    struct DryRunConflict
+    {
+        // HookConflictKind
+        uint8_t            Kind;
+        DryRunConflictHook First;
+        DryRunConflictHook Second;
+    };
+    #pragma pack(pop)
+
+    /*!
+    * @brief Hook plan without debuggee: executable, injectable modules and DLLs targeted by hooks (found next to executable)
+    * @brief are mapped from disk into SimulatedProcess at preferred bases (DLLs are moved by 64K when taken, without relocation),
+    * @brief hook functions & redefines by name are resolved from exports, then HookInjector runs against the simulated process.
+    * @brief Result is every pocket (overridden & relocated bytes, place in program), facade and conflict of hooks, saved by `save`.
+    */
+    class DryRun final
+    {
+    public:
+        struct Image
+        {
+            string       FileName;
+            DWORD        Base;
+            DWORD        Size;
+            unsigned int Checksum;
+        };
+
+        SimulatedProcess         Process;
+        ProcessMemory            Memory { Process };
+        DllRegistry              Dlls;
+        vector<Image>            Images;
+        unique_ptr<HookInjector> Injector;
+        // conflicts of planned program (see HookProgram::Conflicts)
+        vector<HookConflict>     Conflicts;
+
+        DryRun(PortableExecutable const& peExecutable, string_view const& executableFile, list<Module>& modules);
+
+        DryRun(DryRun const&) = delete;
+        DryRun& operator=(DryRun const&) = delete;
+
+        // Writes binary plan & readable summary, returns false if any file is not writable
+        bool save(string const& planFileName, string const& summaryFileName) const;
+    private:
+        // Copies headers & sections of file into simulated process, returns base of image
+        DWORD map_image(string const& fileName, PortableExecutable const& pe);
+        void  map_targets(string_view const& executableFile, list<Module> const& modules);
+        void  resolve_redefines(list<Module>& modules);
+    };
+}
+#endif //INJECTOR_DRY_RUN_HPP
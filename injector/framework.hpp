@@ -12,11 +12,14 @@
 #include <memory>
 #include <variant>
 
+#include <platform.hpp>
 #include <handle.hpp>
 #include <macro.hpp>
 #include <events.hpp>
 #include <string.hpp>
+#ifdef _WIN32
 #include <portable_executable.hpp>
+#endif
 
 //#define FMT_HEADER_ONLY
 #include <spdlog/spdlog.h>
@@ -40,10 +43,12 @@ namespace Injector
     using std::make_unique;
 }
 
+#ifdef _WIN32
 template<typename TFunction>
 inline TFunction GetFunctionAddress(HMODULE handle, std::string_view const& name)
 {
     return reinterpret_cast<TFunction>(GetProcAddress(handle, name.data()));
 }
+#endif
 
 #endif //INJECTOR_FRAMEWORK_HPP
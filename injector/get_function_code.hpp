@@ -71,7 +71,7 @@ namespace Injector
                 _processMemory(processMemory),
                 _procNameMemoryHandle(processMemory.Allocate(MaxLibraryNameLength + 1)),
                 _funcMemoryHandle(processMemory.Allocate(sizeof(FARPROC))),
-                _codeMemoryHandle(processMemory.Allocate(GetProcAddressCodeDataSize)),
+                _codeMemoryHandle(processMemory.Allocate(GetProcAddressCodeDataSize, MemoryPool::Code)),
                 _code()
         {
             memcpy(&_code, GetProcAddressCodeData, GetProcAddressCodeDataSize);
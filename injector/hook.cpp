@@ -1,4 +1,8 @@
+#include <algorithm>
+#include <cctype>
+
 #include "hook.hpp"
+#include "misc_code.hpp"
 
 namespace Injector
 {
@@ -33,4 +37,93 @@ namespace Injector
         FunctionName(functionName),
         Decl(decl)
     {}
+    Hook::Hook(std::string functionName, LeanHookDecl& decl) :
+        Type(HookType::Lean),
+        FunctionName(functionName),
+        Decl(decl)
+    {}
+    Hook::Hook(std::string functionName, Variant const& decl) :
+        Type(type_of(decl)),
+        FunctionName(functionName),
+        Decl(decl)
+    {}
+
+    HookIntervalIndex::HookIntervalIndex(std::vector<Hook*> const& hooks)
+    {
+        _intervals.reserve(hooks.size());
+        for (Hook* hook : hooks)
+        {
+            if (!hook->Placement)
+                continue;
+
+            std::string module = hook->ModuleName;
+            for (char& c : module)
+                c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+            DWORD const begin = reinterpret_cast<DWORD>(hook->Placement);
+            size_t const size = hook->is_redefine() || hook->Size < JumpR32lInstructionLength ? JumpR32lInstructionLength : hook->Size;
+            _intervals.push_back({ std::move(module), begin, static_cast<DWORD>(begin + size), hook });
+        }
+        sort();
+    }
+    HookIntervalIndex::HookIntervalIndex(std::vector<Interval> intervals) :
+        _intervals(std::move(intervals))
+    {
+        sort();
+    }
+
+    void HookIntervalIndex::sort()
+    {
+        std::stable_sort(_intervals.begin(), _intervals.end(), [](Interval const& a, Interval const& b)
+        {
+            int const module = a.Module.compare(b.Module);
+            return module != 0 ? module < 0 : a.Begin < b.Begin;
+        });
+    }
+
+    std::vector<HookConflict> HookIntervalIndex::conflicts() const
+    {
+        std::vector<HookConflict> conflicts;
+
+        // previous ranges reaching farthest (of pocket hooks & of redefines) and the first redefine of current placement
+        Interval const* pocket   = nullptr;
+        Interval const* redefine = nullptr;
+        Interval const* first    = nullptr;
+        for (Interval const& interval : _intervals)
+        {
+            if (pocket && pocket->Module != interval.Module)
+                pocket = nullptr;
+            if (redefine && redefine->Module != interval.Module)
+                redefine = nullptr;
+            if (first && (first->Module != interval.Module || first->Begin != interval.Begin))
+                first = nullptr;
+
+            bool const overlapsPocket   = pocket && pocket->End > interval.Begin;
+            bool const overlapsRedefine = redefine && redefine->End > interval.Begin;
+            if (interval.Source->is_redefine())
+            {
+                if (first)
+                    conflicts.push_back({ HookConflictKind::SameRedefine, first->Source, interval.Source });
+                else if (overlapsRedefine)
+                    conflicts.push_back({ HookConflictKind::PartialOverlap, redefine->Source, interval.Source });
+                if (overlapsPocket)
+                    conflicts.push_back({ HookConflictKind::RedefineInPocket, pocket->Source, interval.Source });
+
+                if (!first)
+                    first = &interval;
+                if (!redefine || interval.End > redefine->End)
+                    redefine = &interval;
+            }
+            else
+            {
+                if (overlapsPocket && pocket->Begin != interval.Begin)
+                    conflicts.push_back({ HookConflictKind::PartialOverlap, pocket->Source, interval.Source });
+                if (overlapsRedefine)
+                    conflicts.push_back({ HookConflictKind::RedefineInPocket, redefine->Source, interval.Source });
+
+                if (!pocket || interval.End > pocket->End)
+                    pocket = &interval;
+            }
+        }
+        return conflicts;
+    }
 }
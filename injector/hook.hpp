@@ -16,19 +16,27 @@ namespace Injector
         /* FunctionReplacemen0tDecl */
         FacadeByName = 3,
         /* FunctionReplacement1Decl */
-        FacadeAtAddress = 4
+        FacadeAtAddress = 4,
+        /* LeanHookDecl */
+        Lean = 5
     };
     class Hook final
     {
         friend class Module;
     public:
-        using Variant = std::variant<HookDecl, ExtendedHookDecl, FunctionReplacement0Decl, FunctionReplacement1Decl>;
+        using Variant = std::variant<HookDecl, ExtendedHookDecl, FunctionReplacement0Decl, FunctionReplacement1Decl, LeanHookDecl>;
 
         HookType    const Type = HookType::Unknown;
         Variant     const Decl;
         std::string const FunctionName;
 
         HookFunction Function       { nullptr };
+        // RVA of hook function inside its module (0 - unknown), it's stored in plan cache
+        DWORD        FunctionRva    = 0;
+        // Function can't be resolved from module exports (forwarded out of known modules), it's retrieved by remote GetProcAddress
+        bool         ResolveRemotely = false;
+        // Function is given by RVA from hook manifest (FunctionRva), it isn't exported
+        bool         Direct         = false;
         Address      Placement      { nullptr };
         std::string  PlacementFunction = "";
         Address      ModuleBase     { nullptr };
@@ -42,7 +50,66 @@ namespace Injector
         Hook(std::string functionName, ExtendedHookDecl& decl);
         Hook(std::string functionName, FunctionReplacement0Decl& decl);
         Hook(std::string functionName, FunctionReplacement1Decl& decl);
+        Hook(std::string functionName, LeanHookDecl& decl);
+        Hook(std::string functionName, Variant const& decl);
+
+        // HookType values follow the order of Variant alternatives
+        static HookType type_of(Variant const& decl) { return static_cast<HookType>(decl.index() + 1); }
+        bool is_redefine() const noexcept { return Type == HookType::FacadeByName || Type == HookType::FacadeAtAddress; }
+    };
+
+    enum class HookConflictKind
+    {
+        // redefines (facades) of the same placement, only the first one is applied
+        SameRedefine,
+        // ranges of hooks overlap, but placements differ
+        PartialOverlap,
+        // jump of redefine overlaps overridden instructions of hook (or the other way)
+        RedefineInPocket,
+    };
+    struct HookConflict
+    {
+        HookConflictKind Kind;
+        Hook*            First;
+        Hook*            Second;
+    };
+
+    /*!
+    * @brief Index of ranges of hooks: [placement, placement + overridden size) for hooks called from pockets and
+    * @brief [placement, placement + jump) for redefines, keyed by target module (placements of modules are RVAs,
+    * @brief redefines by name included - ParseModules resolves them relative to module loaded into injector).
+    * @brief Built by one sort, so conflicts of all modules are found in O(H log H): each hook is checked against the range
+    * @brief reaching farthest among previous ones, so every conflicting hook is reported once (not every pair).
+    * @brief Hooks with equal placement are not conflicts unless both are redefines - they share a pocket.
+    * @brief Built from hooks, ranges are of declared sizes (before process exists); HookProgram::Conflicts builds it from planned parts.
+    */
+    class HookIntervalIndex final
+    {
+    public:
+        struct Interval
+        {
+            std::string Module;
+            DWORD       Begin;
+            DWORD       End;
+            Hook*       Source;
+        };
+    private:
+        // by module, begin, then order of hooks
+        std::vector<Interval> _intervals;
+
+        void sort();
+    public:
+        // Unresolved placements are skipped
+        explicit HookIntervalIndex(std::vector<Hook*> const& hooks);
+        // Ranges given by caller, module is empty for absolute placements
+        explicit HookIntervalIndex(std::vector<Interval> intervals);
+
+        std::vector<HookConflict> conflicts() const;
+
+        std::vector<Interval> const& intervals() const noexcept { return _intervals; }
     };
+
+    inline std::vector<HookConflict> find_hook_conflicts(std::vector<Hook*> const& hooks) { return HookIntervalIndex(hooks).conflicts(); }
 }
 
 #endif //INJECTOR_HOOK_HPP
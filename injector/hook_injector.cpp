@@ -2,10 +2,13 @@
 
 namespace Injector
 {
-    HookInjector::HookInjector(Debugger::DebugLoop& dbgr, list<Module>& modules)
-            : Memory(dbgr.Memory), Modules(modules)
+    HookInjector::HookInjector(Debugger::DebugLoop& dbgr, list<Module>& modules, HookProfiler* profiler, HookTracer* tracer)
+            : HookInjector(dbgr.Memory, dbgr.ExecutablePath, dbgr.Dlls, modules, profiler, tracer) { }
+
+    HookInjector::HookInjector(ProcessMemory& memory, string_view const& executablePath, DllRegistry& dlls, list<Module>& modules, HookProfiler* profiler, HookTracer* tracer)
+            : Memory(memory), Modules(modules), Program(memory), Profiler(profiler), Tracer(tracer)
     {
-        auto executableChecksum = CRC32::compute_stream(file_open_binary(dbgr.ExecutablePath));
+        auto executableChecksum = ChecksumRegistry::instance().get(executablePath);
         for (Module& mdl : modules)
         {
             HMODULE handle = mdl.get_handle();
@@ -20,7 +23,6 @@ namespace Injector
             for (auto& hook : mdl.Hooks)
             {
                 bool isInExecutable = hook.ModuleName.empty();
-                auto hookModuleName = isInExecutable ? "executable" : "\"" + hook.ModuleName + "\"";
 
                 if (!hook.Function)
                 {
@@ -32,17 +34,8 @@ namespace Injector
                 auto placement = hook.Placement;
                 if (!isInExecutable)
                 {
-                    auto inProcessDll = std::find_if(dbgr.Dlls.cbegin(), dbgr.Dlls.cend(),
-                        [&hook, &dbgr](DllMap::value_type pair) -> bool
-                        {
-                            auto ofnp = std::filesystem::path(pair.second.FVI.Loaded ? pair.second.FVI.OriginalFilename : pair.second.FileName);
-                            auto ofn  = ofnp.filename(); // .stem(); no extension
-                            auto mfnp = std::filesystem::path(hook.ModuleName);
-                            auto mfn  = mfnp.filename(); //.stem();
-                            return ofn == mfn;
-                        }
-                    );
-                    if (inProcessDll == dbgr.Dlls.cend())
+                    DllInfo* inProcessDll = dlls.FindByOriginalName(hook.ModuleName);
+                    if (!inProcessDll)
                     {
                         spdlog::info("::Hook \"{0}\" target module \"{1}\" not found, skip.",
                             hook.FunctionName,
@@ -50,8 +43,8 @@ namespace Injector
                         ); continue;
                     }
 
-                    hook.ModuleBase = inProcessDll->first;
-                    checksum = inProcessDll->second.Checksum;
+                    hook.ModuleBase = inProcessDll->Base;
+                    checksum = inProcessDll->Checksum();
                 }
 
                 bool checksumIsOk = hook.ModuleChecksum == 0 || checksum == hook.ModuleChecksum;
@@ -67,216 +60,91 @@ namespace Injector
                     reinterpret_cast<DWORD>(placement) + reinterpret_cast<DWORD>(/*isInExecutable ? 0 : */hook.ModuleBase)
                 );
 
-                string logAddition, logAddition2;
-
-                switch (hook.Type)
-                {
-                    case(HookType::Generic): {}
-                    case(HookType::Extended):
-                    {
-                        spdlog::info("::[0x{2:x}:0x{3:x} = 0x{4:x}] - on \"{1}\" placed hook \"{0}\".",
-                            hook.FunctionName, hookModuleName,
-                            (uint32_t)hook.ModuleBase, (uint32_t)hook.Placement, (uint32_t)placement
-                        );
-
-                        auto pocketIterator = Pockets.find(placement);
-                        if (pocketIterator == Pockets.end())
-                            pocketIterator = Pockets.emplace(placement, HookPocket()).first;
-
-                        HookPocket& pocket = pocketIterator->second;
-                        pocket.Hooks.push_back(&hook);
-                        pocket.OverriddenCount =
-                            hook.Size > pocket.OverriddenCount ? hook.Size : pocket.OverriddenCount;
-                    } break;
-                    case(HookType::FacadeByName):
-                    { logAddition = "::" + hook.PlacementFunction; }
-                    case(HookType::FacadeAtAddress):
-                    {
-                        auto facadeIterator = Facades.find(placement);
-                        if (facadeIterator != Facades.end())
-                        {
-                            logAddition2 = " - FIRST REDEFINE WILL BE CHOISEN!";
-                        }
-                        else
-                        {
-                            facadeIterator = Facades.emplace(placement, Facade()).first;
-                            facadeIterator->second.Redefine = &hook;
-                        }
-
-                        spdlog::info("::[0x{2:x}:0x{3:x} = 0x{4:x}] - for {1}{5} redefine \"{0}\"{6}.",
-                            hook.FunctionName, hookModuleName,
-                            (uint32_t)hook.ModuleBase, (uint32_t)hook.Placement, (uint32_t)placement,
-                            logAddition, logAddition2
-                        );
-                    } break;
-                    default:
-                    {
-                        spdlog::warn("::WTF UKNOWN HOOK!? MUST NEVER HAPPEN.");
-                    } break;
-                }
+                Program.Add(hook, placement);
             }
         }
 
-        size_t programSize = 0;
+        auto const counters = MemoryCounters::current();
+        Program.Plan();
+        size_t prefixSize = 0;
 
-        spdlog::info("Iterate hook pockets and calculate total program size...");
-        for (auto& pair : Pockets)
+        // profile & trace thunks are placed at the start of program, one per regular hook (in pocket order) of each kind
+        vector<HookProfiler::ProfiledHook> instrumentedHooks;
+        if (Profiler || Tracer)
+            for (auto& pair : Program.Pockets)
+                pair.second.ForEachRegularHook(pair.first, [&instrumentedHooks](Hook* hook, Address placement) { instrumentedHooks.push_back({ hook, placement }); });
+        if (Profiler)
         {
-            HookPocket& pocket = pair.second;
-
-            size_t const overridenCount = pocket.OverriddenCount;
-            if (overridenCount < 5)
-                pocket.OverriddenCount = 5;
-
-            pocket.OriginalBytes.resize(pocket.OverriddenCount);
-            Memory.Read(pair.first, pocket.OriginalBytes.data(), pocket.OriginalBytes.size());
-            if (auto rji = is_relative_jump(pocket.OriginalBytes))
-                programSize += 4; // byte jump - 2 bytes, int32 jump - 5 (but some 6) bytes. For edge case, when need extend every 1-byte jump to 4 byte-jump need +4 byte to total program size.
-
-            programSize += RegistersBuildCodeSize;
-            programSize += HookCallCodeSize * pocket.Hooks.size();
-            programSize += RegistersCleanupCodeSize;
-            programSize += pocket.OverriddenCount;
-            programSize += JumpCodeSize;
-
-            if (overridenCount < 5)
-                spdlog::trace("::[0x{0:x}] {1:d} functions, {2:d} overriden bytes (fixed from {3:d})", (uint32_t)pair.first, pair.second.Hooks.size(), pair.second.OverriddenCount, overridenCount);
-            else
-                spdlog::trace("::[0x{0:x}] {1:d} functions, {2:d} overriden bytes", (uint32_t)pair.first, pair.second.Hooks.size(), pair.second.OverriddenCount);
+            try
+            {
+                Profiler->Map(instrumentedHooks);
+                prefixSize += ProfileThunkCodeSize * instrumentedHooks.size();
+            }
+            catch (SharedSection::MappingException const& ex)
+            {
+                spdlog::error("Hooks are not profiled: {0}", ex.what());
+                Profiler = nullptr;
+            }
+        }
+        if (Tracer)
+        {
+            try
+            {
+                vector<HookTracer::TracedHook> tracedHooks;
+                for (auto const& instrumented : instrumentedHooks)
+                    tracedHooks.push_back({ instrumented.Source, instrumented.Placement });
+                Tracer->Map(std::move(tracedHooks));
+                prefixSize += TraceThunkCodeSize * instrumentedHooks.size();
+            }
+            catch (SharedSection::MappingException const& ex)
+            {
+                spdlog::error("Hooks are not traced: {0}", ex.what());
+                Tracer = nullptr;
+            }
         }
 
-        NextInstructionsVmh = &Memory.Allocate(sizeof(Address) * Pockets.size());
-        ProgramVmh = &Memory.Allocate(programSize);
-
-        spdlog::info("Hook program block: ");
-        spdlog::info("::Address = 0x{0:x}", (uint32_t) ProgramVmh->Pointer(0));
-        spdlog::info("::Size = {0} (bytes)", ProgramVmh->Size());
-        spdlog::info("Next instruction memory block: ");
-        spdlog::info("::Address = 0x{0:x}", (uint32_t)NextInstructionsVmh->Pointer(0));
-        spdlog::info("::Size = {0} (bytes)", NextInstructionsVmh->Size());
-
-        DWORD refNextInstruction = reinterpret_cast<DWORD>(NextInstructionsVmh->Pointer(0));
+        Program.Allocate(prefixSize);
+        VirtualMemoryHandle* const programVmh = Program.ProgramVmh;
         size_t offset = 0;
 
-        spdlog::info("Hook program block assembling...");
-        for (auto& pair : Pockets)
+        if (Profiler)
         {
-            Address const hookAddr = pair.first;
-            HookPocket& pocket = pair.second;
-            pocket.Offset = offset;
-
-            Address const jumpBase   = reinterpret_cast<BYTE*>(hookAddr) + JumpR32lInstructionLength;
-            Address const jumpOffset = ProgramVmh->Pointer(offset);
-
-            pocket.HookCallerBlockCode.Offset = relative_offset(jumpBase, jumpOffset);
-            Memory.Write(hookAddr, &pocket.HookCallerBlockCode, JumpCodeSize);
-
-            pocket.RegistersBuild.HookAddress = hookAddr;
-            for (Hook* hook : pocket.Hooks)
+            for (size_t index = 0; index < instrumentedHooks.size(); index++)
             {
-                Address const base = ProgramVmh->Pointer(offset);
-                pocket.HookCallBlocks.emplace_back(
-                    reinterpret_cast<Address>(refNextInstruction),
-                    base,
-                    hook->Function,
-                    hook->ModuleBase);
-                offset += HookCallCodeSize;
+                ProfileThunks.emplace_back(programVmh->Pointer(offset), instrumentedHooks[index].Source->Function, Profiler->Remote(index));
+                offset += ProfileThunkCodeSize;
             }
-            offset = pocket.Offset;
-
-            size_t const hookCallersSize = pocket.HookCallBlocks.size() * HookCallCodeSize;
-            size_t const overridenSize = pocket.OriginalBytes.size();
-            size_t const jumpBackSize = JumpCodeSize;
-
-            ProgramVmh->Write(&pocket.RegistersBuild, RegistersBuildCodeSize, offset);
-            offset += RegistersBuildCodeSize;
-
-            ProgramVmh->Write(pocket.HookCallBlocks.data(), hookCallersSize, offset);
-            offset += hookCallersSize;
-
-            ProgramVmh->Write(&pocket.RegistersCleanup, RegistersCleanupCodeSize, offset);
-            offset += RegistersCleanupCodeSize;
-
-            if (auto rji = is_relative_jump(pocket.OriginalBytes))
+            Program.Emit(ProfileThunks.data(), ProfileThunkCodeSize * ProfileThunks.size(), 0);
+            spdlog::info("::{0} hooks are called through profile thunks.", ProfileThunks.size());
+        }
+        size_t const traceThunksOffset = offset;
+        if (Tracer)
+        {
+            for (size_t index = 0; index < instrumentedHooks.size(); index++)
             {
-                Address pFrom     = ProgramVmh->Pointer(offset);
-                auto    oldOffset = get_relative_offset(pocket.OriginalBytes, rji);
-                auto    pTo       = restore_address(hookAddr, oldOffset, rji.Cmd.Command.size());
-                try
-                {
-                    auto newOffset = relative_offset(pFrom, pTo, rji.Cmd.Command.size());
-                    set_relative_offset(pocket.OriginalBytes, rji, newOffset);
-
-                    spdlog::info("::{0} rel{1:d} => 0x{2:x}: 0x{3:x}+0x{4:x}:{5:X}h -> 0x{3:x}+0x{6:x}:{7:X}h)",
-                        rji.Cmd.Mnemonic, rji.Cmd.Size * 8, (uint32_t) pTo,
-                        rji.Cmd.Command.size(),
-                        (uint32_t) hookAddr, oldOffset,
-                        (uint32_t) pFrom , newOffset
-                    );
-                }
-                catch (const invalid_jump_offset_error& ex)
-                {
-                    try
-                    {
-                        auto cmd = find_rel_cmd(rji.Cmd.Mnemonic, 4);
-                        std::vector<BYTE> extended; extended.resize(pocket.OriginalBytes.size() - rji.Cmd.Command.size() + cmd.Command.size());
-                        memcpy(extended.data(), cmd.Command.data(), cmd.Command.size());
-                        memcpy(extended.data() + cmd.Command.size(), pocket.OriginalBytes.data() + rji.Cmd.Command.size(), pocket.OriginalBytes.size() - rji.Cmd.Command.size());
-                        auto newOffset = relative_offset(pFrom, pTo, cmd.Command.size());
-                        set_relative_offset(extended, rji, newOffset);
-
-                        pocket.OriginalBytes = extended;
-                        spdlog::info("::{0} rel{1:d} => 0x{2:x}: 0x{3:x}+0x{4:x}:{5:X}h -> 0x{3:x}+0x{6:x}:{7:X}h) - extended to {0} rel{8:d}",
-                            rji.Cmd.Mnemonic, rji.Cmd.Size * 8, (uint32_t) pTo,
-                            rji.Cmd.Command.size(),
-                            (uint32_t) hookAddr, oldOffset,
-                            (uint32_t) pFrom , newOffset,
-                            cmd.Size * 8
-                        );
-                    }
-                    catch (...)
-                    {
-                        spdlog::error("::{0} rel{1:d} => 0x{2:x}: 0x{3:x}+0x{4:x}:{5:X}h -> 0x{3:x}+0x{6:x}:{7:X}h) - no command with huge offset size, SKIP",
-                            rji.Cmd.Mnemonic, rji.Cmd.Size * 8, (uint32_t) pTo,
-                            rji.Cmd.Command.size(),
-                            (uint32_t) hookAddr, oldOffset,
-                            (uint32_t) pFrom, ex.Value
-                        );
-                    }
-                }
+                Address const target = Profiler
+                    ? programVmh->Pointer(ProfileThunkCodeSize * index)
+                    : reinterpret_cast<Address>(instrumentedHooks[index].Source->Function);
+                TraceThunks.emplace_back(programVmh->Pointer(offset), target, *Tracer, static_cast<DWORD>(index));
+                offset += TraceThunkCodeSize;
             }
-            ProgramVmh->Write(pocket.OriginalBytes.data(), pocket.OriginalBytes.size(), offset);
-            offset += pocket.OriginalBytes.size();
-
-            // Jump back
-            Address const jumpBackBase = ProgramVmh->Pointer(offset);
-            Address const jumpBackAddress = reinterpret_cast<BYTE*>(hookAddr) + max(JumpR32lInstructionLength, pocket.OverriddenCount);
-            pocket.JumpBackCode.Offset = relative_offset(jumpBackBase, jumpBackAddress, JumpR32lInstructionLength);
-
-            ProgramVmh->Write(&pocket.JumpBackCode, jumpBackSize, offset);
-            offset += jumpBackSize;
-
-            refNextInstruction++;
+            Program.Emit(TraceThunks.data(), TraceThunkCodeSize * TraceThunks.size(), traceThunksOffset);
+            spdlog::info("::{0} hooks are called through trace thunks.", TraceThunks.size());
         }
 
-        spdlog::info("Redefines:");
-        for (auto& redefine : Facades)
+        // regular hooks are called through their instrumentation thunks
+        Program.Assemble([this, traceThunksOffset, programVmh](Hook& hook, size_t index) -> HookFunction
         {
-            auto hook = redefine.second.Redefine;
-            auto placement = redefine.first;
-            Address const jumpBase = reinterpret_cast<BYTE*>(placement) + JumpR32lInstructionLength;
-            Address const jumpTo = hook->Function;
-
-            redefine.second.FacadeCallerBlockCode.Offset = relative_offset(jumpBase, jumpTo);
-            dbgr.Memory.Write(placement, &redefine.second.FacadeCallerBlockCode, JumpCodeSize);
-            spdlog::info("::0x{0:x} --> 0x{1:x} ({2})",
-                placement, jumpTo, hook->FunctionName
-            );
-        }
-    }
-    HookInjector::~HookInjector()
-    {
-        Memory.Free(*NextInstructionsVmh);
-        Memory.Free(*ProgramVmh);
+            if (Tracer)
+                return reinterpret_cast<HookFunction>(programVmh->Pointer(traceThunksOffset + TraceThunkCodeSize * index));
+            if (Profiler)
+                return reinterpret_cast<HookFunction>(programVmh->Pointer(ProfileThunkCodeSize * index));
+            return hook.Function;
+        });
+        Program.Write();
+
+        auto const stats = MemoryCounters::current() - counters;
+        spdlog::info("Hook program written: {0} bytes by 1 call; {1} hook site patches in {2} page groups.", Program.Code.size(), Program.SitePatches, Program.SiteGroups);
+        spdlog::info("Remote memory: {0} writes ({1} bytes), {2} reads ({3} bytes).", stats.WriteCalls, stats.WrittenBytes, stats.ReadCalls, stats.ReadBytes);
     }
 }
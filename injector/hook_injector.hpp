@@ -3,175 +3,207 @@
 
 #include <portable_executable.hpp>
 #include <process_memory.hpp>
+#include <patch_batch.hpp>
 #include <debugger.hpp>
 
 #include "framework.hpp"
 #include "module.hpp"
 #include "misc_code.hpp"
 #include "get_function_code.hpp"
+#include "x86_decoder.hpp"
+#include "hook_program.hpp"
+#include "hook_profiler.hpp"
+#include "hook_tracer.hpp"
 
 namespace Injector
 {
-    BYTE const RegistersBuildCodeData[] =
+    BYTE const ProfileThunkCodeData[] =
     {
-        PUSHAD, PUSHFD,              // It creates REGISTERS structure
-        PUSH_INTO_STACK(INIT_DWORD), // Push address of hook
-        PUSH_ESP,                    // At the top of stack will be REGISTER, and it pushes this* for it
+        RDTSC, PUSH_EDX, PUSH_EAX,                                // Save start timestamp
+        PUSH_ESP_DISP8(0x0C),                                     // Push REGISTERS* again (passed to thunk by hook caller)
+        CALL_R32(INIT_PTR),                                       // Invoke Hook function
+        ADD_ESP(0x04),
+        PUSH_EAX,                                                 // Save result of hook function
+        RDTSC,
+        SUB_R32_ESP_DISP8(EAX, 0x04), SBB_R32_ESP_DISP8(EDX, 0x08), // EDX:EAX = elapsed cycles
+        LOCK, ADD_PTR32_IMM8(INIT_PTR, 0x01),                     // ++Calls
+        LOCK, ADC_PTR32_IMM8(INIT_PTR, 0x00),
+        LOCK, ADD_PTR32_R32(INIT_PTR, EAX),                       // Cycles += EDX:EAX
+        LOCK, ADC_PTR32_R32(INIT_PTR, EDX),
+        TEST_R32_R32(EDX, EDX),                                   // ECX = index of highest set bit of EDX:EAX (0 for 0)
+        JZ_R8(0x08),
+        BSR_R32_R32(ECX, EDX),
+        ADD_R32_IMM8(ECX, 0x20),
+        JMP_R8(0x07),
+        BSR_R32_R32(ECX, EAX),
+        JNZ_R8(0x02),
+        XOR_R32_R32(ECX, ECX),
+        LOCK, INC_PTR32_R32X4(INIT_PTR, ECX),                     // ++Histogram[ECX]
+        POP_EAX,                                                  // Restore result of hook function
+        ADD_ESP(0x08),                                            // Remove start timestamp
+        RET
     };
-    static constexpr size_t RegistersBuildCodeDataSize = sizeof(RegistersBuildCodeData);
+    static constexpr size_t ProfileThunkCodeDataSize = sizeof(ProfileThunkCodeData);
+    static constexpr size_t ProfileThunkCodeCallOffset = 8;
 
     #pragma pack(push, 1)
-    struct RegistersBuildCode
+    /*!
+    * @brief Measures call of hook function: called by HookCallCode instead of hook function itself, has the same signature.
+    * @brief Counters are updated by locked instructions in the HookProfileEntry of hook (shared section).
+    */
+    struct ProfileThunkCode
     {
-        BYTE Pushad;
-        BYTE Pushfd;
-        BYTE PUSH_MEM_OpCode;
-        Address HookAddress;
-        BYTE PUSH_ESP_OpCode;
-
-        RegistersBuildCode()
+        BYTE    Prologue[8];
+        BYTE    CALL_OpCode;
+        DWORD   FunctionProcRelativeAddress;
+        BYTE    Elapsed[14];
+        BYTE    LOCK_ADD_Calls_OpCode[3];
+        Address CallsLow;
+        BYTE    CallsIncrement;
+        BYTE    LOCK_ADC_Calls_OpCode[3];
+        Address CallsHigh;
+        BYTE    CallsCarry;
+        BYTE    LOCK_ADD_Cycles_OpCode[3];
+        Address CyclesLow;
+        BYTE    LOCK_ADC_Cycles_OpCode[3];
+        Address CyclesHigh;
+        BYTE    Bucket[19];
+        BYTE    LOCK_INC_Histogram_OpCode[4];
+        Address Histogram;
+        BYTE    Epilogue[5];
+
+        ProfileThunkCode()
         {
-            memcpy(this, RegistersBuildCodeData, RegistersBuildCodeDataSize);
+            memcpy(this, ProfileThunkCodeData, ProfileThunkCodeDataSize);
         }
-        RegistersBuildCode(Address hookAddress)
+        ProfileThunkCode(
+            Address base,
+            HookFunction hookFunction,
+            HookProfileEntry* entry)
         {
-            memcpy(this, RegistersBuildCodeData, RegistersBuildCodeDataSize);
+            memcpy(this, ProfileThunkCodeData, ProfileThunkCodeDataSize);
 
-            HookAddress = hookAddress;
-        }
-    };
-    static constexpr size_t RegistersBuildCodeSize = sizeof(RegistersBuildCode);
-    #pragma pack(pop)
-    static_assert(RegistersBuildCodeSize == RegistersBuildCodeDataSize, "The code and data are not equals");
-
-    BYTE const RegistersCleanupCodeData[] =
-    {
-        ADD_ESP(0x08), // Remove REGISTERS* from stack
-        POPFD, POPAD   // Clear registers content from stack
-    };
-    static constexpr size_t RegistersCleanupCodeDataSize = sizeof(RegistersCleanupCodeData);
+            BYTE* const calls  = reinterpret_cast<BYTE*>(&entry->Calls);
+            BYTE* const cycles = reinterpret_cast<BYTE*>(&entry->Cycles);
 
-    #pragma pack(push, 1)
-    struct RegistersCleanupCode
-    {
-        BYTE AddEsp[2];
-        BYTE AddEsp_Value;
-        BYTE Popfd;
-        BYTE PopAd;
+            CallsLow   = calls;
+            CallsHigh  = calls + sizeof(DWORD);
+            CyclesLow  = cycles;
+            CyclesHigh = cycles + sizeof(DWORD);
+            Histogram  = entry->Histogram;
 
-        RegistersCleanupCode()
-        {
-            memcpy(this, RegistersCleanupCodeData, RegistersCleanupCodeDataSize);
+            FunctionProcRelativeAddress = relative_offset(
+                reinterpret_cast<BYTE*>(base) + ProfileThunkCodeCallOffset + CallR32InstructionLength,
+                reinterpret_cast<Address>(hookFunction));
         }
     };
-    static constexpr size_t RegistersCleanupCodeSize = sizeof(RegistersCleanupCode);
+    static constexpr size_t ProfileThunkCodeSize = sizeof(ProfileThunkCode);
     #pragma pack(pop)
-    static_assert(RegistersCleanupCodeSize == RegistersCleanupCodeDataSize, "The code and data are not equals");
 
-    BYTE const HookCallCodeData[] =
+    static_assert(ProfileThunkCodeSize == ProfileThunkCodeDataSize, "The code and data are not equals");
+
+    BYTE const TraceThunkCodeData[] =
     {
-        CALL_R32(INIT_PTR),                    // Invoke Hook function
-        MOV_EAX_TO(INIT_PTR),                  // Save result of hook function, ds:ReturnEIP
-        CMP_PTR32_IMM32(INIT_PTR, 0x00),       // Test result for zero (it is address)  | CMP ds:ReturnEIP, 0
-        JZ_R8(0x15),                           // Jump the next instruction outse hook caller (there must be placed overriden bytes with jumb back or another hook caller block
-        ADD_PTR32_IMM32(INIT_PTR, INIT_DWORD), // Make correction of base for hook module. For executable itself it must be 0. | add dword ptr[ds:ReturnEIP], MODULE BASE (Handle)
-        ADD_ESP(0x08),                         // Remove REGISTERS* from stack
-        POPFD, POPAD,                          // Clear registers content from stack
-        JMP_PTR32(INIT_PTR),                   // Jump to returned address | JMP ds:ReturnEIP
+        PUSH_ESP_DISP8(0x04),                            // Push REGISTERS* again (passed to thunk by hook caller)
+        CALL_R32(INIT_PTR),                              // Invoke Hook function (or its profile thunk)
+        ADD_ESP(0x04),
+        PUSH_EAX,                                        // Save result of hook function
+        PUSH_R32(EBX),
+        MOV_R32_IMM32(ECX, IMM32(1)),
+        LOCK, XADD_PTR32_R32(INIT_PTR, ECX),             // ECX = Head++ (claim slot)
+        LEA_R32_R32_DISP8(EBX, ECX, 0x01),               // EBX = sequence of record
+        AND_R32_IMM32(ECX, INIT_DWORD),                  // ECX = &Records[ECX & (Capacity - 1)]
+        SHL_R32_IMM8(ECX, HookTraceRecordShift),
+        ADD_R32_IMM32(ECX, INIT_PTR),
+        MOV_R32PTR_IMM32(ECX, IMM32(0)),                 // Sequence = 0 (record is being written)
+        MOV_R32PTR_DISP8_IMM32(ECX, 0x04, INIT_DWORD),   // Hook
+        MOV_R32PTR_DISP8_R32(ECX, 0x10, EAX),            // Return
+        RDTSC,
+        MOV_R32PTR_DISP8_R32(ECX, 0x08, EAX),            // Tsc
+        MOV_R32PTR_DISP8_R32(ECX, 0x0C, EDX),
+        MOV_EAX_FS(IMM32(0x24)),                         // Thread = TEB.ClientId.UniqueThread
+        MOV_R32PTR_DISP8_R32(ECX, 0x14, EAX),
+        MOV_R32PTR_R32(ECX, EBX),                        // Sequence (publish record, stores are not reordered on x86)
+        POP_R32(EBX),
+        POP_EAX,                                         // Restore result of hook function
+        RET
     };
-    static constexpr size_t HookCallCodeDataSize = sizeof(HookCallCodeData);
-    static constexpr size_t HookCallCodeCallOffset = 8;
+    static constexpr size_t TraceThunkCodeDataSize = sizeof(TraceThunkCodeData);
+    static constexpr size_t TraceThunkCodeCallOffset = 4;
 
     #pragma pack(push, 1)
-    struct HookCallCode
+    /*!
+    * @brief Appends HookTraceRecord to the ring of HookTracer after call of hook function: called by HookCallCode instead of hook function itself.
+    * @brief Several threads may trace at once - slot is claimed by locked instruction.
+    */
+    struct TraceThunkCode
     {
+        BYTE    PUSH_Registers_OpCode[4];
         BYTE    CALL_OpCode;
         DWORD   FunctionProcRelativeAddress;
-        BYTE    MOV_EAX_OpCode;
-        Address RefNextInstruction1;
-        BYTE    CMP_ReturnEIP_OpCode_1;
-        BYTE    CMP_ReturnEIP_OpCode_2;
-        Address RefNextInstruction2;
-        BYTE    NULL_VALUE;
-        BYTE    JZ_OpCode_1;
-        BYTE    JZ_OpCode_2;
-        BYTE    ADD_PTR32_IMM32_0[2];
-        Address RefNextInstruction3;
-        DWORD   ModuleBase;
-        BYTE    ADD_ESP_1_OpCode;
-        BYTE    ADD_ESP_2_OpCode;
-        BYTE    ADD_ESP_3_OpCode;
-        BYTE    POP_FD_OpCode;
-        BYTE    POP_AD_OpCode;
-        BYTE    JMP_ReturnEip_OpCode_1;
-        BYTE    JMP_ReturnEip_OpCode_2;
-        Address RefNextInstruction4;
-
-        HookCallCode()
+        BYTE    Claim[10];
+        BYTE    LOCK_XADD_Head_OpCode[4];
+        Address Head;
+        BYTE    LEA_Sequence_OpCode[3];
+        BYTE    AND_Mask_OpCode[2];
+        DWORD   Mask;
+        BYTE    SHL_Index_OpCode[3];
+        BYTE    ADD_Records_OpCode[2];
+        Address Records;
+        BYTE    MOV_Sequence_OpCode[6];
+        BYTE    MOV_Hook_OpCode[3];
+        DWORD   HookId;
+        BYTE    Store[25];
+
+        TraceThunkCode()
         {
-            memcpy(this, HookCallCodeData, HookCallCodeDataSize);
+            memcpy(this, TraceThunkCodeData, TraceThunkCodeDataSize);
         }
-        HookCallCode(
-            Address refNextInstruction,
+        TraceThunkCode(
             Address base,
-            HookFunction hookFunction,
-            Address moduleBase)
+            Address function,
+            HookTracer const& tracer,
+            DWORD hookId)
         {
-            memcpy(this, HookCallCodeData, HookCallCodeDataSize);
+            memcpy(this, TraceThunkCodeData, TraceThunkCodeDataSize);
 
-            ModuleBase          = reinterpret_cast<DWORD>(moduleBase);
-
-            RefNextInstruction1 = refNextInstruction;
-            RefNextInstruction2 = refNextInstruction;
-            RefNextInstruction3 = refNextInstruction;
-            RefNextInstruction4 = refNextInstruction;
+            Head    = tracer.RemoteHead();
+            Mask    = tracer.Capacity() - 1;
+            Records = tracer.RemoteRecords();
+            HookId  = hookId;
 
             FunctionProcRelativeAddress = relative_offset(
-                reinterpret_cast<BYTE*>(base) + HookCallCodeCallOffset + CallR32InstructionLength,
-                static_cast<Address>(hookFunction));
+                reinterpret_cast<BYTE*>(base) + TraceThunkCodeCallOffset + CallR32InstructionLength,
+                function);
         }
     };
-    static constexpr size_t HookCallCodeSize = sizeof(HookCallCode);
+    static constexpr size_t TraceThunkCodeSize = sizeof(TraceThunkCode);
     #pragma pack(pop)
 
-    static_assert(HookCallCodeSize == HookCallCodeDataSize, "The code and data are not equals");
-
-    struct HookPocket
-    {
-        size_t               Offset = 0;
-        list<Hook*>          Hooks;
-        size_t               OverriddenCount = 0;
-
-        JumpCode             HookCallerBlockCode;
-        RegistersBuildCode   RegistersBuild;
-        vector<HookCallCode> HookCallBlocks;
-        RegistersCleanupCode RegistersCleanup;
-        vector<BYTE>         OriginalBytes;
-        JumpCode             JumpBackCode;
-    };
-
-
-    struct Facade
-    {
-        Hook* Redefine;
-
-        JumpCode             FacadeCallerBlockCode;
-    };
+    static_assert(TraceThunkCodeSize == TraceThunkCodeDataSize, "The code and data are not equals");
 
+    /*!
+    * @brief Selects hooks which apply to process (module loaded, checksum matches), places them into HookProgram,
+    * @brief adds profile & trace thunks if requested and writes program into process.
+    */
     class HookInjector final
     {
     public:
         ProcessMemory&           Memory;
         list<Module>&            Modules;
 
-        VirtualMemoryHandle*     NextInstructionsVmh;
-        VirtualMemoryHandle*     ProgramVmh;
+        HookProgram              Program;
 
-        map<Address, HookPocket> Pockets;
-        map<Address, Facade> Facades;
+        // Set if hooks are profiled: regular hooks are called through profile thunks
+        HookProfiler*            Profiler;
+        vector<ProfileThunkCode> ProfileThunks;
+        // Set if hooks are traced: regular hooks are called through trace thunks (they call profile thunks, if any)
+        HookTracer*              Tracer;
+        vector<TraceThunkCode>   TraceThunks;
 
-        HookInjector(Debugger::DebugLoop& dbg, list<Module>& modules);
-        ~HookInjector();
+        HookInjector(Debugger::DebugLoop& dbg, list<Module>& modules, HookProfiler* profiler = nullptr, HookTracer* tracer = nullptr);
+        // Without debugger: DLLs of process are enumerated by caller (look for DirectInjector)
+        HookInjector(ProcessMemory& memory, string_view const& executablePath, DllRegistry& dlls, list<Module>& modules, HookProfiler* profiler = nullptr, HookTracer* tracer = nullptr);
     };
 }
 #endif //INJECTOR_HOOK_INJECTOR_HPP
@@ -0,0 +1,126 @@
+#include <algorithm>
+#include <fstream>
+
+#include "hook_profiler.hpp"
+
+namespace Injector
+{
+    HookProfiler::HookProfiler(Debugger::DebugLoop& debugger, size_t top) : _debugger(debugger), _top(top)
+    {
+        _debugger.OnDebugString += [this](Debugger::DebugLoop& sender, Thread& thread, string const& message)
+        {
+            if (message.rfind(HookProfileDumpRequest, 0) == 0)
+                Dump();
+        };
+        _debugger.OnProcessExited += [this](Debugger::DebugLoop& sender)
+        {
+            _section.Orphan();
+            Dump();
+        };
+    }
+
+    void HookProfiler::Map(vector<ProfiledHook> hooks)
+    {
+        _hooks = std::move(hooks);
+
+        string const name = "InjProfile-" + std::to_string(_debugger.ProcessInfo.dwProcessId);
+        size_t const size = sizeof(HookProfileHeader) + sizeof(HookProfileEntry) * _hooks.size();
+        _section = SharedSection { _debugger.Process(), name, size };
+
+        auto* header = reinterpret_cast<HookProfileHeader*>(_section.Local());
+        header->Signature   = HookProfileHeader::Magic;
+        header->Revision    = HookProfileHeader::Version;
+        header->HookCount   = static_cast<DWORD>(_hooks.size());
+        header->BucketCount = static_cast<DWORD>(HookProfileBuckets);
+
+        spdlog::info("Hook profile table \"{0}\": {1} hooks, {2} bytes at [0x{3:x}].", name, _hooks.size(), size, (uint32_t) _section.Remote());
+    }
+
+    HookProfileEntry const* HookProfiler::entry(size_t index) const
+    {
+        return reinterpret_cast<HookProfileEntry const*>(_section.Local(sizeof(HookProfileHeader))) + index;
+    }
+    HookProfileEntry* HookProfiler::Remote(size_t index) const
+    {
+        return reinterpret_cast<HookProfileEntry*>(_section.Remote(sizeof(HookProfileHeader))) + index;
+    }
+
+    uint64_t HookProfiler::Percentile(DWORD const (&histogram)[HookProfileBuckets], double fraction)
+    {
+        // histogram is not updated together with calls counter - its own total is used
+        uint64_t total = 0;
+        for (DWORD count : histogram)
+            total += count;
+        if (!total)
+            return 0;
+
+        auto const rank = static_cast<uint64_t>(static_cast<double>(total) * fraction + 0.5);
+        uint64_t   seen = 0;
+        for (size_t bucket = 0; bucket < HookProfileBuckets; bucket++)
+        {
+            seen += histogram[bucket];
+            if (seen >= rank)
+                return bucket + 1 < 64 ? uint64_t(1) << (bucket + 1) : UINT64_MAX;
+        }
+        return UINT64_MAX;
+    }
+
+    vector<HookProfiler::Statistics> HookProfiler::Collect() const
+    {
+        vector<Statistics> statistics;
+        if (!IsMapped())
+            return statistics;
+
+        for (size_t index = 0; index < _hooks.size(); index++)
+        {
+            HookProfileEntry const& e = *entry(index);
+            if (!e.Calls)
+                continue;
+            statistics.push_back({ &_hooks[index], e.Calls, e.Cycles, Percentile(e.Histogram, 0.99) });
+        }
+        return statistics;
+    }
+
+    void HookProfiler::Dump()
+    {
+        auto statistics = Collect();
+        _dumps++;
+        spdlog::info("Hook profile #{0}: {1} of {2} profiled hooks were called.", _dumps, statistics.size(), _hooks.size());
+        if (statistics.empty())
+            return;
+
+        auto const top = [this, &statistics](const char* title, auto less)
+        {
+            std::sort(statistics.begin(), statistics.end(), [&less](Statistics const& a, Statistics const& b) { return less(b, a); });
+            spdlog::info("::Top {0} by {1}:", std::min(_top, statistics.size()), title);
+            for (size_t i = 0; i < statistics.size() && i < _top; i++)
+            {
+                Statistics const& s = statistics[i];
+                spdlog::info("::::[0x{0:x}] \"{1}\": {2} calls, {3} cycles, {4} cycles/call, p99 <= {5} cycles",
+                    (uint32_t) s.Hook->Placement, s.Hook->Source->FunctionName, s.Calls, s.Cycles, s.Cycles / s.Calls, s.P99);
+            }
+        };
+        top("p99 latency",  [](Statistics const& a, Statistics const& b) { return a.P99 < b.P99; });
+        top("calls",        [](Statistics const& a, Statistics const& b) { return a.Calls < b.Calls; });
+        top("total cycles", [](Statistics const& a, Statistics const& b) { return a.Cycles < b.Cycles; });
+
+        write(statistics);
+    }
+
+    void HookProfiler::write(vector<Statistics> const& statistics) const
+    {
+        std::ofstream file(HookProfileFileName, std::ios::trunc);
+        if (!file)
+        {
+            spdlog::warn("Unable to write hook profile \"{0}\".", HookProfileFileName);
+            return;
+        }
+
+        // sorted by total cycles (last criterion of Dump)
+        file << "placement\tfunction\tcalls\tcycles\tcycles_per_call\tp99_cycles_le\n";
+        for (Statistics const& s : statistics)
+            file << fmt::format("0x{0:08x}\t{1}\t{2}\t{3}\t{4}\t{5}\n",
+                (uint32_t) s.Hook->Placement, s.Hook->Source->FunctionName, s.Calls, s.Cycles, s.Cycles / s.Calls, s.P99);
+        spdlog::info("Hook profile written into \"{0}\".", HookProfileFileName);
+    }
+}
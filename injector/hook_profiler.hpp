@@ -0,0 +1,91 @@
+#ifndef INJECTOR_HOOK_PROFILER_HPP
+#define INJECTOR_HOOK_PROFILER_HPP
+
+#include <cstdint>
+
+#include <debugger.hpp>
+#include <shared_section.hpp>
+
+#include "framework.hpp"
+#include "hook.hpp"
+
+namespace Injector
+{
+    static constexpr const char* HookProfileFileName    = "syringe.profile.txt";
+    // OutputDebugStringA(HookProfileDumpRequest) in process makes injector dump profile immediately
+    static constexpr const char* HookProfileDumpRequest = "syringe:profile";
+    // Bucket N counts calls which took [2^N, 2^(N+1)) cycles, bucket 0 also counts calls of 0 cycles
+    static constexpr size_t      HookProfileBuckets     = 64;
+
+    struct alignas(64) HookProfileHeader
+    {
+        static constexpr DWORD Magic   = 0x50485953; // 'SYHP'
+        static constexpr DWORD Version = 1;
+
+        DWORD Signature;
+        DWORD Revision;
+        DWORD HookCount;
+        DWORD BucketCount;
+    };
+
+    // Written by profile thunk of a hook. Entries are cache line aligned, so hooks running on different threads don't share lines.
+    struct alignas(64) HookProfileEntry
+    {
+        uint64_t Calls;
+        uint64_t Cycles;
+        DWORD    Histogram[HookProfileBuckets];
+    };
+
+    /*!
+    * @brief Per-hook call counters & latency histograms.
+    * @brief Table is placed in shared section 'InjProfile-$PID': HookProfileHeader followed by HookProfileEntry for each profiled hook.
+    * @brief Process updates it by profile thunks (see ProfileThunkCode), injector reads it through own view without suspending process.
+    * @brief Report (top hooks by calls, total cycles and p99 latency) is written when process exits or when process requests it (HookProfileDumpRequest).
+    * @brief Values read while process runs may be a few calls behind - counters are not updated as one transaction.
+    */
+    class HookProfiler final
+    {
+    public:
+        struct ProfiledHook
+        {
+            Hook const* Source;
+            Address     Placement;
+        };
+        struct Statistics
+        {
+            ProfiledHook const* Hook;
+            uint64_t            Calls;
+            uint64_t            Cycles;
+            // upper bound of bucket which contains 99th percentile
+            uint64_t            P99;
+        };
+    private:
+        Debugger::DebugLoop&  _debugger;
+        size_t const          _top;
+        SharedSection         _section;
+        vector<ProfiledHook>  _hooks;
+        size_t                _dumps = 0;
+
+        HookProfileEntry const* entry(size_t index) const;
+        void write(vector<Statistics> const& statistics) const;
+    public:
+        HookProfiler(Debugger::DebugLoop& debugger, size_t top);
+
+        HookProfiler(HookProfiler const&) = delete;
+        HookProfiler& operator=(HookProfiler const&) = delete;
+
+        // Creates the table for hooks and maps it into process, hook index is its position in `hooks`
+        void Map(vector<ProfiledHook> hooks);
+        bool IsMapped() const noexcept { return !_section.Empty(); }
+        size_t Count() const noexcept { return _hooks.size(); }
+
+        // Entry of hook in process address space
+        HookProfileEntry* Remote(size_t index) const;
+
+        vector<Statistics> Collect() const;
+        void Dump();
+
+        static uint64_t Percentile(DWORD const (&histogram)[HookProfileBuckets], double fraction);
+    };
+}
+#endif //INJECTOR_HOOK_PROFILER_HPP
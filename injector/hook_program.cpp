@@ -0,0 +1,494 @@
+#include "hook_program.hpp"
+
+namespace Injector
+{
+    LeanHookCallCode::LeanHookCallCode(DWORD registers)
+    {
+        BYTE const arg1          = registers & 0xFF;
+        BYTE const arg2          = (registers >> 8) & 0xFF;
+        BYTE const result        = (registers >> 16) & 0xFF;
+        bool const preserveFlags = (registers >> 24) & 0x01;
+
+        // [esp + 0] = EDX, [esp + 4] = ECX, [esp + 8] = EAX, [esp + 12] = EFLAGS (if preserved)
+        BYTE const savedSize = preserveFlags ? 16 : 12;
+        auto const slot      = [](BYTE reg) -> BYTE { return reg == EAX ? 8 : reg == ECX ? 4 : 0; };
+        auto const append    = [this](std::initializer_list<int> bytes) { for (int b : bytes) Code.push_back(static_cast<BYTE>(b)); };
+        auto const load      = [&](BYTE dst, BYTE lhr)
+        {
+            if (lhr == LHR_None)
+                return append({ XOR_R32_R32(dst, dst) });
+
+            BYTE const src = lhr - 1;
+            if (src <= EDX)
+                append({ MOV_R32_ESP_DISP8(dst, slot(src)) });
+            else if (src == ESP)
+                append({ LEA_R32_ESP_DISP8(dst, savedSize) });
+            else
+                append({ MOV_R32_R32(dst, src) });
+        };
+
+        if (preserveFlags)
+            append({ PUSHFD });
+        append({ PUSH_EAX, PUSH_ECX, PUSH_EDX });
+
+        load(ECX, arg1);
+        load(EDX, arg2);
+
+        _callOffset = Code.size();
+        append({ CALL_R32(INIT_PTR) });
+
+        if (result != LHR_None)
+        {
+            BYTE const dst = result - 1;
+            if (dst <= EDX)
+                append({ MOV_ESP_DISP8_R32(slot(dst), EAX) }); // restored by pop below
+            else
+                append({ MOV_R32_R32(dst, EAX) });
+        }
+
+        append({ POP_EDX, POP_ECX, POP_EAX });
+        if (preserveFlags)
+            append({ POPFD });
+    }
+    void LeanHookCallCode::Link(Address base, Address function)
+    {
+        int32_t const offset = relative_offset(reinterpret_cast<BYTE*>(base) + _callOffset + CallR32InstructionLength, function);
+        memcpy(Code.data() + _callOffset + 1, &offset, sizeof(offset));
+    }
+    bool LeanHookCallCode::IsValid(DWORD registers)
+    {
+        BYTE const arg1   = registers & 0xFF;
+        BYTE const arg2   = (registers >> 8) & 0xFF;
+        BYTE const result = (registers >> 16) & 0xFF;
+        return arg1 <= LHR_EDI && arg2 <= LHR_EDI && result <= LHR_EDI && result != LHR_ESP;
+    }
+
+    HookProgram::~HookProgram()
+    {
+        if (NextInstructionsVmh)
+            Memory.Free(*NextInstructionsVmh);
+        if (ProgramVmh)
+            Memory.Free(*ProgramVmh);
+    }
+
+    bool HookProgram::Add(Hook& hook, Address placement)
+    {
+        auto const hookModuleName = hook.ModuleName.empty() ? "executable" : "\"" + hook.ModuleName + "\"";
+        string logAddition, logAddition2;
+
+        switch (hook.Type)
+        {
+            case(HookType::Generic): {}
+            case(HookType::Extended):
+            {
+                spdlog::info("::[0x{2:x}:0x{3:x} = 0x{4:x}] - on \"{1}\" placed hook \"{0}\".",
+                    hook.FunctionName, hookModuleName,
+                    (uint32_t)hook.ModuleBase, (uint32_t)hook.Placement, (uint32_t)placement
+                );
+
+                auto pocketIterator = Pockets.find(placement);
+                if (pocketIterator == Pockets.end())
+                    pocketIterator = Pockets.emplace(placement, HookPocket()).first;
+
+                HookPocket& pocket = pocketIterator->second;
+                pocket.Hooks.push_back(&hook);
+                pocket.OverriddenCount =
+                    hook.Size > pocket.OverriddenCount ? hook.Size : pocket.OverriddenCount;
+            } break;
+            case(HookType::Lean):
+            {
+                auto const registers = std::get<LeanHookDecl>(hook.Decl).Registers;
+                if (!LeanHookCallCode::IsValid(registers))
+                {
+                    spdlog::warn("::Lean hook \"{0}\" declares invalid registers [0x{1:x}], skip.", hook.FunctionName, registers);
+                    return false;
+                }
+                spdlog::info("::[0x{2:x}:0x{3:x} = 0x{4:x}] - on \"{1}\" placed lean hook \"{0}\".",
+                    hook.FunctionName, hookModuleName,
+                    (uint32_t)hook.ModuleBase, (uint32_t)hook.Placement, (uint32_t)placement
+                );
+
+                auto pocketIterator = Pockets.find(placement);
+                if (pocketIterator == Pockets.end())
+                    pocketIterator = Pockets.emplace(placement, HookPocket()).first;
+
+                HookPocket& pocket = pocketIterator->second;
+                pocket.LeanHooks.push_back(&hook);
+                pocket.OverriddenCount =
+                    hook.Size > pocket.OverriddenCount ? hook.Size : pocket.OverriddenCount;
+            } break;
+            case(HookType::FacadeByName):
+            { logAddition = "::" + hook.PlacementFunction; }
+            case(HookType::FacadeAtAddress):
+            {
+                auto facadeIterator = Facades.find(placement);
+                if (facadeIterator != Facades.end())
+                {
+                    logAddition2 = " - FIRST REDEFINE WILL BE CHOISEN!";
+                    _sameRedefines.push_back({ HookConflictKind::SameRedefine, facadeIterator->second.Redefine, &hook });
+                }
+                else
+                {
+                    facadeIterator = Facades.emplace(placement, Facade()).first;
+                    facadeIterator->second.Redefine = &hook;
+                }
+
+                spdlog::info("::[0x{2:x}:0x{3:x} = 0x{4:x}] - for {1}{5} redefine \"{0}\"{6}.",
+                    hook.FunctionName, hookModuleName,
+                    (uint32_t)hook.ModuleBase, (uint32_t)hook.Placement, (uint32_t)placement,
+                    logAddition, logAddition2
+                );
+            } break;
+            default:
+            {
+                spdlog::warn("::WTF UKNOWN HOOK!? MUST NEVER HAPPEN.");
+                return false;
+            }
+        }
+        return true;
+    }
+
+    size_t HookProgram::Plan()
+    {
+        PocketsSize = 0;
+
+        spdlog::info("Iterate hook pockets and calculate total program size...");
+        vector<PatchBatch::ReadRequest> originalBytesRequests;
+        for (auto& pair : Pockets)
+        {
+            HookPocket& pocket = pair.second;
+            // whole instructions may end behind declared size
+            size_t const declared = pocket.OverriddenCount > JumpR32lInstructionLength ? pocket.OverriddenCount : JumpR32lInstructionLength;
+            pocket.OriginalBytes.resize(declared + MaxInstructionLength - 1);
+            originalBytesRequests.push_back({ static_cast<BYTE*>(pair.first), pocket.OriginalBytes.data(), pocket.OriginalBytes.size() });
+        }
+        PatchBatch::ReadGrouped(Memory, originalBytesRequests);
+
+        for (auto& pair : Pockets)
+        {
+            HookPocket& pocket = pair.second;
+
+            size_t const overridenCount = pocket.OverriddenCount;
+            if (overridenCount < 5)
+                pocket.OverriddenCount = 5;
+
+            // only whole instructions which cover the jump are overridden, declared size is used if they can't be decoded
+            pocket.Relocatable = pocket.Relocation.plan(pocket.OriginalBytes, JumpR32lInstructionLength);
+            if (pocket.Relocatable)
+            {
+                if (pocket.Relocation.OverwriteSize != pocket.OverriddenCount)
+                    spdlog::trace("::[0x{0:x}] overwrite size {1:d} instead of declared {2:d}", (uint32_t)pair.first, pocket.Relocation.OverwriteSize, overridenCount);
+                pocket.OverriddenCount = pocket.Relocation.OverwriteSize;
+            }
+            else
+                spdlog::warn("::[0x{0:x}] overridden instructions can't be decoded, {1:d} bytes are copied without relocation", (uint32_t)pair.first, pocket.OverriddenCount);
+
+            if (overridenCount < 5)
+                spdlog::trace("::[0x{0:x}] {1:d} functions ({4:d} lean), {2:d} overriden bytes (fixed from {3:d})", (uint32_t)pair.first, pair.second.Hooks.size(), pair.second.OverriddenCount, overridenCount, pair.second.LeanHooks.size());
+            else
+                spdlog::trace("::[0x{0:x}] {1:d} functions ({3:d} lean), {2:d} overriden bytes", (uint32_t)pair.first, pair.second.Hooks.size(), pair.second.OverriddenCount, pair.second.LeanHooks.size());
+        }
+
+        merge_overlapping();
+
+        for (auto& pair : Pockets)
+        {
+            HookPocket& pocket = pair.second;
+            pocket.OriginalBytes.resize(pocket.OverriddenCount);
+
+            PocketsSize += plan_calls(pocket);
+            for (HookSegment& segment : pocket.Segments)
+                PocketsSize += plan_calls(segment);
+            PocketsSize += pocket.Relocatable ? pocket.Relocation.Size : pocket.OverriddenCount;
+            PocketsSize += JumpCodeSize;
+        }
+        return PocketsSize;
+    }
+
+    template<typename TCalls>
+    size_t HookProgram::plan_calls(TCalls& calls)
+    {
+        size_t size = 0;
+        calls.LeanCallBlocks.clear();
+        for (Hook* hook : calls.LeanHooks)
+            size += calls.LeanCallBlocks.emplace_back(std::get<LeanHookDecl>(hook->Decl).Registers).Code.size();
+        if (!calls.Hooks.empty())
+        {
+            size += RegistersBuildCodeSize;
+            size += HookCallCodeSize * calls.Hooks.size();
+            size += RegistersCleanupCodeSize;
+        }
+        return size;
+    }
+
+    bool HookProgram::merge(HookPocket& host, HookPocket& pocket, size_t offset)
+    {
+        if (!host.Relocatable || !pocket.Relocatable)
+            return false;
+
+        // both were read from process, bytes of pocket continue bytes of host
+        vector<BYTE> code = host.OriginalBytes;
+        if (offset + pocket.OriginalBytes.size() > code.size())
+            code.insert(code.end(), pocket.OriginalBytes.cbegin() + (code.size() - offset), pocket.OriginalBytes.cend());
+
+        RelocatedCode relocation;
+        size_t const minSize = (std::max)(host.Relocation.OverwriteSize, offset + pocket.Relocation.OverwriteSize);
+        if (!relocation.plan(code, minSize) || relocation.item_at(offset) == relocation.Items.size() || relocation.has_internal_branches(code))
+            return false;
+
+        host.Relocation      = std::move(relocation);
+        host.OriginalBytes   = std::move(code);
+        host.OverriddenCount = host.Relocation.OverwriteSize;
+
+        HookSegment& segment = host.Segments.emplace_back();
+        segment.Offset    = offset;
+        segment.Hooks     = std::move(pocket.Hooks);
+        segment.LeanHooks = std::move(pocket.LeanHooks);
+        for (HookSegment& inner : pocket.Segments)
+        {
+            inner.Offset += offset;
+            host.Segments.push_back(std::move(inner));
+        }
+        return true;
+    }
+
+    void HookProgram::merge_overlapping()
+    {
+        MergedPockets = SkippedPockets = 0;
+        _skippedPockets.clear();
+
+        // pockets are ordered by placement, so only previous pocket (with its merged ones) can be overlapped
+        auto host = Pockets.end();
+        for (auto it = Pockets.begin(); it != Pockets.end();)
+        {
+            if (host != Pockets.end())
+            {
+                size_t const offset = static_cast<BYTE*>(it->first) - static_cast<BYTE*>(host->first);
+                if (offset < host->second.OverriddenCount)
+                {
+                    if (merge(host->second, it->second, offset))
+                    {
+                        spdlog::info("::[0x{0:x}] is inside of overridden instructions of [0x{1:x}], merged into it ({2:d} bytes overridden).",
+                            (uint32_t) it->first, (uint32_t) host->first, host->second.OverriddenCount);
+                        MergedPockets++;
+                    }
+                    else
+                    {
+                        spdlog::error("::[0x{0:x}] is inside of overridden instructions of [0x{1:x}] and can't be merged into it, {2:d} hooks SKIP",
+                            (uint32_t) it->first, (uint32_t) host->first, it->second.Hooks.size() + it->second.LeanHooks.size());
+                        SkippedPockets++;
+                        _skippedPockets.push_back({ HookConflictKind::PartialOverlap, host->second.FirstHook(), it->second.FirstHook() });
+                    }
+                    it = Pockets.erase(it);
+                    continue;
+                }
+            }
+            host = it++;
+        }
+    }
+
+    vector<HookConflict> HookProgram::Conflicts() const
+    {
+        vector<HookConflict> conflicts = _sameRedefines;
+        conflicts.insert(conflicts.end(), _skippedPockets.cbegin(), _skippedPockets.cend());
+
+        // placements are absolute, so all ranges are of one module
+        vector<HookIntervalIndex::Interval> intervals;
+        intervals.reserve(Pockets.size() + Facades.size());
+        for (auto& pair : Pockets)
+        {
+            DWORD const begin = reinterpret_cast<DWORD>(pair.first);
+            intervals.push_back({ {}, begin, static_cast<DWORD>(begin + pair.second.OverriddenCount), pair.second.FirstHook() });
+        }
+        for (auto& pair : Facades)
+        {
+            DWORD const begin = reinterpret_cast<DWORD>(pair.first);
+            intervals.push_back({ {}, begin, static_cast<DWORD>(begin + JumpR32lInstructionLength), pair.second.Redefine });
+        }
+
+        // pockets don't overlap after Plan, only redefines are left to check
+        auto const planned = HookIntervalIndex(std::move(intervals)).conflicts();
+        conflicts.insert(conflicts.end(), planned.cbegin(), planned.cend());
+        return conflicts;
+    }
+
+    void HookProgram::Allocate(size_t prefixSize)
+    {
+        PrefixSize = prefixSize;
+        NextInstructionsVmh = &Memory.Allocate(sizeof(Address) * Pockets.size());
+        ProgramVmh = &Memory.Allocate(Size(), MemoryPool::Code);
+        Code.assign(Size(), 0);
+
+        spdlog::info("Hook program block: ");
+        spdlog::info("::Address = 0x{0:x}", (uint32_t) ProgramVmh->Pointer(0));
+        spdlog::info("::Size = {0} (bytes)", ProgramVmh->Size());
+        spdlog::info("Next instruction memory block: ");
+        spdlog::info("::Address = 0x{0:x}", (uint32_t)NextInstructionsVmh->Pointer(0));
+        spdlog::info("::Size = {0} (bytes)", NextInstructionsVmh->Size());
+    }
+
+    void HookProgram::Emit(void const* data, size_t size, size_t offset)
+    {
+        if (offset + size > Code.size())
+            throw VirtualMemoryHandle::OutOfRangeException { *ProgramVmh, ProgramVmh->Pointer(offset), size };
+        memcpy(Code.data() + offset, data, size);
+    }
+
+    template<typename TCalls>
+    void HookProgram::assemble_calls(TCalls& calls, Address placement, size_t& offset, DWORD refNextInstruction, size_t& regularHook, Callee const& callee)
+    {
+        auto leanHook = calls.LeanHooks.cbegin();
+        for (LeanHookCallCode& lean : calls.LeanCallBlocks)
+        {
+            lean.Link(ProgramVmh->Pointer(offset), reinterpret_cast<Address>((*leanHook++)->Function));
+            Emit(lean.Code.data(), lean.Code.size(), offset);
+            offset += lean.Code.size();
+        }
+
+        if (calls.Hooks.empty())
+            return;
+
+        calls.HookCallBlocks.clear();
+        calls.RegistersBuild.HookAddress = placement;
+        // base of call block is taken as if registers frame is built before each one (see HookCallCodeCallOffset)
+        size_t callOffset = offset;
+        for (Hook* hook : calls.Hooks)
+        {
+            HookFunction const function = callee ? callee(*hook, regularHook) : hook->Function;
+            regularHook++;
+            calls.HookCallBlocks.emplace_back(
+                reinterpret_cast<Address>(refNextInstruction),
+                ProgramVmh->Pointer(callOffset),
+                function,
+                hook->ModuleBase);
+            callOffset += HookCallCodeSize;
+        }
+
+        size_t const hookCallersSize = calls.HookCallBlocks.size() * HookCallCodeSize;
+
+        Emit(&calls.RegistersBuild, RegistersBuildCodeSize, offset);
+        offset += RegistersBuildCodeSize;
+
+        Emit(calls.HookCallBlocks.data(), hookCallersSize, offset);
+        offset += hookCallersSize;
+
+        Emit(&calls.RegistersCleanup, RegistersCleanupCodeSize, offset);
+        offset += RegistersCleanupCodeSize;
+    }
+
+    void HookProgram::Assemble(Callee const& callee)
+    {
+        DWORD refNextInstruction = reinterpret_cast<DWORD>(NextInstructionsVmh->Pointer(0));
+        size_t offset = PrefixSize;
+        size_t regularHook = 0;
+
+        spdlog::info("Hook program block assembling...");
+        for (auto& pair : Pockets)
+        {
+            Address const hookAddr = pair.first;
+            HookPocket& pocket = pair.second;
+            pocket.Offset = offset;
+
+            Address const jumpBase   = reinterpret_cast<BYTE*>(hookAddr) + JumpR32lInstructionLength;
+            Address const jumpOffset = ProgramVmh->Pointer(offset);
+
+            pocket.HookCallerBlockCode.Offset = relative_offset(jumpBase, jumpOffset);
+            _sitePatches.Add(hookAddr, &pocket.HookCallerBlockCode, JumpCodeSize);
+
+            assemble_calls(pocket, hookAddr, offset, refNextInstruction, regularHook, callee);
+
+            if (pocket.Relocatable)
+            {
+                // overridden instructions are copied by parts, hooks of each merged pocket are called before its placement
+                auto const& items = pocket.Relocation.Items;
+                vector<BYTE> relocated;
+                size_t first = 0;
+                for (size_t part = 0; part <= pocket.Segments.size(); part++)
+                {
+                    size_t const last = part < pocket.Segments.size() ? pocket.Relocation.item_at(pocket.Segments[part].Offset) : items.size();
+                    Address const pFrom = ProgramVmh->Pointer(offset);
+                    vector<BYTE> bytes;
+                    try
+                    {
+                        bytes = pocket.Relocation.relocate(pocket.OriginalBytes, hookAddr, pFrom, first, last);
+                        if (pocket.Relocation.Branches && pocket.Segments.empty())
+                            spdlog::info("::[0x{0:x}] {1:d} relative operands relocated to 0x{2:x}, {3:d} -> {4:d} bytes",
+                                (uint32_t) hookAddr, pocket.Relocation.Branches, (uint32_t) pFrom,
+                                pocket.Relocation.OverwriteSize, pocket.Relocation.Size
+                            );
+                    }
+                    catch (const invalid_jump_offset_error& ex)
+                    {
+                        spdlog::error("::[0x{0:x}] relative operand can't be relocated to 0x{1:x} (offset {2:X}h), SKIP",
+                            (uint32_t) hookAddr, (uint32_t) pFrom, ex.Value
+                        );
+                        // bytes of part are copied as is
+                        auto const boundary = [&](size_t index, bool relocated)
+                        {
+                            if (index < items.size())
+                                return relocated ? items[index].NewOffset : items[index].Offset;
+                            return relocated ? pocket.Relocation.Size : pocket.Relocation.OverwriteSize;
+                        };
+                        bytes.assign(pocket.OriginalBytes.cbegin() + boundary(first, false), pocket.OriginalBytes.cbegin() + boundary(last, false));
+                        bytes.resize(boundary(last, true) - boundary(first, true), NOP);
+                    }
+                    Emit(bytes.data(), bytes.size(), offset);
+                    offset += bytes.size();
+                    relocated.insert(relocated.end(), bytes.cbegin(), bytes.cend());
+
+                    if (part < pocket.Segments.size())
+                    {
+                        HookSegment& segment = pocket.Segments[part];
+                        assemble_calls(segment, reinterpret_cast<BYTE*>(hookAddr) + segment.Offset, offset, refNextInstruction, regularHook, callee);
+                    }
+                    first = last;
+                }
+                pocket.OriginalBytes = std::move(relocated);
+            }
+            else
+            {
+                Emit(pocket.OriginalBytes.data(), pocket.OriginalBytes.size(), offset);
+                offset += pocket.OriginalBytes.size();
+            }
+
+            // Jump back
+            Address const jumpBackBase = ProgramVmh->Pointer(offset);
+            Address const jumpBackAddress = reinterpret_cast<BYTE*>(hookAddr) + (std::max)(JumpR32lInstructionLength, pocket.OverriddenCount);
+            pocket.JumpBackCode.Offset = relative_offset(jumpBackBase, jumpBackAddress, JumpR32lInstructionLength);
+
+            Emit(&pocket.JumpBackCode, JumpCodeSize, offset);
+            offset += JumpCodeSize;
+
+            refNextInstruction++;
+        }
+
+        spdlog::info("Redefines:");
+        for (auto& redefine : Facades)
+        {
+            auto hook = redefine.second.Redefine;
+            auto placement = redefine.first;
+            Address const jumpBase = reinterpret_cast<BYTE*>(placement) + JumpR32lInstructionLength;
+            Address const jumpTo = reinterpret_cast<Address>(hook->Function);
+
+            redefine.second.FacadeCallerBlockCode.Offset = relative_offset(jumpBase, jumpTo);
+            _sitePatches.Add(placement, &redefine.second.FacadeCallerBlockCode, JumpCodeSize);
+            spdlog::info("::0x{0:x} --> 0x{1:x} ({2})",
+                placement, jumpTo, hook->FunctionName
+            );
+        }
+        Code.resize(offset);
+    }
+
+    bool HookProgram::Write()
+    {
+        if (!Code.empty())
+            ProgramVmh->Write(Code.data(), Code.size(), 0);
+
+        SitePatches = _sitePatches.Size();
+        bool const result = _sitePatches.Apply();
+        SiteGroups = _sitePatches.Groups;
+        if (!result)
+            spdlog::error("Some of hook sites were not written.");
+        return result;
+    }
+}
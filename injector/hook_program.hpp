@@ -0,0 +1,317 @@
+#ifndef INJECTOR_HOOK_PROGRAM_HPP
+#define INJECTOR_HOOK_PROGRAM_HPP
+
+#include <functional>
+
+#include <process_memory.hpp>
+#include <patch_batch.hpp>
+
+#include "framework.hpp"
+#include "hook.hpp"
+#include "misc_code.hpp"
+#include "x86_decoder.hpp"
+
+namespace Injector
+{
+    static constexpr BYTE EAX = 0, ECX = 1, EDX = 2, EBX = 3, ESP = 4;
+
+    BYTE const RegistersBuildCodeData[] =
+    {
+        PUSHAD, PUSHFD,              // It creates REGISTERS structure
+        PUSH_INTO_STACK(INIT_DWORD), // Push address of hook
+        PUSH_ESP,                    // At the top of stack will be REGISTER, and it pushes this* for it
+    };
+    static constexpr size_t RegistersBuildCodeDataSize = sizeof(RegistersBuildCodeData);
+
+    #pragma pack(push, 1)
+    struct RegistersBuildCode
+    {
+        BYTE Pushad;
+        BYTE Pushfd;
+        BYTE PUSH_MEM_OpCode;
+        Address HookAddress;
+        BYTE PUSH_ESP_OpCode;
+
+        RegistersBuildCode()
+        {
+            memcpy(this, RegistersBuildCodeData, RegistersBuildCodeDataSize);
+        }
+        RegistersBuildCode(Address hookAddress)
+        {
+            memcpy(this, RegistersBuildCodeData, RegistersBuildCodeDataSize);
+
+            HookAddress = hookAddress;
+        }
+    };
+    static constexpr size_t RegistersBuildCodeSize = sizeof(RegistersBuildCode);
+    #pragma pack(pop)
+    static_assert(RegistersBuildCodeSize == RegistersBuildCodeDataSize, "The code and data are not equals");
+
+    BYTE const RegistersCleanupCodeData[] =
+    {
+        ADD_ESP(0x08), // Remove REGISTERS* from stack
+        POPFD, POPAD   // Clear registers content from stack
+    };
+    static constexpr size_t RegistersCleanupCodeDataSize = sizeof(RegistersCleanupCodeData);
+
+    #pragma pack(push, 1)
+    struct RegistersCleanupCode
+    {
+        BYTE AddEsp[2];
+        BYTE AddEsp_Value;
+        BYTE Popfd;
+        BYTE PopAd;
+
+        RegistersCleanupCode()
+        {
+            memcpy(this, RegistersCleanupCodeData, RegistersCleanupCodeDataSize);
+        }
+    };
+    static constexpr size_t RegistersCleanupCodeSize = sizeof(RegistersCleanupCode);
+    #pragma pack(pop)
+    static_assert(RegistersCleanupCodeSize == RegistersCleanupCodeDataSize, "The code and data are not equals");
+
+    BYTE const HookCallCodeData[] =
+    {
+        CALL_R32(INIT_PTR),                    // Invoke Hook function
+        MOV_EAX_TO(INIT_PTR),                  // Save result of hook function, ds:ReturnEIP
+        CMP_PTR32_IMM32(INIT_PTR, 0x00),       // Test result for zero (it is address)  | CMP ds:ReturnEIP, 0
+        JZ_R8(0x15),                           // Jump the next instruction outse hook caller (there must be placed overriden bytes with jumb back or another hook caller block
+        ADD_PTR32_IMM32(INIT_PTR, INIT_DWORD), // Make correction of base for hook module. For executable itself it must be 0. | add dword ptr[ds:ReturnEIP], MODULE BASE (Handle)
+        ADD_ESP(0x08),                         // Remove REGISTERS* from stack
+        POPFD, POPAD,                          // Clear registers content from stack
+        JMP_PTR32(INIT_PTR),                   // Jump to returned address | JMP ds:ReturnEIP
+    };
+    static constexpr size_t HookCallCodeDataSize = sizeof(HookCallCodeData);
+    static constexpr size_t HookCallCodeCallOffset = 8;
+
+    #pragma pack(push, 1)
+    struct HookCallCode
+    {
+        BYTE    CALL_OpCode;
+        DWORD   FunctionProcRelativeAddress;
+        BYTE    MOV_EAX_OpCode;
+        Address RefNextInstruction1;
+        BYTE    CMP_ReturnEIP_OpCode_1;
+        BYTE    CMP_ReturnEIP_OpCode_2;
+        Address RefNextInstruction2;
+        BYTE    NULL_VALUE;
+        BYTE    JZ_OpCode_1;
+        BYTE    JZ_OpCode_2;
+        BYTE    ADD_PTR32_IMM32_0[2];
+        Address RefNextInstruction3;
+        DWORD   ModuleBase;
+        BYTE    ADD_ESP_1_OpCode;
+        BYTE    ADD_ESP_2_OpCode;
+        BYTE    ADD_ESP_3_OpCode;
+        BYTE    POP_FD_OpCode;
+        BYTE    POP_AD_OpCode;
+        BYTE    JMP_ReturnEip_OpCode_1;
+        BYTE    JMP_ReturnEip_OpCode_2;
+        Address RefNextInstruction4;
+
+        HookCallCode()
+        {
+            memcpy(this, HookCallCodeData, HookCallCodeDataSize);
+        }
+        HookCallCode(
+            Address refNextInstruction,
+            Address base,
+            HookFunction hookFunction,
+            Address moduleBase)
+        {
+            memcpy(this, HookCallCodeData, HookCallCodeDataSize);
+
+            ModuleBase          = reinterpret_cast<DWORD>(moduleBase);
+
+            RefNextInstruction1 = refNextInstruction;
+            RefNextInstruction2 = refNextInstruction;
+            RefNextInstruction3 = refNextInstruction;
+            RefNextInstruction4 = refNextInstruction;
+
+            FunctionProcRelativeAddress = relative_offset(
+                reinterpret_cast<BYTE*>(base) + HookCallCodeCallOffset + CallR32InstructionLength,
+                reinterpret_cast<Address>(hookFunction));
+        }
+    };
+    static constexpr size_t HookCallCodeSize = sizeof(HookCallCode);
+    #pragma pack(pop)
+
+    static_assert(HookCallCodeSize == HookCallCodeDataSize, "The code and data are not equals");
+
+    /*!
+    * @brief Call of lean hook (LeanHookDecl) without REGISTERS frame.
+    * @brief Saves only registers which hook function may clobber (EAX, ECX, EDX and flags, if requested),
+    * @brief loads declared registers into ECX & EDX (fastcall arguments) and stores returned value into declared register.
+    */
+    struct LeanHookCallCode
+    {
+        vector<BYTE> Code;
+
+        LeanHookCallCode(DWORD registers);
+
+        // Sets relative offset of call to hook function, `base` is address of code in process
+        void Link(Address base, Address function);
+
+        // Registers are known and result is not written into ESP
+        static bool IsValid(DWORD registers);
+    private:
+        size_t _callOffset = 0;
+    };
+
+    /*!
+    * @brief Hooks of pocket which placement is inside of overridden instructions of another pocket (see HookProgram::Plan).
+    * @brief They are called when copy of overridden instructions reaches their placement.
+    */
+    struct HookSegment
+    {
+        // from placement of pocket
+        size_t               Offset = 0;
+        list<Hook*>          Hooks;
+        list<Hook*>          LeanHooks;
+        vector<LeanHookCallCode> LeanCallBlocks;
+
+        RegistersBuildCode   RegistersBuild;
+        vector<HookCallCode> HookCallBlocks;
+        RegistersCleanupCode RegistersCleanup;
+    };
+
+    struct HookPocket
+    {
+        size_t               Offset = 0;
+        list<Hook*>          Hooks;
+        // lean hooks are called before the others, each one by own short block
+        list<Hook*>          LeanHooks;
+        vector<LeanHookCallCode> LeanCallBlocks;
+        size_t               OverriddenCount = 0;
+
+        JumpCode             HookCallerBlockCode;
+        RegistersBuildCode   RegistersBuild;
+        vector<HookCallCode> HookCallBlocks;
+        RegistersCleanupCode RegistersCleanup;
+        vector<BYTE>         OriginalBytes;
+        RelocatedCode        Relocation;
+        bool                 Relocatable = false;
+        JumpCode             JumpBackCode;
+        // merged pockets, ordered by offset
+        vector<HookSegment>  Segments;
+
+        // Hook called first by pocket (lean hooks are called before the others), pocket has at least one
+        Hook* FirstHook() const { return LeanHooks.empty() ? Hooks.front() : LeanHooks.front(); }
+
+        // Calls `action(hook, placement)` for regular hooks in order they are called by program
+        template<typename TAction>
+        void ForEachRegularHook(Address placement, TAction&& action) const
+        {
+            for (Hook* hook : Hooks)
+                action(hook, placement);
+            for (HookSegment const& segment : Segments)
+                for (Hook* hook : segment.Hooks)
+                    action(hook, static_cast<BYTE*>(placement) + segment.Offset);
+        }
+        // Calls `action(hook, placement)` for lean & regular hooks of pocket and its segments, in order of placement
+        template<typename TAction>
+        void ForEachHook(Address placement, TAction&& action) const
+        {
+            for (Hook* hook : LeanHooks)
+                action(hook, placement);
+            for (Hook* hook : Hooks)
+                action(hook, placement);
+            for (HookSegment const& segment : Segments)
+            {
+                Address const segmentPlacement = static_cast<BYTE*>(placement) + segment.Offset;
+                for (Hook* hook : segment.LeanHooks)
+                    action(hook, segmentPlacement);
+                for (Hook* hook : segment.Hooks)
+                    action(hook, segmentPlacement);
+            }
+        }
+    };
+
+
+    struct Facade
+    {
+        Hook* Redefine;
+
+        JumpCode             FacadeCallerBlockCode;
+    };
+
+    /*!
+    * @brief Hook program without process specifics: hooks are grouped into pockets by placement, overridden instructions
+    * @brief are decoded & relocated, code of pockets is assembled locally and written by one call, site jumps by page groups.
+    * @brief Works through ProcessMemory only, so it runs against real process or SimulatedProcess (planning, tests & benchmarks).
+    * @brief Steps: Add (each hook) -> Plan -> Allocate -> Assemble -> Write. Instrumentation thunks (see HookInjector)
+    * @brief are placed by caller into prefix of program, before pockets.
+    * @brief Pocket placed inside of overridden instructions of previous pocket is merged into it as HookSegment, if the union
+    * @brief of instructions decodes, the placement is instruction boundary and no branch targets the union itself; otherwise it's skipped.
+    */
+    class HookProgram final
+    {
+    public:
+        // Function called by HookCallCode of index-th regular hook (in pocket order)
+        using Callee = std::function<HookFunction(Hook& hook, size_t index)>;
+
+        ProcessMemory&           Memory;
+
+        map<Address, HookPocket> Pockets;
+        map<Address, Facade>     Facades;
+
+        VirtualMemoryHandle*     NextInstructionsVmh = nullptr;
+        VirtualMemoryHandle*     ProgramVmh = nullptr;
+
+        // Program assembled locally
+        vector<BYTE>             Code;
+        // Bytes of pockets (program without prefix), known after Plan
+        size_t                   PocketsSize = 0;
+        // Bytes of prefix, left for caller
+        size_t                   PrefixSize = 0;
+        // Written by last Write
+        size_t                   SitePatches = 0;
+        size_t                   SiteGroups = 0;
+        // Pockets merged into previous pocket & skipped as overlapping it, by last Plan
+        size_t                   MergedPockets = 0;
+        size_t                   SkippedPockets = 0;
+
+        explicit HookProgram(ProcessMemory& memory) : Memory(memory) { }
+        ~HookProgram();
+
+        HookProgram(HookProgram const&) = delete;
+        HookProgram& operator=(HookProgram const&) = delete;
+
+        // Adds hook at placement (absolute address) into pocket or facade by its type. Returns false if hook is skipped.
+        bool Add(Hook& hook, Address placement);
+        // Reads original bytes of pockets, plans relocation of overridden instructions & sizes of pockets
+        size_t Plan();
+        // Allocates program (prefix & pockets) and table of return addresses
+        void Allocate(size_t prefixSize = 0);
+        // Places bytes into local program
+        void Emit(void const* data, size_t size, size_t offset);
+        // Assembles pockets behind prefix, links facades. Regular hooks call `callee` (hook function itself if it's not set).
+        void Assemble(Callee const& callee = nullptr);
+        // Writes program by one call and hook site jumps by page groups. Returns false if any site was not written.
+        bool Write();
+
+        size_t Size() const noexcept { return PrefixSize + PocketsSize; }
+
+        // Conflicts of planned program: redefines of the same placement, pockets skipped as overlapping previous one and
+        // redefines inside of overridden instructions of pocket. Pockets span the overwrite size planned by decoder (not declared size),
+        // so pockets merged by Plan are not conflicts. Valid after Plan.
+        vector<HookConflict> Conflicts() const;
+    private:
+        PatchBatch _sitePatches { Memory };
+        // redefines ignored by Add (placement is taken by the first one)
+        vector<HookConflict> _sameRedefines;
+        // pockets skipped by last Plan
+        vector<HookConflict> _skippedPockets;
+
+        // Merges pocket into `host` at offset (both are planned), returns false if it's not safe
+        static bool merge(HookPocket& host, HookPocket& pocket, size_t offset);
+        void merge_overlapping();
+        // Plans lean call blocks of pocket or segment, returns bytes of its calls
+        template<typename TCalls>
+        static size_t plan_calls(TCalls& calls);
+        template<typename TCalls>
+        void assemble_calls(TCalls& calls, Address placement, size_t& offset, DWORD refNextInstruction, size_t& regularHook, Callee const& callee);
+    };
+}
+#endif //INJECTOR_HOOK_PROGRAM_HPP
@@ -6,14 +6,10 @@ namespace Injector
     {
         size_t total = 0;
         for (auto& mdl : modules)
-            total += mdl.Hooks.size();
+            for (auto& hook : mdl.Hooks)
+                total += hook.ResolveRemotely;
         return total;
     }
-    inline Address write_string(string str, VirtualMemoryHandle& vmh, size_t index)
-    {
-        vmh.Write(const_cast<char*>(str.c_str()), str.size() + 1, HookRetriever::ProcNameLength * index);
-        return vmh.Pointer(HookRetriever::ProcNameLength * index);
-    }
 
     HookRetriever::HookRetriever(
         ProcessMemory& memory,
@@ -23,12 +19,22 @@ namespace Injector
             Modules(modules),
             TotalHookCount(calculate_total_hook_count(modules))
     {
-        InitFuncNameVmh                = &Memory.Allocate(ProcNameLength);
-        InitFunctionsVmh               = &Memory.Allocate(sizeof(FARPROC) * Modules.size());
-        Address const initFunctionName = write_string(InitializerFunctionName, *InitFuncNameVmh, 0);
+        // offsets of names are known before the pool is allocated, the pool is written once
+        size_t const initFunctionNameOffset = Names.add(InitializerFunctionName);
+        vector<size_t> funcNameOffsets;
+        funcNameOffsets.reserve(TotalHookCount);
+        for (auto& mdl : Modules)
+            for (auto& hook : mdl.Hooks)
+                if (hook.ResolveRemotely)
+                    funcNameOffsets.push_back(Names.add(hook.FunctionName));
 
-        FuncNamesVmh                   = &Memory.Allocate(ProcNameLength * TotalHookCount);
+        NamesVmh                       = &Memory.Allocate(Names.size());
+        InitFunctionsVmh               = &Memory.Allocate(sizeof(FARPROC) * Modules.size());
         HookFunctionsVmh               = &Memory.Allocate(sizeof(FARPROC) * TotalHookCount);
+        Names.write(*NamesVmh);
+        Address const initFunctionName = NamesVmh->Pointer(initFunctionNameOffset);
+        spdlog::info("Hook retriever names: {0} ({1} distinct), {2} bytes of remote memory by 1 write ({3} bytes without deduplication).",
+            TotalHookCount + 1, Names.count(), Names.size(), Names.added());
 
         CodeBlocks.reserve(TotalHookCount + Modules.size());
 
@@ -43,7 +49,10 @@ namespace Injector
 
             for (auto& hook : mdl.Hooks)
             {
-                Address const funcName        = write_string(hook.FunctionName, *FuncNamesVmh, thkIndex);
+                if (!hook.ResolveRemotely)
+                    continue;
+
+                Address const funcName        = NamesVmh->Pointer(funcNameOffsets[thkIndex]);
                 Address const refHookFunction = HookFunctionsVmh->Pointer(thkIndex++ * sizeof(FARPROC));
 
                 CodeBlocks.emplace_back((LPCSTR) funcName, handle, Kernel.GetProcAddressFunc, (FARPROC*) refHookFunction);
@@ -54,17 +63,17 @@ namespace Injector
         size_t const base        = PrefixCodeSize + codeSize;
         size_t const programSize = base + PostfixCodeSize;
 
-        BreakpointOffset = base + 2;
+        // INT3 of postfix itself: hardware breakpoint stops there before it's executed
+        BreakpointOffset = base + PostfixCodeBreakpointOffset;
 
-        ProgramVmh = &Memory.Allocate(programSize);
+        ProgramVmh = &Memory.Allocate(programSize, MemoryPool::Code);
         ProgramVmh->Write(&PrxCode, PrefixCodeSize, 0);
         ProgramVmh->Write(CodeBlocks.data(), codeSize, PrefixCodeSize);
         ProgramVmh->Write(&PstxCode, PostfixCodeSize, base);
     }
     HookRetriever::~HookRetriever()
     {
-        Memory.Free(*InitFuncNameVmh);
-        Memory.Free(*FuncNamesVmh);
+        Memory.Free(*NamesVmh);
         Memory.Free(*InitFunctionsVmh);
         Memory.Free(*HookFunctionsVmh);
         Memory.Free(*ProgramVmh);
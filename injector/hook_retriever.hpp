@@ -8,15 +8,19 @@
 #include "module.hpp"
 #include "misc_code.hpp"
 #include "get_function_code.hpp"
+#include "string_pool.hpp"
 
 namespace Injector
 {
     using namespace PECOFF;
 
+    /*!
+    * @brief Fallback program which invokes GetProcAddress inside of process for hooks that can't be resolved from module exports
+    * @brief (see Hook::ResolveRemotely) and for init functions of all modules.
+    * @brief Names are passed by deduplicated string pool (init function name is its first string), written by one call.
+    */
     class HookRetriever final
     {
-    public:
-        static size_t constexpr ProcNameLength = sizeof(char) * (MaxProcNameLength + 1);
     public:
         ProcessMemory& Memory;
         Kernel32&      Kernel;
@@ -25,8 +29,8 @@ namespace Injector
         size_t               BreakpointOffset;
         size_t const         TotalHookCount;
 
-        VirtualMemoryHandle* InitFuncNameVmh;
-        VirtualMemoryHandle* FuncNamesVmh;
+        StringPool           Names;
+        VirtualMemoryHandle* NamesVmh;
         VirtualMemoryHandle* InitFunctionsVmh;
         VirtualMemoryHandle* HookFunctionsVmh;
         VirtualMemoryHandle* ProgramVmh;
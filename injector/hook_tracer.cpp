@@ -0,0 +1,155 @@
+#include <chrono>
+
+#include "hook_tracer.hpp"
+
+namespace Injector
+{
+    static DWORD round_up_power_of_2(DWORD value)
+    {
+        DWORD result = 1;
+        while (result < value && result < 0x80000000)
+            result <<= 1;
+        return result;
+    }
+
+    HookTracer::HookTracer(Debugger::DebugLoop& debugger, DWORD capacity) :
+        _debugger(debugger), _capacity(round_up_power_of_2(capacity))
+    {
+        _debugger.OnProcessExited += [this](Debugger::DebugLoop& sender)
+        {
+            _section.Orphan();
+            stop();
+        };
+    }
+    HookTracer::~HookTracer()
+    {
+        stop();
+    }
+
+    void HookTracer::Map(vector<TracedHook> hooks)
+    {
+        _hooks = std::move(hooks);
+
+        string const name = "InjTrace-" + std::to_string(_debugger.ProcessInfo.dwProcessId);
+        size_t const size = sizeof(HookTraceHeader) + sizeof(HookTraceRecord) * _capacity;
+        _section = SharedSection { _debugger.Process(), name, size };
+
+        HookTraceHeader* h = header();
+        h->Signature  = HookTraceHeader::Magic;
+        h->Revision   = HookTraceHeader::Version;
+        h->Capacity   = _capacity;
+        h->RecordSize = sizeof(HookTraceRecord);
+
+        _file.open(HookTraceFileName, std::ios::binary | std::ios::trunc);
+        if (!_file)
+            spdlog::warn("Unable to write hook trace \"{0}\", records are drained without saving.", HookTraceFileName);
+
+        auto const write = [this](auto value) { _file.write(reinterpret_cast<const char*>(&value), sizeof(value)); };
+        write(HookTraceHeader::Magic);
+        write(HookTraceHeader::Version);
+        write(static_cast<DWORD>(_hooks.size()));
+        for (TracedHook const& hook : _hooks)
+        {
+            write(reinterpret_cast<DWORD>(hook.Placement));
+            write(static_cast<DWORD>(hook.Source->FunctionName.size()));
+            _file.write(hook.Source->FunctionName.data(), hook.Source->FunctionName.size());
+        }
+
+        _drainer = std::thread([this]()
+        {
+            while (!_stop.load(std::memory_order_relaxed))
+                if (!drain())
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        });
+
+        spdlog::info("Hook trace ring \"{0}\": {1} records, {2} bytes at [0x{3:x}].", name, _capacity, size, (uint32_t) _section.Remote());
+    }
+
+    DWORD* HookTracer::RemoteHead() const
+    {
+        return reinterpret_cast<DWORD*>(_section.Remote(offsetof(HookTraceHeader, Head)));
+    }
+    HookTraceRecord* HookTracer::RemoteRecords() const
+    {
+        return reinterpret_cast<HookTraceRecord*>(_section.Remote(sizeof(HookTraceHeader)));
+    }
+
+    void HookTracer::lose(DWORD count)
+    {
+        if (!count)
+            return;
+        _lost += count;
+        FileRecord const gap { _tail, GapHook, 0, count, 0 };
+        _file.write(reinterpret_cast<const char*>(&gap), sizeof(gap));
+    }
+
+    size_t HookTracer::drain()
+    {
+        auto const* head = reinterpret_cast<volatile DWORD const*>(&header()->Head);
+        DWORD const claimed = *head;
+        std::atomic_thread_fence(std::memory_order_acquire);
+
+        // lapped by producers: oldest records are overwritten already
+        if (claimed - _tail > _capacity)
+        {
+            DWORD const skipped = claimed - _tail - _capacity;
+            _tail += skipped;
+            lose(skipped);
+        }
+
+        size_t taken = 0;
+        DWORD  lost  = 0;
+        while (_tail != claimed)
+        {
+            auto* record = reinterpret_cast<volatile HookTraceRecord*>(&records()[_tail & (_capacity - 1)]);
+            DWORD const expected = _tail + 1;
+
+            DWORD const sequence = record->Sequence;
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (sequence != expected)
+            {
+                // slot is claimed but not published yet - wait for producer
+                if (static_cast<int32_t>(sequence - expected) <= 0)
+                    break;
+                // overwritten by lapping producer
+                lost++;
+                _tail++;
+                continue;
+            }
+
+            FileRecord const copy { sequence, record->Hook, record->Tsc, record->Return, record->Thread };
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (record->Sequence != sequence)
+            {
+                lost++;
+                _tail++;
+                continue;
+            }
+
+            if (lost)
+            {
+                lose(lost);
+                lost = 0;
+            }
+            _file.write(reinterpret_cast<const char*>(&copy), sizeof(copy));
+            _written++;
+            _tail++;
+            taken++;
+        }
+        lose(lost);
+        return taken;
+    }
+
+    void HookTracer::stop()
+    {
+        if (!_drainer.joinable())
+            return;
+
+        _stop = true;
+        _drainer.join();
+        // producers are gone, the rest of ring is taken by this thread
+        drain();
+        _file.flush();
+        spdlog::info("Hook trace written into \"{0}\": {1} records, {2} lost.", HookTraceFileName, _written, _lost);
+    }
+}
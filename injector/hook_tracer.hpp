@@ -0,0 +1,113 @@
+#ifndef INJECTOR_HOOK_TRACER_HPP
+#define INJECTOR_HOOK_TRACER_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <thread>
+
+#include <debugger.hpp>
+#include <shared_section.hpp>
+
+#include "framework.hpp"
+#include "hook.hpp"
+
+namespace Injector
+{
+    static constexpr const char* HookTraceFileName = "syringe.trace";
+
+    struct HookTraceHeader
+    {
+        static constexpr DWORD Magic   = 0x52545953; // 'SYTR'
+        static constexpr DWORD Version = 1;
+
+        DWORD Signature;
+        DWORD Revision;
+        // count of records, power of 2
+        DWORD Capacity;
+        DWORD RecordSize;
+        // count of claimed records (sequence of last claimed one), written by process only
+        alignas(64) DWORD Head;
+    };
+
+    // Written by trace thunk of a hook. Record is valid when Sequence is its claim number (+1), 0 while it's written.
+    struct HookTraceRecord
+    {
+        DWORD    Sequence;
+        DWORD    Hook;
+        uint64_t Tsc;
+        // value returned by hook function (ReturnEIP, relative to hook module base), 0 - continue with overridden code
+        DWORD    Return;
+        DWORD    Thread;
+        DWORD    Reserved[2];
+    };
+    static_assert(sizeof(HookTraceRecord) == 32, "Trace thunk indexes records by shift");
+    static constexpr BYTE HookTraceRecordShift = 5;
+
+    /*!
+    * @brief Trace of hook calls: which hook was called, when (TSC), by which thread and where it returned to.
+    * @brief Process appends records to the ring buffer in shared section 'InjTrace-$PID' (HookTraceHeader followed by records)
+    * @brief by trace thunks (see TraceThunkCode): slot is claimed by one `lock xadd`, producer never waits.
+    * @brief Background thread of injector drains the ring into HookTraceFileName. If producers lap the drainer, oldest records are lost:
+    * @brief their count is written into trace as a gap record (Hook = GapHook, Return = count of lost records).
+    * @brief Trace file: 'SYTR', version, hook count, for each hook [placement, name length, name], then packed FileRecord stream.
+    */
+    class HookTracer final
+    {
+    public:
+        static constexpr DWORD GapHook = 0xFFFFFFFF;
+
+        struct TracedHook
+        {
+            Hook const* Source;
+            Address     Placement;
+        };
+        #pragma pack(push, 1)
+        struct FileRecord
+        {
+            DWORD    Sequence;
+            DWORD    Hook;
+            uint64_t Tsc;
+            DWORD    Return;
+            DWORD    Thread;
+        };
+        #pragma pack(pop)
+    private:
+        Debugger::DebugLoop& _debugger;
+        DWORD const          _capacity;
+        SharedSection        _section;
+        vector<TracedHook>   _hooks;
+
+        std::thread          _drainer;
+        std::atomic_bool     _stop { false };
+        std::ofstream        _file;
+        DWORD                _tail    = 0;
+        size_t               _written = 0;
+        size_t               _lost    = 0;
+
+        HookTraceHeader* header() const { return reinterpret_cast<HookTraceHeader*>(_section.Local()); }
+        HookTraceRecord* records() const { return reinterpret_cast<HookTraceRecord*>(_section.Local(sizeof(HookTraceHeader))); }
+
+        // Returns count of records taken from ring
+        size_t drain();
+        void lose(DWORD count);
+        void stop();
+    public:
+        // Capacity is rounded up to power of 2
+        HookTracer(Debugger::DebugLoop& debugger, DWORD capacity);
+        ~HookTracer();
+
+        HookTracer(HookTracer const&) = delete;
+        HookTracer& operator=(HookTracer const&) = delete;
+
+        // Creates the ring & trace file and starts drainer, hook id is its position in `hooks`
+        void Map(vector<TracedHook> hooks);
+        bool IsMapped() const noexcept { return !_section.Empty(); }
+
+        DWORD Capacity() const noexcept { return _capacity; }
+        // Addresses in process address space
+        DWORD* RemoteHead() const;
+        HookTraceRecord* RemoteRecords() const;
+    };
+}
+#endif //INJECTOR_HOOK_TRACER_HPP
@@ -0,0 +1,37 @@
+#ifndef INJECTOR_INJECTION_OPTIONS_HPP
+#define INJECTOR_INJECTION_OPTIONS_HPP
+
+#include <cstddef>
+
+#include "typedefs.hpp"
+
+namespace Injector
+{
+    // Optional behavior of Configurator, set from command line
+    struct InjectionOptions
+    {
+        // Call regular hooks through profile thunks (see HookProfiler)
+        bool   ProfileHooks = false;
+        // Count of hooks listed for each criterion of hook profile
+        size_t ProfileTop   = 20;
+        // Sample threads of process periodically (see SamplingProfiler)
+        bool   Sample         = false;
+        // Milliseconds between samples (effective period can't be shorter than system timer resolution)
+        DWORD  SampleInterval = 1;
+        // Frames walked per sample
+        size_t SampleDepth    = 32;
+        // Record calls of regular hooks into trace (see HookTracer)
+        bool   Trace          = false;
+        // Records in trace ring (rounded up to power of 2)
+        DWORD  TraceCapacity  = 0x10000;
+        // Stop debugging the process when injection is done (see DebugLoop::Detach)
+        bool   Detach         = false;
+        // Inject without debugger (see DirectInjector), profiling & tracing are not available then
+        bool   Direct         = false;
+        // Record debug events, remote memory accesses & thread contexts of session into event log (see EventRecorder)
+        bool   Record         = false;
+        // Plan hooks against images on disk and save the plan instead of running process (see DryRun)
+        bool   Plan           = false;
+    };
+}
+#endif //INJECTOR_INJECTION_OPTIONS_HPP
@@ -67,7 +67,7 @@ namespace Injector
                 _processMemory(processMemory),
                 _libraryNameMemoryHandle(processMemory.Allocate(MaxLibraryNameLength + 1)),
                 _handleMemoryHandle(processMemory.Allocate(sizeof(HMODULE))),
-                _codeMemoryHandle(processMemory.Allocate(LoadLibraryCodeDataSize))
+                _codeMemoryHandle(processMemory.Allocate(LoadLibraryCodeDataSize, MemoryPool::Code))
         {
             memcpy(&_code, LoadLibraryCodeData, LoadLibraryCodeDataSize);
 
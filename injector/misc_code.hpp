@@ -103,7 +103,7 @@ namespace Injector
             memcpy(this, CallCodeData, CallCodeDataSize);
             Offset = relative_offset(
                 reinterpret_cast<BYTE*>(base) + JumpR32lInstructionLength,
-                func);
+                reinterpret_cast<Address>(func));
         }
     };
     static constexpr size_t CallCodeSize = sizeof(CallCode);
@@ -1,169 +1,317 @@
-#include <crc32.hpp>
+#include <algorithm>
+#include <cctype>
+#include <checksum.hpp>
 
 #include "module.hpp"
+#include "plan_cache.hpp"
 
 namespace Injector
 {
     using PE    = PECOFF::PortableExecutable;
-    using CRC32 = Utilities::CRC32;
 
-    void Module::parse_hosts()
+    template<typename TDecl, typename TCallback>
+    void Module::for_each_decl(MappedFile const& image, const char* sectionName, TCallback&& callback)
     {
-        auto& hostsSection = _pe.find_section(HostsPESectionName);
-        auto const base    = _pe.PEHeader.OptionalHeader.ImageBase;
-        auto const begin   = hostsSection.PointerToRawData;
-        auto const end     = begin + hostsSection.SizeOfRawData;
+        auto& section    = _pe.find_section(sectionName);
+        auto const begin = static_cast<size_t>(section.PointerToRawData);
+        auto const end   = begin + section.SizeOfRawData;
 
-        for (auto ptr = begin; ptr < end; ptr += sizeof(HostDecl))
+        if (!image.contains(begin, section.SizeOfRawData))
+            throw construct_error(file_read_error, "PE section is out of file bounds");
+
+        for (auto ptr = begin; ptr + sizeof(TDecl) <= end; ptr += sizeof(TDecl))
         {
-            std::string hostName;
-            HostDecl h;
-            if (PE::read_bytes(_ifs, ptr, sizeof(HostDecl), &h)    && h.NamePtr &&
-                PE::read_cstring(_ifs, PE::virtual_to_raw(h.NamePtr - base, _pe.Sections), hostName))
-            {
-                Hosts.emplace_back(hostName, h.Checksum);
-            }
+            TDecl decl;
+            memcpy(&decl, image.data() + ptr, sizeof(TDecl));
+            callback(decl);
         }
     }
-    void Module::parse_generic_hooks()
+    bool Module::read_cstring(MappedFile const& image, DWORD va, string_view& str) const
     {
-        size_t const declSize = sizeof(HookDecl);
+        auto const base = _pe.PEHeader.OptionalHeader.ImageBase;
+        if (va < base)
+            return false;
 
-        auto const base       = _pe.PEHeader.OptionalHeader.ImageBase;
+        auto const raw = PE::virtual_to_raw(va - base, _pe.Sections);
+        if (raw >= image.size())
+            return false;
 
-        auto&      section    = _pe.find_section(GenericHooksPESectionName);
-        auto const begin      = section.PointerToRawData;
-        auto const end        = begin + section.SizeOfRawData;
+        str = image.cstring(raw);
+        return true;
+    }
 
-        for (auto ptr = begin; ptr < end; ptr += declSize)
+    void Module::parse_hosts(MappedFile const& image)
+    {
+        for_each_decl<HostDecl>(image, HostsPESectionName, [this, &image](HostDecl const& h)
         {
-            HookDecl h;
-            if (PE::read_bytes(_ifs, ptr, declSize, &h))
+            string_view hostName;
+            if (h.NamePtr && read_cstring(image, h.NamePtr, hostName))
+                Hosts.emplace_back(string(hostName), h.Checksum);
+        });
+    }
+    void Module::parse_generic_hooks(MappedFile const& image)
+    {
+        for_each_decl<HookDecl>(image, GenericHooksPESectionName, [this, &image](HookDecl const& h)
+        {
+            // msvc linker inserts arbitrary padding between variables that come
+            // from different translation units
+            string_view functionName;
+            if (h.FunctionNamePtr && read_cstring(image, h.FunctionNamePtr, functionName))
             {
-                // msvc linker inserts arbitrary padding between variables that come
-                // from different translation units
-                if (h.FunctionNamePtr)
-                {
-                    std::string functionName;
-                    if (PE::read_cstring(_ifs, PE::virtual_to_raw(h.FunctionNamePtr - base, _pe.Sections), functionName))
-                    {
-                        Hook& hook     = Hooks.emplace_back(functionName, h);
-                        hook.Placement = reinterpret_cast<Address>(h.Address);
-                        hook.Size      = h.Size;
-                    }
-                }
+                Hook& hook     = Hooks.emplace_back(string(functionName), Hook::Variant(h));
+                hook.Placement = reinterpret_cast<Address>(h.Address);
+                hook.Size      = h.Size;
             }
-            else throw construct_error_no_msg(file_read_error);
-        }
+        });
     }
-    void Module::parse_extended_hooks()
+    void Module::parse_extended_hooks(MappedFile const& image)
     {
-        size_t const declSize = sizeof(ExtendedHookDecl);
-
-        auto const base       = _pe.PEHeader.OptionalHeader.ImageBase;
-
-        auto&      section    = _pe.find_section(ExtendedHooksPESectionName);
-        auto const begin      = section.PointerToRawData;
-        auto const end        = begin + section.SizeOfRawData;
+        for_each_decl<ExtendedHookDecl>(image, ExtendedHooksPESectionName, [this, &image](ExtendedHookDecl const& h)
+        {
+            // msvc linker inserts arbitrary padding between variables that come
+            // from different translation units
+            string_view functionName;
+            string_view moduleName;
+            if (h.FunctionNamePtr &&
+                read_cstring(image, h.FunctionNamePtr, functionName) &&
+                read_cstring(image, h.ModuleNamePtr, moduleName))
+            {
+                Hook& hook          = Hooks.emplace_back(string(functionName), Hook::Variant(h));
+                hook.Placement      = reinterpret_cast<Address>(h.Address);
+                hook.Size           = h.Size;
+                hook.ModuleName     = moduleName;
+                hook.ModuleChecksum = h.ModuleChecksum;
+            }
+        });
+    }
+    void Module::parse_lean_hooks(MappedFile const& image)
+    {
+        for_each_decl<LeanHookDecl>(image, LeanHooksPESectionName, [this, &image](LeanHookDecl const& h)
+        {
+            string_view functionName;
+            if (h.FunctionNamePtr && read_cstring(image, h.FunctionNamePtr, functionName))
+            {
+                // __fastcall function with two DWORD arguments is exported with decorated name
+                Hook& hook     = Hooks.emplace_back("@" + string(functionName) + "@8", Hook::Variant(h));
+                hook.Placement = reinterpret_cast<Address>(h.Address);
+                hook.Size      = h.Size;
+            }
+        });
+    }
+    void Module::parse_hook_manifest(MappedFile const& image)
+    {
+        auto& section    = _pe.find_section(HookManifestPESectionName);
+        // raw size of section is padded to file alignment, virtual size is the size of header & entries
+        auto const size  = section.Misc.VirtualSize ? (std::min)(section.Misc.VirtualSize, section.SizeOfRawData) : section.SizeOfRawData;
+        auto const begin = static_cast<size_t>(section.PointerToRawData);
+        auto const end   = begin + size;
+
+        if (!image.contains(begin, section.SizeOfRawData))
+            throw construct_error(file_read_error, "PE section is out of file bounds");
+
+        HookManifestHeader header;
+        if (size < sizeof(header))
+            return;
+        memcpy(&header, image.data() + begin, sizeof(header));
+        if (header.Signature != HookManifestSignature || header.Version != HookManifestVersion || header.EntrySize < sizeof(HookManifestEntry))
+        {
+            Warnings.push_back(fmt::format("Hook manifest of \"{0}\" has no valid header (SYRINGE_HOOK_MANIFEST), direct hooks are ignored.", FileName));
+            return;
+        }
+        // entries are tightly packed, anything else is padding inserted by linker (e.g. incremental) and entries behind it can't be located
+        if (!header.Count && section.Misc.VirtualSize && (size - sizeof(header)) % header.EntrySize)
+        {
+            Warnings.push_back(fmt::format("Hook manifest of \"{0}\" is not packed ({1} bytes of entries of {2} bytes), direct hooks are ignored.",
+                FileName, size - sizeof(header), header.EntrySize));
+            return;
+        }
 
-        for (auto ptr = begin; ptr < end; ptr += declSize)
+        auto const imageBase = _pe.PEHeader.OptionalHeader.ImageBase;
+        auto const imageSize = _pe.PEHeader.OptionalHeader.SizeOfImage;
+        auto const stem      = std::filesystem::path(FileName).stem().string();
+        list<Hook> hooks;
+        size_t     count     = 0;
+        for (auto ptr = begin + sizeof(header); ptr + header.EntrySize <= end && (!header.Count || count < header.Count); ptr += header.EntrySize, count++)
         {
-            ExtendedHookDecl h;
-            if (PE::read_bytes(_ifs, ptr, declSize, &h))
+            HookManifestEntry entry;
+            memcpy(&entry, image.data() + ptr, sizeof(entry));
+            if (std::all_of(image.data() + ptr, image.data() + ptr + header.EntrySize, [](auto byte) { return byte == 0; }))
+            {
+                Warnings.push_back(fmt::format("Hook manifest of \"{0}\": entry {1} is empty (padding between entries), direct hooks are ignored.", FileName, count));
+                return;
+            }
+            if (entry.Function < imageBase || entry.Function - imageBase >= imageSize)
+            {
+                Warnings.push_back(fmt::format("Hook manifest of \"{0}\": entry {1} has function 0x{2:x} outside of image, SKIP", FileName, count, entry.Function));
+                continue;
+            }
+
+            DWORD const rva = entry.Function - imageBase;
+            // there is no exported name, hook is named by its function for logs & context
+            string const functionName = fmt::format("{0}+0x{1:x}", stem, rva);
+            Hook* hook = nullptr;
+            switch (entry.Type)
             {
-                // msvc linker inserts arbitrary padding between variables that come
-                // from different translation units
-                if(h.FunctionNamePtr)
+                case HMT_Generic:
+                {
+                    HookDecl decl { entry.Address, entry.Size, 0 };
+                    hook = &hooks.emplace_back(functionName, decl);
+                    break;
+                }
+                case HMT_Lean:
+                {
+                    LeanHookDecl decl { entry.Address, entry.Size, 0, entry.Registers };
+                    hook = &hooks.emplace_back(functionName, decl);
+                    break;
+                }
+                case HMT_Extended:
                 {
-                    std::string functionName;
-                    std::string moduleName;
-                    if (PE::read_cstring(_ifs, PE::virtual_to_raw(h.FunctionNamePtr - base, _pe.Sections), functionName) &&
-                        PE::read_cstring(_ifs, PE::virtual_to_raw(h.ModuleNamePtr - base, _pe.Sections), moduleName))
-                    {
-                        Hook& hook          = Hooks.emplace_back(functionName, h);
-                        hook.Placement      = reinterpret_cast<Address>(h.Address);
-                        hook.Size           = h.Size;
-                        hook.ModuleName     = moduleName;
-                        hook.ModuleChecksum = h.ModuleChecksum;
-                    }
+                    string_view moduleName;
+                    if (!read_cstring(image, entry.ModuleNamePtr, moduleName))
+                        continue;
+                    ExtendedHookDecl decl { entry.Address, entry.Size, 0, entry.ModuleNamePtr, entry.ModuleChecksum };
+                    hook = &hooks.emplace_back(functionName, decl);
+                    hook->ModuleName     = moduleName;
+                    hook->ModuleChecksum = entry.ModuleChecksum;
+                    break;
                 }
+                default:
+                    Warnings.push_back(fmt::format("Hook manifest of \"{0}\": entry {1} has unknown type {2}, SKIP", FileName, count, entry.Type));
+                    continue;
             }
-            else throw construct_error_no_msg(file_read_error);
+            hook->Placement   = reinterpret_cast<Address>(entry.Address);
+            hook->Size        = entry.Size;
+            hook->FunctionRva = rva;
+            hook->Direct      = true;
         }
+        Hooks.splice(Hooks.end(), hooks);
     }
-    void Module::parse_function_replacements_type0()
+    void Module::parse_function_replacements_type0(MappedFile const& image)
     {
-        size_t const declSize = sizeof(FunctionReplacement0Decl);
-
-        auto const base = _pe.PEHeader.OptionalHeader.ImageBase;
-
-        auto& section = _pe.find_section(FunctionReplacementsByAddressPESectionName);
-        auto const begin = section.PointerToRawData;
-        auto const end = begin + section.SizeOfRawData;
-
-        for (auto ptr = begin; ptr < end; ptr += declSize)
+        for_each_decl<FunctionReplacement0Decl>(image, FunctionReplacementsByAddressPESectionName, [this, &image](FunctionReplacement0Decl const& fr)
         {
-            FunctionReplacement0Decl fr;
-            if (PE::read_bytes(_ifs, ptr, declSize, &fr))
+            // msvc linker inserts arbitrary padding between variables that come
+            // from different translation units
+            string_view functionName;
+            string_view moduleName;
+            string_view originalName;
+            if (fr.FunctionNamePtr &&
+                read_cstring(image, fr.FunctionNamePtr, functionName) &&
+                read_cstring(image, fr.ModuleNamePtr, moduleName) &&
+                read_cstring(image, fr.OriginalFunctionNamePtr, originalName))
             {
-                // msvc linker inserts arbitrary padding between variables that come
-                // from different translation units
-                if (fr.FunctionNamePtr)
-                {
-                    std::string functionName;
-                    std::string moduleName;
-                    std::string originalName;
-                    if (PE::read_cstring(_ifs, PE::virtual_to_raw(fr.FunctionNamePtr - base, _pe.Sections), functionName) &&
-                        PE::read_cstring(_ifs, PE::virtual_to_raw(fr.ModuleNamePtr - base, _pe.Sections), moduleName) &&
-                        PE::read_cstring(_ifs, PE::virtual_to_raw(fr.OriginalFunctionNamePtr - base, _pe.Sections), originalName)
-
-                    ) {
-                        Hook& hook = Hooks.emplace_back(functionName, fr);
-                        hook.PlacementFunction = originalName;
-                        hook.Size = 0; // jmp real size is 5
-                        hook.ModuleName = moduleName;
-                        hook.ModuleChecksum = fr.ModuleChecksum;
-                    }
-                }
+                Hook& hook = Hooks.emplace_back(string(functionName), Hook::Variant(fr));
+                hook.PlacementFunction = originalName;
+                hook.Size = 0; // jmp real size is 5
+                hook.ModuleName = moduleName;
+                hook.ModuleChecksum = fr.ModuleChecksum;
             }
-            else throw construct_error_no_msg(file_read_error);
+        });
+    }
+    void Module::parse_function_replacements_type1(MappedFile const& image)
+    {
+        for_each_decl<FunctionReplacement1Decl>(image, FunctionReplacementsByNamePESectionName, [this, &image](FunctionReplacement1Decl const& fr)
+        {
+            // msvc linker inserts arbitrary padding between variables that come
+            // from different translation units
+            string_view functionName;
+            string_view moduleName;
+            if (fr.FunctionNamePtr &&
+                read_cstring(image, fr.FunctionNamePtr, functionName) &&
+                read_cstring(image, fr.ModuleNamePtr, moduleName))
+            {
+                Hook& hook = Hooks.emplace_back(string(functionName), Hook::Variant(fr));
+                hook.Placement = reinterpret_cast<Address>(fr.Address);
+                hook.Size = 0; // jmp real size is 5
+                hook.ModuleName = moduleName;
+                hook.ModuleChecksum = fr.ModuleChecksum;
+            }
+        });
+    }
+    inline string to_lower(string str)
+    {
+        std::transform(str.begin(), str.end(), str.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        return str;
+    }
+
+    void Module::parse_exports(MappedFile const& image)
+    {
+        Exports.clear();
+
+        auto const& directory = _pe.PEHeader.OptionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_EXPORT];
+        if (!directory.VirtualAddress || !directory.Size)
+            return;
+
+        auto const raw = [this](DWORD rva) -> size_t { return PE::virtual_to_raw(rva, _pe.Sections); };
+
+        IMAGE_EXPORT_DIRECTORY exports;
+        auto const directoryRaw = raw(directory.VirtualAddress);
+        if (!image.contains(directoryRaw, sizeof(exports)))
+            throw construct_error(file_read_error, "Export directory is out of file bounds");
+        memcpy(&exports, image.data() + directoryRaw, sizeof(exports));
+
+        auto const namesRaw     = raw(exports.AddressOfNames);
+        auto const ordinalsRaw  = raw(exports.AddressOfNameOrdinals);
+        auto const functionsRaw = raw(exports.AddressOfFunctions);
+        if (exports.NumberOfNames > image.size() || exports.NumberOfFunctions > image.size() ||
+            !image.contains(namesRaw,     exports.NumberOfNames     * sizeof(DWORD)) ||
+            !image.contains(ordinalsRaw,  exports.NumberOfNames     * sizeof(WORD))  ||
+            !image.contains(functionsRaw, exports.NumberOfFunctions * sizeof(DWORD)))
+            throw construct_error(file_read_error, "Export tables are out of file bounds");
+
+        Exports.reserve(exports.NumberOfNames);
+        for (DWORD i = 0; i < exports.NumberOfNames; i++)
+        {
+            DWORD nameRva;
+            WORD  ordinal;
+            DWORD functionRva;
+            memcpy(&nameRva, image.data() + namesRaw    + i * sizeof(DWORD), sizeof(DWORD));
+            memcpy(&ordinal, image.data() + ordinalsRaw + i * sizeof(WORD),  sizeof(WORD));
+            if (ordinal >= exports.NumberOfFunctions)
+                continue;
+            memcpy(&functionRva, image.data() + functionsRaw + ordinal * sizeof(DWORD), sizeof(DWORD));
+
+            auto const name = image.cstring(raw(nameRva));
+            if (name.empty())
+                continue;
+
+            Export& entry = Exports[string(name)];
+            entry.Rva     = functionRva;
+            // export pointing inside of export directory is forwarder string
+            if (functionRva >= directory.VirtualAddress && functionRva < directory.VirtualAddress + directory.Size)
+                entry.Forwarder = image.cstring(raw(functionRva));
         }
     }
-    void Module::parse_function_replacements_type1()
+    bool Module::find_export(string const& name, list<Module> const& modules, Address& function, size_t depth) const
     {
-        size_t const declSize = sizeof(FunctionReplacement1Decl);
+        function = nullptr;
 
-        auto const base = _pe.PEHeader.OptionalHeader.ImageBase;
+        auto const it = Exports.find(name);
+        if (it == Exports.cend())
+            return true; // remote GetProcAddress would return NULL too
+        if (it->second.Forwarder.empty())
+        {
+            function = reinterpret_cast<Address>(reinterpret_cast<DWORD>(_handle) + it->second.Rva);
+            return true;
+        }
 
-        auto& section = _pe.find_section(FunctionReplacementsByNamePESectionName);
-        auto const begin = section.PointerToRawData;
-        auto const end = begin + section.SizeOfRawData;
+        // "module.function"; forwarding by ordinal ("module.#N") and into system modules is left for GetProcAddress
+        auto const& forwarder = it->second.Forwarder;
+        auto const  dot       = forwarder.rfind('.');
+        if (dot == string::npos || dot + 1 >= forwarder.size() || forwarder[dot + 1] == '#' || depth >= MaxForwardDepth)
+            return false;
 
-        for (auto ptr = begin; ptr < end; ptr += declSize)
+        auto const targetName = to_lower(forwarder.substr(0, dot));
+        for (auto const& mdl : modules)
         {
-            FunctionReplacement1Decl fr;
-            if (PE::read_bytes(_ifs, ptr, declSize, &fr))
-            {
-                // msvc linker inserts arbitrary padding between variables that come
-                // from different translation units
-                if (fr.FunctionNamePtr)
-                {
-                    std::string functionName;
-                    std::string moduleName;
-                    if (PE::read_cstring(_ifs, PE::virtual_to_raw(fr.FunctionNamePtr - base, _pe.Sections), functionName) &&
-                        PE::read_cstring(_ifs, PE::virtual_to_raw(fr.ModuleNamePtr - base, _pe.Sections), moduleName)
-                    ) {
-                        Hook& hook = Hooks.emplace_back(functionName, fr);
-                        hook.Placement = reinterpret_cast<Address>(fr.Address);
-                        hook.Size = 0; // jmp real size is 5
-                        hook.ModuleName = moduleName;
-                        hook.ModuleChecksum = fr.ModuleChecksum;
-                    }
-                }
-            }
-            else throw construct_error_no_msg(file_read_error);
+            if (!mdl._handle || mdl.Cached)
+                continue;
+            if (to_lower(std::filesystem::path(mdl.FileName).stem().string()) == targetName)
+                return mdl.find_export(forwarder.substr(dot + 1), modules, function, depth + 1);
         }
+        return false;
     }
+
     void Module::parse_inj_file(string_view const& injFileName)
     {
         std::string inj = file_read_text(injFileName.data());
@@ -193,11 +341,11 @@ namespace Injector
     {
         parse(fileName, strictFVI);
     }
-    void Module::parse(string_view const& fileName, bool strictFVI)
+    void Module::parse(string_view const& fileName, bool strictFVI, PlanCache const* cache)
     {
         FileName        = fileName;
         _ifs            = file_open_binary(FileName);
-        Checksum        = CRC32::compute_stream(_ifs);
+        Checksum        = ChecksumRegistry::instance().get(FileName);
         _pe             = PE(_ifs);
         _injectorHandle = make_unique<HMODULE>(LoadLibrary(FileName.c_str()));
         _handle         = nullptr;
@@ -205,18 +353,25 @@ namespace Injector
         if (!_injectorHandle.get())
             throw construct_error_args_no_msg(load_library_error, fileName);
 
-        try { FVI.Load(FileName); }
-        catch (const Utilities::FileVersionInformation::fvi_load_error&)
-        {
-            if(strictFVI)
-                throw construct_error(file_read_error, "Unable to read FileVersionInformation");
-        }
-
-        try { parse_hosts();          } catch(const PE::section_not_found_error&) { };
-        try { parse_generic_hooks();  } catch(const PE::section_not_found_error&) { };
-        try { parse_extended_hooks(); } catch(const PE::section_not_found_error&) { };
-        try { parse_function_replacements_type0(); } catch(const PE::section_not_found_error&) { };
-        try { parse_function_replacements_type1(); } catch(const PE::section_not_found_error&) { };
+        if (!ChecksumRegistry::instance().load_version(FileName, FVI) && strictFVI)
+            throw construct_error(file_read_error, "Unable to read FileVersionInformation");
+
+        if (cache && cache->restore(*this))
+            return;
+
+        // whole file is mapped once, declarations & names are read straight from the view
+        MappedFile image;
+        try { image = MappedFile(FileName); }
+        catch (const MappedFile::MappingException& ex) { throw construct_error(file_read_error, ex.what()); }
+
+        try { parse_hosts(image);          } catch(const PE::section_not_found_error&) { };
+        try { parse_generic_hooks(image);  } catch(const PE::section_not_found_error&) { };
+        try { parse_extended_hooks(image); } catch(const PE::section_not_found_error&) { };
+        try { parse_lean_hooks(image);     } catch(const PE::section_not_found_error&) { };
+        try { parse_hook_manifest(image);  } catch(const PE::section_not_found_error&) { };
+        try { parse_function_replacements_type0(image); } catch(const PE::section_not_found_error&) { };
+        try { parse_function_replacements_type1(image); } catch(const PE::section_not_found_error&) { };
+        parse_exports(image);
     }
     Module::Module(string_view const& fileName, string_view const& injFileName, bool strictFVI)
     {
@@ -226,7 +381,7 @@ namespace Injector
     {
         FileName        = fileName;
         _ifs            = file_open_binary(FileName);
-        Checksum        = CRC32::compute_stream(_ifs);
+        Checksum        = ChecksumRegistry::instance().get(FileName);
         _pe             = PE(_ifs);
         _injectorHandle = make_unique<HMODULE>(LoadLibrary(FileName.c_str()));
         _handle         = nullptr;
@@ -234,14 +389,13 @@ namespace Injector
         if (!_injectorHandle.get())
             throw construct_error_args_no_msg(load_library_error, fileName);
 
-        try { FVI.Load(FileName); }
-        catch (const Utilities::FileVersionInformation::fvi_load_error&)
-        {
-            if (strictFVI)
-                throw construct_error(file_read_error, "Unable to read FileVersionInformation");
-        }
+        if (!ChecksumRegistry::instance().load_version(FileName, FVI) && strictFVI)
+            throw construct_error(file_read_error, "Unable to read FileVersionInformation");
 
         try { parse_inj_file(injFileName); } catch(const file_not_found_error&) { throw construct_error_args_no_msg(non_injectable_module_error, fileName, non_injectable_module_error::Type::MissingInj); };
+
+        try { parse_exports(MappedFile(FileName)); }
+        catch (const MappedFile::MappingException& ex) { throw construct_error(file_read_error, ex.what()); }
     }
 
     bool Module::is_host_supported(string_view const& executableFile, unsigned int checksum)
@@ -267,12 +421,10 @@ namespace Injector
             HandshakeInfo   hsInfo;
             HandshakeResult hsResult;
 
-            auto fs = file_open_binary(FileName);
-
             hsInfo.cbSize       = sizeof(HandshakeInfo);
             hsInfo.num_hooks    = Hooks.size();
-            hsInfo.exeFilesize  = file_size(fs);
-            hsInfo.checksum     = CRC32::compute_stream(fs);
+            hsInfo.exeFilesize  = static_cast<DWORD>(std::filesystem::file_size(FileName));
+            hsInfo.checksum     = ChecksumRegistry::instance().get(FileName);
             hsInfo.exeTimestamp = _pe.PEHeader.FileHeader.TimeDateStamp;
             hsInfo.cchMessage   = static_cast<int>(bufferLength);
             hsInfo.Message      = buffer.data();
@@ -286,9 +438,49 @@ namespace Injector
         }
         return false;
     }
+    void Module::resolve_cached_functions()
+    {
+        auto const base = reinterpret_cast<DWORD>(_handle);
+        if (!Cached || !base)
+            return;
+
+        InitFunction = InitFunctionRva ? reinterpret_cast<Injector::InitFunction>(base + InitFunctionRva) : nullptr;
+        for (auto& hook : Hooks)
+            hook.Function = hook.FunctionRva ? reinterpret_cast<HookFunction>(base + hook.FunctionRva) : nullptr;
+    }
+    size_t Module::resolve_exported_functions(list<Module> const& modules)
+    {
+        size_t remote = 0;
+        Address function;
+
+        // module is not loaded into process, injector skips it
+        if (!_handle)
+        {
+            InitFunction = nullptr;
+            for (auto& hook : Hooks)
+                hook.Function = nullptr;
+            return 0;
+        }
+
+        InitFunction = find_export(InitializerFunctionName, modules, function) ? reinterpret_cast<Injector::InitFunction>(function) : nullptr;
+        for (auto& hook : Hooks)
+        {
+            if (hook.Direct)
+            {
+                hook.ResolveRemotely = false;
+                hook.Function        = reinterpret_cast<HookFunction>(reinterpret_cast<DWORD>(_handle) + hook.FunctionRva);
+                continue;
+            }
+            hook.ResolveRemotely = !find_export(hook.FunctionName, modules, function);
+            hook.Function        = hook.ResolveRemotely ? nullptr : reinterpret_cast<HookFunction>(function);
+            remote              += hook.ResolveRemotely;
+        }
+        return remote;
+    }
     bool Module::is_executable_supported(string_view const& executableFile, unsigned int checksum)
     {
-        Utilities::FileVersionInformation fvi { executableFile.data() };
+        Utilities::FileVersionInformation fvi;
+        ChecksumRegistry::instance().load_version(executableFile, fvi);
         return is_host_supported(fvi.Loaded ? fvi.OriginalFilename : executableFile, checksum) || handshake();
     }
 }
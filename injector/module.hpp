@@ -5,12 +5,16 @@
 #include <handle.win.hpp>
 #include <exceptions.win.hpp>
 #include <winapi.utilities.hpp>
+#include <mapped_file.hpp>
+#include <unordered_map>
 
 #include "framework.hpp"
 #include "hook.hpp"
 
 namespace Injector
 {
+    class PlanCache;
+
     using namespace Utilities;
     using namespace Exceptions;
 
@@ -45,6 +49,15 @@ namespace Injector
     class Module final
     {
     public:
+        // Depth limit for export forwarding chains between injectable modules
+        static constexpr size_t MaxForwardDepth = 8;
+
+        struct Export
+        {
+            DWORD  Rva = 0;
+            // "module.function" for forwarded export, empty otherwise
+            string Forwarder;
+        };
         struct Host
         {
             std::string  const FileName;
@@ -61,18 +74,38 @@ namespace Injector
         list<Host>   Hosts;
         // it's idea about Initialize(...) function concept, which invokes before main thread resumed or at moment when it's resumed. Invocation not implemented. Just use hook at top of program.
         InitFunction InitFunction;
+        // RVA of Initialize(...) export (0 - absent), valid only when module restored from plan cache
+        DWORD        InitFunctionRva = 0;
+        // Hooks & hosts were restored from plan cache instead of PE sections, hook functions are known by RVA
+        bool         Cached = false;
+        // Named exports of module file, not filled when module is restored from plan cache
+        std::unordered_map<string, Export> Exports;
+        // Warnings of parse, logged by caller: modules are parsed concurrently, so they are logged in order of modules
+        vector<string> Warnings;
     private:
         HMODULE                    _handle;
         unique_ptr<HMODULE>        _injectorHandle;
         std::ifstream              _ifs;
         PECOFF::PortableExecutable _pe;
 
-        void parse_hosts();
-        void parse_generic_hooks();
-        void parse_extended_hooks();
-        void parse_function_replacements_type0();
-        void parse_function_replacements_type1();
+        // Invokes callback for each declaration of PE section, section must be fully inside of image.
+        template<typename TDecl, typename TCallback>
+        void for_each_decl(MappedFile const& image, const char* sectionName, TCallback&& callback);
+        // Zero terminated string at virtual address of module image (preferred base). View is valid while image is mapped.
+        bool read_cstring(MappedFile const& image, DWORD va, string_view& str) const;
+
+        void parse_hosts(MappedFile const& image);
+        void parse_generic_hooks(MappedFile const& image);
+        void parse_extended_hooks(MappedFile const& image);
+        void parse_lean_hooks(MappedFile const& image);
+        // Header & entries of direct hook manifest are read in one pass, functions are known by RVA
+        void parse_hook_manifest(MappedFile const& image);
+        void parse_function_replacements_type0(MappedFile const& image);
+        void parse_function_replacements_type1(MappedFile const& image);
         void parse_inj_file(string_view const& injFileName);
+        void parse_exports(MappedFile const& image);
+        // Returns false if export must be resolved remotely. Not exported function is resolved locally as nullptr.
+        bool find_export(string const& name, list<Module> const& modules, Address& function, size_t depth = 0) const;
     public:
         std::istream&                     stream()   { return _ifs; }
         PECOFF::PortableExecutable const& pe() const { return _pe; }
@@ -81,12 +114,18 @@ namespace Injector
         Module(string_view const& fileName, bool strictFVI = false);
         Module(string_view const& fileName, string_view const& injFileName, bool strictFVI = false);
 
-        void parse(string_view const& fileName, bool strictFVI = false);
+        void parse(string_view const& fileName, bool strictFVI = false, PlanCache const* cache = nullptr);
         void parse(string_view const& fileName, string_view const& injFileName, bool strictFVI = false);
 
         bool is_host_supported(string_view const& executableFile, unsigned int checksum = 0);
         bool is_executable_supported(string_view const& executableFile, unsigned int checksum = 0);
         bool handshake();
+        // Sets hook & init functions from cached RVAs. Module handle must be set.
+        void resolve_cached_functions();
+        // Sets hook & init functions as module handle + export RVA, forwarded exports are followed into other modules of list.
+        // Direct hooks are set as module handle + RVA from manifest.
+        // Module handle must be set. Returns count of hooks left for remote GetProcAddress (Hook::ResolveRemotely).
+        size_t resolve_exported_functions(list<Module> const& modules);
 
         HMODULE get_handle() const { return _handle; }
         void    set_handle(HMODULE value) { _handle = value; }
@@ -2,12 +2,6 @@
 
 namespace Injector
 {
-    inline Address write_string(string str, VirtualMemoryHandle& vmh, size_t index)
-    {
-        vmh.Write(const_cast<char*>(str.c_str()), str.size() + 1, ModuleRetriever::LibraryNameLength * index);
-        return vmh.Pointer(ModuleRetriever::LibraryNameLength * index);
-    }
-
     ModuleRetriever::ModuleRetriever(
         ProcessMemory& memory,
         Kernel32& kernel,
@@ -18,19 +12,22 @@ namespace Injector
         LoadLibraryFunction llFunc = reinterpret_cast<LoadLibraryFunction>(reinterpret_cast<BYTE*>(Kernel.LoadLibraryFunc));
         //LoadLibraryFunction llFunc = reinterpret_cast<LoadLibraryFunction>(reinterpret_cast<BYTE*>(Kernel.LoadLibraryFunc) + imageOffset);
 
-        LibNamesVmh = &Memory.Allocate(LibraryNameLength * Modules.size());
+        vector<size_t> libNameOffsets;
+        libNameOffsets.reserve(Modules.size());
+        for (auto& mdl : Modules)
+            libNameOffsets.push_back(LibNames.add(mdl.FileName));
+
+        LibNamesVmh = &Memory.Allocate(LibNames.size());
         ModuleHandlesVmh = &Memory.Allocate(sizeof(HMODULE) * Modules.size());
+        LibNames.write(*LibNamesVmh);
+        spdlog::info("Module retriever names: {0} ({1} distinct), {2} bytes of remote memory by 1 write ({3} bytes without deduplication).",
+            Modules.size(), LibNames.count(), LibNames.size(), LibNames.added());
 
         CodeBlocks.reserve(Modules.size());
 
         for (size_t index = 0; index < Modules.size(); ++index)
         {
-            Module& mdl = *std::next(Modules.begin(), index);
-
-            size_t const libNameOffset = index * LibraryNameLength;
-            write_string(mdl.FileName, *LibNamesVmh, index);
-
-            Address const refLibName      = LibNamesVmh->Pointer(libNameOffset);
+            Address const refLibName      = LibNamesVmh->Pointer(libNameOffsets[index]);
             Address const refModuleHandle = ModuleHandlesVmh->Pointer(index * sizeof(HMODULE));
 
             LoadLibraryCode& block = CodeBlocks.emplace_back(
@@ -43,9 +40,10 @@ namespace Injector
         size_t const base        = PrefixCodeSize + codeSize;
         size_t const programSize = base + PostfixCodeSize;
 
-        BreakpointOffset = base + 2;
+        // INT3 of postfix itself: hardware breakpoint stops there before it's executed
+        BreakpointOffset = base + PostfixCodeBreakpointOffset;
 
-        ProgramVmh = &Memory.Allocate(programSize);
+        ProgramVmh = &Memory.Allocate(programSize, MemoryPool::Code);
         ProgramVmh->Write(&PrxCode, PrefixCodeSize, 0);
         ProgramVmh->Write(CodeBlocks.data(), codeSize, PrefixCodeSize);
         ProgramVmh->Write(&PstxCode, PostfixCodeSize, base);
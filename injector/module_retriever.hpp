@@ -8,21 +8,23 @@
 #include "module.hpp"
 #include "misc_code.hpp"
 #include "load_library_code.hpp"
+#include "string_pool.hpp"
 
 namespace Injector
 {
 	using namespace PECOFF;
 
+	/*!
+	* @brief Program which invokes LoadLibrary inside of process for each module, names are passed by deduplicated string pool written by one call.
+	*/
 	class ModuleRetriever final
 	{
-	public:
-		static size_t constexpr LibraryNameLength = sizeof(char) * (MaxLibraryNameLength + 1);
-
 	public:
 		ProcessMemory&				Memory;
 		Kernel32&							Kernel;
 		list<Module>&					Modules;
 
+		StringPool							LibNames;
 		VirtualMemoryHandle*		LibNamesVmh;
 		VirtualMemoryHandle*		ModuleHandlesVmh;
 		VirtualMemoryHandle*		ProgramVmh;
@@ -43,4 +45,4 @@ namespace Injector
 		Address instruction() const;
 	};
 }
-#endif //INJECTOR_MODULE_RETRIEVER_HPP
\ No newline at end of file
+#endif //INJECTOR_MODULE_RETRIEVER_HPP
\ No newline at end of file
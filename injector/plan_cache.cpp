@@ -0,0 +1,255 @@
+#include <fstream>
+
+#include "plan_cache.hpp"
+
+namespace Injector
+{
+    template<typename T>
+    inline void write_pod(std::ostream& os, T const& value)
+    {
+        os.write(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+    template<typename T>
+    inline T read_pod(std::istream& is)
+    {
+        T value;
+        if (!is.read(reinterpret_cast<char*>(&value), sizeof(T)))
+            throw plan_cache_format_error("Unexpected end of plan cache");
+        return value;
+    }
+    inline void write_string(std::ostream& os, string const& str)
+    {
+        write_pod<DWORD>(os, static_cast<DWORD>(str.size()));
+        os.write(str.data(), str.size());
+    }
+    inline string read_string(std::istream& is)
+    {
+        auto const size = read_pod<DWORD>(is);
+        string str(size, '\0');
+        if (!is.read(str.data(), size))
+            throw plan_cache_format_error("Unexpected end of plan cache");
+        return str;
+    }
+
+    template<size_t Index = 0>
+    inline Hook::Variant read_decl(std::istream& is, size_t index)
+    {
+        if constexpr (Index < std::variant_size_v<Hook::Variant>)
+        {
+            if (index == Index)
+                return read_pod<std::variant_alternative_t<Index, Hook::Variant>>(is);
+            return read_decl<Index + 1>(is, index);
+        }
+        else throw plan_cache_format_error("Unknown hook declaration type in plan cache");
+    }
+
+    PlanCache::PlanCache(string_view const& fileName, unsigned int executableChecksum) :
+        FileName(fileName),
+        ExecutableChecksum(executableChecksum)
+    {}
+
+    bool PlanCache::load()
+    {
+        Modules.clear();
+
+        std::ifstream is(FileName, std::ios::binary);
+        if (!is)
+            return false;
+
+        try
+        {
+            if (read_pod<DWORD>(is) != Magic || read_pod<DWORD>(is) != Version)
+                throw plan_cache_format_error("Plan cache version mismatch");
+            if (read_pod<unsigned int>(is) != ExecutableChecksum)
+            {
+                spdlog::info("Plan cache \"{0}\" made for different executable, ignore it.", FileName);
+                return false;
+            }
+
+            Modules.resize(read_pod<DWORD>(is));
+            for (auto& mdl : Modules)
+            {
+                mdl.FileName        = read_string(is);
+                mdl.Checksum        = read_pod<unsigned int>(is);
+                mdl.InitFunctionRva = read_pod<DWORD>(is);
+
+                mdl.Hosts.resize(read_pod<DWORD>(is));
+                for (auto& host : mdl.Hosts)
+                {
+                    host.FileName = read_string(is);
+                    host.Checksum = read_pod<unsigned int>(is);
+                }
+
+                mdl.Hooks.resize(read_pod<DWORD>(is));
+                for (auto& hook : mdl.Hooks)
+                {
+                    hook.Decl              = read_decl(is, read_pod<DWORD>(is));
+                    hook.FunctionName      = read_string(is);
+                    hook.Placement         = reinterpret_cast<Address>(read_pod<DWORD>(is));
+                    hook.PlacementFunction = read_string(is);
+                    hook.ModuleName        = read_string(is);
+                    hook.ModuleChecksum    = read_pod<unsigned int>(is);
+                    hook.Size              = read_pod<DWORD>(is);
+                    hook.FunctionRva       = read_pod<DWORD>(is);
+                }
+            }
+        }
+        catch (const plan_cache_format_error& ex)
+        {
+            spdlog::warn("Plan cache \"{0}\" is not readable ({1}), ignore it.", FileName, ex.what());
+            Modules.clear();
+            return false;
+        }
+
+        spdlog::info("Plan cache \"{0}\" loaded: {1} module entries.", FileName, Modules.size());
+        return true;
+    }
+
+    void PlanCache::save()
+    {
+        if (!Dirty)
+            return;
+
+        std::ofstream os(FileName, std::ios::binary | std::ios::trunc);
+        if (!os)
+        {
+            spdlog::warn("Plan cache \"{0}\" is not writable.", FileName);
+            return;
+        }
+
+        write_pod(os, Magic);
+        write_pod(os, Version);
+        write_pod(os, ExecutableChecksum);
+
+        write_pod<DWORD>(os, static_cast<DWORD>(Modules.size()));
+        for (auto const& mdl : Modules)
+        {
+            write_string(os, mdl.FileName);
+            write_pod(os, mdl.Checksum);
+            write_pod(os, mdl.InitFunctionRva);
+
+            write_pod<DWORD>(os, static_cast<DWORD>(mdl.Hosts.size()));
+            for (auto const& host : mdl.Hosts)
+            {
+                write_string(os, host.FileName);
+                write_pod(os, host.Checksum);
+            }
+
+            write_pod<DWORD>(os, static_cast<DWORD>(mdl.Hooks.size()));
+            for (auto const& hook : mdl.Hooks)
+            {
+                write_pod<DWORD>(os, static_cast<DWORD>(hook.Decl.index()));
+                std::visit([&os](auto const& decl) { write_pod(os, decl); }, hook.Decl);
+                write_string(os, hook.FunctionName);
+                write_pod<DWORD>(os, reinterpret_cast<DWORD>(hook.Placement));
+                write_string(os, hook.PlacementFunction);
+                write_string(os, hook.ModuleName);
+                write_pod(os, hook.ModuleChecksum);
+                write_pod<DWORD>(os, static_cast<DWORD>(hook.Size));
+                write_pod(os, hook.FunctionRva);
+            }
+        }
+
+        Dirty = false;
+        spdlog::info("Plan cache \"{0}\" saved: {1} module entries.", FileName, Modules.size());
+    }
+
+    PlanCache::ModuleEntry const* PlanCache::find(string_view const& fileName, unsigned int checksum) const
+    {
+        auto const it = std::find_if(Modules.cbegin(), Modules.cend(),
+            [&fileName, checksum](ModuleEntry const& entry) -> bool
+            {
+                return entry.Checksum == checksum && entry.FileName == fileName;
+            });
+        return it == Modules.cend() ? nullptr : &*it;
+    }
+
+    bool PlanCache::restore(Module& mdl) const
+    {
+        auto const* entry = find(mdl.FileName, mdl.Checksum);
+        if (!entry)
+            return false;
+
+        for (auto const& host : entry->Hosts)
+            mdl.Hosts.emplace_back(host.FileName, host.Checksum);
+
+        for (auto const& entryHook : entry->Hooks)
+        {
+            Hook& hook             = mdl.Hooks.emplace_back(entryHook.FunctionName, entryHook.Decl);
+            hook.Placement         = entryHook.Placement;
+            hook.PlacementFunction = entryHook.PlacementFunction;
+            hook.ModuleName        = entryHook.ModuleName;
+            hook.ModuleChecksum    = entryHook.ModuleChecksum;
+            hook.Size              = entryHook.Size;
+            hook.FunctionRva       = entryHook.FunctionRva;
+        }
+
+        mdl.InitFunctionRva = entry->InitFunctionRva;
+        mdl.Cached          = true;
+        return true;
+    }
+
+    void PlanCache::store(Module const& mdl)
+    {
+        auto const base = reinterpret_cast<DWORD>(mdl.get_handle());
+        if (!base)
+            return;
+
+        auto const rva = [base](auto function) -> DWORD
+        {
+            return function ? reinterpret_cast<DWORD>(function) - base : 0;
+        };
+        auto const it = std::find_if(Modules.begin(), Modules.end(),
+            [&mdl](ModuleEntry const& e) -> bool { return e.FileName == mdl.FileName; });
+
+        // function outside of module (forwarded export, remote GetProcAddress) has no RVA of it, cached module would skip
+        // retrieving and jump to stale address when the other module is moved; such module is parsed each launch
+        DWORD const imageSize = mdl.pe().PEHeader.OptionalHeader.SizeOfImage;
+        auto const  inside    = [base, imageSize](auto function)
+        {
+            return !function || reinterpret_cast<DWORD>(function) - base < imageSize;
+        };
+        bool cacheable = inside(mdl.InitFunction);
+        for (auto const& hook : mdl.Hooks)
+            cacheable = cacheable && inside(hook.Function);
+        if (!cacheable)
+        {
+            spdlog::info("Plan cache: \"{0}\" has hook functions outside of it, it's not cached.", mdl.FileName);
+            if (it != Modules.end())
+            {
+                Modules.erase(it);
+                Dirty = true;
+            }
+            return;
+        }
+
+        ModuleEntry entry;
+        entry.FileName        = mdl.FileName;
+        entry.Checksum        = mdl.Checksum;
+        entry.InitFunctionRva = rva(mdl.InitFunction);
+
+        for (auto const& host : mdl.Hosts)
+            entry.Hosts.push_back({ host.FileName, host.Checksum });
+
+        for (auto const& hook : mdl.Hooks)
+        {
+            entry.Hooks.push_back({
+                hook.Decl,
+                hook.FunctionName,
+                hook.Placement,
+                hook.PlacementFunction,
+                hook.ModuleName,
+                hook.ModuleChecksum,
+                hook.Size,
+                rva(hook.Function)
+            });
+        }
+
+        if (it != Modules.end())
+            *it = std::move(entry);
+        else
+            Modules.push_back(std::move(entry));
+
+        Dirty = true;
+    }
+}
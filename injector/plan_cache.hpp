@@ -0,0 +1,72 @@
+#ifndef INJECTOR_PLAN_CACHE_HPP
+#define INJECTOR_PLAN_CACHE_HPP
+
+#include "framework.hpp"
+#include "module.hpp"
+
+namespace Injector
+{
+    static constexpr const char* PlanCacheFileName = "syringe.plan";
+
+    struct plan_cache_format_error : std::runtime_error
+    {
+        plan_cache_format_error(string const& what) : std::runtime_error(what) {}
+    };
+
+    /*!
+    * @brief Persistent (on-disk) cache of the resolved hook plan.
+    * @brief It keeps for each module: hosts, hooks (declarations, placements, overridden sizes) and RVAs of hook functions
+    * @brief inside the module, so the next launch can skip section parsing and the remote function retrievening program.
+    * @brief Whole cache is bound to the executable checksum, each module entry is bound to the module checksum.
+    * @brief Any checksum difference is a miss: the module is parsed as usual and its entry is rewritten.
+    */
+    class PlanCache final
+    {
+    public:
+        static constexpr DWORD Magic   = 0x43505953; // 'SYPC'
+        static constexpr DWORD Version = 1;
+
+        struct HookEntry
+        {
+            Hook::Variant Decl;
+            string        FunctionName;
+            Address       Placement;
+            string        PlacementFunction;
+            string        ModuleName;
+            unsigned int  ModuleChecksum;
+            size_t        Size;
+            DWORD         FunctionRva;
+        };
+        struct HostEntry
+        {
+            string       FileName;
+            unsigned int Checksum;
+        };
+        struct ModuleEntry
+        {
+            string            FileName;
+            unsigned int      Checksum;
+            DWORD             InitFunctionRva;
+            vector<HostEntry> Hosts;
+            vector<HookEntry> Hooks;
+        };
+
+        string const        FileName;
+        unsigned int const  ExecutableChecksum;
+        vector<ModuleEntry> Modules;
+        bool                Dirty = false;
+
+        PlanCache(string_view const& fileName, unsigned int executableChecksum);
+
+        // Reads cache file. Returns false (and keeps cache empty) if file is missing, corrupted or made for another executable.
+        bool load();
+        void save();
+
+        ModuleEntry const* find(string_view const& fileName, unsigned int checksum) const;
+        // Fills module hooks & hosts from cache entry. Returns false when there is no entry for module checksum.
+        bool restore(Module& mdl) const;
+        // Replaces module entry with current (resolved) module state. Module with functions outside of its image is not cached.
+        void store(Module const& mdl);
+    };
+}
+#endif //INJECTOR_PLAN_CACHE_HPP
@@ -0,0 +1,201 @@
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+
+#include "sampling_profiler.hpp"
+
+namespace Injector
+{
+    void AddressIndex::AddRegion(Address begin, size_t size, string name, bool offsets)
+    {
+        _regions.push_back({ static_cast<BYTE*>(begin), static_cast<BYTE*>(begin) + size, std::move(name), offsets });
+        _sorted = false;
+    }
+    void AddressIndex::AddSymbol(Address address, string name)
+    {
+        _symbols.push_back({ static_cast<BYTE*>(address), std::move(name) });
+        _sorted = false;
+    }
+    void AddressIndex::Clear()
+    {
+        _regions.clear();
+        _symbols.clear();
+        _sorted = true;
+    }
+    void AddressIndex::sort()
+    {
+        std::sort(_regions.begin(), _regions.end(), [](Region const& a, Region const& b) { return a.Begin < b.Begin; });
+        std::sort(_symbols.begin(), _symbols.end(), [](Symbol const& a, Symbol const& b) { return a.Address < b.Address; });
+        _sorted = true;
+    }
+
+    string AddressIndex::Resolve(Address address, bool withOffset)
+    {
+        if (!_sorted)
+            sort();
+
+        BYTE* const where = static_cast<BYTE*>(address);
+        auto region = std::upper_bound(_regions.cbegin(), _regions.cend(), where, [](BYTE* a, Region const& r) { return a < r.Begin; });
+        if (region == _regions.cbegin())
+            return {};
+        --region;
+        if (where >= region->End)
+            return {};
+
+        auto symbol = std::upper_bound(_symbols.cbegin(), _symbols.cend(), where, [](BYTE* a, Symbol const& s) { return a < s.Address; });
+        if (symbol != _symbols.cbegin() && (--symbol)->Address >= region->Begin)
+            return region->Name + "!" + symbol->Name;
+        if (withOffset && region->Offsets)
+            return fmt::format("{0}+0x{1:x}", region->Name, static_cast<uint32_t>(where - region->Begin));
+        return region->Name;
+    }
+
+    SamplingProfiler::SamplingProfiler(Debugger::DebugLoop& debugger, list<Module>& modules, string_view const& executableName, size_t executableSize, DWORD interval, size_t depth) :
+        _debugger(debugger), _modules(modules),
+        _executableName(std::filesystem::path(executableName).filename().string()), _executableSize(executableSize),
+        _depth(std::clamp<size_t>(depth, 1, MaxDepth))
+    {
+        _debugger.TickInterval = interval ? interval : 1;
+        _debugger.OnTick          += [this](Debugger::DebugLoop& sender) { on_tick(); };
+        _debugger.OnDllLoaded     += [this](Debugger::DebugLoop& sender, DllInfo& dll) { _indexDirty = true; };
+        _debugger.OnDllUnloaded   += [this](Debugger::DebugLoop& sender, DllInfo& dll) { _indexDirty = true; };
+        _debugger.OnProcessExited += [this](Debugger::DebugLoop& sender) { dump(); };
+    }
+
+    void SamplingProfiler::Index(HookInjector const& hookInjector)
+    {
+        _hookInjector = &hookInjector;
+        _indexDirty   = true;
+    }
+
+    void SamplingProfiler::rebuild_index()
+    {
+        _index.Clear();
+        _index.AddRegion(_debugger.ProcessDebugInfo.lpBaseOfImage, _executableSize, _executableName, true);
+        for (auto const& [base, dll] : _debugger.Dlls)
+        {
+            if (dll.Unloaded)
+                continue;
+            try
+            {
+                _index.AddRegion(base, dll.ImageSize(), std::filesystem::path(dll.FileName).filename().string(), true);
+            }
+            catch (std::exception const& ex)
+            {
+                spdlog::trace("::Sampling: image size of \"{0}\" is unknown ({1}), it's not indexed.", dll.FileName, ex.what());
+            }
+        }
+
+        for (Module const& mdl : _modules)
+        {
+            if (mdl.InitFunction)
+                _index.AddSymbol(reinterpret_cast<Address>(mdl.InitFunction), "SyringeInit");
+            for (Hook const& hook : mdl.Hooks)
+                if (hook.Function)
+                    _index.AddSymbol(reinterpret_cast<Address>(hook.Function), hook.FunctionName);
+        }
+
+        if (_hookInjector)
+        {
+            VirtualMemoryHandle const& program = *_hookInjector->Program.ProgramVmh;
+            size_t const thunksSize = ProfileThunkCodeSize * _hookInjector->ProfileThunks.size();
+            if (thunksSize)
+                _index.AddRegion(program.Pointer(0), thunksSize, "[syringe profile thunks]", false);
+            size_t const traceThunksSize = TraceThunkCodeSize * _hookInjector->TraceThunks.size();
+            if (traceThunksSize)
+                _index.AddRegion(program.Pointer(thunksSize), traceThunksSize, "[syringe trace thunks]", false);
+
+            auto const& pockets = _hookInjector->Program.Pockets;
+            for (auto it = pockets.cbegin(); it != pockets.cend(); ++it)
+            {
+                size_t const end = std::next(it) != pockets.cend() ? std::next(it)->second.Offset : program.Size();
+                _index.AddRegion(program.Pointer(it->second.Offset), end - it->second.Offset,
+                    fmt::format("[syringe hook 0x{0:x}]", reinterpret_cast<uint32_t>(it->first)), false);
+            }
+        }
+
+        _indexDirty = false;
+        spdlog::trace("::Sampling: address index rebuilt, {0} regions & {1} symbols.", _index.Regions(), _index.Symbols());
+    }
+
+    void SamplingProfiler::sample(Thread& thread, vector<Address>& frames)
+    {
+        frames.clear();
+        if (thread.Suspend() == static_cast<DWORD>(-1))
+            return;
+
+        CONTEXT const& context = thread.GetContext(CONTEXT_CONTROL);
+        frames.push_back(reinterpret_cast<Address>(context.Eip));
+
+        // [EBP] = caller's EBP, [EBP + 4] = return address
+        DWORD frame = context.Ebp;
+        DWORD const stack = context.Esp;
+        while (frames.size() < _depth && frame >= stack && (frame & 3) == 0)
+        {
+            DWORD link[2];
+            if (!_debugger.Memory.Read(reinterpret_cast<Address>(frame), link, sizeof(link)) || !link[1])
+                break;
+            frames.push_back(reinterpret_cast<Address>(link[1]));
+            if (link[0] <= frame || link[0] - frame > MaxFrameSize)
+                break;
+            frame = link[0];
+        }
+        thread.Resume();
+
+        // outermost frame first; callers are named without offsets, so recursion inside of module or symbol is one frame
+        string stackLine = fmt::format("thread {0}", thread.Id);
+        string previous;
+        for (auto it = frames.crbegin(); it != frames.crend(); ++it)
+        {
+            bool const isLeaf = std::next(it) == frames.crend();
+            string name = _index.Resolve(*it, isLeaf);
+            if (name.empty())
+                name = "[unknown]";
+            else if (!isLeaf && name == previous)
+                continue;
+            stackLine += ";" + name;
+            previous = name;
+        }
+
+        _stacks[stackLine]++;
+        _self[_index.Resolve(frames.front(), false)]++;
+        _samples++;
+    }
+
+    void SamplingProfiler::on_tick()
+    {
+        if (_indexDirty)
+            rebuild_index();
+
+        auto const start = std::chrono::steady_clock::now();
+        vector<Address> frames;
+        frames.reserve(_depth);
+        for (auto& [id, thread] : _debugger.ThreadMgr.Threads)
+            sample(thread, frames);
+        _sampleTime += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+        _ticks++;
+    }
+
+    void SamplingProfiler::dump()
+    {
+        spdlog::info("Sampling profile: {0} samples in {1} ticks, {2:.1f} us per tick.", _samples, _ticks, _ticks ? _sampleTime / _ticks : 0.0);
+        if (!_samples)
+            return;
+
+        vector<std::pair<string, size_t>> self(_self.cbegin(), _self.cend());
+        std::sort(self.begin(), self.end(), [](auto const& a, auto const& b) { return a.second > b.second; });
+        spdlog::info("::Top {0} by samples:", std::min<size_t>(20, self.size()));
+        for (size_t i = 0; i < self.size() && i < 20; i++)
+            spdlog::info("::::{0}: {1} ({2:.1f}%)", self[i].first.empty() ? "[unknown]" : self[i].first, self[i].second, 100.0 * self[i].second / _samples);
+
+        std::ofstream file(SamplingProfileFileName, std::ios::trunc);
+        if (!file)
+        {
+            spdlog::warn("Unable to write sampling profile \"{0}\".", SamplingProfileFileName);
+            return;
+        }
+        for (auto const& [stack, count] : _stacks)
+            file << stack << ' ' << count << '\n';
+        spdlog::info("Sampling profile written into \"{0}\" ({1} distinct stacks).", SamplingProfileFileName, _stacks.size());
+    }
+}
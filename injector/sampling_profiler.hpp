@@ -0,0 +1,99 @@
+#ifndef INJECTOR_SAMPLING_PROFILER_HPP
+#define INJECTOR_SAMPLING_PROFILER_HPP
+
+#include <debugger.hpp>
+
+#include "framework.hpp"
+#include "module.hpp"
+#include "hook_injector.hpp"
+
+namespace Injector
+{
+    static constexpr const char* SamplingProfileFileName = "syringe.samples.folded";
+
+    /*!
+    * @brief Sorted address index of process code: modules (executable & DLLs), hook program pieces and hook functions.
+    * @brief Regions don't overlap, symbols (hook & init functions) are attributed inside of their module region:
+    * @brief address belongs to the nearest symbol below it (only exported functions are known, so it's approximate).
+    */
+    class AddressIndex final
+    {
+    public:
+        struct Region
+        {
+            BYTE*  Begin;
+            BYTE*  End;
+            string Name;
+            // unresolved addresses are named "region+0xRVA"
+            bool   Offsets;
+        };
+        struct Symbol
+        {
+            BYTE*  Address;
+            string Name;
+        };
+    private:
+        vector<Region> _regions;
+        vector<Symbol> _symbols;
+        bool           _sorted = true;
+
+        void sort();
+    public:
+        void AddRegion(Address begin, size_t size, string name, bool offsets);
+        void AddSymbol(Address address, string name);
+        void Clear();
+
+        // "module!symbol", "module+0xRVA" (if withOffset), "module", hook program region name or empty string if address is unknown
+        string Resolve(Address address, bool withOffset);
+
+        size_t Regions() const noexcept { return _regions.size(); }
+        size_t Symbols() const noexcept { return _symbols.size(); }
+    };
+
+    /*!
+    * @brief Statistical profiler of debugged process.
+    * @brief Each tick of debug loop (DebugLoop::OnTick) all threads are suspended one by one, EIP is taken by Thread::GetContext
+    * @brief and the stack is walked by EBP chain (so frames of functions compiled without frame pointers are skipped).
+    * @brief Every frame is attributed by AddressIndex, samples are aggregated as collapsed stacks ("thread;outer;...;inner count"),
+    * @brief which are written into SamplingProfileFileName at exit of process - input for flame graph tools.
+    */
+    class SamplingProfiler final
+    {
+        Debugger::DebugLoop& _debugger;
+        list<Module>&        _modules;
+        HookInjector const*  _hookInjector = nullptr;
+        string               _executableName;
+        size_t               _executableSize;
+        size_t const         _depth;
+
+        AddressIndex         _index;
+        bool                 _indexDirty = true;
+
+        map<string, size_t>  _stacks;
+        map<string, size_t>  _self;
+        size_t               _samples = 0;
+        size_t               _ticks   = 0;
+        double               _sampleTime = 0;
+
+        void rebuild_index();
+        void sample(Thread& thread, vector<Address>& frames);
+        void on_tick();
+        void dump();
+    public:
+        // Maximal depth of stack walk
+        static constexpr size_t MaxDepth = 64;
+        // Frame pointers are not followed further than this from previous one
+        static constexpr DWORD  MaxFrameSize = 0x100000;
+
+        SamplingProfiler(Debugger::DebugLoop& debugger, list<Module>& modules, string_view const& executableName, size_t executableSize, DWORD interval, size_t depth);
+
+        SamplingProfiler(SamplingProfiler const&) = delete;
+        SamplingProfiler& operator=(SamplingProfiler const&) = delete;
+
+        // Hook pockets & profile thunks become known to attribution
+        void Index(HookInjector const& hookInjector);
+
+        size_t Samples() const noexcept { return _samples; }
+    };
+}
+#endif //INJECTOR_SAMPLING_PROFILER_HPP
@@ -0,0 +1,49 @@
+#ifndef INJECTOR_STRING_POOL_HPP
+#define INJECTOR_STRING_POOL_HPP
+
+#include <unordered_map>
+
+#include <process_memory.hpp>
+
+#include "framework.hpp"
+
+namespace Injector
+{
+    /*!
+    * @brief Zero terminated strings packed one after another, each distinct string is stored once.
+    * @brief Offsets are exact, so strings of any length fit; pool is copied into process by one write (see `write`).
+    */
+    class StringPool final
+    {
+    public:
+        // Offset of string in pool, added if it's new
+        size_t add(string_view const& str)
+        {
+            _added += str.size() + 1;
+            auto const it = _offsets.find(string(str));
+            if (it != _offsets.cend())
+                return it->second;
+            size_t const offset = _data.size();
+            _data.append(str).push_back('\0');
+            _offsets.emplace(str, offset);
+            return offset;
+        }
+
+        size_t      size()  const { return _data.size(); }
+        size_t      count() const { return _offsets.size(); }
+        const char* data()  const { return _data.data(); }
+        // Bytes of strings as they were added, with duplicates
+        size_t      added() const { return _added; }
+
+        void write(VirtualMemoryHandle& vmh) const
+        {
+            if (!_data.empty())
+                vmh.Write(const_cast<char*>(_data.data()), _data.size(), 0);
+        }
+    private:
+        string                             _data;
+        std::unordered_map<string, size_t> _offsets;
+        size_t                             _added = 0;
+    };
+}
+#endif //INJECTOR_STRING_POOL_HPP
@@ -0,0 +1,423 @@
+#ifndef INJECTOR_X86_DECODER_HPP
+#define INJECTOR_X86_DECODER_HPP
+
+#include <array>
+
+#include "framework.hpp"
+#include "asm.hpp"
+#include "misc_code.hpp"
+
+namespace Injector
+{
+    static constexpr size_t MaxInstructionLength = 15;
+
+    /*!
+    * @brief Length decoder of x86-32 instructions (general purpose, x87, MMX/SSE with 0F, 0F 38, 0F 3A escapes).
+    * @brief It's table-driven and constexpr: only sizes of prefixes, opcode, ModRM/SIB, displacement & immediate are decoded,
+    * @brief plus position of EIP-relative operand for branches.
+    */
+    struct X86Instruction
+    {
+        // values are operand sizes
+        enum class Relative : BYTE
+        {
+            None  = 0,
+            Rel8  = 1,
+            Rel32 = 4,
+        };
+
+        BYTE     Length         = 0;
+        BYTE     PrefixLength   = 0;
+        // Last opcode byte, `Escaped` - after 0F
+        BYTE     Opcode         = 0;
+        bool     Escaped        = false;
+        Relative Branch         = Relative::None;
+        // Offset of relative operand from instruction start
+        BYTE     BranchOffset   = 0;
+
+        constexpr bool is_relative() const { return Branch != Relative::None; }
+        // JCXZ, LOOP, LOOPZ, LOOPNZ - rel8 only
+        constexpr bool is_counter_branch() const { return !Escaped && Opcode >= 0xE0 && Opcode <= 0xE3; }
+    };
+
+    namespace X86Tables
+    {
+        enum : BYTE
+        {
+            ModRM   = 0x01,
+            Imm8    = 0x02,
+            Imm16   = 0x04,
+            // 32 bit immediate, 16 bit with operand size prefix
+            ImmZ    = 0x08,
+            Rel8    = 0x10,
+            RelZ    = 0x20,
+            // memory offset of address size
+            Moffs   = 0x40,
+            Invalid = 0x80,
+        };
+
+        constexpr std::array<BYTE, 256> one_byte()
+        {
+            std::array<BYTE, 256> t {};
+            for (int op = 0x00; op < 0x40; op++)
+            {
+                int const low = op & 0x07;
+                if (low < 4)       t[op] = ModRM;
+                else if (low == 4) t[op] = Imm8;
+                else if (low == 5) t[op] = ImmZ;
+            }
+            t[0x62] = t[0x63] = ModRM;
+            t[0x68] = ImmZ;  t[0x69] = ModRM | ImmZ;
+            t[0x6A] = Imm8;  t[0x6B] = ModRM | Imm8;
+            for (int op = 0x70; op < 0x80; op++)
+                t[op] = Rel8;
+            t[0x80] = t[0x82] = t[0x83] = ModRM | Imm8;
+            t[0x81] = ModRM | ImmZ;
+            for (int op = 0x84; op < 0x90; op++)
+                t[op] = ModRM;
+            t[0x9A] = ImmZ | Imm16;
+            t[0xA0] = t[0xA1] = t[0xA2] = t[0xA3] = Moffs;
+            t[0xA8] = Imm8;  t[0xA9] = ImmZ;
+            for (int op = 0xB0; op < 0xB8; op++)
+                t[op] = Imm8;
+            for (int op = 0xB8; op < 0xC0; op++)
+                t[op] = ImmZ;
+            t[0xC0] = t[0xC1] = t[0xC6] = ModRM | Imm8;
+            t[0xC2] = t[0xCA] = Imm16;
+            t[0xC4] = t[0xC5] = ModRM;
+            t[0xC7] = ModRM | ImmZ;
+            t[0xC8] = Imm16 | Imm8;
+            t[0xCD] = t[0xD4] = t[0xD5] = Imm8;
+            for (int op = 0xD0; op < 0xD4; op++)
+                t[op] = ModRM;
+            for (int op = 0xD8; op < 0xE0; op++)
+                t[op] = ModRM;
+            t[0xE0] = t[0xE1] = t[0xE2] = t[0xE3] = t[0xEB] = Rel8;
+            t[0xE4] = t[0xE5] = t[0xE6] = t[0xE7] = Imm8;
+            t[0xE8] = t[0xE9] = RelZ;
+            t[0xEA] = ImmZ | Imm16;
+            // F6 & F7 have immediate only for TEST (/0, /1), it's checked by decoder
+            t[0xF6] = t[0xF7] = t[0xFE] = t[0xFF] = ModRM;
+            return t;
+        }
+
+        constexpr std::array<BYTE, 256> two_byte()
+        {
+            std::array<BYTE, 256> t {};
+            for (auto& flags : t)
+                flags = ModRM;
+            for (int op : { 0x04, 0x0A, 0x0C, 0x0E, 0x36, 0x39, 0x3B, 0x3C, 0x3D, 0x3E, 0x3F, 0x7A, 0x7B, 0xFF })
+                t[op] = Invalid;
+            for (int op : { 0x05, 0x06, 0x07, 0x08, 0x09, 0x0B, 0x30, 0x31, 0x32, 0x33, 0x34, 0x35, 0x37, 0x77, 0xA0, 0xA1, 0xA2, 0xA8, 0xA9, 0xAA })
+                t[op] = 0;
+            for (int op = 0x80; op < 0x90; op++)
+                t[op] = RelZ;
+            for (int op = 0xC8; op < 0xD0; op++)
+                t[op] = 0;
+            // 0F 0F - 3DNow!, opcode is imm8 suffix
+            for (int op : { 0x0F, 0x70, 0x71, 0x72, 0x73, 0xA4, 0xAC, 0xBA, 0xC2, 0xC4, 0xC5, 0xC6 })
+                t[op] = ModRM | Imm8;
+            return t;
+        }
+
+        static constexpr std::array<BYTE, 256> OneByte = one_byte();
+        static constexpr std::array<BYTE, 256> TwoByte = two_byte();
+
+        constexpr bool is_prefix(BYTE b)
+        {
+            switch (b)
+            {
+                case 0xF0: case 0xF2: case 0xF3:
+                case 0x2E: case 0x36: case 0x3E: case 0x26: case 0x64: case 0x65:
+                case 0x66: case 0x67:
+                    return true;
+                default:
+                    return false;
+            }
+        }
+    }
+
+    // Decodes single instruction, returns false if it's unknown or not complete in `size` bytes
+    constexpr bool decode_instruction(BYTE const* code, size_t size, X86Instruction& instruction)
+    {
+        using namespace X86Tables;
+
+        instruction = X86Instruction {};
+        size_t const limit = size < MaxInstructionLength ? size : MaxInstructionLength;
+
+        bool operandSize16 = false;
+        bool addressSize16 = false;
+        size_t i = 0;
+        for (; i < limit && is_prefix(code[i]); i++)
+        {
+            operandSize16 |= code[i] == 0x66;
+            addressSize16 |= code[i] == 0x67;
+        }
+        if (i >= limit)
+            return false;
+        instruction.PrefixLength = static_cast<BYTE>(i);
+
+        BYTE flags = 0;
+        if (code[i] == 0x0F)
+        {
+            if (++i >= limit)
+                return false;
+            instruction.Escaped = true;
+            if (code[i] == 0x38 || code[i] == 0x3A)
+            {
+                flags = code[i] == 0x38 ? ModRM : ModRM | Imm8;
+                if (++i >= limit)
+                    return false;
+            }
+            else flags = TwoByte[code[i]];
+        }
+        else flags = OneByte[code[i]];
+
+        instruction.Opcode = code[i++];
+        if (flags & Invalid)
+            return false;
+
+        if (flags & ModRM)
+        {
+            if (i >= limit)
+                return false;
+            BYTE const modrm = code[i++];
+            BYTE const mod   = modrm >> 6;
+            BYTE const reg   = (modrm >> 3) & 0x07;
+            BYTE const rm    = modrm & 0x07;
+
+            if (!instruction.Escaped && reg < 2 && (instruction.Opcode == 0xF6 || instruction.Opcode == 0xF7))
+                flags |= instruction.Opcode == 0xF6 ? Imm8 : ImmZ;
+
+            if (mod != 3)
+            {
+                if (addressSize16)
+                {
+                    if (mod == 1)                  i += 1;
+                    else if (mod == 2)             i += 2;
+                    else if (rm == 6)              i += 2;
+                }
+                else
+                {
+                    if (rm == 4)
+                    {
+                        if (i >= limit)
+                            return false;
+                        BYTE const sib = code[i++];
+                        if (mod == 0 && (sib & 0x07) == 5)
+                            i += 4;
+                    }
+                    if (mod == 1)                  i += 1;
+                    else if (mod == 2)             i += 4;
+                    else if (rm == 5)              i += 4;
+                }
+            }
+        }
+
+        if (flags & (Rel8 | RelZ))
+        {
+            // rel16 branches (with operand size prefix) truncate EIP, they never appear in 32 bit code
+            if ((flags & RelZ) && operandSize16)
+                return false;
+            instruction.Branch       = flags & Rel8 ? X86Instruction::Relative::Rel8 : X86Instruction::Relative::Rel32;
+            instruction.BranchOffset = static_cast<BYTE>(i);
+            i += flags & Rel8 ? 1 : 4;
+        }
+        if (flags & Imm8)  i += 1;
+        if (flags & Imm16) i += 2;
+        if (flags & ImmZ)  i += operandSize16 ? 2 : 4;
+        if (flags & Moffs) i += addressSize16 ? 2 : 4;
+
+        if (i > limit)
+            return false;
+        instruction.Length = static_cast<BYTE>(i);
+        return true;
+    }
+
+    constexpr size_t instruction_length(std::initializer_list<BYTE> code)
+    {
+        X86Instruction instruction;
+        return decode_instruction(code.begin(), code.size(), instruction) ? instruction.Length : 0;
+    }
+
+    static_assert(instruction_length({ 0x55 }) == 1,                                     "push ebp");
+    static_assert(instruction_length({ 0x8B, 0x4C, 0x24, 0x04 }) == 4,                   "mov ecx, [esp+4]");
+    static_assert(instruction_length({ 0x81, 0xEC, 0x00, 0x01, 0x00, 0x00 }) == 6,       "sub esp, 100h");
+    static_assert(instruction_length({ 0xC7, 0x05, INIT_PTR, INIT_DWORD }) == 10,        "mov dword ptr [imm32], imm32");
+    static_assert(instruction_length({ 0x66, 0xC7, 0x40, 0x08, 0x01, 0x00 }) == 6,       "mov word ptr [eax+8], 1");
+    static_assert(instruction_length({ 0xF6, 0x41, 0x10, 0x01 }) == 4,                   "test byte ptr [ecx+10h], 1");
+    static_assert(instruction_length({ 0xF7, 0xD8 }) == 2,                               "neg eax");
+    static_assert(instruction_length({ 0x0F, 0x84, INIT_DWORD }) == 6,                   "jz rel32");
+    static_assert(instruction_length({ 0x0F, 0xB6, 0x44, 0x24, 0x08 }) == 5,             "movzx eax, byte ptr [esp+8]");
+    static_assert(instruction_length({ 0xD9, 0x05, INIT_PTR }) == 6,                     "fld dword ptr [imm32]");
+    static_assert(instruction_length({ 0x8B, 0x04, 0x85, INIT_PTR }) == 7,               "mov eax, [eax*4+imm32]");
+    static_assert(instruction_length({ 0xA1, INIT_PTR }) == 5,                           "mov eax, [moffs32]");
+    static_assert(instruction_length({ 0x66, 0x0F, 0x3A, 0x0F, 0xC1, 0x08 }) == 6,       "palignr xmm0, xmm1, 8");
+
+    /*!
+    * @brief Instructions overridden by hook jump, copied to be executed at another address.
+    * @brief Overwrite size is the minimal count of whole instruction bytes which covers the jump.
+    * @brief Every EIP-relative operand is relocated: rel8 branches out of the region are widened to rel32 forms,
+    * @brief JCXZ & LOOPcc (rel8 only) become `op +2; jmp short +5; jmp rel32`.
+    * @brief Branches into the region itself (except its start, which is hook jump now) keep pointing into the copy.
+    */
+    class RelocatedCode final
+    {
+    public:
+        struct Item
+        {
+            X86Instruction Instruction;
+            size_t         Offset;
+            size_t         NewOffset;
+            size_t         NewLength;
+        };
+
+        vector<Item> Items;
+        // Bytes of whole instructions at source
+        size_t       OverwriteSize = 0;
+        // Bytes of relocated code
+        size_t       Size          = 0;
+        size_t       Branches      = 0;
+
+        // Decodes whole instructions from `code` until `minSize` bytes are covered, returns false on unknown instruction
+        bool plan(vector<BYTE> const& code, size_t minSize)
+        {
+            Items.clear();
+            OverwriteSize = Size = Branches = 0;
+
+            while (OverwriteSize < minSize)
+            {
+                X86Instruction instruction;
+                if (!decode_instruction(code.data() + OverwriteSize, code.size() - OverwriteSize, instruction))
+                    return false;
+                Items.push_back({ instruction, OverwriteSize, 0, instruction.Length });
+                OverwriteSize += instruction.Length;
+            }
+
+            for (Item& item : Items)
+            {
+                item.NewOffset = Size;
+                if (item.Instruction.Branch == X86Instruction::Relative::Rel8 && !is_internal(code, item))
+                {
+                    if (item.Instruction.is_counter_branch())
+                        item.NewLength = item.Instruction.PrefixLength + 2 + 2 + JumpR32lInstructionLength;
+                    else if (item.Instruction.Opcode == 0xEB)
+                        item.NewLength = item.Instruction.PrefixLength + JumpR32lInstructionLength;
+                    else
+                        item.NewLength = item.Instruction.PrefixLength + 6;
+                }
+                if (item.Instruction.is_relative())
+                    Branches++;
+                Size += item.NewLength;
+            }
+            return true;
+        }
+
+        // Index of item which starts at `offset` of region, Items.size() if offset is not instruction boundary
+        size_t item_at(size_t offset) const
+        {
+            for (size_t index = 0; index < Items.size(); index++)
+                if (Items[index].Offset == offset)
+                    return index;
+            return Items.size();
+        }
+        // Whether any branch targets the region itself (except its start), region can't be relocated by parts then
+        bool has_internal_branches(vector<BYTE> const& code) const
+        {
+            for (Item const& item : Items)
+                if (item.Instruction.is_relative() && is_internal(code, item))
+                    return true;
+            return false;
+        }
+
+        // Relocated code for placement at `target`, `code` was read from `source`, throws invalid_jump_offset_error.
+        // Items [first, last) are relocated only, it's valid for part of region without internal branches.
+        vector<BYTE> relocate(vector<BYTE> const& code, Address source, Address target, size_t first = 0, size_t last = SIZE_MAX) const
+        {
+            last = (std::min)(last, Items.size());
+            size_t const base = first < last ? Items[first].NewOffset : 0;
+
+            vector<BYTE> result;
+            result.reserve(Size);
+
+            auto const address_of = [](Address base, int64_t offset) { return reinterpret_cast<Address>(reinterpret_cast<intptr_t>(base) + static_cast<intptr_t>(offset)); };
+            auto const append_rel32 = [&result](int32_t value)
+            {
+                BYTE bytes[sizeof(value)];
+                memcpy(bytes, &value, sizeof(value));
+                result.insert(result.end(), bytes, bytes + sizeof(value));
+            };
+
+            for (size_t index = first; index < last; index++)
+            {
+                Item const& item = Items[index];
+                X86Instruction const& instruction = item.Instruction;
+                BYTE const* const bytes = code.data() + item.Offset;
+                if (!instruction.is_relative())
+                {
+                    result.insert(result.end(), bytes, bytes + instruction.Length);
+                    continue;
+                }
+
+                int64_t const targetOffset = branch_target(code, item);
+                bool const   internal     = is_internal(code, item);
+                Address const destination = internal
+                    ? address_of(target, new_offset_of(static_cast<size_t>(targetOffset)) - base)
+                    : address_of(source, targetOffset);
+                Address const end = address_of(target, item.NewOffset - base + item.NewLength);
+                size_t const operandSize  = static_cast<size_t>(instruction.Branch);
+
+                if (instruction.Branch == X86Instruction::Relative::Rel32 || internal)
+                {
+                    result.insert(result.end(), bytes, bytes + instruction.BranchOffset);
+                    int32_t const offset = relative_offset(end, destination);
+                    if (instruction.Branch == X86Instruction::Relative::Rel32)
+                        append_rel32(offset);
+                    else if (offset <= INT8_MAX && offset >= INT8_MIN)
+                        result.push_back(static_cast<BYTE>(offset));
+                    else
+                        throw invalid_jump_offset_error { offset, sizeof(int8_t) };
+                    result.insert(result.end(), bytes + instruction.BranchOffset + operandSize, bytes + instruction.Length);
+                    continue;
+                }
+
+                result.insert(result.end(), bytes, bytes + instruction.PrefixLength);
+                if (instruction.is_counter_branch())
+                    result.insert(result.end(), { instruction.Opcode, 0x02, JMP_R8(0x05), 0xE9 });
+                else if (instruction.Opcode == 0xEB)
+                    result.push_back(0xE9);
+                else
+                    result.insert(result.end(), { 0x0F, static_cast<BYTE>(0x80 | (instruction.Opcode & 0x0F)) });
+                append_rel32(relative_offset(end, destination));
+            }
+            return result;
+        }
+    private:
+        // Target of branch as offset from region start (may be out of region)
+        static int64_t branch_target(vector<BYTE> const& code, Item const& item)
+        {
+            BYTE const* const operand = code.data() + item.Offset + item.Instruction.BranchOffset;
+            int32_t value = 0;
+            if (item.Instruction.Branch == X86Instruction::Relative::Rel8)
+                value = static_cast<int8_t>(*operand);
+            else
+                memcpy(&value, operand, sizeof(value));
+            return static_cast<int64_t>(item.Offset + item.Instruction.Length) + value;
+        }
+        bool is_internal(vector<BYTE> const& code, Item const& item) const
+        {
+            int64_t const offset = branch_target(code, item);
+            return offset > 0 && offset < static_cast<int64_t>(OverwriteSize);
+        }
+        size_t new_offset_of(size_t offset) const
+        {
+            for (Item const& item : Items)
+                if (item.Offset == offset)
+                    return item.NewOffset;
+            // branch into the middle of instruction - it can't be relocated
+            throw invalid_jump_offset_error { static_cast<int64_t>(offset), 0 };
+        }
+    };
+}
+
+#endif //INJECTOR_X86_DECODER_HPP
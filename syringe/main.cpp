@@ -1,6 +1,10 @@
 ﻿#include <iostream>
 #include <string>
 #include <string_view>
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <thread>
 
 #define SPDLOG_HEADER_ONLY
 #include <spdlog/spdlog.h>
@@ -8,21 +12,64 @@
 #include <cmd_line_parser.hpp>
 #include <debugger.hpp>
 #include <configurator.hpp>
+#include <direct_injector.hpp>
+#include <dry_run.hpp>
 
 using namespace std;
 using namespace Injector;
 using namespace PECOFF;
 
+// Parses modules on worker threads. Errors are kept per module (in list order) to be reported sequentially.
+vector<std::exception_ptr> ParseModulesConcurrently(
+    list<Module>& modules,
+    bool strictFVI,
+    PlanCache const* planCache)
+{
+    vector<Module*>            queue;
+    for (auto& mdl : modules)
+        queue.push_back(&mdl);
+    vector<std::exception_ptr> errors(queue.size());
+
+    std::atomic_size_t next = 0;
+    auto worker = [&]()
+    {
+        for (size_t i; (i = next++) < queue.size();)
+        {
+            try { queue[i]->parse(queue[i]->FileName, strictFVI, planCache); }
+            catch (...) { errors[i] = std::current_exception(); }
+        }
+    };
+
+    auto const   start   = std::chrono::steady_clock::now();
+    size_t const threads = std::min<size_t>(std::max(std::thread::hardware_concurrency(), 1u), queue.size());
+
+    vector<std::thread> workers;
+    for (size_t i = 1; i < threads; i++)
+        workers.emplace_back(worker);
+    worker();
+    for (auto& t : workers)
+        t.join();
+
+    spdlog::debug("{0} modules parsed in {1} ms by {2} threads.", queue.size(),
+        std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count(), threads);
+    return errors;
+}
+
 int ParseModule(
     Module& mdl,
     bool forceExecutableValidation,
     bool stopIfModuleInvalid,
-    bool strictFVI)
+    std::exception_ptr const& parseError)
 {
     try
     {
-        mdl.parse(mdl.FileName, strictFVI);
-        spdlog::info("::\"{0}\": {1} hooks & {2} hosts found, checksum: 0x{3:x} ({3:d})", mdl.FileName, mdl.Hooks.size(), mdl.Hosts.size(), mdl.Checksum);
+        // warnings of concurrent parse are logged here, in order of modules
+        for (auto const& warning : mdl.Warnings)
+            spdlog::warn("{}", warning);
+        if (parseError)
+            std::rethrow_exception(parseError);
+        spdlog::info("::\"{0}\": {1} hooks & {2} hosts found, checksum: 0x{3:x} ({3:d}){4}", mdl.FileName, mdl.Hooks.size(), mdl.Hosts.size(), mdl.Checksum,
+            mdl.Cached ? " - restored from plan cache" : "");
         for (auto& host : mdl.Hosts)
             spdlog::trace(":::: 0x{1:x}, \"{0}\"", host.FileName, host.Checksum);
     }
@@ -90,7 +137,8 @@ int ParseModules(
     bool forceExecutableValidation,
     bool processWithEmptyModules,
     bool stopIfModuleInvalid,
-    bool strictFVI)
+    bool strictFVI,
+    PlanCache const* planCache)
 {
     if (modules.empty() && !processWithEmptyModules)
     {
@@ -102,10 +150,13 @@ int ParseModules(
             MB_OK);
         return EXIT_FAILURE;
     }
+    // parsing is concurrent, but diagnostics & rejection follow module order (hook pocket order depends on it)
+    auto const    parseErrors = ParseModulesConcurrently(modules, strictFVI, planCache);
+    auto          parseError  = parseErrors.cbegin();
     list<Module*> notAccepted;
     for (auto& mdl : modules)
     {
-        auto r = ParseModule(mdl, forceExecutableValidation, stopIfModuleInvalid, strictFVI);
+        auto r = ParseModule(mdl, forceExecutableValidation, stopIfModuleInvalid, *parseError++);
         if (r != EXIT_SUCCESS)
         {
             notAccepted.push_back(&mdl);
@@ -143,7 +194,9 @@ int ParseModules(
                     break;
                 }
 
-                hook.Placement = GetProcAddress(localDll->get_handle(), hook.PlacementFunction.c_str());
+                // module is loaded only into injector yet, its process handle is set on injection
+                HMODULE const localHandle = isInExecutable ? localDll->get_handle() : localDll->get_injector_handle();
+                hook.Placement = GetProcAddress(localHandle, hook.PlacementFunction.c_str());
                 if (!hook.Placement)
                 {
                     spdlog::warn("::::Redefine {0} for {1}::{2} can not be resolved - target function not defined in target module.",
@@ -151,29 +204,33 @@ int ParseModules(
                     );
                     break;
                 }
+                // placements in modules are RVAs like the ones of other hooks, module base in process is added on injection
+                if (!isInExecutable)
+                    hook.Placement = reinterpret_cast<BYTE*>(hook.Placement) - reinterpret_cast<DWORD>(localHandle);
                 spdlog::info("::::Redefine {0} for {1}::{2} = 0x{3:x}.",
                     hook.FunctionName, hookModuleName, hook.PlacementFunction, hook.Placement
                 );
             }
-            else if (hook.Type != HookType::FacadeAtAddress)
-                continue;
+        }
+    }
 
-            for (auto& m : modules)
-            {
-                for (auto& h : m.Hooks)
-                {
-                    auto isRedefine = hook.Type == HookType::FacadeByName || hook.Type == HookType::FacadeAtAddress;
-                    if (!isRedefine)
-                        continue;
-                    if (hook.Placement != h.Placement)
-                        continue;
-                    auto hModuleName = h.ModuleName.empty() ? "executable" : "\"" + h.ModuleName + "\"";
-                    spdlog::warn("::::Redefine conflict between ({0} for {1}::0x{2:x}) and ({3} for {4}::0x{5:x}).",
-                        hook.FunctionName, hookModuleName, hook.Placement,
-                        h.FunctionName, hModuleName, h.Placement
-                    );
-                }
-            }
+    vector<Hook*> hooks;
+    for (auto& mdl : modules)
+        for (auto& hook : mdl.Hooks)
+            hooks.push_back(&hook);
+    auto const moduleNameOf = [](Hook const* hook) { return hook->ModuleName.empty() ? "executable" : "\"" + hook->ModuleName + "\""; };
+    for (auto const& conflict : find_hook_conflicts(hooks))
+    {
+        auto const first  = fmt::format("{0} for {1}::0x{2:x}, {3} bytes", conflict.First->FunctionName, moduleNameOf(conflict.First), (uint32_t) conflict.First->Placement, conflict.First->Size);
+        auto const second = fmt::format("{0} for {1}::0x{2:x}, {3} bytes", conflict.Second->FunctionName, moduleNameOf(conflict.Second), (uint32_t) conflict.Second->Placement, conflict.Second->Size);
+        switch (conflict.Kind)
+        {
+            case HookConflictKind::SameRedefine:
+                spdlog::warn("::Redefine conflict between ({0}) and ({1}), the first one is applied.", first, second); break;
+            case HookConflictKind::PartialOverlap:
+                spdlog::warn("::Hooks overlap: ({0}) and ({1}), the second one is merged into pocket of the first one if it's safe.", first, second); break;
+            case HookConflictKind::RedefineInPocket:
+                spdlog::warn("::Redefine overlaps overridden instructions of hook: ({0}) and ({1}).", first, second); break;
         }
     }
     return EXIT_SUCCESS;
@@ -208,8 +265,16 @@ int Run(std::string_view const arguments)
     bool         processWithEmptyModules   = true;
     bool         stopIfModuleInvalid       = false;
     bool         strictFVI = false;
+    bool         usePlanCache              = true;
+    bool         useFileCache              = true;
+    InjectionOptions options;
 
     unsigned int executableChecksum        = 0;
+    unique_ptr<PlanCache>         planCache;
+    unique_ptr<FileIdentityCache> fileCache;
+    unique_ptr<EventRecorder>     recorder;
+    // registry must not keep pointer to file cache after it's destroyed, on any return
+    struct FileCacheDetach { ~FileCacheDetach() { ChecksumRegistry::instance().attach(nullptr); } } fileCacheDetach;
 
     try
     {
@@ -228,9 +293,6 @@ int Run(std::string_view const arguments)
             }
             executableFile = map->FreeParameters()->Parameters[0];
 
-            executableChecksum = CRC32::compute_stream(file_open_binary(executableFile));
-            spdlog::info("Executable \"{0}\", checksum: 0x{1:x} ({1:d})", executableFile, executableChecksum);
-
             size_t moduleCount = 0;
             for (size_t i = 0; i < map->Count(); i++)
             {
@@ -245,6 +307,41 @@ int Run(std::string_view const arguments)
                     moduleCount++;
                 else if ((string)arg->Prefix == (string)"-strictFVI")
                     strictFVI = true;
+                else if ((string)arg->Prefix == (string)"-noPlanCache")
+                    usePlanCache = false;
+                else if ((string)arg->Prefix == (string)"-noFileCache")
+                    useFileCache = false;
+                else if ((string)arg->Prefix == (string)"-profileHooks")
+                    options.ProfileHooks = true;
+                else if ((string)arg->Prefix == (string)"-profile")
+                    options.Sample = true;
+                else if ((string)arg->Prefix == (string)"-trace")
+                    options.Trace = true;
+                else if ((string)arg->Prefix == (string)"-detach")
+                    options.Detach = true;
+                else if ((string)arg->Prefix == (string)"-direct")
+                    options.Direct = true;
+                else if ((string)arg->Prefix == (string)"-record")
+                    options.Record = true;
+                else if ((string)arg->Prefix == (string)"-plan")
+                    options.Plan = true;
+            }
+
+            if (useFileCache)
+            {
+                fileCache = make_unique<FileIdentityCache>(FileIdentityCacheFileName);
+                if (fileCache->load())
+                    spdlog::info("File cache \"{0}\" loaded: {1} entries.", fileCache->FileName, fileCache->size());
+                ChecksumRegistry::instance().attach(fileCache.get());
+            }
+
+            executableChecksum = ChecksumRegistry::instance().get(executableFile);
+            spdlog::info("Executable \"{0}\", checksum: 0x{1:x} ({1:d})", executableFile, executableChecksum);
+
+            if (usePlanCache)
+            {
+                planCache = make_unique<PlanCache>(PlanCacheFileName, executableChecksum);
+                planCache->load();
             }
 
             if (moduleCount > 0)
@@ -286,7 +383,12 @@ int Run(std::string_view const arguments)
                 spdlog::info("::\"{0}\"", mdl.FileName);
 
             spdlog::info("Parse modules for hosts & hooks");
-            auto r = ParseModules(modules, forceExecutableValidation, processWithEmptyModules, stopIfModuleInvalid, strictFVI);
+            auto r = ParseModules(modules, forceExecutableValidation, processWithEmptyModules, stopIfModuleInvalid, strictFVI, planCache.get());
+            if (fileCache)
+            {
+                spdlog::info("File cache: {0} hits, {1} misses.", fileCache->hits(), fileCache->misses());
+                fileCache->save();
+            }
             if (r != EXIT_SUCCESS)
                 return r;
         }
@@ -312,14 +414,78 @@ int Run(std::string_view const arguments)
             return EXIT_FAILURE;
         }
 
-        spdlog::info("Prepare debugger & process...");
-        Debugger::DebugLoop debugger{ executableFile, arguments, /* We do not want to lost all applies after debugger detach (by other, real debugger, attaching) */ false };
-        spdlog::info("Prepare configurator...");
-        Configurator configurator{ peExecutable, debugger, /*kernel,*/ modules, arguments, executableFile };
-        spdlog::info("Run debugger...");
-        debugger.Run();
-        spdlog::info("Injector & debugger done.");
-        return EXIT_SUCCESS;
+        if (options.Record && !options.Plan)
+        {
+            recorder = make_unique<EventRecorder>(EventLogFileName);
+            if (recorder->IsActive())
+                spdlog::info("Record session into event log \"{0}\".", EventLogFileName);
+            else
+                spdlog::warn("Unable to create event log \"{0}\", session is not recorded.", EventLogFileName);
+        }
+
+        int exitCode = EXIT_SUCCESS;
+        if (options.Plan)
+        {
+            spdlog::info("Plan hooks against images of executable & modules (process is not created)...");
+            DryRun dryRun{ peExecutable, executableFile, modules };
+            auto const& program = dryRun.Injector->Program;
+            if (!dryRun.save(DryRunPlanFileName, DryRunSummaryFileName))
+                exitCode = EXIT_FAILURE;
+            else
+            {
+                spdlog::info("Hook plan \"{0}\" & summary \"{1}\" written: {2} pockets, {3} facades, {4} conflicts, program {5} bytes.",
+                    DryRunPlanFileName, DryRunSummaryFileName, program.Pockets.size(), program.Facades.size(), dryRun.Conflicts.size(), program.Code.size());
+                if (!dryRun.Conflicts.empty())
+                    exitCode = DryRunConflictsExitCode;
+            }
+        }
+        else if (options.Direct)
+        {
+            if (options.ProfileHooks || options.Sample || options.Trace || options.Detach)
+                spdlog::warn("-profileHooks, -profile, -trace & -detach require debugger, they are ignored with -direct.");
+            spdlog::info("Prepare process (without debugger)...");
+            DirectInjector injector{ peExecutable, modules, arguments, executableFile, planCache.get() };
+            injector.Run();
+            spdlog::info("Injector done.");
+        }
+        else
+        {
+            spdlog::info("Prepare debugger & process...");
+            Debugger::DebugLoop debugger{ executableFile, arguments, /* We do not want to lost all applies after debugger detach (by other, real debugger, attaching) */ false };
+            spdlog::info("Prepare configurator...");
+            Configurator configurator{ peExecutable, debugger, /*kernel,*/ modules, arguments, executableFile, planCache.get(), options };
+            spdlog::info("Run debugger...");
+            debugger.OnDetached += [](Debugger::DebugLoop& sender)
+            {
+                spdlog::info("Debugger detached, wait for process exit...");
+            };
+            debugger.Run();
+            spdlog::info("Injector & debugger done.");
+            {
+                auto const& stats = debugger.Stats;
+                size_t events = 0;
+                for (size_t count : stats.Events)
+                    events += count;
+                spdlog::info("Debug events{0}: {1} (exceptions {2}, first chance {3}; threads {4}; DLL loads {5}; debug strings {6}), process was stopped for {7:.1f} ms.",
+                    debugger.Detached ? " before detach" : "", events,
+                    stats.Events[EXCEPTION_DEBUG_EVENT], stats.FirstChanceExceptions, stats.Events[CREATE_THREAD_DEBUG_EVENT],
+                    stats.Events[LOAD_DLL_DEBUG_EVENT], stats.Events[OUTPUT_DEBUG_STRING_EVENT],
+                    std::chrono::duration<double, std::milli>(stats.Stopped).count());
+            }
+        }
+        if (recorder && recorder->IsActive())
+        {
+            spdlog::info("Event log \"{0}\": {1} records, {2} bytes.", EventLogFileName, recorder->Records(), recorder->Bytes());
+            recorder.reset();
+        }
+        spdlog::debug("Checksums: {0} files hashed, {1} requests served from registry.",
+            ChecksumRegistry::instance().misses(), ChecksumRegistry::instance().hits());
+        if (fileCache)
+        {
+            spdlog::info("File cache: {0} hits, {1} misses (including loaded DLLs).", fileCache->hits(), fileCache->misses());
+            fileCache->save();
+        }
+        return exitCode;
     }
     catch (const std::exception& e)
     {